@@ -44,6 +44,21 @@ namespace ycsbc {
         double GCRatio_;
         uint64_t blockWriteSize_;
         bool intra_compation_;
+        size_t valueCache_;
+        bool blobDirectIO_;
+        size_t blobWriteBuffer_;
+        int valueCacheMinFreq_;
+        int gcSubjobs_;
+        uint64_t blobIORate_;
+        uint64_t blobIOTargetP99_;
+        int blobFormatVersion_;
+        uint64_t blobBlockSize_;
+        bool adaptiveBlobSize_;
+        int inlineHotValueFreq_;
+        int foregroundBuilders_;
+        bool numaAwareBuilders_;
+        uint32_t blobReadQueueDepth_;
+        uint64_t slowdownWriteSize_;
 
 
     public:
@@ -76,6 +91,21 @@ namespace ycsbc {
             GCRatio_ = pt_.get<double>("config.gcRatio");
             blockWriteSize_ = pt_.get<uint64_t>("config.blockWriteSize");
             intra_compation_ = pt_.get<bool>("config.intraCompaction");
+            valueCache_ = pt_.get<size_t>("config.valueCache", 0);
+            valueCacheMinFreq_ = pt_.get<int>("config.valueCacheMinFreq", 2);
+            blobDirectIO_ = pt_.get<bool>("config.blobDirectIO", false);
+            blobWriteBuffer_ = pt_.get<size_t>("config.blobWriteBuffer", 0);
+            gcSubjobs_ = pt_.get<int>("config.gcSubjobs", 1);
+            blobIORate_ = pt_.get<uint64_t>("config.blobIORate", 0);
+            blobIOTargetP99_ = pt_.get<uint64_t>("config.blobIOTargetP99", 0);
+            blobFormatVersion_ = pt_.get<int>("config.blobFormatVersion", 1);
+            blobBlockSize_ = pt_.get<uint64_t>("config.blobBlockSize", 16384);
+            adaptiveBlobSize_ = pt_.get<bool>("config.adaptiveBlobSize", false);
+            inlineHotValueFreq_ = pt_.get<int>("config.inlineHotValueFreq", 0);
+            foregroundBuilders_ = pt_.get<int>("config.foregroundBuilders", 1);
+            numaAwareBuilders_ = pt_.get<bool>("config.numaAwareBuilders", false);
+            blobReadQueueDepth_ = pt_.get<uint32_t>("config.blobReadQueueDepth", 0);
+            slowdownWriteSize_ = pt_.get<uint64_t>("config.slowdownWriteSize", 0);
         }
 
         int getBloomBits() {
@@ -184,6 +214,66 @@ namespace ycsbc {
         bool getIntraCompaction(){
             return intra_compation_;
         }
+
+        size_t getValueCache(){
+            return valueCache_;
+        }
+
+        int getValueCacheMinFreq(){
+            return valueCacheMinFreq_;
+        }
+
+        bool getBlobDirectIO(){
+            return blobDirectIO_;
+        }
+
+        size_t getBlobWriteBuffer(){
+            return blobWriteBuffer_;
+        }
+
+        int getGCSubjobs(){
+            return gcSubjobs_;
+        }
+
+        uint64_t getBlobIORate(){
+            return blobIORate_;
+        }
+
+        uint64_t getBlobIOTargetP99(){
+            return blobIOTargetP99_;
+        }
+
+        int getBlobFormatVersion(){
+            return blobFormatVersion_;
+        }
+
+        uint64_t getBlobBlockSize(){
+            return blobBlockSize_;
+        }
+
+        bool getAdaptiveBlobSize(){
+            return adaptiveBlobSize_;
+        }
+
+        int getInlineHotValueFreq(){
+            return inlineHotValueFreq_;
+        }
+
+        int getForegroundBuilders(){
+            return foregroundBuilders_;
+        }
+
+        bool getNumaAwareBuilders(){
+            return numaAwareBuilders_;
+        }
+
+        uint32_t getBlobReadQueueDepth(){
+            return blobReadQueueDepth_;
+        }
+
+        uint64_t getSlowdownWriteSize(){
+            return slowdownWriteSize_;
+        }
     };
 }
 
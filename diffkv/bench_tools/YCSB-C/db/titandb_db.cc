@@ -50,7 +50,9 @@ namespace ycsbc {
         options.lazy_merge = config.getLazyMerge();
 
         options.max_background_gc = config.getGCThreads();
+        options.max_gc_subjobs = config.getGCSubjobs();
 	    options.block_write_size = blockWriteSize;
+        options.slowdown_write_size = config.getSlowdownWriteSize();
         std::cerr<<"block write size "<<options.block_write_size<<std::endl;
         options.blob_file_discardable_ratio = gcRatio;
 
@@ -64,11 +66,28 @@ namespace ycsbc {
   
 		std::cerr<<"intro compaction "<<options.intra_compact_small_l0<<std::endl;
         options.sep_before_flush = config.getSepBeforeFlush();
+        options.num_foreground_builders = config.getForegroundBuilders();
+        options.numa_aware_foreground_builders = config.getNumaAwareBuilders();
+        options.blob_read_queue_depth = config.getBlobReadQueueDepth();
         if(config.getTiered()) options.compaction_style = rocksdb::kCompactionStyleUniversal;
         options.max_background_jobs = config.getNumThreads();
         options.disable_auto_compactions = config.getNoCompaction();
         options.mid_blob_size = config.getMidThresh();
         options.min_blob_size = config.getSmallThresh();
+        options.adaptive_blob_size = config.getAdaptiveBlobSize();
+        options.inline_hot_value_frequency = config.getInlineHotValueFreq();
+        options.blob_file_use_direct_io = config.getBlobDirectIO();
+        options.blob_file_write_buffer_size = config.getBlobWriteBuffer();
+        options.blob_file_format_version = config.getBlobFormatVersion();
+        options.blob_file_block_size = config.getBlobBlockSize();
+        if(config.getValueCache()>0) {
+            options.blob_value_cache = rocksdb::NewLRUCache(config.getValueCache());
+            options.blob_value_cache_min_frequency = config.getValueCacheMinFreq();
+        }
+        if(config.getBlobIORate()>0) {
+            options.blob_io_scheduler = rocksdb::titandb::NewBlobIOScheduler(
+                config.getBlobIORate(), config.getBlobIOTargetP99());
+        }
      
 
         rocksdb::Status s = rocksdb::titandb::TitanDB::Open(options, dbfilename, &db_);
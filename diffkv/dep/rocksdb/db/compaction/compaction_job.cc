@@ -1505,7 +1505,8 @@ Status CompactionJob::OpenCompactionOutputFile(
       sub_compact->compaction->output_compression_opts(),
       sub_compact->compaction->output_level(), skip_filters, latest_key_time,
       0 /* oldest_key_time */, sub_compact->compaction->max_output_file_size(),
-      current_time, sub_compact->compaction->start_level()));
+      current_time, sub_compact->compaction->start_level(),
+      TableFileCreationReason::kCompaction));
   LogFlush(db_options_.info_log);
   return s;
 }
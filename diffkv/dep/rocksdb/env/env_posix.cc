@@ -987,12 +987,12 @@ class PosixEnv : public Env {
 
   // Allow increasing the number of worker threads.
   void SetBackgroundThreads(int num, Priority pri) override {
-    assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
+    assert(pri >= Priority::BOTTOM && pri <= Priority::USER);
     thread_pools_[pri].SetBackgroundThreads(num);
   }
 
   int GetBackgroundThreads(Priority pri) override {
-    assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
+    assert(pri >= Priority::BOTTOM && pri <= Priority::USER);
     return thread_pools_[pri].GetBackgroundThreads();
   }
 
@@ -1003,12 +1003,12 @@ class PosixEnv : public Env {
 
   // Allow increasing the number of worker threads.
   void IncBackgroundThreadsIfNeeded(int num, Priority pri) override {
-    assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
+    assert(pri >= Priority::BOTTOM && pri <= Priority::USER);
     thread_pools_[pri].IncBackgroundThreadsIfNeeded(num);
   }
 
   void LowerThreadPoolIOPriority(Priority pool = LOW) override {
-    assert(pool >= Priority::BOTTOM && pool <= Priority::HIGH);
+    assert(pool >= Priority::BOTTOM && pool <= Priority::USER);
 #ifdef OS_LINUX
     thread_pools_[pool].LowerIOPriority();
 #else
@@ -1017,7 +1017,7 @@ class PosixEnv : public Env {
   }
 
   void LowerThreadPoolCPUPriority(Priority pool = LOW) override {
-    assert(pool >= Priority::BOTTOM && pool <= Priority::HIGH);
+    assert(pool >= Priority::BOTTOM && pool <= Priority::USER);
 #ifdef OS_LINUX
     thread_pools_[pool].LowerCPUPriority();
 #else
@@ -1132,7 +1132,7 @@ PosixEnv::PosixEnv()
 
 void PosixEnv::Schedule(void (*function)(void* arg1), void* arg, Priority pri,
                         void* tag, void (*unschedFunction)(void* arg)) {
-  assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
+  assert(pri >= Priority::BOTTOM && pri <= Priority::USER);
   thread_pools_[pri].Schedule(function, arg, tag, unschedFunction);
 }
 
@@ -1141,7 +1141,7 @@ int PosixEnv::UnSchedule(void* arg, Priority pri) {
 }
 
 unsigned int PosixEnv::GetThreadPoolQueueLen(Priority pri) const {
-  assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
+  assert(pri >= Priority::BOTTOM && pri <= Priority::USER);
   return thread_pools_[pri].GetQueueLen();
 }
 
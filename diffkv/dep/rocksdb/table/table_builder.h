@@ -16,6 +16,7 @@
 #include "db/dbformat.h"
 #include "db/table_properties_collector.h"
 #include "options/cf_options.h"
+#include "rocksdb/listener.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table_properties.h"
 #include "trace_replay/block_cache_tracer.h"
@@ -84,7 +85,8 @@ struct TableBuilderOptions {
       const std::string& _column_family_name, int _level,
       const uint64_t _creation_time = 0, const int64_t _oldest_key_time = 0,
       const uint64_t _target_file_size = 0,
-      const uint64_t _file_creation_time = 0, int _start_level = -1)
+      const uint64_t _file_creation_time = 0, int _start_level = -1,
+      TableFileCreationReason _reason = TableFileCreationReason::kMisc)
       : ioptions(_ioptions),
         moptions(_moptions),
         internal_comparator(_internal_comparator),
@@ -99,7 +101,8 @@ struct TableBuilderOptions {
         oldest_key_time(_oldest_key_time),
         target_file_size(_target_file_size),
         file_creation_time(_file_creation_time),
-        start_level(_start_level) {}
+        start_level(_start_level),
+        reason(_reason) {}
   const ImmutableCFOptions& ioptions;
   const MutableCFOptions& moptions;
   const InternalKeyComparator& internal_comparator;
@@ -116,6 +119,8 @@ struct TableBuilderOptions {
   const uint64_t target_file_size;
   const uint64_t file_creation_time;
   int start_level;
+  // The job that creates the table.
+  TableFileCreationReason reason;
 };
 
 // TableBuilder provides the interface used to build a Table
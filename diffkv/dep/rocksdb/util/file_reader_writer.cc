@@ -85,17 +85,23 @@ Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
       size_t aligned_offset = TruncateToPageBoundary(alignment, static_cast<size_t>(offset));
       size_t offset_advance = static_cast<size_t>(offset) - aligned_offset;
       size_t read_size = Roundup(static_cast<size_t>(offset + n), alignment) - aligned_offset;
+      // Whole pages read into an aligned scratch need no bounce buffer.
+      bool read_in_place = offset_advance == 0 && read_size == n &&
+                           reinterpret_cast<uintptr_t>(scratch) % alignment == 0;
       AlignedBuffer buf;
       buf.Alignment(alignment);
-      buf.AllocateNewBuffer(read_size);
-      while (buf.CurrentSize() < read_size) {
+      if (!read_in_place) {
+        buf.AllocateNewBuffer(read_size);
+      }
+      size_t filled = 0;
+      while (filled < read_size) {
         size_t allowed;
         if (for_compaction && rate_limiter_ != nullptr) {
           allowed = rate_limiter_->RequestToken(
-              buf.Capacity() - buf.CurrentSize(), buf.Alignment(),
+              read_size - filled, alignment,
               Env::IOPriority::IO_LOW, stats_, RateLimiter::OpType::kRead);
         } else {
-          assert(buf.CurrentSize() == 0);
+          assert(filled == 0);
           allowed = read_size;
         }
         Slice tmp;
@@ -104,12 +110,12 @@ Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
         uint64_t orig_offset = 0;
         if (ShouldNotifyListeners()) {
           start_ts = std::chrono::system_clock::now();
-          orig_offset = aligned_offset + buf.CurrentSize();
+          orig_offset = aligned_offset + filled;
         }
         {
           IOSTATS_CPU_TIMER_GUARD(cpu_read_nanos, env_);
-          s = file_->Read(aligned_offset + buf.CurrentSize(), allowed, &tmp,
-                          buf.Destination());
+          s = file_->Read(aligned_offset + filled, allowed, &tmp,
+                          read_in_place ? scratch + filled : buf.Destination());
         }
         if (ShouldNotifyListeners()) {
           auto finish_ts = std::chrono::system_clock::now();
@@ -117,15 +123,20 @@ Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
                                  s);
         }
 
-        buf.Size(buf.CurrentSize() + tmp.size());
+        filled += tmp.size();
+        if (!read_in_place) {
+          buf.Size(filled);
+        }
         if (!s.ok() || tmp.size() < allowed) {
           break;
         }
       }
       size_t res_len = 0;
-      if (s.ok() && offset_advance < buf.CurrentSize()) {
-        res_len = buf.Read(scratch, offset_advance,
-                           std::min(buf.CurrentSize() - offset_advance, n));
+      if (s.ok() && offset_advance < filled) {
+        res_len = read_in_place
+                      ? filled
+                      : buf.Read(scratch, offset_advance,
+                                 std::min(filled - offset_advance, n));
       }
       *result = Slice(scratch, res_len);
 #endif  // !ROCKSDB_LITE
@@ -177,6 +177,18 @@ class TitanDB : public StackableDB {
     //  "rocksdb.titandb.discardable_ratio_le100_file_num" - returns count of
     //  file whose discardable ratio is less or equal to 100%.
     static const std::string kNumDiscardableRatioLE100File;
+    //  "rocksdb.titandb.min-blob-size" - returns the current min_blob_size,
+    //      which adaptive_blob_size may have moved.
+    static const std::string kMinBlobSize;
+    //  "rocksdb.titandb.mid-blob-size" - returns the current mid_blob_size.
+    static const std::string kMidBlobSize;
+    //  "rocksdb.titandb.perf-context" - returns the non-zero counters of the
+    //      TitanPerfContext of the calling thread.
+    static const std::string kPerfContext;
+    //  "rocksdb.titandb.blob-dir-stats" - returns the number of blob files,
+    //      their size and their discardable size in each blob directory of
+    //      the column family.
+    static const std::string kBlobDirStats;
   };
 
   bool GetProperty(ColumnFamilyHandle* column_family, const Slice& property,
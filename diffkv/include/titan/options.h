@@ -1,7 +1,9 @@
 #pragma once
 
 #include <map>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "logging/logging.h"
 #include "rocksdb/options.h"
@@ -9,6 +11,15 @@
 namespace rocksdb {
 namespace titandb {
 
+class BlobIOScheduler;
+
+// Creates a scheduler of background blob I/O with a budget of
+// "bytes_per_sec". If "target_p99_micros" is non-zero, the budget is
+// lowered while the p99 latency of foreground reads exceeds it.
+extern std::shared_ptr<BlobIOScheduler> NewBlobIOScheduler(
+    uint64_t bytes_per_sec, uint64_t target_p99_micros = 0,
+    Env* env = Env::Default());
+
 struct TitanDBOptions : public DBOptions {
   // The directory to store data specific to TitanDB alongside with
   // the base DB.
@@ -26,6 +37,14 @@ struct TitanDBOptions : public DBOptions {
   // Default: 1
   int32_t max_background_gc{1};
 
+  // Max number of sub jobs a GC job is split into. Sub jobs work on
+  // disjoint sets of the input files concurrently, and their outputs are
+  // installed together. They run on the GC thread pool, which gets
+  // max_background_gc * (max_gc_subjobs - 1) more threads.
+  //
+  // Default: 1
+  int32_t max_gc_subjobs{1};
+
   // How often to schedule delete obsolete blob files periods.
   // If set zero, obsolete blob files won't be deleted.
   //
@@ -38,13 +57,70 @@ struct TitanDBOptions : public DBOptions {
   // Default: 600 (10 min)
   uint32_t titan_stats_dump_period_sec{600};
 
+  // The Titan manifest is rewritten as a snapshot of the live blob files
+  // once the edits appended to it exceed this size, or twice the size of
+  // the last snapshot if that's larger, so that reopening the DB doesn't
+  // replay a long history of edits. If zero, the manifest is only
+  // rewritten when the DB is opened.
+  //
+  // Default: 64MB
+  uint64_t titan_max_manifest_file_size{64 << 20};
+
+  // If true, the size, header and footer of every live blob file are
+  // checked when the DB is opened, with up to `max_file_opening_threads`
+  // threads. Blob file readers are still opened on first access.
+  //
+  // Default: false
+  bool verify_blob_files_on_open{false};
+
   bool sep_before_flush{false};
 
   int num_foreground_builders{1};
 
-  // block foreground write if blob size too large
+  // If true, every NUMA node gets its own `num_foreground_builders`
+  // builders, whose threads only run on the node's CPUs. A value is
+  // separated by a builder of the node its writer runs on, picked among
+  // them by the hash of the key as usual, so every blob file still holds
+  // a single key partition. Has no effect without sep_before_flush, or if
+  // the NUMA topology can't be read.
+  //
+  // Default: false
+  bool numa_aware_foreground_builders{false};
+
+  // Foreground writes are stopped while the blob files of the DB, live
+  // values and garbage left for GC together, are larger than this. If
+  // zero, writes are never delayed or stopped for the size of blob files.
+  //
+  // Default: 0
   uint64_t block_write_size{0};
 
+  // Foreground writes are delayed once the blob files grow past this size.
+  // The delayed write rate falls from `delayed_write_rate` (16MB/s if
+  // zero) at slowdown_write_size to a hundredth of it near
+  // block_write_size, so writers slow down gradually while GC catches up
+  // instead of all being stopped at once. If zero, 3/4 of
+  // block_write_size. Values not below block_write_size disable the delay.
+  //
+  // Default: 0
+  uint64_t slowdown_write_size{0};
+
+  // Blob reads of a batch, issued by MultiGet, Scan and level merge, are
+  // submitted to a pool of this many threads shared by all the column
+  // families, so that the number of reads in flight follows the depth the
+  // device can serve rather than the number of user threads. If zero, the
+  // reads of a batch are issued one after the other by the calling thread,
+  // in file and offset order.
+  //
+  // Default: 0
+  uint32_t blob_read_queue_depth{0};
+
+  // If non-null, blob I/O of flush, compaction (separation and merge) and
+  // GC is charged to this scheduler, which throttles compaction and GC to
+  // its budget. It can be shared by several DBs. See NewBlobIOScheduler().
+  //
+  // Default: nullptr
+  std::shared_ptr<BlobIOScheduler> blob_io_scheduler;
+
   TitanDBOptions() = default;
   explicit TitanDBOptions(const DBOptions& options) : DBOptions(options) {}
 
@@ -87,8 +163,22 @@ struct TitanCFOptions : public ColumnFamilyOptions {
   // Default: 4096
   uint64_t min_blob_size{128};
 
+  // With level_merge and sep_before_flush, values at least this big are
+  // separated before the memtable into unsorted blob files, and smaller
+  // ones are separated at flush into sorted blob files.
+  //
+  // Default: 4096
   uint64_t mid_blob_size{4096};
 
+  // If true, min_blob_size and mid_blob_size are moved at runtime through
+  // SetOptions, from the sizes of the values written and read since they
+  // were last moved. The decisions are reported in TitanStats and through
+  // the "rocksdb.titandb.min-blob-size" and "mid-blob-size" properties.
+  // Both options can also be changed with SetOptions by hand.
+  //
+  // Default: false
+  bool adaptive_blob_size{false};
+
   // The compression algorithm used to compress data in blob files.
   //
   // Default: kNoCompression
@@ -99,11 +189,109 @@ struct TitanCFOptions : public ColumnFamilyOptions {
   // Default: 256MB
   uint64_t blob_file_target_size{256 << 20};
 
+  // Directories of the blob files of this column family, which may be on
+  // other devices than the DB. New blob files are striped over them by
+  // file number, so their I/O is spread over all of them. The directory of
+  // a file is derived from its number, so the list must not change once
+  // the column family has blob files.
+  //
+  // Default: empty, which puts the blob files in TitanDBOptions::dirname
+  std::vector<std::string> blob_dirs;
+
+  // If non-null, the blob I/O of flush, compaction and GC of this column
+  // family is charged to this scheduler rather than to
+  // TitanDBOptions::blob_io_scheduler, so a column family on devices of
+  // its own gets a budget of its own.
+  //
+  // Default: nullptr
+  std::shared_ptr<BlobIOScheduler> blob_io_scheduler;
+
+  // If true, blob files are read and written with direct I/O, so blob
+  // reads don't evict the pages of the base DB from the page cache.
+  // Unsorted blob files built by foreground builders are still written
+  // with buffered I/O, since they are read while being built.
+  //
+  // Default: false
+  bool blob_file_use_direct_io{false};
+
+  // The write buffer size of blob files. Writes smaller than this are
+  // coalesced before being issued to the file.
+  //
+  // Default: 0, which uses `writable_file_max_buffer_size` (at least 4MB
+  // with direct I/O) for sorted blob files and 4KB for blob files built
+  // by foreground builders.
+  uint64_t blob_file_write_buffer_size{0};
+
+  // The format version of new sorted blob files. Version 1 stores every
+  // record on its own, with its own header and compression. Version 2
+  // packs records into blocks of `blob_file_block_size` bytes, which are
+  // compressed as a whole and located through a block index at the end
+  // of the file. Both versions are always readable. Unsorted blob files
+  // built by foreground builders always use version 1, since they are
+  // read while being built.
+  //
+  // Default: 1
+  uint32_t blob_file_format_version{1};
+
+  // The uncompressed size of blocks of version 2 blob files, in
+  // [4KB, 64KB]. A record bigger than that gets a block of its own.
+  //
+  // Default: 16KB
+  uint64_t blob_file_block_size{16 << 10};
+
+  // Dictionary compression of version 2 blob files. If `max_dict_bytes`
+  // is non-zero, the first blocks of every file (`zstd_max_train_bytes`
+  // of them, or 100 times `max_dict_bytes` if zero) are buffered to make
+  // a dictionary, which is trained with zstd if `zstd_max_train_bytes`
+  // is non-zero and sampled from the blocks otherwise. The dictionary is
+  // stored in the file and used for all its blocks.
+  //
+  // Default: no dictionary
+  CompressionOptions blob_file_compression_options;
+
   // If non-NULL use the specified cache for blob records.
   //
   // Default: nullptr
   std::shared_ptr<Cache> blob_cache;
 
+  // If non-NULL use the specified cache for the values of point lookups.
+  // A value is admitted only when the cache has room or it has been read
+  // at least `blob_value_cache_min_frequency` times recently, plus one
+  // more time for every doubling of its size above `mid_blob_size`.
+  // Iterators, GC and compaction never fill this cache.
+  //
+  // Default: nullptr
+  std::shared_ptr<Cache> blob_value_cache;
+
+  // The minimum recent access frequency, as estimated by a count-min
+  // sketch, required to admit a value into a full `blob_value_cache`.
+  // Capped at 15.
+  //
+  // Default: 2
+  uint32_t blob_value_cache_min_frequency{2};
+
+  // If non-zero, compaction writes separated values back into the SST
+  // when their key has been read at least this many times recently, as
+  // estimated by a count-min sketch updated by point lookups, so reading
+  // them takes one I/O. They are separated again by a later compaction
+  // once the key cools down. Capped at 15.
+  //
+  // Default: 0, which disables it
+  uint32_t inline_hot_value_frequency{0};
+
+  // The largest value kept in the SST for a hot key.
+  //
+  // Default: 4KB
+  uint64_t inline_hot_value_max_size{4 << 10};
+
+  // The number of distinct hot keys the sketch behind
+  // `inline_hot_value_frequency` is sized for, rounded up to a power of
+  // two within [1K, 16M]. It takes 4 bytes per entry; fewer entries make
+  // unrelated keys look hot more often.
+  //
+  // Default: 1M
+  uint64_t inline_hot_value_sketch_entries{1 << 20};
+
   // Max batch size for GC.
   //
   // Default: 1GB
@@ -187,11 +375,22 @@ struct ImmutableTitanCFOptions {
   ImmutableTitanCFOptions() : ImmutableTitanCFOptions(TitanCFOptions()) {}
 
   explicit ImmutableTitanCFOptions(const TitanCFOptions& opts)
-      : min_blob_size(opts.min_blob_size),
-        mid_blob_size(opts.mid_blob_size),
+      : adaptive_blob_size(opts.adaptive_blob_size),
         blob_file_compression(opts.blob_file_compression),
         blob_file_target_size(opts.blob_file_target_size),
+        blob_dirs(opts.blob_dirs),
+        blob_io_scheduler(opts.blob_io_scheduler),
+        blob_file_use_direct_io(opts.blob_file_use_direct_io),
+        blob_file_write_buffer_size(opts.blob_file_write_buffer_size),
+        blob_file_format_version(opts.blob_file_format_version),
+        blob_file_block_size(opts.blob_file_block_size),
+        blob_file_compression_options(opts.blob_file_compression_options),
         blob_cache(opts.blob_cache),
+        blob_value_cache(opts.blob_value_cache),
+        blob_value_cache_min_frequency(opts.blob_value_cache_min_frequency),
+        inline_hot_value_frequency(opts.inline_hot_value_frequency),
+        inline_hot_value_max_size(opts.inline_hot_value_max_size),
+        inline_hot_value_sketch_entries(opts.inline_hot_value_sketch_entries),
         max_gc_batch_size(opts.max_gc_batch_size),
         min_gc_batch_size(opts.min_gc_batch_size),
         blob_file_discardable_ratio(opts.blob_file_discardable_ratio),
@@ -200,16 +399,38 @@ struct ImmutableTitanCFOptions {
         lazy_merge(opts.lazy_merge),
         level_merge(opts.level_merge){}
 
-  uint64_t min_blob_size;
-
-  uint64_t mid_blob_size;
+  bool adaptive_blob_size;
 
   CompressionType blob_file_compression;
 
   uint64_t blob_file_target_size;
 
+  std::vector<std::string> blob_dirs;
+
+  std::shared_ptr<BlobIOScheduler> blob_io_scheduler;
+
+  bool blob_file_use_direct_io;
+
+  uint64_t blob_file_write_buffer_size;
+
+  uint32_t blob_file_format_version;
+
+  uint64_t blob_file_block_size;
+
+  CompressionOptions blob_file_compression_options;
+
   std::shared_ptr<Cache> blob_cache;
 
+  std::shared_ptr<Cache> blob_value_cache;
+
+  uint32_t blob_value_cache_min_frequency;
+
+  uint32_t inline_hot_value_frequency;
+
+  uint64_t inline_hot_value_max_size;
+
+  uint64_t inline_hot_value_sketch_entries;
+
   uint64_t max_gc_batch_size;
 
   uint64_t min_gc_batch_size;
@@ -229,7 +450,13 @@ struct MutableTitanCFOptions {
   MutableTitanCFOptions() : MutableTitanCFOptions(TitanCFOptions()) {}
 
   explicit MutableTitanCFOptions(const TitanCFOptions& opts)
-      : blob_run_mode(opts.blob_run_mode) {}
+      : min_blob_size(opts.min_blob_size),
+        mid_blob_size(opts.mid_blob_size),
+        blob_run_mode(opts.blob_run_mode) {}
+
+  uint64_t min_blob_size;
+
+  uint64_t mid_blob_size;
 
   TitanBlobRunMode blob_run_mode;
 };
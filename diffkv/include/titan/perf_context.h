@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include "rocksdb/perf_level.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// Breaks down the time of the operations of the calling thread in the
+// parts Titan adds on top of RocksDB, which rocksdb::PerfContext doesn't
+// see. Like it, the context is thread-local and set by
+// rocksdb::SetPerfLevel(): counters are updated from kEnableCount, the
+// default, and timers from kEnableTimeExceptForMutex.
+//
+// Reads issued by the pool of blob_read_queue_depth are counted in the
+// context of the pool's threads, not of the caller.
+struct TitanPerfContext {
+  void Reset();
+
+  std::string ToString(bool exclude_zero_counters = false) const;
+
+  // Time spent looking up keys in the LSM-tree by Get and MultiGet.
+  uint64_t get_lsm_nanos;
+
+  // Blob file readers opened on a miss of the blob file cache, and the
+  // time spent opening them.
+  uint64_t blob_file_open_count;
+  uint64_t blob_file_open_nanos;
+
+  // Values served by the blob value cache.
+  uint64_t blob_value_cache_hit_count;
+
+  // Reads of blob records and blocks, their bytes and time.
+  uint64_t blob_read_count;
+  uint64_t blob_read_byte;
+  uint64_t blob_read_nanos;
+
+  // Time spent decompressing blob records and blocks.
+  uint64_t blob_decompress_nanos;
+
+  // Writes delayed or stopped as the blob files grow towards
+  // block_write_size, and the time they were held for.
+  uint64_t write_stall_count;
+  uint64_t write_stall_nanos;
+
+  // Time a Put waits for a foreground builder to separate its value,
+  // including the time queued behind other writes.
+  uint64_t foreground_builder_wait_nanos;
+};
+
+// Returns the context of the calling thread.
+TitanPerfContext* get_titan_perf_context();
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -21,5 +21,9 @@ void BaseDbListener::OnCompactionCompleted(
   db_impl_->OnCompactionCompleted(compaction_job_info);
 }
 
+void BaseDbListener::OnTableFileDeleted(const TableFileDeletionInfo& info) {
+  db_impl_->OnTableFileDeleted(info);
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
@@ -19,6 +19,8 @@ class BaseDbListener final : public EventListener {
   void OnCompactionCompleted(
       DB* db, const CompactionJobInfo& compaction_job_info) override;
 
+  void OnTableFileDeleted(const TableFileDeletionInfo& info) override;
+
  private:
   rocksdb::titandb::TitanDBImpl* db_impl_;
 };
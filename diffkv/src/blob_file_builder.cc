@@ -1,6 +1,8 @@
 #include "blob_file_builder.h"
 #include "atomic"
 
+#include <algorithm>
+
 std::atomic<uint64_t> bytes_written{0};
 
 namespace rocksdb {
@@ -11,8 +13,29 @@ BlobFileBuilder::BlobFileBuilder(const TitanDBOptions& db_options,
                                  WritableFileWriter* file)
     : cf_options_(cf_options),
       file_(file),
-      encoder_(cf_options_.blob_file_compression) {
+      encoder_(cf_options_.blob_file_compression),
+      version_(cf_options_.blob_file_format_version ==
+                       BlobFileHeader::kVersion2
+                   ? BlobFileHeader::kVersion2
+                   : BlobFileHeader::kVersion1),
+      block_size_(std::min(
+          std::max(cf_options_.blob_file_block_size, kMinBlobBlockSize),
+          kMaxBlobBlockSize)) {
+  if (version_ == BlobFileHeader::kVersion2) {
+    const auto& compression_opt = cf_options_.blob_file_compression_options;
+    block_encoder_.reset(new BlobBlockEncoder(
+        cf_options_.blob_file_compression, compression_opt));
+    block_index_.compression = cf_options_.blob_file_compression;
+    if (cf_options_.blob_file_compression != kNoCompression &&
+        compression_opt.max_dict_bytes > 0) {
+      sample_blocks_ = true;
+      sample_bytes_ = compression_opt.zstd_max_train_bytes > 0
+                          ? compression_opt.zstd_max_train_bytes
+                          : 100 * uint64_t{compression_opt.max_dict_bytes};
+    }
+  }
   BlobFileHeader header;
+  header.version = version_;
   std::string buffer;
   header.EncodeTo(&buffer);
   status_ = file_->Append(buffer);
@@ -21,14 +44,20 @@ BlobFileBuilder::BlobFileBuilder(const TitanDBOptions& db_options,
 void BlobFileBuilder::Add(const BlobRecord& record, BlobHandle* handle) {
   if (!ok()) return;
 
-  encoder_.EncodeRecord(record);
-  handle->offset = file_->GetFileSize();
-  handle->size = encoder_.GetEncodedSize();
+  if (version_ == BlobFileHeader::kVersion2) {
+    AddToBlock(record, handle);
+  } else {
+    encoder_.EncodeRecord(record);
+    handle->offset = file_->GetFileSize();
+    handle->size = encoder_.GetEncodedSize();
 
-  status_ = file_->Append(encoder_.GetHeader().ToString() +
-                          encoder_.GetRecord().ToString());
+    status_ = file_->Append(encoder_.GetHeader().ToString() +
+                            encoder_.GetRecord().ToString());
+    if (ok()) {
+      bytes_written += handle->size;
+    }
+  }
   if (ok()) {
-    bytes_written += handle->size;
     // status_ = file_->Append(encoder_.GetRecord());
     num_entries_++;
     // The keys added into blob files are in order.
@@ -51,11 +80,100 @@ void BlobFileBuilder::Add(const BlobRecord& record, BlobHandle* handle) {
   }
 }
 
+void BlobFileBuilder::AddToBlock(const BlobRecord& record,
+                                 BlobHandle* handle) {
+  record_buffer_.clear();
+  record.EncodeTo(&record_buffer_);
+  if (!block_buffer_.empty() &&
+      block_buffer_.size() + VarintLength(record_buffer_.size()) +
+              record_buffer_.size() >
+          block_size_) {
+    FlushBlock();
+    if (!ok()) return;
+  }
+  PutVarint32(&block_buffer_, static_cast<uint32_t>(record_buffer_.size()));
+  handle->offset = raw_offset_ + block_buffer_.size();
+  handle->size = record_buffer_.size();
+  block_buffer_.append(record_buffer_);
+}
+
+void BlobFileBuilder::FlushBlock() {
+  if (block_buffer_.empty()) return;
+  raw_offset_ += block_buffer_.size();
+  if (sample_blocks_) {
+    sampled_blocks_.emplace_back(std::move(block_buffer_));
+    block_buffer_.clear();
+    if (raw_offset_ >= sample_bytes_) {
+      FinishDictionary();
+    }
+    return;
+  }
+  WriteBlock(block_buffer_);
+  block_buffer_.clear();
+}
+
+void BlobFileBuilder::FinishDictionary() {
+  assert(sample_blocks_);
+  sample_blocks_ = false;
+  const auto& compression_opt = cf_options_.blob_file_compression_options;
+  std::string samples;
+  std::vector<size_t> sample_lens;
+  for (const auto& block : sampled_blocks_) {
+    samples.append(block);
+    sample_lens.push_back(block.size());
+  }
+  std::string dict;
+  if (compression_opt.zstd_max_train_bytes > 0 &&
+      ZSTD_TrainDictionarySupported()) {
+    dict = ZSTD_TrainDictionary(samples, sample_lens,
+                                compression_opt.max_dict_bytes);
+  } else {
+    dict = samples.substr(
+        0, std::min<size_t>(samples.size(), compression_opt.max_dict_bytes));
+  }
+  if (!dict.empty()) {
+    EncodeBlobBlock(dict, kNoCompression, &dict_block_);
+    block_encoder_->SetDictionary(std::move(dict));
+  }
+  for (const auto& block : sampled_blocks_) {
+    WriteBlock(block);
+  }
+  sampled_blocks_.clear();
+}
+
+void BlobFileBuilder::WriteBlock(const Slice& contents) {
+  if (!ok()) return;
+  block_output_.clear();
+  block_encoder_->EncodeBlock(contents, &block_output_);
+  status_ = file_->Append(block_output_);
+  if (ok()) {
+    bytes_written += block_output_.size();
+    block_index_.AddBlock(block_output_.size(), contents.size());
+  }
+}
+
 Status BlobFileBuilder::Finish() {
   if (!ok()) return status();
 
   std::string buffer;
   BlobFileFooter footer;
+  if (version_ == BlobFileHeader::kVersion2) {
+    FlushBlock();
+    if (sample_blocks_) {
+      FinishDictionary();
+    }
+    if (ok() && !dict_block_.empty()) {
+      block_index_.dict_handle.set_offset(file_->GetFileSize());
+      block_index_.dict_handle.set_size(dict_block_.size());
+      status_ = file_->Append(dict_block_);
+    }
+    if (!ok()) return status();
+    std::string index;
+    block_index_.EncodeTo(&index);
+    EncodeBlobBlock(index, kNoCompression, &buffer);
+    footer.meta_index_handle.set_offset(file_->GetFileSize());
+    footer.meta_index_handle.set_size(buffer.size());
+  }
   footer.EncodeTo(&buffer);
 
   status_ = file_->Append(buffer);
@@ -30,6 +30,10 @@ namespace titandb {
 // meta index block with block handles pointed to the meta blocks. The
 // meta block and the meta index block are formatted the same as the
 // BlockBasedTable.
+//
+// 3. In version 2 files, the records are packed into blocks instead,
+// which are compressed as a whole, optionally with a dictionary trained
+// from the first blocks. See blob_format.h.
 
 class BlobFileBuilder {
  public:
@@ -63,12 +67,38 @@ class BlobFileBuilder {
  private:
   bool ok() const { return status().ok(); }
 
+  // Adds the record to the current block of a version 2 file.
+  void AddToBlock(const BlobRecord& record, BlobHandle* handle);
+  // Ends the current block, which is written unless it's kept as a
+  // sample for the dictionary.
+  void FlushBlock();
+  // Makes the dictionary from the sampled blocks and writes them.
+  void FinishDictionary();
+  void WriteBlock(const Slice& contents);
+
   TitanCFOptions cf_options_;
   WritableFileWriter* file_;
 
   Status status_;
   BlobEncoder encoder_;
 
+  uint32_t version_;
+  // Only used by version 2 files.
+  uint64_t block_size_;
+  std::unique_ptr<BlobBlockEncoder> block_encoder_;
+  BlobBlockIndex block_index_;
+  std::string record_buffer_;
+  std::string block_buffer_;
+  std::string block_output_;
+  // Offset of the current block in the uncompressed contents.
+  uint64_t raw_offset_{0};
+  // Blocks kept as samples until there are enough bytes to make the
+  // dictionary.
+  bool sample_blocks_{false};
+  uint64_t sample_bytes_{0};
+  std::vector<std::string> sampled_blocks_;
+  std::string dict_block_;
+
   uint64_t num_entries_{0};
   std::string smallest_key_;
   std::string largest_key_;
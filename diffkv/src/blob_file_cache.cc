@@ -1,6 +1,9 @@
 #include "blob_file_cache.h"
 
+#include <algorithm>
+
 #include "file/filename.h"
+#include "titan_perf_context_imp.h"
 #include "util.h"
 
 namespace rocksdb {
@@ -16,13 +19,15 @@ Slice EncodeFileNumber(const uint64_t* number) {
 
 BlobFileCache::BlobFileCache(const TitanDBOptions& db_options,
                              const TitanCFOptions& cf_options,
-                             std::shared_ptr<Cache> cache, TitanStats* stats)
+                             std::shared_ptr<Cache> cache, TitanStats* stats,
+                             std::shared_ptr<ThreadPool> read_pool)
     : env_(db_options.env),
-      env_options_(db_options),
+      env_options_(BlobFileEnvOptions(EnvOptions(db_options), cf_options)),
       db_options_(db_options),
       cf_options_(cf_options),
       cache_(cache),
-      stats_(stats) {}
+      stats_(stats),
+      read_pool_(read_pool) {}
 
 Status BlobFileCache::Get(const ReadOptions& options, uint64_t file_number,
                           uint64_t file_size, const BlobHandle& handle,
@@ -37,6 +42,62 @@ Status BlobFileCache::Get(const ReadOptions& options, uint64_t file_number,
   return s;
 }
 
+void BlobFileCache::MultiGet(const ReadOptions& options,
+                             std::vector<BlobReadRequest*>* requests) {
+  std::sort(requests->begin(), requests->end(),
+            [](const BlobReadRequest* a, const BlobReadRequest* b) {
+              return a->file_number != b->file_number
+                         ? a->file_number < b->file_number
+                         : a->handle.offset < b->handle.offset;
+            });
+
+  // The readers are pinned until all the reads are done.
+  std::vector<Cache::Handle*> cache_handles;
+  std::vector<std::pair<BlobReadRequest*, BlobFileReader*>> reads;
+  reads.reserve(requests->size());
+  BlobFileReader* reader = nullptr;
+  uint64_t reader_file_number = 0;
+  for (auto* request : *requests) {
+    if (reader == nullptr || request->file_number != reader_file_number) {
+      Cache::Handle* cache_handle = nullptr;
+      request->status =
+          FindFile(request->file_number, request->file_size, &cache_handle);
+      if (!request->status.ok()) {
+        reader = nullptr;
+        continue;
+      }
+      cache_handles.push_back(cache_handle);
+      reader = reinterpret_cast<BlobFileReader*>(cache_->Value(cache_handle));
+      reader_file_number = request->file_number;
+    }
+    reads.emplace_back(request, reader);
+  }
+
+  if (read_pool_ && reads.size() > 1) {
+    std::vector<std::future<void>> done;
+    done.reserve(reads.size());
+    for (const auto& read : reads) {
+      done.emplace_back(read_pool_->addTask([&options, read]() {
+        read.first->status = read.second->Get(
+            options, read.first->handle, read.first->record,
+            read.first->buffer);
+      }));
+    }
+    for (auto& f : done) {
+      f.wait();
+    }
+  } else {
+    for (const auto& read : reads) {
+      read.first->status = read.second->Get(
+          options, read.first->handle, read.first->record, read.first->buffer);
+    }
+  }
+
+  for (auto* cache_handle : cache_handles) {
+    cache_->Release(cache_handle);
+  }
+}
+
 Status BlobFileCache::NewPrefetcher(uint64_t file_number, uint64_t file_size,
                                     std::unique_ptr<BlobFilePrefetcher>* result,
                                     bool sorted_blob) {
@@ -64,10 +125,12 @@ Status BlobFileCache::FindFile(uint64_t file_number, uint64_t file_size,
     // TODO: add file reader cache hit/miss metrics
     return s;
   }
+  TITAN_PERF_COUNTER_ADD(blob_file_open_count, 1);
+  TITAN_PERF_TIMER_GUARD(blob_file_open_nanos);
   std::unique_ptr<RandomAccessFileReader> file;
   {
     std::unique_ptr<RandomAccessFile> f;
-    auto file_name = BlobFileName(db_options_.dirname, file_number);
+    auto file_name = BlobFilePath(db_options_, cf_options_, file_number);
     s = env_->NewRandomAccessFile(file_name, &f, env_options_);
     if (!s.ok()) return s;
     if (db_options_.advise_random_on_open) {
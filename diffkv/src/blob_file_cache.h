@@ -3,18 +3,31 @@
 #include "blob_file_reader.h"
 #include "blob_format.h"
 #include "rocksdb/options.h"
+#include "threadpool.h"
 #include "titan/options.h"
 #include "titan_stats.h"
 
 namespace rocksdb {
 namespace titandb {
 
+// A read of a batch passed to BlobFileCache::MultiGet().
+struct BlobReadRequest {
+  uint64_t file_number{0};
+  uint64_t file_size{0};
+  BlobHandle handle;
+  BlobRecord* record{nullptr};
+  PinnableSlice* buffer{nullptr};
+  Status status;
+};
+
 class BlobFileCache {
  public:
-  // Constructs a blob file cache to cache opened files.
+  // Constructs a blob file cache to cache opened files. Batched reads are
+  // issued by "read_pool" if it is not null.
   BlobFileCache(const TitanDBOptions& db_options,
                 const TitanCFOptions& cf_options, std::shared_ptr<Cache> cache,
-                TitanStats* stats);
+                TitanStats* stats,
+                std::shared_ptr<ThreadPool> read_pool = nullptr);
 
   // Gets the blob record pointed by the handle in the specified file
   // number. The corresponding file size must be exactly "file_size"
@@ -24,6 +37,13 @@ class BlobFileCache {
              uint64_t file_size, const BlobHandle& handle, BlobRecord* record,
              PinnableSlice* buffer);
 
+  // Gets the records of the requests, which may point to different files,
+  // and sets the status of each of them. The requests are sorted by file
+  // number and offset. With a read pool they are all submitted to it and
+  // waited for; otherwise they are read in order by the calling thread.
+  void MultiGet(const ReadOptions& options,
+                std::vector<BlobReadRequest*>* requests);
+
   // Creates a prefetcher for the specified file number.
   Status NewPrefetcher(uint64_t file_number, uint64_t file_size,
                        std::unique_ptr<BlobFilePrefetcher>* result,
@@ -45,6 +65,7 @@ class BlobFileCache {
   TitanCFOptions cf_options_;
   std::shared_ptr<Cache> cache_;
   TitanStats* stats_;
+  std::shared_ptr<ThreadPool> read_pool_;
 };
 
 }  // namespace titandb
@@ -40,9 +40,31 @@ bool BlobFileIterator::Init() {
   if (!status_.ok()) return false;
   BlobFileFooter blob_file_footer;
   status_ = blob_file_footer.DecodeFrom(&slice);
-  end_of_blob_record_ = file_size_ - BlobFileFooter::kEncodedLength -
-                        blob_file_footer.meta_index_handle.size();
-  assert(end_of_blob_record_ > BlobFileHeader::kEncodedLength);
+  if (!status_.ok()) return false;
+  version_ = blob_file_header.version;
+  if (version_ == BlobFileHeader::kVersion2) {
+    OwnedSlice contents;
+    status_ = ReadBlockContents(blob_file_footer.meta_index_handle,
+                                UncompressionDict::GetEmptyDict(), &contents);
+    if (!status_.ok()) return false;
+    status_ = DecodeInto(contents, &block_index_);
+    if (!status_.ok()) return false;
+    if (!block_index_.dict_handle.IsNull()) {
+      status_ = ReadBlockContents(block_index_.dict_handle,
+                                  UncompressionDict::GetEmptyDict(),
+                                  &contents);
+      if (!status_.ok()) return false;
+      auto compression = block_index_.compression;
+      dict_.reset(new UncompressionDict(
+          contents.ToString(),
+          compression == kZSTD || compression == kZSTDNotFinalCompression));
+    }
+    end_of_blob_record_ = block_index_.file_offsets.back();
+  } else {
+    end_of_blob_record_ = file_size_ - BlobFileFooter::kEncodedLength -
+                          blob_file_footer.meta_index_handle.size();
+    assert(end_of_blob_record_ > BlobFileHeader::kEncodedLength);
+  }
   init_ = true;
   return true;
 }
@@ -51,6 +73,8 @@ void BlobFileIterator::SeekToFirst() {
   if (!init_ && !Init()) return;
   status_ = Status::OK();
   iterate_offset_ = BlobFileHeader::kEncodedLength;
+  next_block_ = 0;
+  block_iter_.clear();
   PrefetchAndGet();
 }
 
@@ -76,6 +100,17 @@ void BlobFileIterator::IterateForPrev(uint64_t offset) {
     return;
   }
 
+  if (version_ == BlobFileHeader::kVersion2) {
+    next_block_ = block_index_.FindBlockByFileOffset(offset);
+    if (next_block_ == block_index_.num_blocks()) {
+      next_block_ = 0;
+    }
+    iterate_offset_ = block_index_.file_offsets[next_block_];
+    block_iter_.clear();
+    valid_ = false;
+    return;
+  }
+
   uint64_t total_length = 0;
   FixedSlice<kRecordHeaderSize> header_buffer;
   iterate_offset_ = BlobFileHeader::kEncodedLength;
@@ -123,7 +158,60 @@ void BlobFileIterator::GetBlobRecord() {
   valid_ = true;
 }
 
+void BlobFileIterator::GetBlockRecord() {
+  while (block_iter_.empty()) {
+    if (next_block_ >= block_index_.num_blocks()) {
+      valid_ = false;
+      return;
+    }
+    uint64_t offset = block_index_.file_offsets[next_block_];
+    status_ = ReadBlockContents(
+        BlockHandle(offset, block_index_.file_offsets[next_block_ + 1] - offset),
+        dict_ ? *dict_ : UncompressionDict::GetEmptyDict(), &block_contents_);
+    if (!status_.ok()) return;
+    block_iter_ = block_contents_;
+    block_raw_offset_ = block_index_.raw_offsets[next_block_];
+    next_block_++;
+    iterate_offset_ = block_index_.file_offsets[next_block_];
+  }
+
+  uint32_t record_size = 0;
+  if (!GetVarint32(&block_iter_, &record_size) ||
+      block_iter_.size() < record_size) {
+    status_ = Status::Corruption("BlobBlock", "bad record length");
+    return;
+  }
+  cur_record_offset_ =
+      block_raw_offset_ + (block_iter_.data() - block_contents_.data());
+  cur_record_size_ = record_size;
+  status_ = DecodeInto(Slice(block_iter_.data(), record_size),
+                       &cur_blob_record_);
+  if (!status_.ok()) return;
+  block_iter_.remove_prefix(record_size);
+  valid_ = true;
+}
+
+Status BlobFileIterator::ReadBlockContents(const BlockHandle& handle,
+                                           const UncompressionDict& dict,
+                                           OwnedSlice* contents) {
+  Slice blob;
+  CacheAllocationPtr buffer(new char[handle.size()]);
+  // With for_compaction=true, rate_limiter is enabled. Since BlobFileIterator
+  // is only used for GC, we always set for_compaction to true.
+  Status s = file_->Read(handle.offset(), handle.size(), &blob, buffer.get(),
+                         true /*for_compaction*/);
+  if (!s.ok()) return s;
+  if (blob.size() != handle.size()) {
+    return Status::Corruption("BlobBlock", "truncated block");
+  }
+  return DecodeBlobBlock(blob, dict, std::move(buffer), contents);
+}
+
 void BlobFileIterator::PrefetchAndGet() {
+  if (version_ == BlobFileHeader::kVersion2) {
+    GetBlockRecord();
+    return;
+  }
   if (iterate_offset_ >= end_of_blob_record_) {
     valid_ = false;
     return;
@@ -14,7 +14,8 @@
 namespace rocksdb {
 namespace titandb {
 
-// Used by GC job for iterate through blob file.
+// Used by GC job for iterate through blob file. Version 2 files are read
+// block by block, and the blob indexes refer to the uncompressed records.
 class BlobFileIterator {
  public:
   const uint64_t kMinReadaheadSize = 4 << 10;
@@ -33,6 +34,8 @@ class BlobFileIterator {
   Slice value() const;
   Status status() const { return status_; }
 
+  // Positions before the record, or the block of version 2 files, which
+  // contains the file offset.
   void IterateForPrev(uint64_t);
 
   BlobIndex GetBlobIndex() {
@@ -69,8 +72,23 @@ class BlobFileIterator {
   uint64_t readahead_end_offset_{0};
   uint64_t readahead_size_{kMinReadaheadSize};
 
+  uint32_t version_{BlobFileHeader::kVersion1};
+  // Only used by version 2 files.
+  BlobBlockIndex block_index_;
+  std::unique_ptr<UncompressionDict> dict_;
+  // The next block to read.
+  size_t next_block_{0};
+  OwnedSlice block_contents_;
+  // The records left in the current block.
+  Slice block_iter_;
+  uint64_t block_raw_offset_{0};
+
   void PrefetchAndGet();
   void GetBlobRecord();
+  void GetBlockRecord();
+  Status ReadBlockContents(const BlockHandle& handle,
+                           const UncompressionDict& dict,
+                           OwnedSlice* contents);
 };
 
 class BlobFileMergeIterator {
@@ -82,8 +82,8 @@ class BlobFileIteratorTest : public testing::Test {
   void NewBlobFileIterator() {
     uint64_t file_size = 0;
     ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
-    NewBlobFileReader(file_number_, 0, titan_options_, env_options_, env_,
-                      &readable_file_);
+    NewBlobFileReader(file_number_, 0, titan_options_, titan_options_,
+                      env_options_, env_, &readable_file_);
     blob_file_iterator_.reset(new BlobFileIterator{
         std::move(readable_file_), file_number_, file_size, TitanCFOptions()});
   }
@@ -185,8 +185,8 @@ TEST_F(BlobFileIteratorTest, MergeIterator) {
       FinishBuilder();
       uint64_t file_size = 0;
       ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
-      NewBlobFileReader(file_number_, 0, titan_options_, env_options_, env_,
-                        &readable_file_);
+      NewBlobFileReader(file_number_, 0, titan_options_, titan_options_,
+                        env_options_, env_, &readable_file_);
       iters.emplace_back(std::unique_ptr<BlobFileIterator>(
           new BlobFileIterator{std::move(readable_file_), file_number_,
                                file_size, TitanCFOptions()}));
@@ -199,8 +199,8 @@ TEST_F(BlobFileIteratorTest, MergeIterator) {
   FinishBuilder();
   uint64_t file_size = 0;
   ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
-  NewBlobFileReader(file_number_, 0, titan_options_, env_options_, env_,
-                    &readable_file_);
+  NewBlobFileReader(file_number_, 0, titan_options_, titan_options_,
+                    env_options_, env_, &readable_file_);
   iters.emplace_back(std::unique_ptr<BlobFileIterator>(new BlobFileIterator{
       std::move(readable_file_), file_number_, file_size, TitanCFOptions()}));
   BlobFileMergeIterator iter(std::move(iters), titan_options_.comparator);
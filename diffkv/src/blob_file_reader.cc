@@ -7,21 +7,26 @@
 #include <inttypes.h>
 
 #include "file/filename.h"
+#include "monitoring/iostats_context_imp.h"
 #include "test_util/sync_point.h"
+#include "util/aligned_buffer.h"
 #include "util/crc32c.h"
 #include "util/string_util.h"
 
+#include "titan_perf_context_imp.h"
 #include "titan_stats.h"
+#include "util.h"
 
 namespace rocksdb {
 namespace titandb {
 
 Status NewBlobFileReader(uint64_t file_number, uint64_t readahead_size,
                          const TitanDBOptions& db_options,
+                         const TitanCFOptions& cf_options,
                          const EnvOptions& env_options, Env* env,
                          std::unique_ptr<RandomAccessFileReader>* result) {
   std::unique_ptr<RandomAccessFile> file;
-  auto file_name = BlobFileName(db_options.dirname, file_number);
+  auto file_name = BlobFilePath(db_options, cf_options, file_number);
   Status s = env->NewRandomAccessFile(file_name, &file, env_options);
   if (!s.ok()) return s;
 
@@ -34,6 +39,46 @@ Status NewBlobFileReader(uint64_t file_number, uint64_t readahead_size,
   return s;
 }
 
+Status VerifyBlobFile(uint64_t file_number, uint64_t file_size,
+                      const TitanDBOptions& db_options,
+                      const TitanCFOptions& cf_options,
+                      const EnvOptions& env_options, Env* env) {
+  auto file_name = BlobFilePath(db_options, cf_options, file_number);
+  uint64_t actual_size = 0;
+  Status s = env->GetFileSize(file_name, &actual_size);
+  if (!s.ok()) return s;
+  if (actual_size != file_size) {
+    return Status::Corruption(file_name,
+                              "file size " + ToString(actual_size) +
+                                  " doesn't match " + ToString(file_size));
+  }
+  if (file_size <
+      BlobFileHeader::kEncodedLength + BlobFileFooter::kEncodedLength) {
+    return Status::Corruption(file_name, "file is too short");
+  }
+
+  std::unique_ptr<RandomAccessFileReader> file;
+  s = NewBlobFileReader(file_number, 0, db_options, cf_options, env_options,
+                        env, &file);
+  if (!s.ok()) return s;
+
+  FixedSlice<BlobFileHeader::kEncodedLength> header_buffer;
+  s = file->Read(0, BlobFileHeader::kEncodedLength, &header_buffer,
+                 header_buffer.get());
+  if (!s.ok()) return s;
+  BlobFileHeader header;
+  s = DecodeInto(header_buffer, &header);
+  if (!s.ok()) return s;
+
+  FixedSlice<BlobFileFooter::kEncodedLength> footer_buffer;
+  s = file->Read(file_size - BlobFileFooter::kEncodedLength,
+                 BlobFileFooter::kEncodedLength, &footer_buffer,
+                 footer_buffer.get());
+  if (!s.ok()) return s;
+  BlobFileFooter footer;
+  return DecodeInto(footer_buffer, &footer);
+}
+
 const uint64_t kMaxReadaheadSize = 64 << 10;
 
 namespace {
@@ -53,6 +98,21 @@ void EncodeBlobCache(std::string* dst, const Slice& prefix, uint64_t offset) {
   PutVarint64(dst, offset);
 }
 
+// Buffers of direct I/O reads may be kept in the blob cache after the
+// reader is gone, so the pool is shared by all readers and never freed.
+AlignedBufferPool* DirectIOBufferPool() {
+  static AlignedBufferPool* pool =
+      new AlignedBufferPool(kDefaultPageSize, 64 << 20);
+  return pool;
+}
+
+// Pins the data of "blob" to "buffer", which takes the ownership.
+void PinOwnedSlice(OwnedSlice* blob, PinnableSlice* buffer) {
+  Slice data = *blob;
+  auto allocator = blob->allocator();
+  buffer->PinSlice(data, OwnedSlice::CleanupFunc, blob->release(), allocator);
+}
+
 }  // namespace
 
 Status BlobFileReader::Open(const TitanCFOptions& options,
@@ -60,13 +120,27 @@ Status BlobFileReader::Open(const TitanCFOptions& options,
                             uint64_t file_size,
                             std::unique_ptr<BlobFileReader>* result,
                             TitanStats* stats) {
-  if (file_size < BlobFileFooter::kEncodedLength) {
+  if (file_size <
+      BlobFileHeader::kEncodedLength + BlobFileFooter::kEncodedLength) {
     return Status::Corruption("file is too short to be a blob file");
   }
 
+  FixedSlice<BlobFileHeader::kEncodedLength> header_buffer;
+  Status s = file->Read(0, BlobFileHeader::kEncodedLength, &header_buffer,
+                        header_buffer.get());
+  if (!s.ok()) {
+    return s;
+  }
+
+  BlobFileHeader header;
+  s = DecodeInto(header_buffer, &header);
+  if (!s.ok()) {
+    return s;
+  }
+
   FixedSlice<BlobFileFooter::kEncodedLength> buffer;
-  Status s = file->Read(file_size - BlobFileFooter::kEncodedLength,
-                        BlobFileFooter::kEncodedLength, &buffer, buffer.get());
+  s = file->Read(file_size - BlobFileFooter::kEncodedLength,
+                 BlobFileFooter::kEncodedLength, &buffer, buffer.get());
   if (!s.ok()) {
     return s;
   }
@@ -77,9 +151,35 @@ Status BlobFileReader::Open(const TitanCFOptions& options,
     return s;
   }
 
-  auto reader = new BlobFileReader(options, std::move(file), stats);
+  std::unique_ptr<BlobFileReader> reader(
+      new BlobFileReader(options, std::move(file), stats));
   reader->footer_ = footer;
-  result->reset(reader);
+  reader->version_ = header.version;
+  if (header.version == BlobFileHeader::kVersion2) {
+    OwnedSlice index;
+    s = reader->ReadBlockContents(footer.meta_index_handle,
+                                  UncompressionDict::GetEmptyDict(), &index);
+    if (s.ok()) {
+      s = DecodeInto(index, &reader->block_index_);
+    }
+    if (s.ok() && !reader->block_index_.dict_handle.IsNull()) {
+      OwnedSlice dict;
+      s = reader->ReadBlockContents(reader->block_index_.dict_handle,
+                                    UncompressionDict::GetEmptyDict(), &dict);
+      if (s.ok()) {
+        // The options may have changed since the file was written.
+        auto compression = reader->block_index_.compression;
+        bool using_zstd =
+            compression == kZSTD || compression == kZSTDNotFinalCompression;
+        reader->dict_.reset(
+            new UncompressionDict(dict.ToString(), using_zstd));
+      }
+    }
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  *result = std::move(reader);
   return Status::OK();
 }
 
@@ -100,6 +200,10 @@ Status BlobFileReader::Get(const ReadOptions& /*options*/,
                            PinnableSlice* buffer) {
   TEST_SYNC_POINT("BlobFileReader::Get");
 
+  if (version_ == BlobFileHeader::kVersion2) {
+    return GetFromBlock(handle, record, buffer);
+  }
+
   std::string cache_key;
   Cache::Handle* cache_handle = nullptr;
   if (cache_) {
@@ -128,7 +232,7 @@ Status BlobFileReader::Get(const ReadOptions& /*options*/,
     buffer->PinSlice(*cache_value, UnrefCacheHandle, cache_.get(),
                      cache_handle);
   } else {
-    buffer->PinSlice(blob, OwnedSlice::CleanupFunc, blob.release(), nullptr);
+    PinOwnedSlice(&blob, buffer);
   }
 
   return Status::OK();
@@ -137,11 +241,142 @@ Status BlobFileReader::Get(const ReadOptions& /*options*/,
 Status BlobFileReader::ReadRecord(const BlobHandle& handle, BlobRecord* record,
                                   OwnedSlice* buffer) {
   Slice blob;
-  CacheAllocationPtr ubuf(new char[handle.size]);
-  Status s = file_->Read(handle.offset, handle.size, &blob, ubuf.get());
+  CacheAllocationPtr ubuf;
+  Status s = Read(handle, &blob, &ubuf);
   if (!s.ok()) {
     return s;
   }
+  return DecodeRecord(handle, blob, std::move(ubuf), record, buffer);
+}
+
+Status BlobFileReader::Read(const BlobHandle& handle, Slice* blob,
+                            CacheAllocationPtr* buffer) {
+  TITAN_PERF_COUNTER_ADD(blob_read_count, 1);
+  TITAN_PERF_COUNTER_ADD(blob_read_byte, handle.size);
+  TITAN_PERF_TIMER_GUARD(blob_read_nanos);
+  if (file_->use_direct_io()) {
+    return ReadAligned(handle, blob, buffer);
+  }
+  buffer->reset(new char[handle.size]);
+  return file_->Read(handle.offset, handle.size, blob, buffer->get());
+}
+
+Status BlobFileReader::GetFromBlock(const BlobHandle& handle,
+                                    BlobRecord* record,
+                                    PinnableSlice* buffer) {
+  size_t i = block_index_.FindBlock(handle.offset);
+  if (i == block_index_.num_blocks() ||
+      handle.offset + handle.size > block_index_.raw_offsets[i + 1]) {
+    return Status::Corruption("Blob handle " + ToString(handle.offset) +
+                              " out of blocks");
+  }
+  Status s = ReadBlock(i, buffer);
+  if (!s.ok()) {
+    return s;
+  }
+  Slice blob(buffer->data() + handle.offset - block_index_.raw_offsets[i],
+             handle.size);
+  return DecodeInto(blob, record);
+}
+
+Status BlobFileReader::ReadBlock(size_t i, PinnableSlice* buffer) {
+  assert(i < block_index_.num_blocks());
+  buffer->Reset();
+  uint64_t offset = block_index_.file_offsets[i];
+
+  std::string cache_key;
+  Cache::Handle* cache_handle = nullptr;
+  if (cache_) {
+    EncodeBlobCache(&cache_key, cache_prefix_, offset);
+    cache_handle = cache_->Lookup(cache_key);
+    if (cache_handle) {
+      auto block = reinterpret_cast<OwnedSlice*>(cache_->Value(cache_handle));
+      buffer->PinSlice(*block, UnrefCacheHandle, cache_.get(), cache_handle);
+      return Status::OK();
+    }
+  }
+
+  OwnedSlice block;
+  Status s = ReadBlockContents(
+      BlockHandle(offset, block_index_.file_offsets[i + 1] - offset),
+      dict_ ? *dict_ : UncompressionDict::GetEmptyDict(), &block);
+  if (!s.ok()) {
+    return s;
+  }
+  uint64_t raw_size =
+      block_index_.raw_offsets[i + 1] - block_index_.raw_offsets[i];
+  if (block.size() != raw_size) {
+    return Status::Corruption(
+        "ReadBlock actual size: " + ToString(block.size()) +
+        " not equal to block size " + ToString(raw_size));
+  }
+
+  if (cache_) {
+    auto cache_value = new OwnedSlice(std::move(block));
+    auto cache_size = cache_value->size() + sizeof(*cache_value);
+    cache_->Insert(cache_key, cache_value, cache_size,
+                   &DeleteCacheValue<OwnedSlice>, &cache_handle);
+    buffer->PinSlice(*cache_value, UnrefCacheHandle, cache_.get(),
+                     cache_handle);
+  } else {
+    PinOwnedSlice(&block, buffer);
+  }
+  return Status::OK();
+}
+
+Status BlobFileReader::ReadBlockContents(const BlockHandle& handle,
+                                         const UncompressionDict& dict,
+                                         OwnedSlice* contents) {
+  BlobHandle blob_handle;
+  blob_handle.offset = handle.offset();
+  blob_handle.size = handle.size();
+  Slice blob;
+  CacheAllocationPtr ubuf;
+  Status s = Read(blob_handle, &blob, &ubuf);
+  if (!s.ok()) {
+    return s;
+  }
+  if (blob.size() != handle.size()) {
+    return Status::Corruption(
+        "ReadBlock actual size: " + ToString(blob.size()) +
+        " not equal to stored size " + ToString(handle.size()));
+  }
+  return DecodeBlobBlock(blob, dict, std::move(ubuf), contents);
+}
+
+Status BlobFileReader::ReadAligned(const BlobHandle& handle, Slice* blob,
+                                   CacheAllocationPtr* buffer) {
+  auto pool = DirectIOBufferPool();
+  size_t alignment = file_->file()->GetRequiredBufferAlignment();
+  assert(pool->alignment() % alignment == 0);
+  size_t aligned_offset = TruncateToPageBoundary(alignment, handle.offset);
+  size_t read_size =
+      Roundup(handle.offset + handle.size, alignment) - aligned_offset;
+  CacheAllocationPtr ubuf(reinterpret_cast<char*>(pool->Allocate(read_size)),
+                          pool);
+
+  // Whole pages into an aligned buffer are read by the file reader without
+  // a bounce buffer, and still counted by its stats and histograms.
+  Slice result;
+  Status s = file_->Read(aligned_offset, read_size, &result, ubuf.get());
+  if (!s.ok()) {
+    return s;
+  }
+  size_t advance = handle.offset - aligned_offset;
+  if (result.size() < advance) {
+    *blob = Slice();
+  } else {
+    *blob = Slice(result.data() + advance,
+                  std::min<size_t>(result.size() - advance, handle.size));
+  }
+  *buffer = std::move(ubuf);
+  return s;
+}
+
+Status BlobFileReader::DecodeRecord(const BlobHandle& handle, Slice blob,
+                                    CacheAllocationPtr ubuf,
+                                    BlobRecord* record, OwnedSlice* buffer) {
+  Status s;
   if (handle.size != static_cast<uint64_t>(blob.size())) {
     return Status::Corruption(
         "ReadRecord actual size: " + ToString(blob.size()) +
@@ -158,7 +393,25 @@ Status BlobFileReader::ReadRecord(const BlobHandle& handle, BlobRecord* record,
   return s;
 }
 
+BlobFilePrefetcher::BlobFilePrefetcher(BlobFileReader* reader, bool ov)
+    : reader_(reader), only_value_(ov) {
+  if (reader_->file_->use_direct_io()) {
+    prefetch_buffer_.reset(new FilePrefetchBuffer(
+        reader_->file_.get(), kDefaultPageSize, kMaxReadaheadSize));
+  }
+}
+
 void BlobFilePrefetcher::Prefetch(const BlobHandle& handle){
+  if (reader_->version_ == BlobFileHeader::kVersion2) {
+    const auto& index = reader_->block_index_;
+    size_t i = index.FindBlock(handle.offset);
+    if (i < index.num_blocks()) {
+      reader_->file_->Prefetch(
+          index.file_offsets[i],
+          index.file_offsets[i + 1] - index.file_offsets[i]);
+    }
+    return;
+  }
   reader_->file_->Prefetch(handle.offset, handle.size);
 }
 
@@ -177,7 +430,27 @@ Status BlobFilePrefetcher::Get(const ReadOptions& options,
     record->only_value = true;
   else
     record->only_value = false;
-  if (handle.offset == last_offset_) {
+  if (reader_->version_ == BlobFileHeader::kVersion2) {
+    return GetFromBlock(handle, record, buffer);
+  }
+  if (prefetch_buffer_ && handle.offset == last_offset_) {
+    last_offset_ = handle.offset + handle.size;
+    Slice blob;
+    if (prefetch_buffer_->TryReadFromCache(handle.offset, handle.size,
+                                           &blob)) {
+      // The prefetch buffer is reused by the next read, take a copy.
+      CacheAllocationPtr ubuf(new char[handle.size]);
+      memcpy(ubuf.get(), blob.data(), handle.size);
+      OwnedSlice owned;
+      Status s = reader_->DecodeRecord(
+          handle, Slice(ubuf.get(), handle.size), std::move(ubuf), record,
+          &owned);
+      if (s.ok()) {
+        PinOwnedSlice(&owned, buffer);
+      }
+      return s;
+    }
+  } else if (handle.offset == last_offset_) {
     last_offset_ = handle.offset + handle.size;
     if (handle.offset + handle.size > readahead_limit_) {
       readahead_size_ = std::max(handle.size, readahead_size_);
@@ -194,5 +467,43 @@ Status BlobFilePrefetcher::Get(const ReadOptions& options,
   return reader_->Get(options, handle, record, buffer);
 }
 
+Status BlobFilePrefetcher::GetFromBlock(const BlobHandle& handle,
+                                        BlobRecord* record,
+                                        PinnableSlice* buffer) {
+  const auto& index = reader_->block_index_;
+  size_t i = index.FindBlock(handle.offset);
+  if (i == index.num_blocks() ||
+      handle.offset + handle.size > index.raw_offsets[i + 1]) {
+    return Status::Corruption("Blob handle " + ToString(handle.offset) +
+                              " out of blocks");
+  }
+  if (i != last_block_) {
+    uint64_t block_end = index.file_offsets[i + 1];
+    if (i == last_block_ + 1 && !reader_->file_->use_direct_io()) {
+      if (block_end > readahead_limit_) {
+        uint64_t block_size = block_end - index.file_offsets[i];
+        readahead_size_ = std::max(block_size, readahead_size_);
+        reader_->file_->Prefetch(index.file_offsets[i], readahead_size_);
+        readahead_limit_ = index.file_offsets[i] + readahead_size_;
+        readahead_size_ = std::min(kMaxReadaheadSize, readahead_size_ * 2);
+      }
+    } else {
+      readahead_size_ = 0;
+      readahead_limit_ = 0;
+    }
+    last_block_ = port::kMaxSizet;
+    Status s = reader_->ReadBlock(i, &block_);
+    if (!s.ok()) {
+      return s;
+    }
+    last_block_ = i;
+  }
+  // The block is reused by the next reads, take a copy.
+  buffer->Reset();
+  buffer->PinSelf(Slice(block_.data() + handle.offset - index.raw_offsets[i],
+                        handle.size));
+  return DecodeInto(*buffer, record);
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
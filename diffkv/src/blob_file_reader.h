@@ -10,9 +10,17 @@ namespace titandb {
 
 Status NewBlobFileReader(uint64_t file_number, uint64_t readahead_size,
                          const TitanDBOptions& db_options,
+                         const TitanCFOptions& cf_options,
                          const EnvOptions& env_options, Env* env,
                          std::unique_ptr<RandomAccessFileReader>* result);
 
+// Checks that the blob file has the expected size and a valid header and
+// footer, without opening a reader for it.
+Status VerifyBlobFile(uint64_t file_number, uint64_t file_size,
+                      const TitanDBOptions& db_options,
+                      const TitanCFOptions& cf_options,
+                      const EnvOptions& env_options, Env* env);
+
 class BlobFileReader {
  public:
   // Opens a blob file and read the necessary metadata from it.
@@ -39,6 +47,35 @@ class BlobFileReader {
   Status ReadRecord(const BlobHandle& handle, BlobRecord* record,
                     OwnedSlice* buffer);
 
+  // Reads "handle.size" bytes at "handle.offset" of the file into
+  // "*buffer", and sets "*blob" to them.
+  Status Read(const BlobHandle& handle, Slice* blob,
+              CacheAllocationPtr* buffer);
+
+  // Gets the record of a version 2 file from its block.
+  Status GetFromBlock(const BlobHandle& handle, BlobRecord* record,
+                      PinnableSlice* buffer);
+
+  // Reads the uncompressed contents of block "i" of a version 2 file
+  // into "*buffer", through the blob cache.
+  Status ReadBlock(size_t i, PinnableSlice* buffer);
+
+  // Reads the block at "handle" and uncompresses it with "dict".
+  Status ReadBlockContents(const BlockHandle& handle,
+                           const UncompressionDict& dict,
+                           OwnedSlice* contents);
+
+  // Reads the record with a direct I/O read into a pooled aligned buffer.
+  // Sets "*blob" to the record within "*buffer".
+  Status ReadAligned(const BlobHandle& handle, Slice* blob,
+                     CacheAllocationPtr* buffer);
+
+  // Decodes the record "blob" read from "handle", which is stored in
+  // "ubuf". The ownership of "ubuf" is passed to "*buffer".
+  Status DecodeRecord(const BlobHandle& handle, Slice blob,
+                      CacheAllocationPtr ubuf, BlobRecord* record,
+                      OwnedSlice* buffer);
+
   TitanCFOptions options_;
   std::unique_ptr<RandomAccessFileReader> file_;
 
@@ -47,6 +84,10 @@ class BlobFileReader {
 
   // Information read from the file.
   BlobFileFooter footer_;
+  uint32_t version_{BlobFileHeader::kVersion1};
+  // Only set for version 2 files.
+  BlobBlockIndex block_index_;
+  std::unique_ptr<UncompressionDict> dict_;
 
   TitanStats* stats_;
 };
@@ -56,8 +97,7 @@ class BlobFilePrefetcher : public Cleanable {
  public:
   // Constructs a prefetcher with the blob file reader.
   // "*reader" must be valid when the prefetcher is used.
-  BlobFilePrefetcher(BlobFileReader* reader, bool ov = false)
-      : reader_(reader), only_value_(ov) {}
+  BlobFilePrefetcher(BlobFileReader* reader, bool ov = false);
 
   Status Get(const ReadOptions& options, const BlobHandle& handle,
              BlobRecord* record, PinnableSlice* buffer);
@@ -67,11 +107,22 @@ class BlobFilePrefetcher : public Cleanable {
   Status PointGet(const ReadOptions& options, const BlobHandle& handle, BlobRecord* record, PinnableSlice* buffer);
 
  private:
+  // Gets the record of a version 2 file from the last block read, or
+  // reads its block with readahead on continuous blocks.
+  Status GetFromBlock(const BlobHandle& handle, BlobRecord* record,
+                      PinnableSlice* buffer);
+
   BlobFileReader* reader_;
   uint64_t last_offset_{0};
   uint64_t readahead_size_{0};
   uint64_t readahead_limit_{0};
   bool only_value_{false};
+  // Readahead with direct I/O can't rely on the page cache, so continuous
+  // reads are served from this buffer instead. Only set with direct I/O.
+  std::unique_ptr<FilePrefetchBuffer> prefetch_buffer_;
+  // The last block read of a version 2 file.
+  size_t last_block_{port::kMaxSizet};
+  PinnableSlice block_;
 };
 
 }  // namespace titandb
@@ -2,7 +2,9 @@
 
 #include <inttypes.h>
 
+#include "blob_file_reader.h"
 #include "edit_collector.h"
+#include "port/port.h"
 
 namespace rocksdb {
 namespace titandb {
@@ -20,6 +22,10 @@ BlobFileSet::BlobFileSet(const TitanDBOptions& options, TitanStats* stats)
     file_cache_size = kMaxFileCacheSize;
   }
   file_cache_ = NewLRUCache(file_cache_size);
+  if (db_options_.blob_read_queue_depth > 0) {
+    read_pool_ = std::make_shared<ThreadPool>(
+        static_cast<int>(db_options_.blob_read_queue_depth));
+  }
 }
 
 Status BlobFileSet::Open(
@@ -94,6 +100,11 @@ Status BlobFileSet::Recover() {
                    "Next blob file number is %" PRIu64 ".", next_file_number);
   }
 
+  if (db_options_.verify_blob_files_on_open) {
+    s = VerifyBlobFiles();
+    if (!s.ok()) return s;
+  }
+
   // Make sure perform gc on all files at the beginning
   MarkAllFilesForGC();
   for (auto& cf : column_families_) {
@@ -107,7 +118,11 @@ Status BlobFileSet::Recover() {
   // Purge inactive files at start
   std::set<uint64_t> alive_files;
   alive_files.insert(new_manifest_file_number);
+  std::set<std::string> blob_dirs;
   for (const auto& bs : column_families_) {
+    for (const auto& dir : bs.second->cf_options().blob_dirs) {
+      blob_dirs.insert(dir);
+    }
     std::string files_str;
     for (const auto& f : bs.second->files_) {
       if (!files_str.empty()) {
@@ -142,6 +157,26 @@ Status BlobFileSet::Recover() {
                    "Titan recovery delete obsolete file %s.", f.c_str());
     env_->DeleteFile(dirname_ + "/" + f);
   }
+  // Column families with blob directories of their own only keep blob
+  // files there.
+  blob_dirs.erase(dirname_);
+  for (const auto& dir : blob_dirs) {
+    files.clear();
+    env_->GetChildren(dir, &files);
+    for (const auto& f : files) {
+      uint64_t file_number;
+      FileType file_type;
+      if (!ParseFileName(f, &file_number, &file_type) ||
+          file_type != FileType::kBlobFile ||
+          alive_files.find(file_number) != alive_files.end()) {
+        continue;
+      }
+      ROCKS_LOG_INFO(db_options_.info_log,
+                     "Titan recovery delete obsolete file %s/%s.", dir.c_str(),
+                     f.c_str());
+      env_->DeleteFile(dir + "/" + f);
+    }
+  }
 
   return Status::OK();
 }
@@ -158,13 +193,15 @@ Status BlobFileSet::OpenManifest(uint64_t file_number) {
     file.reset(new WritableFileWriter(std::move(f), file_name, env_options_));
   }
 
-  manifest_.reset(new log::Writer(std::move(file), 0, false));
+  // The current manifest, if any, is kept until the new one is ready.
+  std::unique_ptr<log::Writer> manifest(
+      new log::Writer(std::move(file), 0, false));
 
   // Saves current snapshot
-  s = WriteSnapshot(manifest_.get());
+  s = WriteSnapshot(manifest.get());
   if (s.ok()) {
     ImmutableDBOptions ioptions(db_options_);
-    s = SyncTitanManifest(env_, stats_, &ioptions, manifest_->file());
+    s = SyncTitanManifest(env_, stats_, &ioptions, manifest->file());
   }
   if (s.ok()) {
     // Makes "CURRENT" file that points to the new manifest file.
@@ -172,12 +209,92 @@ Status BlobFileSet::OpenManifest(uint64_t file_number) {
   }
 
   if (!s.ok()) {
-    manifest_.reset();
     obsolete_manifests_.emplace_back(file_name);
+    return s;
+  }
+  manifest_snapshot_size_ = manifest->file()->GetFileSize();
+  manifest_ = std::move(manifest);
+  return s;
+}
+
+Status BlobFileSet::MaybeRollManifest() {
+  uint64_t max_size = db_options_.titan_max_manifest_file_size;
+  if (max_size == 0 ||
+      manifest_->file()->GetFileSize() <=
+          std::max(max_size, 2 * manifest_snapshot_size_)) {
+    return Status::OK();
+  }
+  std::string old_manifest = manifest_->file()->file_name();
+  uint64_t old_size = manifest_->file()->GetFileSize();
+  Status s = OpenManifest(NewFileNumber());
+  if (!s.ok()) {
+    ROCKS_LOG_WARN(db_options_.info_log,
+                   "Titan failed to roll manifest %s: %s",
+                   old_manifest.c_str(), s.ToString().c_str());
+    return s;
   }
+  ROCKS_LOG_INFO(db_options_.info_log,
+                 "Titan rolled manifest %s of %" PRIu64
+                 " bytes to a snapshot of %" PRIu64 " bytes.",
+                 old_manifest.c_str(), old_size, manifest_snapshot_size_);
+  obsolete_manifests_.emplace_back(old_manifest);
   return s;
 }
 
+Status BlobFileSet::VerifyBlobFiles() {
+  std::vector<std::shared_ptr<BlobFileMeta>> files;
+  std::vector<const TitanCFOptions*> files_cf_options;
+  for (auto& cf : column_families_) {
+    for (auto& file : cf.second->files_) {
+      if (!file.second->is_obsolete()) {
+        files.push_back(file.second);
+        files_cf_options.push_back(&cf.second->cf_options());
+      }
+    }
+  }
+  if (files.empty()) {
+    return Status::OK();
+  }
+  size_t num_threads = std::min(
+      files.size(),
+      static_cast<size_t>(std::max(db_options_.max_file_opening_threads, 1)));
+  uint64_t start = env_->NowMicros();
+  std::atomic<size_t> next_file{0};
+  std::vector<Status> statuses(num_threads);
+  auto verify = [&](size_t i) {
+    size_t f;
+    while (statuses[i].ok() &&
+           (f = next_file.fetch_add(1, std::memory_order_relaxed)) <
+               files.size()) {
+      statuses[i] =
+          VerifyBlobFile(files[f]->file_number(), files[f]->file_size(),
+                         db_options_, *files_cf_options[f], env_options_, env_);
+    }
+  };
+  std::vector<port::Thread> threads;
+  for (size_t i = 1; i < num_threads; i++) {
+    threads.emplace_back(verify, i);
+  }
+  verify(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& s : statuses) {
+    if (!s.ok()) {
+      ROCKS_LOG_ERROR(db_options_.info_log,
+                      "Titan failed to verify blob files: %s",
+                      s.ToString().c_str());
+      return s;
+    }
+  }
+  ROCKS_LOG_INFO(db_options_.info_log,
+                 "Titan verified %" ROCKSDB_PRIszt
+                 " blob files with %" ROCKSDB_PRIszt " threads in %" PRIu64
+                 " us.",
+                 files.size(), num_threads, env_->NowMicros() - start);
+  return Status::OK();
+}
+
 Status BlobFileSet::WriteSnapshot(log::Writer* log) {
   Status s;
   // Saves global information
@@ -226,14 +343,19 @@ Status BlobFileSet::LogAndApply(VersionEdit& edit) {
   ImmutableDBOptions ioptions(db_options_);
   s = SyncTitanManifest(env_, stats_, &ioptions, manifest_->file());
   if (!s.ok()) return s;
-  return collector.Apply(*this);
+  s = collector.Apply(*this);
+  if (!s.ok()) return s;
+  // The edit is already persisted, so failing to roll the manifest only
+  // leaves it growing.
+  MaybeRollManifest();
+  return s;
 }
 
 void BlobFileSet::AddColumnFamilies(
     const std::map<uint32_t, TitanCFOptions>& column_families) {
   for (auto& cf : column_families) {
-    auto file_cache = std::make_shared<BlobFileCache>(db_options_, cf.second,
-                                                      file_cache_, stats_);
+    auto file_cache = std::make_shared<BlobFileCache>(
+        db_options_, cf.second, file_cache_, stats_, read_pool_);
     auto blob_storage = std::make_shared<BlobStorage>(
         db_options_, cf.second, cf.first, file_cache, stats_);
     column_families_.emplace(cf.first, blob_storage);
@@ -101,13 +101,22 @@ class BlobFileSet {
 
   Status OpenManifest(uint64_t number);
 
+  // Rewrites the manifest as a snapshot if it has grown too large.
+  Status MaybeRollManifest();
+
   Status WriteSnapshot(log::Writer* log);
 
+  // Checks all the live blob files in parallel.
+  Status VerifyBlobFiles();
+
   std::string dirname_;
   Env* env_;
   EnvOptions env_options_;
   TitanDBOptions db_options_;
   std::shared_ptr<Cache> file_cache_;
+  // Issues the batched blob reads of all column families, only set with
+  // blob_read_queue_depth.
+  std::shared_ptr<ThreadPool> read_pool_;
 
   TitanStats* stats_;
 
@@ -123,6 +132,8 @@ class BlobFileSet {
 
   std::unordered_map<uint32_t, std::shared_ptr<BlobStorage>> column_families_;
   std::unique_ptr<log::Writer> manifest_;
+  // Size of the snapshot the current manifest starts with.
+  uint64_t manifest_snapshot_size_{0};
   std::atomic<uint64_t> next_file_number_{1};
 };
 
@@ -4,6 +4,7 @@
 #include "blob_file_builder.h"
 #include "blob_file_cache.h"
 #include "blob_file_reader.h"
+#include "titan/perf_context.h"
 
 #include <cinttypes>
 
@@ -126,7 +127,8 @@ class BlobFileTest : public testing::Test {
 
     ReadOptions ro;
     std::unique_ptr<RandomAccessFileReader> random_access_file_reader;
-    ASSERT_OK(NewBlobFileReader(file_number_, 0, db_options, env_options_, env_,
+    ASSERT_OK(NewBlobFileReader(file_number_, 0, db_options, cf_options,
+                                env_options_, env_,
                                 &random_access_file_reader));
     std::unique_ptr<BlobFileReader> blob_file_reader;
     ASSERT_OK(BlobFileReader::Open(cf_options,
@@ -156,6 +158,67 @@ class BlobFileTest : public testing::Test {
     }
   }
 
+  void TestMultiGet(TitanOptions options,
+                    std::shared_ptr<ThreadPool> read_pool) {
+    options.dirname = dirname_;
+    TitanDBOptions db_options(options);
+    TitanCFOptions cf_options(options);
+    BlobFileCache cache(db_options, cf_options, {NewLRUCache(128)}, nullptr,
+                        read_pool);
+
+    const int n = 100;
+    std::vector<BlobHandle> handles(n);
+
+    std::unique_ptr<WritableFileWriter> file;
+    {
+      std::unique_ptr<WritableFile> f;
+      ASSERT_OK(env_->NewWritableFile(file_name_, &f, env_options_));
+      file.reset(
+          new WritableFileWriter(std::move(f), file_name_, env_options_));
+    }
+    std::unique_ptr<BlobFileBuilder> builder(
+        new BlobFileBuilder(db_options, cf_options, file.get()));
+    for (int i = 0; i < n; i++) {
+      auto key = GenKey(i);
+      auto value = GenValue(i);
+      BlobRecord record;
+      record.key = key;
+      record.value = value;
+      builder->Add(record, &handles[i]);
+      ASSERT_OK(builder->status());
+    }
+    ASSERT_OK(builder->Finish());
+
+    uint64_t file_size = 0;
+    ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
+
+    // Requests are passed out of order, and the last one points to a file
+    // that doesn't exist.
+    std::vector<BlobRecord> records(n + 1);
+    std::vector<PinnableSlice> buffers(n + 1);
+    std::vector<BlobReadRequest> requests(n + 1);
+    std::vector<BlobReadRequest*> batch;
+    for (int i = 0; i <= n; i++) {
+      requests[i].file_number = i < n ? file_number_ : file_number_ + 1;
+      requests[i].file_size = file_size;
+      requests[i].handle = handles[i < n ? n - 1 - i : 0];
+      requests[i].record = &records[i];
+      requests[i].buffer = &buffers[i];
+      batch.push_back(&requests[i]);
+    }
+    cache.MultiGet(ReadOptions(), &batch);
+    for (int i = 0; i < n; i++) {
+      ASSERT_OK(requests[i].status);
+      auto key = GenKey(n - 1 - i);
+      auto value = GenValue(n - 1 - i);
+      BlobRecord expect;
+      expect.key = key;
+      expect.value = value;
+      ASSERT_EQ(records[i], expect);
+    }
+    ASSERT_FALSE(requests[n].status.ok());
+  }
+
   Env* env_{Env::Default()};
   EnvOptions env_options_;
   std::string dirname_;
@@ -168,6 +231,8 @@ TEST_F(BlobFileTest, BlobFileReader) {
   TestBlobFileReader(options);
   options.blob_file_compression = kLZ4Compression;
   TestBlobFileReader(options);
+  options.blob_file_use_direct_io = true;
+  TestBlobFileReader(options);
 }
 
 TEST_F(BlobFileTest, BlobFilePrefetcher) {
@@ -179,6 +244,73 @@ TEST_F(BlobFileTest, BlobFilePrefetcher) {
   TestBlobFilePrefetcher(options);
 }
 
+TEST_F(BlobFileTest, PerfContext) {
+  TitanOptions options;
+  options.dirname = dirname_;
+  options.blob_file_compression = kLZ4Compression;
+  TitanDBOptions db_options(options);
+  TitanCFOptions cf_options(options);
+  BlobFileCache cache(db_options, cf_options, {NewLRUCache(128)}, nullptr);
+
+  std::unique_ptr<WritableFileWriter> file;
+  {
+    std::unique_ptr<WritableFile> f;
+    ASSERT_OK(env_->NewWritableFile(file_name_, &f, env_options_));
+    file.reset(new WritableFileWriter(std::move(f), file_name_, env_options_));
+  }
+  BlobFileBuilder builder(db_options, cf_options, file.get());
+  std::string key = GenKey(1);
+  std::string value = GenValue(1);
+  BlobRecord expect;
+  expect.key = key;
+  expect.value = value;
+  BlobHandle handle;
+  builder.Add(expect, &handle);
+  ASSERT_OK(builder.Finish());
+  uint64_t file_size = 0;
+  ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
+
+  auto* perf_context = get_titan_perf_context();
+  SetPerfLevel(PerfLevel::kEnableTimeExceptForMutex);
+  perf_context->Reset();
+  BlobRecord record;
+  PinnableSlice buffer;
+  ASSERT_OK(cache.Get(ReadOptions(), file_number_, file_size, handle, &record,
+                      &buffer));
+  ASSERT_EQ(record, expect);
+  ASSERT_EQ(perf_context->blob_file_open_count, 1);
+  ASSERT_GT(perf_context->blob_file_open_nanos, 0);
+  ASSERT_GE(perf_context->blob_read_count, 1);
+  ASSERT_GE(perf_context->blob_read_byte, handle.size);
+  ASSERT_GT(perf_context->blob_read_nanos, 0);
+  if (LZ4_Supported()) {
+    ASSERT_GT(perf_context->blob_decompress_nanos, 0);
+  }
+
+  // Counters keep being updated at the default level, timers don't.
+  SetPerfLevel(PerfLevel::kEnableCount);
+  perf_context->Reset();
+  buffer.Reset();
+  ASSERT_OK(cache.Get(ReadOptions(), file_number_, file_size, handle, &record,
+                      &buffer));
+  ASSERT_EQ(perf_context->blob_file_open_count, 0);
+  ASSERT_EQ(perf_context->blob_read_count, 1);
+  ASSERT_EQ(perf_context->blob_read_nanos, 0);
+  ASSERT_EQ(perf_context->blob_decompress_nanos, 0);
+  ASSERT_EQ(perf_context->ToString(true),
+            "blob_read_count = 1, blob_read_byte = " +
+                ToString(handle.size));
+}
+
+TEST_F(BlobFileTest, MultiGet) {
+  TitanOptions options;
+  TestMultiGet(options, nullptr);
+  TestMultiGet(options, std::make_shared<ThreadPool>(4));
+  options.blob_cache = NewLRUCache(1 << 20);
+  options.blob_file_compression = kLZ4Compression;
+  TestMultiGet(options, std::make_shared<ThreadPool>(4));
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
 
@@ -1,5 +1,7 @@
 #include "blob_format.h"
 
+#include <algorithm>
+
 #include "test_util/sync_point.h"
 #include "util/crc32c.h"
 
@@ -17,6 +19,10 @@ bool GetChar(Slice* src, unsigned char* value) {
 
 }  // namespace
 
+const uint32_t BlobFileHeader::kVersion1;
+const uint32_t BlobFileHeader::kVersion2;
+const uint64_t BlobFileHeader::kEncodedLength;
+
 void BlobRecord::EncodeTo(std::string* dst) const {
   if (only_value) {
     dst->append(value.data(), value.size());
@@ -99,6 +105,126 @@ Status BlobDecoder::DecodeRecord(Slice* src, BlobRecord* record,
   return DecodeInto(*buffer, record);
 }
 
+void EncodeBlobBlock(const Slice& contents, CompressionType type,
+                     std::string* dst) {
+  size_t start = dst->size();
+  dst->append(contents.data(), contents.size());
+  dst->push_back(type);
+  uint32_t crc = crc32c::Value(dst->data() + start, dst->size() - start);
+  PutFixed32(dst, crc);
+}
+
+Status DecodeBlobBlock(const Slice& src, const UncompressionDict& dict,
+                       CacheAllocationPtr buffer, OwnedSlice* contents) {
+  if (src.size() < kBlobBlockTrailerSize) {
+    return Status::Corruption("BlobBlock", "too short");
+  }
+  size_t size = src.size() - kBlobBlockTrailerSize;
+  uint32_t crc = DecodeFixed32(src.data() + size + 1);
+  if (crc32c::Value(src.data(), size + 1) != crc) {
+    return Status::Corruption("BlobBlock", "checksum mismatch");
+  }
+  auto compression = static_cast<CompressionType>(src[size]);
+  Slice input(src.data(), size);
+  if (compression == kNoCompression) {
+    contents->reset(std::move(buffer), input);
+    return Status::OK();
+  }
+  UncompressionContext ctx(compression);
+  UncompressionInfo info(ctx, dict, compression);
+  return Uncompress(info, input, contents);
+}
+
+void BlobBlockEncoder::SetDictionary(std::string dict) {
+  // The info refers to the dictionary, so it goes first.
+  compression_info_.reset();
+  dict_.reset(new CompressionDict(std::move(dict), compression_,
+                                  compression_opt_.level));
+  compression_info_.reset(new CompressionInfo(compression_opt_,
+                                              compression_ctx_, *dict_,
+                                              compression_,
+                                              0 /*sample_for_compression*/));
+}
+
+void BlobBlockEncoder::EncodeBlock(const Slice& contents, std::string* dst) {
+  compressed_buffer_.clear();
+  CompressionType compression;
+  Slice output =
+      Compress(*compression_info_, contents, &compressed_buffer_, &compression);
+  EncodeBlobBlock(output, compression, dst);
+}
+
+void BlobBlockIndex::Clear() {
+  dict_handle = BlockHandle::NullBlockHandle();
+  compression = kNoCompression;
+  file_offsets.assign(1, BlobFileHeader::kEncodedLength);
+  raw_offsets.assign(1, 0);
+}
+
+void BlobBlockIndex::AddBlock(uint64_t stored_size, uint64_t raw_size) {
+  file_offsets.push_back(file_offsets.back() + stored_size);
+  raw_offsets.push_back(raw_offsets.back() + raw_size);
+}
+
+size_t BlobBlockIndex::FindBlock(uint64_t raw_offset) const {
+  auto it =
+      std::upper_bound(raw_offsets.begin(), raw_offsets.end(), raw_offset);
+  if (it == raw_offsets.begin() || it == raw_offsets.end()) {
+    return num_blocks();
+  }
+  return static_cast<size_t>(it - raw_offsets.begin()) - 1;
+}
+
+size_t BlobBlockIndex::FindBlockByFileOffset(uint64_t file_offset) const {
+  auto it =
+      std::upper_bound(file_offsets.begin(), file_offsets.end(), file_offset);
+  if (it == file_offsets.begin() || it == file_offsets.end()) {
+    return num_blocks();
+  }
+  return static_cast<size_t>(it - file_offsets.begin()) - 1;
+}
+
+void BlobBlockIndex::EncodeTo(std::string* dst) const {
+  dict_handle.EncodeTo(dst);
+  dst->push_back(compression);
+  PutVarint64(dst, num_blocks());
+  for (size_t i = 0; i < num_blocks(); i++) {
+    PutVarint64(dst, file_offsets[i + 1] - file_offsets[i]);
+    PutVarint64(dst, raw_offsets[i + 1] - raw_offsets[i]);
+  }
+}
+
+Status BlobBlockIndex::DecodeFrom(Slice* src) {
+  Clear();
+  Status s = dict_handle.DecodeFrom(src);
+  if (!s.ok()) {
+    return Status::Corruption("BlobBlockIndex", s.ToString());
+  }
+  unsigned char type;
+  uint64_t num_blocks = 0;
+  if (!GetChar(src, &type) || !GetVarint64(src, &num_blocks)) {
+    return Status::Corruption("BlobBlockIndex");
+  }
+  compression = static_cast<CompressionType>(type);
+  for (uint64_t i = 0; i < num_blocks; i++) {
+    uint64_t stored_size = 0;
+    uint64_t raw_size = 0;
+    if (!GetVarint64(src, &stored_size) || !GetVarint64(src, &raw_size)) {
+      return Status::Corruption("BlobBlockIndex");
+    }
+    AddBlock(stored_size, raw_size);
+  }
+  return Status::OK();
+}
+
+bool operator==(const BlobBlockIndex& lhs, const BlobBlockIndex& rhs) {
+  return (lhs.dict_handle.offset() == rhs.dict_handle.offset() &&
+          lhs.dict_handle.size() == rhs.dict_handle.size() &&
+          lhs.compression == rhs.compression &&
+          lhs.file_offsets == rhs.file_offsets &&
+          lhs.raw_offsets == rhs.raw_offsets);
+}
+
 void BlobHandle::EncodeTo(std::string* dst) const {
   PutVarint64(dst, offset);
   PutVarint64(dst, size);
@@ -250,14 +376,21 @@ void BlobFileMeta::FileStateTransit(const FileEvent& event) {
   }
 }
 
-void BlobFileMeta::AddDiscardableSize(uint64_t _discardable_size) {
-  assert(_discardable_size < file_size_);
-  discardable_size_ += _discardable_size;
-  assert(discardable_size_ < file_size_);
+uint64_t BlobFileMeta::AddDiscardableSize(uint64_t _discardable_size) {
+  // Blob handles of version 2 files refer to the uncompressed records,
+  // which may take more bytes than the file.
+  uint64_t old_size = discardable_size_.load(std::memory_order_relaxed);
+  while (!discardable_size_.compare_exchange_weak(
+      old_size, std::min(old_size + _discardable_size, file_size_),
+      std::memory_order_relaxed)) {
+  }
+  return old_size;
 }
 
-TitanInternalStats::StatsType BlobFileMeta::GetDiscardableRatioLevel() const {
-  auto ratio = GetDiscardableRatio();
+TitanInternalStats::StatsType BlobFileMeta::GetDiscardableRatioLevel(
+    uint64_t _discardable_size) const {
+  auto ratio = static_cast<double>(_discardable_size) /
+               static_cast<double>(file_size_);
   TitanInternalStats::StatsType type;
   if (ratio == 0) {
     type = TitanInternalStats::NUM_DISCARDABLE_RATIO_LE0;
@@ -275,7 +408,7 @@ TitanInternalStats::StatsType BlobFileMeta::GetDiscardableRatioLevel() const {
     fprintf(stderr,
             "invalid discardable ratio %.2f, file type %d, file number %lu, "
             "file size %lu, discardable size %lu\n",
-            ratio, file_type_, file_number_, file_size_, discardable_size_);
+            ratio, file_type_, file_number_, file_size_, _discardable_size);
             */
     type = TitanInternalStats::NUM_DISCARDABLE_RATIO_LE100;
   }
@@ -283,7 +416,7 @@ TitanInternalStats::StatsType BlobFileMeta::GetDiscardableRatioLevel() const {
 }
 
 double BlobFileMeta::GetDiscardableRatio() const {
-  return static_cast<double>(discardable_size_) /
+  return static_cast<double>(discardable_size()) /
          static_cast<double>(file_size_);
 }
 
@@ -298,7 +431,8 @@ Status BlobFileHeader::DecodeFrom(Slice* src) {
     return Status::Corruption(
         "Blob file header magic number missing or mismatched.");
   }
-  if (!GetFixed32(src, &version) || version != kVersion1) {
+  if (!GetFixed32(src, &version) ||
+      (version != kVersion1 && version != kVersion2)) {
     return Status::Corruption("Blob file header version missing or invalid.");
   }
   return Status::OK();
@@ -18,6 +18,17 @@ namespace titandb {
 // ...
 // [record head + record N]
 // [blob file footer]
+//
+// Version 2 blob file overall format:
+//
+// [blob file header]
+// [blob block 1]
+// [blob block 2]
+// ...
+// [blob block N]
+// [dictionary block] (optional)
+// [block index block]
+// [blob file footer]
 
 // Format of blob head (9 bytes):
 //
@@ -93,6 +104,105 @@ class BlobDecoder {
   CompressionType compression_{kNoCompression};
 };
 
+// Format of blob block, only in version 2 blob files (not fixed size):
+//
+//    +----------+-------------+---------+
+//    | contents | compression |   crc   |
+//    +----------+-------------+---------+
+//    |          |    char     | Fixed32 |
+//    +----------+-------------+---------+
+//
+// The crc covers the contents and the compression type. Uncompressed,
+// the contents of a data block are records prefixed with their length:
+//
+//    +----------+----------+----------+----------+-----+
+//    |  length  | record 1 |  length  | record 2 | ... |
+//    +----------+----------+----------+----------+-----+
+//    | Varint32 |          | Varint32 |          |     |
+//    +----------+----------+----------+----------+-----+
+//
+// The dictionary and the block index are stored as uncompressed blocks.
+const uint64_t kBlobBlockTrailerSize = 5;
+const uint64_t kMinBlobBlockSize = 4 << 10;
+const uint64_t kMaxBlobBlockSize = 64 << 10;
+
+// Appends the block with "contents", which are compressed by "type", to
+// "*dst".
+void EncodeBlobBlock(const Slice &contents, CompressionType type,
+                     std::string *dst);
+
+// Verifies the block "src" and sets "*contents" to its uncompressed
+// contents. "src" is stored in "buffer", whose ownership is passed to
+// "*contents" if the block is not compressed.
+Status DecodeBlobBlock(const Slice &src, const UncompressionDict &dict,
+                       CacheAllocationPtr buffer, OwnedSlice *contents);
+
+class BlobBlockEncoder {
+ public:
+  BlobBlockEncoder(CompressionType compression,
+                   const CompressionOptions &compression_opt)
+      : compression_(compression),
+        compression_opt_(compression_opt),
+        compression_ctx_(compression) {
+    SetDictionary(std::string());
+  }
+
+  // Compresses the following blocks with the dictionary "dict".
+  void SetDictionary(std::string dict);
+
+  // Appends the block with the uncompressed "contents" to "*dst".
+  void EncodeBlock(const Slice &contents, std::string *dst);
+
+ private:
+  CompressionType compression_;
+  CompressionOptions compression_opt_;
+  CompressionContext compression_ctx_;
+  std::unique_ptr<CompressionDict> dict_;
+  std::unique_ptr<CompressionInfo> compression_info_;
+  std::string compressed_buffer_;
+};
+
+// Format of block index, only in version 2 blob files (not fixed size):
+//
+//    +---------------------+-------------+------------+---------------------+-----+
+//    |     dict handle     | compression | num blocks |    block 1 sizes    | ... |
+//    +---------------------+-------------+------------+---------------------+-----+
+//    | Varint64 + Varint64 |    char     |  Varint64  | Varint64 + Varint64 |     |
+//    +---------------------+-------------+------------+---------------------+-----+
+//
+// The compression is the type the file was written with, which the
+// dictionary is meant for. The sizes of a block are its stored size, with the trailer, and the
+// size of its uncompressed contents. Blocks start right after the file
+// header. The blob handle of a record in a version 2 file refers to the
+// uncompressed contents of all the blocks laid end to end: the offset is
+// where the record starts, and the size is the length of the record.
+struct BlobBlockIndex {
+  BlockHandle dict_handle{BlockHandle::NullBlockHandle()};
+  CompressionType compression{kNoCompression};
+  // Offsets of the blocks in the file and in the uncompressed contents,
+  // followed by the end offsets of the last block.
+  std::vector<uint64_t> file_offsets;
+  std::vector<uint64_t> raw_offsets;
+
+  BlobBlockIndex() { Clear(); }
+
+  void Clear();
+  void AddBlock(uint64_t stored_size, uint64_t raw_size);
+  size_t num_blocks() const { return file_offsets.size() - 1; }
+
+  // Returns the block whose uncompressed contents contain "raw_offset",
+  // or num_blocks() if there is none.
+  size_t FindBlock(uint64_t raw_offset) const;
+  // Returns the block stored at "file_offset", or num_blocks() if there
+  // is none.
+  size_t FindBlockByFileOffset(uint64_t file_offset) const;
+
+  void EncodeTo(std::string *dst) const;
+  Status DecodeFrom(Slice *src);
+
+  friend bool operator==(const BlobBlockIndex &lhs, const BlobBlockIndex &rhs);
+};
+
 // Format of blob handle (not fixed size):
 //
 //    +----------+----------+
@@ -216,19 +326,29 @@ class BlobFileMeta {
   FileState file_state() const { return state_; }
   bool is_obsolete() const { return state_ == FileState::kObsolete; }
   uint32_t file_type() const { return file_type_; }
-  uint64_t discardable_size() const { return discardable_size_; }
+  uint64_t discardable_size() const {
+    return discardable_size_.load(std::memory_order_relaxed);
+  }
 
   bool gc_mark() const { return gc_mark_; }
   void set_gc_mark(bool mark) { gc_mark_ = mark; }
 
   void FileStateTransit(const FileEvent &event);
 
-  void AddDiscardableSize(uint64_t _discardable_size);
+  // Adds garbage to the file without locking. Returns the discardable size
+  // before the addition.
+  uint64_t AddDiscardableSize(uint64_t _discardable_size);
   double GetDiscardableRatio() const;
   bool NoLiveData() {
-    return discardable_size_ == file_size_ - kBlobHeaderSize - kBlobFooterSize;
+    return discardable_size() >=
+           file_size_ - kBlobHeaderSize - kBlobFooterSize;
+  }
+  TitanInternalStats::StatsType GetDiscardableRatioLevel() const {
+    return GetDiscardableRatioLevel(discardable_size());
   }
-  TitanInternalStats::StatsType GetDiscardableRatioLevel() const;
+  // Gets the level of the discardable ratio with the given discardable size.
+  TitanInternalStats::StatsType GetDiscardableRatioLevel(
+      uint64_t _discardable_size) const;
 
  private:
   // Persistent field
@@ -247,7 +367,8 @@ class BlobFileMeta {
   // Not persistent field
   FileState state_{FileState::kInit};
 
-  uint64_t discardable_size_{0};
+  // Updated by flush, compaction and GC concurrently.
+  std::atomic<uint64_t> discardable_size_{0};
   // gc_mark is set to true when this file is recovered from re-opening the DB
   // that means this file needs to be checked for GC
   bool gc_mark_{false};
@@ -267,6 +388,7 @@ struct BlobFileHeader {
   // The first 32bits from $(echo titandb/blob | sha1sum).
   static const uint32_t kHeaderMagicNumber = 0x2be0a614ul;
   static const uint32_t kVersion1 = 1;
+  static const uint32_t kVersion2 = 2;
   static const uint64_t kEncodedLength = 4 + 4;
 
   uint32_t version = kVersion1;
@@ -284,7 +406,9 @@ struct BlobFileHeader {
 //    +---------------------+-------------+--------------+----------+
 //
 // To make the blob file footer fixed size,
-// the padding_len is `BlockHandle::kMaxEncodedLength - meta_handle_len`
+// the padding_len is `BlockHandle::kMaxEncodedLength - meta_handle_len`.
+// The meta index handle points to the block index in version 2 files,
+// and is null in version 1 files.
 struct BlobFileFooter {
   // The first 64bits from $(echo titandb/blob | sha1sum).
   static const uint64_t kFooterMagicNumber{0x2be0a6148e39edc6ull};
@@ -1,14 +1,129 @@
+#include "file/filename.h"
 #include "test_util/testharness.h"
 
+#include "blob_file_builder.h"
+#include "blob_file_iterator.h"
+#include "blob_file_reader.h"
 #include "blob_format.h"
 #include "testutil.h"
 #include "util.h"
 
+#include <cinttypes>
+
 namespace rocksdb {
 namespace titandb {
 
 class BlobFormatTest : public testing::Test {};
 
+class BlobFileFormatTest : public testing::Test {
+ public:
+  BlobFileFormatTest() : dirname_(test::TmpDir(env_)) {
+    file_name_ = BlobFileName(dirname_, file_number_);
+  }
+
+  ~BlobFileFormatTest() {
+    env_->DeleteFile(file_name_);
+    env_->DeleteDir(dirname_);
+  }
+
+  std::string GenKey(uint64_t i) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "k-%08" PRIu64, i);
+    return buf;
+  }
+
+  // Values of various sizes, so that some records span most of a block.
+  std::string GenValue(uint64_t i) {
+    return std::string(100 + (i * 997) % (8 << 10), 'a' + i % 26);
+  }
+
+  // Builds a blob file of "n" records and checks that they are read back
+  // by the reader, the prefetcher and the iterator.
+  void CheckBlobFile(const TitanCFOptions& cf_options, int n) {
+    CheckBlobFile(cf_options, cf_options, n);
+  }
+
+  // Writes the file with "cf_options" and reads it with "read_cf_options".
+  void CheckBlobFile(const TitanCFOptions& cf_options,
+                     const TitanCFOptions& read_cf_options, int n) {
+    TitanDBOptions db_options;
+    db_options.dirname = dirname_;
+    std::vector<BlobHandle> handles(n);
+
+    std::unique_ptr<WritableFileWriter> file;
+    {
+      std::unique_ptr<WritableFile> f;
+      ASSERT_OK(env_->NewWritableFile(file_name_, &f, env_options_));
+      file.reset(
+          new WritableFileWriter(std::move(f), file_name_, env_options_));
+    }
+    BlobFileBuilder builder(db_options, cf_options, file.get());
+    for (int i = 0; i < n; i++) {
+      auto key = GenKey(i);
+      auto value = GenValue(i);
+      BlobRecord record;
+      record.key = key;
+      record.value = value;
+      builder.Add(record, &handles[i]);
+      ASSERT_OK(builder.status());
+    }
+    ASSERT_OK(builder.Finish());
+    ASSERT_OK(file->Sync(true));
+    ASSERT_OK(file->Close());
+
+    uint64_t file_size = 0;
+    ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
+    {
+      std::unique_ptr<RandomAccessFileReader> file_reader;
+      ASSERT_OK(NewBlobFileReader(file_number_, 0, db_options, read_cf_options,
+                                  env_options_, env_, &file_reader));
+      std::unique_ptr<BlobFileReader> reader;
+      ASSERT_OK(BlobFileReader::Open(read_cf_options, std::move(file_reader),
+                                     file_size, &reader, nullptr));
+      // Point reads in reverse order.
+      for (int i = n - 1; i >= 0; i--) {
+        BlobRecord record;
+        PinnableSlice buffer;
+        ASSERT_OK(reader->Get(ReadOptions(), handles[i], &record, &buffer));
+        ASSERT_EQ(record.key, GenKey(i));
+        ASSERT_EQ(record.value, GenValue(i));
+      }
+      // Continuous reads.
+      BlobFilePrefetcher prefetcher(reader.get());
+      for (int i = 0; i < n; i++) {
+        BlobRecord record;
+        PinnableSlice buffer;
+        ASSERT_OK(prefetcher.Get(ReadOptions(), handles[i], &record, &buffer));
+        ASSERT_EQ(record.key, GenKey(i));
+        ASSERT_EQ(record.value, GenValue(i));
+      }
+    }
+    {
+      std::unique_ptr<RandomAccessFileReader> file_reader;
+      ASSERT_OK(NewBlobFileReader(file_number_, 0, db_options, read_cf_options,
+                                  env_options_, env_, &file_reader));
+      BlobFileIterator iter(std::move(file_reader), file_number_, file_size,
+                            read_cf_options);
+      iter.SeekToFirst();
+      for (int i = 0; i < n; i++, iter.Next()) {
+        ASSERT_OK(iter.status());
+        ASSERT_TRUE(iter.Valid());
+        ASSERT_EQ(iter.key(), GenKey(i));
+        ASSERT_EQ(iter.value(), GenValue(i));
+        ASSERT_EQ(iter.GetBlobIndex().blob_handle, handles[i]);
+      }
+      ASSERT_OK(iter.status());
+      ASSERT_FALSE(iter.Valid());
+    }
+  }
+
+  Env* env_{Env::Default()};
+  EnvOptions env_options_;
+  std::string dirname_;
+  std::string file_name_;
+  uint64_t file_number_{1};
+};
+
 TEST(BlobFormatTest, BlobRecord) {
   BlobRecord input;
   CheckCodec(input);
@@ -35,7 +150,7 @@ TEST(BlobFormatTest, BlobIndex) {
 }
 
 TEST(BlobFormatTest, BlobFileMeta) {
-  BlobFileMeta input(2, 3, 0, 0, "0", "9");
+  BlobFileMeta input(2, 3, 0, 0, "0", "9", kSorted);
   CheckCodec(input);
 }
 
@@ -47,6 +162,155 @@ TEST(BlobFormatTest, BlobFileFooter) {
   CheckCodec(input);
 }
 
+TEST(BlobFormatTest, BlobBlockIndex) {
+  BlobBlockIndex input;
+  CheckCodec(input);
+  input.dict_handle.set_offset(123);
+  input.dict_handle.set_size(321);
+  input.compression = kZSTD;
+  input.AddBlock(100, 4096);
+  input.AddBlock(50, 4000);
+  CheckCodec(input);
+
+  ASSERT_EQ(input.num_blocks(), 2);
+  ASSERT_EQ(input.FindBlock(0), 0);
+  ASSERT_EQ(input.FindBlock(4095), 0);
+  ASSERT_EQ(input.FindBlock(4096), 1);
+  ASSERT_EQ(input.FindBlock(8095), 1);
+  ASSERT_EQ(input.FindBlock(8096), 2);
+  ASSERT_EQ(input.FindBlockByFileOffset(0), 2);
+  ASSERT_EQ(input.FindBlockByFileOffset(BlobFileHeader::kEncodedLength), 0);
+  ASSERT_EQ(input.FindBlockByFileOffset(BlobFileHeader::kEncodedLength + 100),
+            1);
+  ASSERT_EQ(input.FindBlockByFileOffset(BlobFileHeader::kEncodedLength + 150),
+            2);
+}
+
+TEST(BlobFormatTest, BlobBlock) {
+  std::string contents(1000, 'x');
+  BlobBlockEncoder encoder(kNoCompression, CompressionOptions());
+  std::string block;
+  encoder.EncodeBlock(contents, &block);
+  ASSERT_EQ(block.size(), contents.size() + kBlobBlockTrailerSize);
+
+  auto decode = [&](const std::string& src, OwnedSlice* output) {
+    CacheAllocationPtr buffer(new char[src.size()]);
+    memcpy(buffer.get(), src.data(), src.size());
+    Slice input(buffer.get(), src.size());
+    return DecodeBlobBlock(input, UncompressionDict::GetEmptyDict(),
+                           std::move(buffer), output);
+  };
+  OwnedSlice output;
+  ASSERT_OK(decode(block, &output));
+  ASSERT_EQ(output, contents);
+
+  block[10] ^= 1;
+  ASSERT_TRUE(decode(block, &output).IsCorruption());
+  ASSERT_TRUE(decode(block.substr(0, 3), &output).IsCorruption());
+}
+
+TEST(BlobFormatTest, BlobFileHeader) {
+  BlobFileHeader input;
+  std::string encoded;
+  input.version = BlobFileHeader::kVersion2;
+  input.EncodeTo(&encoded);
+  BlobFileHeader output;
+  ASSERT_OK(DecodeInto(encoded, &output));
+  ASSERT_EQ(output.version, BlobFileHeader::kVersion2);
+
+  encoded.clear();
+  input.version = 3;
+  input.EncodeTo(&encoded);
+  ASSERT_TRUE(DecodeInto(encoded, &output).IsCorruption());
+}
+
+TEST_F(BlobFileFormatTest, BlobFileVersion1) {
+  TitanCFOptions cf_options;
+  CheckBlobFile(cf_options, 1000);
+}
+
+TEST_F(BlobFileFormatTest, BlobFileVersion2) {
+  TitanCFOptions cf_options;
+  cf_options.blob_file_format_version = BlobFileHeader::kVersion2;
+  for (uint64_t block_size : {uint64_t{1}, uint64_t{16 << 10}, uint64_t{1} << 30}) {
+    cf_options.blob_file_block_size = block_size;
+    CheckBlobFile(cf_options, 1000);
+  }
+  // No record at all.
+  CheckBlobFile(cf_options, 0);
+
+  // The compression and the dictionary are ignored when the compression
+  // library is missing, so they are checked wherever it's available.
+  cf_options.blob_file_compression = kLZ4Compression;
+  CheckBlobFile(cf_options, 1000);
+  cf_options.blob_file_compression_options.max_dict_bytes = 4 << 10;
+  CheckBlobFile(cf_options, 1000);
+  cf_options.blob_file_compression = kZSTD;
+  cf_options.blob_file_compression_options.zstd_max_train_bytes = 64 << 10;
+  CheckBlobFile(cf_options, 1000);
+  // Files are read with the compression they were written with, whatever
+  // the options are now.
+  CheckBlobFile(cf_options, TitanCFOptions(), 1000);
+}
+
+TEST_F(BlobFileFormatTest, BlobFileVersion2Blocks) {
+  TitanCFOptions cf_options;
+  cf_options.blob_file_format_version = BlobFileHeader::kVersion2;
+  cf_options.blob_file_block_size = 16 << 10;
+  cf_options.blob_file_compression = kNoCompression;
+  TitanDBOptions db_options;
+
+  std::unique_ptr<WritableFileWriter> file;
+  {
+    std::unique_ptr<WritableFile> f;
+    ASSERT_OK(env_->NewWritableFile(file_name_, &f, env_options_));
+    file.reset(new WritableFileWriter(std::move(f), file_name_, env_options_));
+  }
+  BlobFileBuilder builder(db_options, cf_options, file.get());
+  // Small records share blocks, and a big one gets a block of its own.
+  std::string small(1000, 's');
+  std::string big(100 << 10, 'b');
+  BlobHandle handle;
+  uint64_t raw_size = 0;
+  for (int i = 0; i < 100; i++) {
+    auto key = GenKey(i);
+    BlobRecord record;
+    record.key = key;
+    record.value = i == 50 ? big : small;
+    builder.Add(record, &handle);
+    ASSERT_EQ(handle.offset, raw_size + VarintLength(handle.size));
+    raw_size = handle.offset + handle.size;
+  }
+  ASSERT_OK(builder.Finish());
+  ASSERT_OK(file->Close());
+
+  uint64_t file_size = 0;
+  ASSERT_OK(env_->GetFileSize(file_name_, &file_size));
+  std::unique_ptr<RandomAccessFileReader> file_reader;
+  db_options.dirname = dirname_;
+  ASSERT_OK(NewBlobFileReader(file_number_, 0, db_options, cf_options,
+                              env_options_, env_, &file_reader));
+  BlobFileIterator iter(std::move(file_reader), file_number_, file_size,
+                        cf_options);
+  ASSERT_TRUE(iter.Init());
+  // Without compression the file holds the records, the length prefixes
+  // and the trailers, plus the header, the index and the footer.
+  uint64_t num_blocks = (50 * 1010 + (16 << 10) - 1) / (16 << 10) * 2 + 1;
+  ASSERT_LT(file_size, raw_size + num_blocks * (kBlobBlockTrailerSize + 4) +
+                           BlobFileHeader::kEncodedLength +
+                           BlobFileFooter::kEncodedLength + 100);
+
+  // IterateForPrev positions at the block containing the offset.
+  iter.IterateForPrev(BlobFileHeader::kEncodedLength + (20 << 10));
+  ASSERT_OK(iter.status());
+  iter.Next();
+  ASSERT_TRUE(iter.Valid());
+  ASSERT_GT(iter.key().ToString(), GenKey(0));
+  ASSERT_LE(iter.key().ToString(), GenKey(20));
+  iter.IterateForPrev(file_size);
+  ASSERT_TRUE(iter.status().IsInvalidArgument());
+}
+
 TEST(BlobFormatTest, BlobFileStateTransit) {
   BlobFileMeta blob_file;
   ASSERT_EQ(blob_file.file_state(), BlobFileMeta::FileState::kInit);
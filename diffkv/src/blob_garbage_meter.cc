@@ -0,0 +1,50 @@
+#include "blob_garbage_meter.h"
+
+namespace rocksdb {
+namespace titandb {
+
+void BlobGarbageMeter::AddTable(uint64_t sst_number, BlobFileSizes&& sizes) {
+  std::unique_lock<std::mutex> l(mutex_);
+  tables_[sst_number] = std::move(sizes);
+}
+
+bool BlobGarbageMeter::GetTable(uint64_t sst_number,
+                                BlobFileSizes* sizes) const {
+  std::unique_lock<std::mutex> l(mutex_);
+  auto it = tables_.find(sst_number);
+  if (it == tables_.end()) {
+    return false;
+  }
+  for (const auto& file : it->second) {
+    (*sizes)[file.first] += file.second;
+  }
+  return true;
+}
+
+void BlobGarbageMeter::RemoveTable(uint64_t sst_number) {
+  std::unique_lock<std::mutex> l(mutex_);
+  tables_.erase(sst_number);
+}
+
+size_t BlobGarbageMeter::NumTables() const {
+  std::unique_lock<std::mutex> l(mutex_);
+  return tables_.size();
+}
+
+void BlobGarbageMeter::ComputeGarbage(const BlobFileSizes& inputs,
+                                      const BlobFileSizes& outputs,
+                                      BlobFileSizes* garbage) {
+  for (const auto& input : inputs) {
+    uint64_t output = 0;
+    auto it = outputs.find(input.first);
+    if (it != outputs.end()) {
+      output = it->second;
+    }
+    if (input.second > output) {
+      (*garbage)[input.first] += input.second - output;
+    }
+  }
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
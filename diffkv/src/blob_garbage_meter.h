@@ -0,0 +1,45 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include "rocksdb/types.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// Blob file number -> bytes of the blob records referenced.
+using BlobFileSizes = std::unordered_map<uint64_t, uint64_t>;
+
+// Keeps the blob references of every SST built by TitanTableBuilder since
+// the DB was opened, so that flush and compaction can tell how many bytes
+// of each blob file they dropped without decoding the table properties
+// written by BlobFileSizeCollector. SSTs written before the DB was opened
+// are unknown to the meter; their properties are still needed for them.
+class BlobGarbageMeter {
+ public:
+  // Records the blob references of a newly built SST.
+  void AddTable(uint64_t sst_number, BlobFileSizes&& sizes);
+
+  // Adds the blob references of the SST to "sizes" and returns true, or
+  // returns false if the SST is unknown.
+  bool GetTable(uint64_t sst_number, BlobFileSizes* sizes) const;
+
+  // Forgets an SST that has been deleted.
+  void RemoveTable(uint64_t sst_number);
+
+  size_t NumTables() const;
+
+  // Computes the bytes each blob file lost when the "inputs" SSTs were
+  // rewritten to the "outputs" SSTs, skipping the files that lost none.
+  static void ComputeGarbage(const BlobFileSizes& inputs,
+                             const BlobFileSizes& outputs,
+                             BlobFileSizes* garbage);
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, BlobFileSizes> tables_;
+};
+
+}  // namespace titandb
+}  // namespace rocksdb
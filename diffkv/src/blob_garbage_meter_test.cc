@@ -0,0 +1,69 @@
+#include "blob_garbage_meter.h"
+
+#include <thread>
+#include <vector>
+
+#include "test_util/testharness.h"
+
+#include "blob_format.h"
+
+namespace rocksdb {
+namespace titandb {
+
+class BlobGarbageMeterTest : public testing::Test {};
+
+TEST(BlobGarbageMeterTest, Basic) {
+  BlobGarbageMeter meter;
+  meter.AddTable(10, BlobFileSizes{{1, 100}, {2, 200}});
+  meter.AddTable(11, BlobFileSizes{{2, 50}, {3, 300}});
+  ASSERT_EQ(meter.NumTables(), 2);
+
+  BlobFileSizes inputs;
+  ASSERT_TRUE(meter.GetTable(10, &inputs));
+  ASSERT_TRUE(meter.GetTable(11, &inputs));
+  ASSERT_FALSE(meter.GetTable(12, &inputs));
+  ASSERT_EQ(inputs, (BlobFileSizes{{1, 100}, {2, 250}, {3, 300}}));
+
+  // File 1 is dropped, file 2 loses some records and file 4 is new.
+  meter.AddTable(12, BlobFileSizes{{2, 150}, {3, 300}, {4, 400}});
+  BlobFileSizes outputs;
+  ASSERT_TRUE(meter.GetTable(12, &outputs));
+  BlobFileSizes garbage;
+  BlobGarbageMeter::ComputeGarbage(inputs, outputs, &garbage);
+  ASSERT_EQ(garbage, (BlobFileSizes{{1, 100}, {2, 100}}));
+
+  meter.RemoveTable(10);
+  meter.RemoveTable(11);
+  ASSERT_EQ(meter.NumTables(), 1);
+  ASSERT_FALSE(meter.GetTable(10, &inputs));
+}
+
+TEST(BlobGarbageMeterTest, ConcurrentDiscardableSize) {
+  const uint64_t kFileSize = 1 << 20;
+  BlobFileMeta file(1, kFileSize, 100, 0, "a", "z", kSorted);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&file]() {
+      for (int j = 0; j < 1000; j++) {
+        file.AddDiscardableSize(100);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(file.discardable_size(), 4 * 1000 * 100);
+
+  // The discardable size never exceeds the file size.
+  ASSERT_EQ(file.AddDiscardableSize(kFileSize), 4 * 1000 * 100);
+  ASSERT_EQ(file.discardable_size(), kFileSize);
+  ASSERT_TRUE(file.NoLiveData());
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -3,11 +3,15 @@
 #endif
 #include <inttypes.h>
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
 #include <memory>
 
 #include "blob_gc_job.h"
+#include "blob_io_scheduler.h"
 #include "iostream"
+#include "port/port.h"
 
 std::atomic<uint64_t> gc_update_lsm{0};
 std::atomic<uint64_t> gc_read_lsm{0};
@@ -81,6 +85,26 @@ class BlobGCJob::GarbageCollectionWriteCallback : public WriteCallback {
   uint64_t read_bytes_;
 };
 
+void BlobGCJob::GCMetrics::Add(const GCMetrics& other) {
+  bytes_read += other.bytes_read;
+  bytes_written += other.bytes_written;
+  gc_num_keys_overwritten += other.gc_num_keys_overwritten;
+  gc_bytes_overwritten += other.gc_bytes_overwritten;
+  gc_num_keys_relocated += other.gc_num_keys_relocated;
+  gc_bytes_relocated += other.gc_bytes_relocated;
+  gc_num_new_files += other.gc_num_new_files;
+  gc_num_files += other.gc_num_files;
+  gc_small_file += other.gc_small_file;
+  gc_discardable += other.gc_discardable;
+  gc_sample += other.gc_sample;
+  gc_sampling_micros += other.gc_sampling_micros;
+  gc_read_lsm_micros += other.gc_read_lsm_micros;
+  gc_update_lsm_micros += other.gc_update_lsm_micros;
+  gc_total_micros += other.gc_total_micros;
+  gc_write_blob_micros += other.gc_write_blob_micros;
+  gc_read_blob_micros += other.gc_read_blob_micros;
+}
+
 BlobGCJob::BlobGCJob(BlobGC* blob_gc, DB* db, port::Mutex* mutex,
                      const TitanDBOptions& titan_db_options, Env* env,
                      const EnvOptions& env_options,
@@ -99,7 +123,10 @@ BlobGCJob::BlobGCJob(BlobGC* blob_gc, DB* db, port::Mutex* mutex,
       log_buffer_(log_buffer),
       shuting_down_(shuting_down),
       stats_(stats),
-      builder_(builder) {}
+      builder_(builder) {
+  io_scheduler_ =
+      GetBlobIOScheduler(db_options_, blob_gc_->titan_cf_options());
+}
 
 BlobGCJob::~BlobGCJob() {
   if (log_buffer_) {
@@ -160,7 +187,163 @@ Status BlobGCJob::Run() {
     return Status::OK();
   }
 
-  return DoRunGC();
+  PartitionInputs();
+  s = RunSubJobs(&BlobGCJob::DoRunGC);
+  for (auto& sub_job : sub_jobs_) {
+    for (auto& builder : sub_job.blob_file_builders) {
+      blob_file_builders_.emplace_back(std::move(builder));
+    }
+    sub_job.blob_file_builders.clear();
+  }
+  return s;
+}
+
+void BlobGCJob::PartitionInputs() {
+  std::vector<BlobFileMeta*> inputs(blob_gc_->sampled_inputs());
+  auto* cmp = blob_gc_->titan_cf_options().comparator;
+  std::sort(inputs.begin(), inputs.end(),
+            [cmp](const BlobFileMeta* a, const BlobFileMeta* b) {
+              return cmp->Compare(a->smallest_key(), b->smallest_key()) < 0;
+            });
+
+  // Blob files can't be seeked by key, so the inputs are split by files.
+  // Outputs of sorted files must not overlap with each other, thus files
+  // with overlapping key ranges have to go to the same sub job. Unsorted
+  // outputs have no such constraint, every file is a range of its own.
+  struct Range {
+    size_t begin;
+    size_t end;
+    uint64_t size;
+  };
+  std::vector<Range> ranges;
+  uint64_t total_size = 0;
+  std::string largest_key;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (ranges.empty() || db_options_.sep_before_flush ||
+        cmp->Compare(inputs[i]->smallest_key(), largest_key) > 0) {
+      ranges.push_back({i, i, 0});
+      largest_key.clear();
+    }
+    ranges.back().end = i + 1;
+    ranges.back().size += inputs[i]->file_size();
+    total_size += inputs[i]->file_size();
+    if (largest_key.empty() ||
+        cmp->Compare(inputs[i]->largest_key(), largest_key) > 0) {
+      largest_key = inputs[i]->largest_key();
+    }
+  }
+
+  // Packs consecutive ranges into sub jobs of about the same size.
+  size_t max_sub_jobs = static_cast<size_t>(
+      std::max(db_options_.max_gc_subjobs, 1));
+  max_sub_jobs = std::min(max_sub_jobs, ranges.size());
+  uint64_t target_size = total_size / max_sub_jobs;
+  sub_jobs_.clear();
+  sub_jobs_.resize(1);
+  uint64_t sub_job_size = 0;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    // Leave at least one range for each of the remaining sub jobs.
+    bool must_split =
+        ranges.size() - i <= max_sub_jobs - sub_jobs_.size();
+    if (!sub_jobs_.back().inputs.empty() &&
+        sub_jobs_.size() < max_sub_jobs &&
+        (must_split || sub_job_size + ranges[i].size / 2 > target_size)) {
+      sub_jobs_.emplace_back();
+      sub_job_size = 0;
+    }
+    for (size_t j = ranges[i].begin; j < ranges[i].end; j++) {
+      sub_jobs_.back().inputs.push_back(inputs[j]);
+    }
+    sub_job_size += ranges[i].size;
+  }
+  if (sub_jobs_.size() > 1) {
+    ROCKS_LOG_BUFFER(log_buffer_, "[%s] Titan GC split into %" ROCKSDB_PRIszt
+                     " sub jobs",
+                     blob_gc_->column_family_handle()->GetName().c_str(),
+                     sub_jobs_.size());
+  }
+}
+
+namespace {
+
+// Shared by a GC job and the tasks it schedules on the GC thread pool.
+// Sub jobs are claimed in order by whichever thread gets to them first,
+// the job's own thread included, so the job only waits for sub jobs that
+// are already running and never for a task still queued behind other GC
+// jobs in the pool.
+class SubJobRunner {
+ public:
+  SubJobRunner(size_t num_sub_jobs, std::function<void(size_t)>&& run)
+      : num_sub_jobs_(num_sub_jobs), run_(std::move(run)), cv_(&mutex_) {}
+
+  // Runs the next unclaimed sub job. Returns false if there was none.
+  bool RunNext() {
+    size_t i = next_.fetch_add(1);
+    if (i >= num_sub_jobs_) {
+      return false;
+    }
+    run_(i);
+    MutexLock l(&mutex_);
+    if (++num_done_ == num_sub_jobs_) {
+      cv_.SignalAll();
+    }
+    return true;
+  }
+
+  void Wait() {
+    MutexLock l(&mutex_);
+    while (num_done_ < num_sub_jobs_) {
+      cv_.Wait();
+    }
+  }
+
+  static void BGWork(void* arg) {
+    std::unique_ptr<std::shared_ptr<SubJobRunner>> runner(
+        reinterpret_cast<std::shared_ptr<SubJobRunner>*>(arg));
+    (*runner)->RunNext();
+  }
+
+  static void UnscheduleWork(void* arg) {
+    delete reinterpret_cast<std::shared_ptr<SubJobRunner>*>(arg);
+  }
+
+ private:
+  const size_t num_sub_jobs_;
+  std::function<void(size_t)> run_;
+  std::atomic<size_t> next_{0};
+  port::Mutex mutex_;
+  port::CondVar cv_;
+  size_t num_done_{0};
+};
+
+}  // namespace
+
+Status BlobGCJob::RunSubJobs(Status (BlobGCJob::*func)(SubJob*)) {
+  auto runner = std::make_shared<SubJobRunner>(
+      sub_jobs_.size(), [this, func](size_t i) {
+        sub_jobs_[i].status = (this->*func)(&sub_jobs_[i]);
+      });
+  // A task that runs after all sub jobs are claimed finds nothing to do,
+  // it only keeps the runner alive.
+  for (size_t i = 1; i < sub_jobs_.size(); i++) {
+    env_->Schedule(&SubJobRunner::BGWork,
+                   new std::shared_ptr<SubJobRunner>(runner),
+                   Env::Priority::USER, nullptr,
+                   &SubJobRunner::UnscheduleWork);
+  }
+  while (runner->RunNext()) {
+  }
+  runner->Wait();
+
+  Status s;
+  for (auto& sub_job : sub_jobs_) {
+    metrics_.Add(sub_job.metrics);
+    sub_job.metrics = GCMetrics();
+    if (s.ok() && !sub_job.status.ok()) {
+      s = sub_job.status;
+    }
+  }
+  return s;
 }
 
 Status BlobGCJob::SampleCandidateFiles() {
@@ -212,8 +395,11 @@ Status BlobGCJob::DoSample(const BlobFileMeta* file, bool* selected) {
   }
   std::unique_ptr<RandomAccessFileReader> file_reader;
   const int readahead = 256 << 10;
-  s = NewBlobFileReader(file->file_number(), readahead, db_options_,
-                        env_options_, env_, &file_reader);
+  s = NewBlobFileReader(
+      file->file_number(), readahead, db_options_,
+      blob_gc_->titan_cf_options(),
+      BlobFileEnvOptions(env_options_, blob_gc_->titan_cf_options()), env_,
+      &file_reader);
   if (!s.ok()) {
     return s;
   }
@@ -262,12 +448,13 @@ Status BlobGCJob::DoSample(const BlobFileMeta* file, bool* selected) {
   return s;
 }
 
-Status BlobGCJob::DoRunGC() {
+Status BlobGCJob::DoRunGC(SubJob* sub_job) {
   Status s;
   WriteOptions wo;
+  GCMetrics& metrics = sub_job->metrics;
 
   std::unique_ptr<BlobFileMergeIterator> gc_iter;
-  s = BuildIterator(&gc_iter);
+  s = BuildIterator(sub_job->inputs, &gc_iter);
   if (!s.ok()) return s;
   if (!gc_iter) return Status::Aborted("Build iterator for gc failed");
 
@@ -290,6 +477,7 @@ Status BlobGCJob::DoRunGC() {
   //  uint64_t total_entry_size = 0;
 
   uint64_t file_size = 0;
+  BlobIOCharger io_charger(io_scheduler_, BlobIOSource::kGC, stats_);
 
   // std::string last_key;
   // bool last_key_valid = false;
@@ -302,7 +490,8 @@ Status BlobGCJob::DoRunGC() {
     }
     BlobIndex blob_index = gc_iter->GetBlobIndex();
     // count read bytes for blob record of gc candidate files
-    metrics_.bytes_read += blob_index.blob_handle.size;
+    metrics.bytes_read += blob_index.blob_handle.size;
+    io_charger.Charge(blob_index.blob_handle.size);
 /*
     if (!last_key.empty() && !gc_iter->key().compare(last_key)) {
       if (last_key_valid) {
@@ -314,13 +503,13 @@ Status BlobGCJob::DoRunGC() {
     }
 */
     bool discardable = false;
-    s = DiscardEntry(gc_iter->key(), blob_index, &discardable);
+    s = DiscardEntry(gc_iter->key(), blob_index, &discardable, &metrics);
     if (!s.ok()) {
       break;
     }
     if (discardable) {
-      metrics_.gc_num_keys_overwritten++;
-      metrics_.gc_bytes_overwritten += blob_index.blob_handle.size;
+      metrics.gc_num_keys_overwritten++;
+      metrics.gc_bytes_overwritten += blob_index.blob_handle.size;
       continue;
     }
 
@@ -328,12 +517,13 @@ Status BlobGCJob::DoRunGC() {
     if(db_options_.sep_before_flush&&!blob_gc_->titan_cf_options().level_merge){
       Status add_status;
       auto wb = WriteBatch();
+      io_charger.Charge(gc_iter->key().size() + gc_iter->value().size());
       {
-        TitanStopWatch w(env_, metrics_.gc_write_blob_micros);
+        TitanStopWatch w(env_, metrics.gc_write_blob_micros);
         add_status = builder_->Add(gc_iter->key(), gc_iter->value(), &wb);
       }
       if (add_status.ok()) {
-        TitanStopWatch w(env_, metrics_.gc_update_lsm_micros);
+        TitanStopWatch w(env_, metrics.gc_update_lsm_micros);
         s = base_db_->Write(wo, &wb);
         // if(!s.ok()) return s;
       } else {
@@ -341,7 +531,7 @@ Status BlobGCJob::DoRunGC() {
       }
       continue;
     }
-    TitanStopWatch w(env_, metrics_.gc_write_blob_micros);
+    TitanStopWatch w(env_, metrics.gc_write_blob_micros);
     
     // Rewrite entry to new blob file
     if ((!blob_file_handle && !blob_file_builder) ||
@@ -350,10 +540,12 @@ Status BlobGCJob::DoRunGC() {
         assert(blob_file_builder);
         assert(blob_file_handle);
         assert(blob_file_builder->status().ok());
-        blob_file_builders_.emplace_back(std::make_pair(
+        sub_job->blob_file_builders.emplace_back(std::make_pair(
             std::move(blob_file_handle), std::move(blob_file_builder)));
       }
-      s = blob_file_manager_->NewFile(&blob_file_handle);
+      s = blob_file_manager_->NewFile(
+          &blob_file_handle,
+          BlobFileEnvOptions(env_options_, blob_gc_->titan_cf_options()));
       if (!s.ok()) {
         break;
       }
@@ -373,8 +565,9 @@ Status BlobGCJob::DoRunGC() {
     blob_record.value = gc_iter->value();
     // count written bytes for new blob record,
     // blob index's size is counted in `RewriteValidKeyToLSM`
-    metrics_.bytes_written += blob_record.size();
+    metrics.bytes_written += blob_record.size();
     file_size += blob_record.size();
+    io_charger.Charge(blob_record.size());
     BlobIndex new_blob_index;
     new_blob_index.file_number = blob_file_handle->GetNumber();
     blob_file_builder->Add(blob_record, &new_blob_index.blob_handle);
@@ -385,9 +578,9 @@ Status BlobGCJob::DoRunGC() {
     GarbageCollectionWriteCallback callback(cfh, blob_record.key.ToString(),
                                             std::move(blob_index));
     callback.value = index_entry;
-    rewrite_batches_.emplace_back(
+    sub_job->rewrite_batches.emplace_back(
         std::make_pair(WriteBatch(), std::move(callback)));
-    auto& wb = rewrite_batches_.back().first;
+    auto& wb = sub_job->rewrite_batches.back().first;
     s = WriteBatchInternal::PutBlobIndex(&wb, cfh->GetID(), blob_record.key,
                                          index_entry);
     if (!s.ok()) {
@@ -398,7 +591,7 @@ Status BlobGCJob::DoRunGC() {
   if (gc_iter->status().ok() && s.ok()) {
     if (blob_file_builder && blob_file_handle) {
       assert(blob_file_builder->status().ok());
-      blob_file_builders_.emplace_back(std::make_pair(
+      sub_job->blob_file_builders.emplace_back(std::make_pair(
           std::move(blob_file_handle), std::move(blob_file_builder)));
     } else {
       assert(!blob_file_builder);
@@ -412,16 +605,19 @@ Status BlobGCJob::DoRunGC() {
 }
 
 Status BlobGCJob::BuildIterator(
+    const std::vector<BlobFileMeta*>& inputs,
     std::unique_ptr<BlobFileMergeIterator>* result) {
   Status s;
-  const auto& inputs = blob_gc_->sampled_inputs();
   assert(!inputs.empty());
   std::vector<std::unique_ptr<BlobFileIterator>> list;
   for (std::size_t i = 0; i < inputs.size(); ++i) {
     std::unique_ptr<RandomAccessFileReader> file;
     // TODO(@DorianZheng) set read ahead size
-    s = NewBlobFileReader(inputs[i]->file_number(), 0, db_options_,
-                          env_options_, env_, &file);
+    s = NewBlobFileReader(
+        inputs[i]->file_number(), 0, db_options_,
+        blob_gc_->titan_cf_options(),
+        BlobFileEnvOptions(env_options_, blob_gc_->titan_cf_options()), env_,
+        &file);
     if (!s.ok()) {
       break;
     }
@@ -438,8 +634,11 @@ Status BlobGCJob::BuildIterator(
 }
 
 Status BlobGCJob::DiscardEntry(const Slice& key, const BlobIndex& blob_index,
-                               bool* discardable) {
-  TitanStopWatch sw(env_, metrics_.gc_read_lsm_micros);
+                               bool* discardable, GCMetrics* metrics) {
+  if (metrics == nullptr) {
+    metrics = &metrics_;
+  }
+  TitanStopWatch sw(env_, metrics->gc_read_lsm_micros);
   assert(discardable != nullptr);
   PinnableSlice index_entry;
   bool is_blob_index = false;
@@ -450,7 +649,7 @@ Status BlobGCJob::DiscardEntry(const Slice& key, const BlobIndex& blob_index,
     return s;
   }
   // count read bytes for checking LSM entry
-  metrics_.bytes_read += key.size() + index_entry.size();
+  metrics->bytes_read += key.size() + index_entry.size();
   if (s.IsNotFound() || !is_blob_index) {
     // Either the key is deleted or updated with a newer version which is
     // inlined in LSM.
@@ -571,14 +770,23 @@ Status BlobGCJob::InstallOutputBlobFiles() {
 }
 
 Status BlobGCJob::RewriteValidKeyToLSM() {
-  TitanStopWatch sw(env_, metrics_.gc_update_lsm_micros);
+  if (sub_jobs_.empty()) {
+    return Status::OK();
+  }
+  // Sub jobs rewrite disjoint sets of keys, so they can go concurrently.
+  return RunSubJobs(&BlobGCJob::RewriteValidKeyToLSM);
+}
+
+Status BlobGCJob::RewriteValidKeyToLSM(SubJob* sub_job) {
+  GCMetrics& metrics = sub_job->metrics;
+  TitanStopWatch sw(env_, metrics.gc_update_lsm_micros);
   Status s;
   auto* db_impl = reinterpret_cast<DBImpl*>(base_db_);
 
   WriteOptions wo;
   wo.low_pri = true;
   wo.ignore_missing_column_families = true;
-  for (auto& write_batch : rewrite_batches_) {
+  for (auto& write_batch : sub_job->rewrite_batches) {
     if (blob_gc_->GetColumnFamilyData()->IsDropped()) {
       s = Status::Aborted("Column family drop");
       break;
@@ -591,20 +799,20 @@ Status BlobGCJob::RewriteValidKeyToLSM() {
     s = db_impl->Write(wo, &write_batch.first);
     if (s.ok()) {
       // count written bytes for new blob index.
-      metrics_.bytes_written += write_batch.first.GetDataSize();
-      metrics_.gc_num_keys_relocated++;
-      metrics_.gc_bytes_relocated += write_batch.second.blob_record_size();
+      metrics.bytes_written += write_batch.first.GetDataSize();
+      metrics.gc_num_keys_relocated++;
+      metrics.gc_bytes_relocated += write_batch.second.blob_record_size();
       // Key is successfully written to LSM.
     } else if (s.IsBusy()) {
-      metrics_.gc_num_keys_overwritten++;
-      metrics_.gc_bytes_overwritten += write_batch.second.blob_record_size();
+      metrics.gc_num_keys_overwritten++;
+      metrics.gc_bytes_overwritten += write_batch.second.blob_record_size();
       // The key is overwritten in the meanwhile. Drop the blob record.
     } else {
       // We hit an error.
       break;
     }
     // count read bytes in write callback
-    metrics_.bytes_read += write_batch.second.read_bytes();
+    metrics.bytes_read += write_batch.second.read_bytes();
   }
   if (s.IsBusy()) {
     s = Status::OK();
@@ -41,6 +41,42 @@ class BlobGCJob {
   class GarbageCollectionWriteCallback;
   friend class BlobGCJobTest;
 
+  struct GCMetrics {
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t gc_num_keys_overwritten = 0;
+    uint64_t gc_bytes_overwritten = 0;
+    uint64_t gc_num_keys_relocated = 0;
+    uint64_t gc_bytes_relocated = 0;
+    uint64_t gc_num_new_files = 0;
+    uint64_t gc_num_files = 0;
+    uint64_t gc_small_file = 0;
+    uint64_t gc_discardable = 0;
+    uint64_t gc_sample = 0;
+    uint64_t gc_sampling_micros = 0;
+    uint64_t gc_read_lsm_micros = 0;
+    uint64_t gc_update_lsm_micros = 0;
+    uint64_t gc_total_micros = 0;
+    uint64_t gc_write_blob_micros = 0;
+    uint64_t gc_read_blob_micros = 0;
+
+    void Add(const GCMetrics& other);
+  };
+
+  // A GC job is split into sub jobs working on disjoint key ranges of the
+  // input files, which read, check and rewrite their entries concurrently.
+  struct SubJob {
+    std::vector<BlobFileMeta*> inputs;
+    std::vector<std::pair<std::unique_ptr<BlobFileHandle>,
+                          std::unique_ptr<BlobFileBuilder>>>
+        blob_file_builders;
+    std::vector<std::pair<WriteBatch, GarbageCollectionWriteCallback>>
+        rewrite_batches;
+    // Metrics of the sub job, merged into the job's after it's done.
+    GCMetrics metrics;
+    Status status;
+  };
+
   void UpdateInternalOpStats();
 
   BlobGC* blob_gc_;
@@ -52,38 +88,21 @@ class BlobGCJob {
   EnvOptions env_options_;
   BlobFileManager* blob_file_manager_;
   BlobFileSet* blob_file_set_;
+  BlobIOScheduler* io_scheduler_{nullptr};
   LogBuffer* log_buffer_{nullptr};
 
+  std::vector<SubJob> sub_jobs_;
+  // Output files of all the sub jobs, which are installed at once.
   std::vector<std::pair<std::unique_ptr<BlobFileHandle>,
                         std::unique_ptr<BlobFileBuilder>>>
       blob_file_builders_;
-  std::vector<std::pair<WriteBatch, GarbageCollectionWriteCallback>>
-      rewrite_batches_;
 
   std::atomic_bool* shuting_down_{nullptr};
 
   TitanStats* stats_;
 
 
-  struct {
-    uint64_t bytes_read = 0;
-    uint64_t bytes_written = 0;
-    uint64_t gc_num_keys_overwritten = 0;
-    uint64_t gc_bytes_overwritten = 0;
-    uint64_t gc_num_keys_relocated = 0;
-    uint64_t gc_bytes_relocated = 0;
-    uint64_t gc_num_new_files = 0;
-    uint64_t gc_num_files = 0;
-    uint64_t gc_small_file = 0;
-    uint64_t gc_discardable = 0;
-    uint64_t gc_sample = 0;
-    uint64_t gc_sampling_micros = 0;
-    uint64_t gc_read_lsm_micros = 0;
-    uint64_t gc_update_lsm_micros = 0;
-    uint64_t gc_total_micros = 0;
-    uint64_t gc_write_blob_micros = 0;
-    uint64_t gc_read_blob_micros = 0;
-  } metrics_;
+  GCMetrics metrics_;
 
   uint64_t prev_bytes_read_ = 0;
   uint64_t prev_bytes_written_ = 0;
@@ -95,12 +114,20 @@ class BlobGCJob {
 
   Status SampleCandidateFiles();
   Status DoSample(const BlobFileMeta* file, bool* selected);
-  Status DoRunGC();
-  Status BuildIterator(std::unique_ptr<BlobFileMergeIterator>* result);
+  // Splits the sampled inputs into at most `max_gc_subjobs` sub jobs.
+  void PartitionInputs();
+  // Runs "func" on every sub job concurrently, on the GC thread pool and
+  // the calling thread, and returns the first error.
+  Status RunSubJobs(Status (BlobGCJob::*func)(SubJob*));
+  Status DoRunGC(SubJob* sub_job);
+  Status BuildIterator(const std::vector<BlobFileMeta*>& inputs,
+                       std::unique_ptr<BlobFileMergeIterator>* result);
+  // Updates "*metrics", or the job's metrics if it's nullptr.
   Status DiscardEntry(const Slice& key, const BlobIndex& blob_index,
-                      bool* discardable);
+                      bool* discardable, GCMetrics* metrics = nullptr);
   Status InstallOutputBlobFiles();
   Status RewriteValidKeyToLSM();
+  Status RewriteValidKeyToLSM(SubJob* sub_job);
   Status DeleteInputBlobFiles();
 
   bool IsShutingDown();
@@ -1,4 +1,5 @@
 #include "rocksdb/convenience.h"
+#include "test_util/sync_point.h"
 #include "test_util/testharness.h"
 
 #include "blob_gc_job.h"
@@ -158,7 +159,8 @@ class BlobGCJobTest : public testing::Test {
       BlobGCJob blob_gc_job(blob_gc.get(), base_db_, mutex_, tdb_->db_options_,
                             tdb_->env_, EnvOptions(options_),
                             tdb_->blob_manager_.get(), blob_file_set_,
-                            &log_buffer, nullptr, nullptr);
+                            &log_buffer, nullptr, nullptr,
+                            &tdb_->builders_[cfh->GetID()]);
 
       s = blob_gc_job.Prepare();
       ASSERT_OK(s);
@@ -188,7 +190,8 @@ class BlobGCJobTest : public testing::Test {
                      std::unique_ptr<BlobFileIterator>* iter) {
     std::unique_ptr<RandomAccessFileReader> file;
     Status s = NewBlobFileReader(file_number, 0, tdb_->db_options_,
-                                 tdb_->env_options_, tdb_->env_, &file);
+                                 TitanCFOptions(), tdb_->env_options_,
+                                 tdb_->env_, &file);
     if (!s.ok()) {
       return s;
     }
@@ -216,7 +219,7 @@ class BlobGCJobTest : public testing::Test {
     blob_gc.SetColumnFamily(cfh);
     BlobGCJob blob_gc_job(&blob_gc, base_db_, mutex_, TitanDBOptions(),
                           Env::Default(), EnvOptions(), nullptr, blob_file_set_,
-                          nullptr, nullptr, nullptr);
+                          nullptr, nullptr, nullptr, nullptr);
     bool discardable = false;
     ASSERT_OK(blob_gc_job.DiscardEntry(key, blob_index, &discardable));
     ASSERT_FALSE(discardable);
@@ -279,12 +282,88 @@ class BlobGCJobTest : public testing::Test {
     ASSERT_FALSE(iter->Valid() || !iter->status().ok());
     DestroyDB();
   }
+
+  void TestSubJobs() {
+    const int kNumFiles = 4;
+    const int kNumKeysPerFile = 100;
+    options_.max_gc_subjobs = kNumFiles;
+    NewDB();
+    // Blob files are picked up by GC only after the flush listener marked
+    // them normal, which may happen after Flush() returns.
+    std::atomic<int> num_flushed{0};
+    int num_edits = 0;
+    SyncPoint::GetInstance()->SetCallBack(
+        "TitanDBImpl::OnFlushCompleted:Finished",
+        [&](void*) { num_flushed++; });
+    SyncPoint::GetInstance()->SetCallBack("BlobFileSet::LogAndApply",
+                                          [&](void*) { num_edits++; });
+    SyncPoint::GetInstance()->EnableProcessing();
+    // Every flush writes a blob file of its own key range, so each file
+    // becomes a sub job.
+    for (int i = 0; i < kNumFiles * kNumKeysPerFile; i++) {
+      ASSERT_OK(db_->Put(WriteOptions(), GenKey(i), GenValue(i)));
+      if ((i + 1) % kNumKeysPerFile == 0) {
+        Flush();
+      }
+    }
+    while (num_flushed < kNumFiles) {
+      options_.env->SleepForMicroseconds(1000);
+    }
+    auto b = GetBlobStorage(base_db_->DefaultColumnFamily()->GetID()).lock();
+    ASSERT_EQ(kNumFiles, b->files_.size());
+    std::vector<BlobFileMeta*> inputs;
+    for (auto& file : b->files_) {
+      inputs.push_back(file.second.get());
+    }
+    // The sub jobs run on the GC thread pool.
+    options_.env->IncBackgroundThreadsIfNeeded(kNumFiles - 1,
+                                               Env::Priority::USER);
+
+    num_edits = 0;
+    {
+      MutexLock l(mutex_);
+      auto* cfh = base_db_->DefaultColumnFamily();
+      BlobGC blob_gc(std::move(inputs), TitanCFOptions(options_),
+                     false /*trigger_next*/);
+      blob_gc.SetColumnFamily(cfh);
+      LogBuffer log_buffer(InfoLogLevel::INFO_LEVEL,
+                           tdb_->db_options_.info_log.get());
+      BlobGCJob blob_gc_job(&blob_gc, base_db_, mutex_, tdb_->db_options_,
+                            tdb_->env_, EnvOptions(options_),
+                            tdb_->blob_manager_.get(), blob_file_set_,
+                            &log_buffer, nullptr, nullptr,
+                            &tdb_->builders_[cfh->GetID()]);
+      ASSERT_OK(blob_gc_job.Prepare());
+      mutex_->Unlock();
+      Status s = blob_gc_job.Run();
+      mutex_->Lock();
+      ASSERT_OK(s);
+      ASSERT_EQ(kNumFiles, blob_gc_job.sub_jobs_.size());
+      ASSERT_OK(blob_gc_job.Finish());
+      // Each sub job wrote an output file of its own.
+      ASSERT_EQ(kNumFiles, blob_gc_job.metrics_.gc_num_new_files);
+      blob_gc.ReleaseGcFiles();
+    }
+    SyncPoint::GetInstance()->DisableProcessing();
+    SyncPoint::GetInstance()->ClearAllCallBacks();
+    // One edit adds the outputs of all the sub jobs, one deletes the inputs.
+    ASSERT_EQ(2, num_edits);
+
+    std::string value;
+    for (int i = 0; i < kNumFiles * kNumKeysPerFile; i++) {
+      ASSERT_OK(db_->Get(ReadOptions(), GenKey(i), &value));
+      ASSERT_EQ(GenValue(i), value);
+    }
+    DestroyDB();
+  }
 };
 
 TEST_F(BlobGCJobTest, DiscardEntry) { TestDiscardEntry(); }
 
 TEST_F(BlobGCJobTest, RunGC) { TestRunGC(); }
 
+TEST_F(BlobGCJobTest, SubJobs) { TestSubJobs(); }
+
 TEST_F(BlobGCJobTest, GCLimiter) {
   class TestLimiter : public RateLimiter {
    public:
@@ -613,7 +692,8 @@ TEST_F(BlobGCJobTest, RangeMergeScheduler) {
   auto add_file = [&](int file_num, const std::string& smallest,
                       const std::string& largest) {
     auto file =
-        std::make_shared<BlobFileMeta>(file_num, 0, 0, 0, smallest, largest);
+        std::make_shared<BlobFileMeta>(file_num, 0, 0, 0, smallest, largest,
+                                       kSorted);
     file->FileStateTransit(BlobFileMeta::FileEvent::kReset);
     files.emplace_back(file);
   };
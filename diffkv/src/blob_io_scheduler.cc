@@ -0,0 +1,114 @@
+#include "blob_io_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "monitoring/statistics.h"
+
+namespace rocksdb {
+namespace titandb {
+
+static_assert(TitanStats::BLOB_IO_GC_BYTES - TitanStats::BLOB_IO_FLUSH_BYTES ==
+                  static_cast<uint32_t>(BlobIOSource::kGC),
+              "Tickers of blob I/O must follow the order of BlobIOSource");
+
+const uint64_t BlobIOScheduler::kRefillPeriodMicros;
+const uint64_t BlobIOScheduler::kTunePeriods;
+const uint64_t BlobIOScheduler::kMinTuneSamples;
+const uint64_t BlobIOCharger::kBatchBytes;
+
+std::shared_ptr<BlobIOScheduler> NewBlobIOScheduler(uint64_t bytes_per_sec,
+                                                    uint64_t target_p99_micros,
+                                                    Env* env) {
+  return std::make_shared<BlobIOScheduler>(bytes_per_sec, target_p99_micros,
+                                           env);
+}
+
+BlobIOScheduler::BlobIOScheduler(uint64_t max_bytes_per_sec,
+                                 uint64_t target_p99_micros, Env* env)
+    : max_bytes_per_sec_(std::max<uint64_t>(max_bytes_per_sec, 1)),
+      min_bytes_per_sec_(std::max<uint64_t>(max_bytes_per_sec_ / 16, 1)),
+      target_p99_micros_(target_p99_micros),
+      env_(env),
+      bytes_per_sec_(max_bytes_per_sec_) {
+  available_bytes_ =
+      static_cast<int64_t>(max_bytes_per_sec_ * kRefillPeriodMicros / 1000000);
+  next_refill_micros_ = env_->NowMicros() + kRefillPeriodMicros;
+  for (auto& bytes : total_bytes_) {
+    bytes.store(0, std::memory_order_relaxed);
+  }
+}
+
+void BlobIOScheduler::Request(uint64_t bytes, BlobIOSource source,
+                              TitanStats* stats) {
+  total_bytes_[static_cast<uint32_t>(source)].fetch_add(
+      bytes, std::memory_order_relaxed);
+  RecordTick(stats,
+             TitanStats::BLOB_IO_FLUSH_BYTES + static_cast<uint32_t>(source),
+             bytes);
+
+  std::unique_lock<std::mutex> l(mutex_);
+  uint64_t now = env_->NowMicros();
+  Refill(now);
+  if (source == BlobIOSource::kFlush) {
+    available_bytes_ -= static_cast<int64_t>(bytes);
+    return;
+  }
+  uint64_t start = now;
+  while (available_bytes_ <= 0) {
+    cv_.wait_for(l, std::chrono::microseconds(next_refill_micros_ - now));
+    now = std::max(env_->NowMicros(), now);
+    Refill(now);
+  }
+  available_bytes_ -= static_cast<int64_t>(bytes);
+  if (now > start) {
+    total_throttled_micros_.fetch_add(now - start, std::memory_order_relaxed);
+    RecordTick(stats, TitanStats::BLOB_IO_THROTTLED_MICROS, now - start);
+  }
+}
+
+void BlobIOScheduler::RecordForegroundLatency(uint64_t micros) {
+  if (target_p99_micros_ > 0) {
+    foreground_latency_.Add(micros);
+  }
+}
+
+void BlobIOScheduler::Refill(uint64_t now) {
+  if (now < next_refill_micros_) {
+    return;
+  }
+  uint64_t periods = (now - next_refill_micros_) / kRefillPeriodMicros + 1;
+  next_refill_micros_ += periods * kRefillPeriodMicros;
+  // The bucket holds at most one period of budget.
+  int64_t burst = static_cast<int64_t>(
+      bytes_per_sec_.load(std::memory_order_relaxed) * kRefillPeriodMicros /
+      1000000);
+  available_bytes_ = std::min(
+      available_bytes_ + static_cast<int64_t>(periods) * burst, burst);
+  refills_since_tune_ += periods;
+  if (refills_since_tune_ >= kTunePeriods) {
+    refills_since_tune_ = 0;
+    Tune();
+  }
+  cv_.notify_all();
+}
+
+void BlobIOScheduler::Tune() {
+  if (target_p99_micros_ == 0 ||
+      foreground_latency_.num() < kMinTuneSamples) {
+    return;
+  }
+  double p99 = foreground_latency_.Percentile(99);
+  foreground_latency_.Clear();
+  uint64_t rate = bytes_per_sec_.load(std::memory_order_relaxed);
+  if (p99 > target_p99_micros_) {
+    rate = std::max(rate - rate / 4, min_bytes_per_sec_);
+  } else if (p99 < target_p99_micros_ * 0.8) {
+    rate = std::min(rate + std::max<uint64_t>(rate / 10, 1),
+                    max_bytes_per_sec_);
+  }
+  bytes_per_sec_.store(rate, std::memory_order_relaxed);
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
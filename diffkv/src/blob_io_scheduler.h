@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "monitoring/histogram.h"
+#include "rocksdb/env.h"
+#include "titan_stats.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// Background work that rewrites blob values.
+enum class BlobIOSource : uint32_t {
+  kFlush = 0,
+  kCompaction = 1,  // separation and level/range merge during compaction
+  kGC = 2,
+  kNumSources,
+};
+
+// A token bucket shared by all the background blob I/O of a DB.
+//
+// Compaction and GC wait for tokens before they read or write blob
+// records. Flush is charged as well but never waits, since throttling it
+// would stall foreground writes; it leaves less budget to the others.
+//
+// If a target p99 latency of foreground reads is given, the rate adapts
+// to the observed latency: it's cut by a quarter whenever the p99 of the
+// last tuning period exceeds the target, and raised by a tenth when it's
+// well below, within [max_bytes_per_sec / 16, max_bytes_per_sec].
+class BlobIOScheduler {
+ public:
+  BlobIOScheduler(uint64_t max_bytes_per_sec, uint64_t target_p99_micros,
+                  Env* env);
+
+  // Charges "bytes" of I/O to "source", blocking until the budget allows
+  // it unless the source is flush.
+  void Request(uint64_t bytes, BlobIOSource source, TitanStats* stats);
+
+  // Records the latency of a foreground read.
+  void RecordForegroundLatency(uint64_t micros);
+
+  uint64_t GetBytesPerSecond() const {
+    return bytes_per_sec_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t GetMaxBytesPerSecond() const { return max_bytes_per_sec_; }
+
+  uint64_t GetTotalBytes(BlobIOSource source) const {
+    return total_bytes_[static_cast<uint32_t>(source)].load(
+        std::memory_order_relaxed);
+  }
+
+  uint64_t GetTotalThrottledMicros() const {
+    return total_throttled_micros_.load(std::memory_order_relaxed);
+  }
+
+  // Length of a refill period.
+  static const uint64_t kRefillPeriodMicros = 10 * 1000;
+  // Number of refill periods between two rate adjustments.
+  static const uint64_t kTunePeriods = 100;
+  // Minimal number of foreground samples needed to adjust the rate.
+  static const uint64_t kMinTuneSamples = 100;
+
+ private:
+  // Refills the bucket and retunes the rate. REQUIRES: mutex_ held.
+  void Refill(uint64_t now);
+  void Tune();
+
+  const uint64_t max_bytes_per_sec_;
+  const uint64_t min_bytes_per_sec_;
+  const uint64_t target_p99_micros_;
+  Env* env_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<uint64_t> bytes_per_sec_;
+  // May go negative after flush or a request bigger than the bucket.
+  int64_t available_bytes_;
+  uint64_t next_refill_micros_;
+  uint64_t refills_since_tune_{0};
+
+  HistogramImpl foreground_latency_;
+
+  std::atomic<uint64_t>
+      total_bytes_[static_cast<uint32_t>(BlobIOSource::kNumSources)];
+  std::atomic<uint64_t> total_throttled_micros_{0};
+};
+
+// Charges the I/O of a single job to a scheduler in batches of
+// kBatchBytes, so that the job doesn't take the scheduler's lock for
+// every record. What's left is charged on Flush() or destruction.
+// Not thread-safe.
+class BlobIOCharger {
+ public:
+  BlobIOCharger(BlobIOScheduler* scheduler, BlobIOSource source,
+                TitanStats* stats)
+      : scheduler_(scheduler), source_(source), stats_(stats) {}
+
+  ~BlobIOCharger() { Flush(); }
+
+  void Charge(uint64_t bytes) {
+    if (scheduler_ == nullptr) {
+      return;
+    }
+    pending_bytes_ += bytes;
+    if (pending_bytes_ >= kBatchBytes) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    if (pending_bytes_ > 0) {
+      scheduler_->Request(pending_bytes_, source_, stats_);
+      pending_bytes_ = 0;
+    }
+  }
+
+  static const uint64_t kBatchBytes = 64 << 10;
+
+ private:
+  BlobIOScheduler* scheduler_;
+  const BlobIOSource source_;
+  TitanStats* stats_;
+  uint64_t pending_bytes_{0};
+};
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -0,0 +1,135 @@
+#include "blob_io_scheduler.h"
+
+#include "port/port.h"
+#include "test_util/testharness.h"
+
+namespace rocksdb {
+namespace titandb {
+
+class BlobIOSchedulerTest : public testing::Test {};
+
+class ManualClockEnv : public EnvWrapper {
+ public:
+  ManualClockEnv() : EnvWrapper(Env::Default()) {}
+
+  uint64_t NowMicros() override { return now_micros_.load(); }
+
+  void Advance(uint64_t micros) { now_micros_.fetch_add(micros); }
+
+ private:
+  std::atomic<uint64_t> now_micros_{1000000};
+};
+
+TEST(BlobIOSchedulerTest, Throttle) {
+  const uint64_t kRate = 1 << 20;
+  const uint64_t kPeriod = BlobIOScheduler::kRefillPeriodMicros;
+  ManualClockEnv env;
+  BlobIOScheduler scheduler(kRate, 0, &env);
+  const uint64_t kBurst = kRate * kPeriod / 1000000;
+
+  // Flush is only charged, it doesn't wait for the clock.
+  for (int i = 0; i < 100; i++) {
+    scheduler.Request(kBurst, BlobIOSource::kFlush, nullptr);
+  }
+  ASSERT_EQ(scheduler.GetTotalBytes(BlobIOSource::kFlush), 100 * kBurst);
+  ASSERT_EQ(scheduler.GetTotalThrottledMicros(), 0);
+
+  // The debt of flush is paid by GC. The bucket holds one burst and flush
+  // took 100, so GC gets nothing for 99 refill periods and one burst in
+  // each period afterwards.
+  const int kNumRequests = 10;
+  std::atomic<int> num_done{0};
+  port::Thread gc([&]() {
+    for (int i = 0; i < kNumRequests; i++) {
+      scheduler.Request(kBurst, BlobIOSource::kGC, nullptr);
+      num_done++;
+    }
+  });
+  env.Advance(99 * kPeriod);
+  // A waiting request checks the clock again at least once a period of
+  // real time.
+  Env::Default()->SleepForMicroseconds(static_cast<int>(5 * kPeriod));
+  ASSERT_EQ(0, num_done.load());
+  for (int i = 1; i <= kNumRequests; i++) {
+    env.Advance(kPeriod);
+    while (num_done.load() < i) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    ASSERT_EQ(i, num_done.load());
+  }
+  gc.join();
+  ASSERT_EQ(scheduler.GetTotalBytes(BlobIOSource::kGC), kNumRequests * kBurst);
+  ASSERT_GE(scheduler.GetTotalThrottledMicros(), kNumRequests * kPeriod);
+  ASSERT_EQ(scheduler.GetTotalBytes(BlobIOSource::kCompaction), 0);
+}
+
+TEST(BlobIOSchedulerTest, Charger) {
+  ManualClockEnv env;
+  BlobIOScheduler scheduler(1 << 30, 0, &env);
+  const uint64_t kBatch = BlobIOCharger::kBatchBytes;
+  {
+    BlobIOCharger charger(&scheduler, BlobIOSource::kCompaction, nullptr);
+    // Charges are held until they make a batch.
+    charger.Charge(kBatch - 1);
+    ASSERT_EQ(scheduler.GetTotalBytes(BlobIOSource::kCompaction), 0);
+    charger.Charge(2);
+    ASSERT_EQ(scheduler.GetTotalBytes(BlobIOSource::kCompaction), kBatch + 1);
+    // The rest is charged on destruction.
+    charger.Charge(1);
+  }
+  ASSERT_EQ(scheduler.GetTotalBytes(BlobIOSource::kCompaction), kBatch + 2);
+
+  // Nothing to charge without a scheduler.
+  BlobIOCharger charger(nullptr, BlobIOSource::kGC, nullptr);
+  charger.Charge(kBatch);
+  charger.Flush();
+}
+
+TEST(BlobIOSchedulerTest, AdaptToForegroundLatency) {
+  const uint64_t kRate = 64 << 20;
+  ManualClockEnv env;
+  BlobIOScheduler scheduler(kRate, 100 /* target_p99_micros */, &env);
+  const uint64_t kTuneMicros =
+      BlobIOScheduler::kTunePeriods * BlobIOScheduler::kRefillPeriodMicros;
+  // Requests of flush never wait, they just trigger the refills.
+  auto next_tune_period = [&]() {
+    env.Advance(kTuneMicros);
+    scheduler.Request(1, BlobIOSource::kFlush, nullptr);
+  };
+
+  // Too few samples to tune.
+  scheduler.RecordForegroundLatency(1000);
+  next_tune_period();
+  ASSERT_EQ(scheduler.GetBytesPerSecond(), kRate);
+
+  // Slow foreground reads cut the rate, down to 1/16 of the max.
+  uint64_t rate = kRate;
+  for (int i = 0; i < 20; i++) {
+    for (uint64_t j = 0; j < BlobIOScheduler::kMinTuneSamples; j++) {
+      scheduler.RecordForegroundLatency(1000);
+    }
+    next_tune_period();
+    ASSERT_LE(scheduler.GetBytesPerSecond(), rate);
+    rate = scheduler.GetBytesPerSecond();
+  }
+  ASSERT_EQ(scheduler.GetBytesPerSecond(), kRate / 16);
+
+  // Fast ones raise it back, up to the max.
+  for (int i = 0; i < 50; i++) {
+    for (uint64_t j = 0; j < BlobIOScheduler::kMinTuneSamples; j++) {
+      scheduler.RecordForegroundLatency(10);
+    }
+    next_tune_period();
+    ASSERT_GE(scheduler.GetBytesPerSecond(), rate);
+    rate = scheduler.GetBytesPerSecond();
+  }
+  ASSERT_EQ(scheduler.GetBytesPerSecond(), kRate);
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+#include "blob_size_controller.h"
+
+#include <algorithm>
+
+#include "monitoring/statistics.h"
+
+namespace rocksdb {
+namespace titandb {
+
+namespace {
+
+// Bytes of a blob index kept in the LSM-tree for a separated value.
+const double kBlobIndexSize = 16;
+// The smallest read of a blob file.
+const double kBlockSize = 4096;
+// Writes of a value separated at flush: the WAL, the sorted blob file and
+// one level merge.
+const double kSortedWrites = 3;
+
+// Bytes GC rewrites for every byte of garbage it reclaims from unsorted
+// blob files, which are picked once that much of them is discardable.
+double GCRewrites(double discardable_ratio) {
+  discardable_ratio = std::min(std::max(discardable_ratio, 0.05), 1.0);
+  return (1 - discardable_ratio) / discardable_ratio;
+}
+
+}  // namespace
+
+const int BlobSizeController::kNumSizeClasses;
+const uint64_t BlobSizeController::kMinSamples;
+const double BlobSizeController::kMinGain = 0.05;
+const uint64_t BlobSizeController::kMinThreshold;
+const uint64_t BlobSizeController::kMaxThreshold;
+
+BlobSizeController::BlobSizeController(const TitanDBOptions& db_options,
+                                       const TitanCFOptions& cf_options,
+                                       TitanStats* stats)
+    : lsm_rewrites_(std::max(1, cf_options.num_levels - 1)),
+      gc_rewrites_(GCRewrites(cf_options.blob_file_discardable_ratio)),
+      separate_before_flush_(db_options.sep_before_flush),
+      tune_mid_blob_size_(db_options.sep_before_flush &&
+                          cf_options.level_merge),
+      stats_(stats),
+      min_blob_size_(cf_options.min_blob_size),
+      mid_blob_size_(cf_options.mid_blob_size) {
+  for (int i = 0; i < kNumSizeClasses; i++) {
+    writes_[i].store(0, std::memory_order_relaxed);
+    write_bytes_[i].store(0, std::memory_order_relaxed);
+    reads_[i].store(0, std::memory_order_relaxed);
+    class_writes_[i] = 0;
+    class_write_bytes_[i] = 0;
+    class_reads_[i] = 0;
+  }
+}
+
+int BlobSizeController::SizeClass(uint64_t size) {
+  int size_class = 0;
+  while (size > 1 && size_class < kNumSizeClasses - 1) {
+    size >>= 1;
+    size_class++;
+  }
+  return size_class;
+}
+
+void BlobSizeController::RecordWrite(uint64_t value_size) {
+  int size_class = SizeClass(value_size);
+  writes_[size_class].fetch_add(1, std::memory_order_relaxed);
+  write_bytes_[size_class].fetch_add(value_size, std::memory_order_relaxed);
+  RecordTick(stats_,
+             value_size >= min_blob_size_.load(std::memory_order_relaxed)
+                 ? TitanStats::BLOB_SIZE_SEPARATED_WRITE_BYTES
+                 : TitanStats::BLOB_SIZE_INLINE_WRITE_BYTES,
+             value_size);
+}
+
+void BlobSizeController::RecordRead(uint64_t value_size, bool is_blob) {
+  reads_[SizeClass(value_size)].fetch_add(1, std::memory_order_relaxed);
+  RecordTick(stats_,
+             is_blob ? TitanStats::BLOB_SIZE_SEPARATED_READ_BYTES
+                     : TitanStats::BLOB_SIZE_INLINE_READ_BYTES,
+             value_size);
+}
+
+double BlobSizeController::Cost(uint64_t min_blob_size,
+                                uint64_t mid_blob_size) const {
+  double cost = 0;
+  for (int i = 0; i < kNumSizeClasses; i++) {
+    double writes = class_writes_[i];
+    double bytes = class_write_bytes_[i];
+    double reads = class_reads_[i];
+    if (writes == 0 && reads == 0) {
+      continue;
+    }
+    uint64_t class_size = uint64_t{1} << i;
+    double value_size = writes > 0 ? bytes / writes : class_size;
+    if (class_size < min_blob_size) {
+      cost += bytes * lsm_rewrites_;
+      continue;
+    }
+    cost += writes * kBlobIndexSize * lsm_rewrites_;
+    double read_size = std::max(value_size, kBlockSize);
+    bool unsorted = tune_mid_blob_size_ ? class_size >= mid_blob_size
+                                        : separate_before_flush_;
+    if (unsorted) {
+      cost += bytes * (1 + gc_rewrites_) + reads * (read_size + kBlockSize);
+    } else {
+      cost += bytes * kSortedWrites + reads * read_size;
+    }
+  }
+  return cost;
+}
+
+bool BlobSizeController::Tune(uint64_t* min_blob_size,
+                              uint64_t* mid_blob_size) {
+  std::unique_lock<std::mutex> l(mutex_);
+  for (int i = 0; i < kNumSizeClasses; i++) {
+    uint64_t writes = writes_[i].exchange(0, std::memory_order_relaxed);
+    class_writes_[i] += writes;
+    class_write_bytes_[i] +=
+        write_bytes_[i].exchange(0, std::memory_order_relaxed);
+    class_reads_[i] += reads_[i].exchange(0, std::memory_order_relaxed);
+    pending_writes_ += writes;
+  }
+  if (pending_writes_ < kMinSamples) {
+    return false;
+  }
+
+  uint64_t current_min = min_blob_size_.load();
+  uint64_t current_mid = mid_blob_size_.load();
+  double current_cost = Cost(current_min, current_mid);
+  uint64_t best_min = current_min;
+  uint64_t best_mid = current_mid;
+  double best_cost = current_cost;
+  for (uint64_t min_size = kMinThreshold; min_size <= kMaxThreshold;
+       min_size <<= 1) {
+    if (!tune_mid_blob_size_) {
+      double cost = Cost(min_size, current_mid);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_min = min_size;
+      }
+      continue;
+    }
+    for (uint64_t mid_size = min_size; mid_size <= kMaxThreshold;
+         mid_size <<= 1) {
+      double cost = Cost(min_size, mid_size);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_min = min_size;
+        best_mid = mid_size;
+      }
+    }
+  }
+
+  // Older samples weigh half as much at every evaluation, so the thresholds
+  // follow the workload as it shifts.
+  for (int i = 0; i < kNumSizeClasses; i++) {
+    class_writes_[i] /= 2;
+    class_write_bytes_[i] /= 2;
+    class_reads_[i] /= 2;
+  }
+  pending_writes_ = 0;
+
+  if (best_cost >= current_cost * (1 - kMinGain) ||
+      (best_min == current_min && best_mid == current_mid)) {
+    return false;
+  }
+  *min_blob_size = best_min;
+  *mid_blob_size = best_mid;
+  RecordTick(stats_, TitanStats::BLOB_SIZE_CHANGES);
+  return true;
+}
+
+void BlobSizeController::SetThresholds(uint64_t min_blob_size,
+                                       uint64_t mid_blob_size) {
+  min_blob_size_.store(min_blob_size);
+  mid_blob_size_.store(mid_blob_size);
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
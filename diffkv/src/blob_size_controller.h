@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include "titan/options.h"
+#include "titan_stats.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// Learns where to separate the values of a column family from its
+// workload. Writes and point reads are counted per power-of-two size
+// class, and Tune() picks the min_blob_size and mid_blob_size that
+// minimize an estimate of the bytes written and read for them:
+//
+// * A value kept inline is rewritten by compaction about once per level.
+// * A value in [min_blob_size, mid_blob_size) goes through the WAL and is
+//   separated into a sorted blob file at flush, which level merge rewrites
+//   once more. Reading it costs a blob read of at least a block.
+// * A value of at least mid_blob_size is separated before the memtable
+//   into an unsorted blob file, which GC rewrites depending on
+//   blob_file_discardable_ratio. Its records are in arrival order, so a
+//   read is charged one more block for the locality it lacks.
+//
+// mid_blob_size only splits the two paths with both sep_before_flush and
+// level_merge; otherwise it is left alone and every separated value takes
+// the one path there is.
+//
+// Separated values leave a blob index in the LSM-tree, which is charged
+// like an inline value. Thresholds only route new writes; blob files
+// written under earlier thresholds stay readable as they are.
+class BlobSizeController {
+ public:
+  // Size classes are [2^i, 2^(i+1)) bytes, the last one is open-ended.
+  static const int kNumSizeClasses = 32;
+
+  // Tune() needs at least this many writes since its last change.
+  static const uint64_t kMinSamples = 1000;
+
+  // A change has to save this fraction of the estimated cost.
+  static const double kMinGain;
+
+  // Thresholds are kept within [kMinThreshold, kMaxThreshold].
+  static const uint64_t kMinThreshold = 32;
+  static const uint64_t kMaxThreshold = 1 << 20;
+
+  BlobSizeController(const TitanDBOptions& db_options,
+                     const TitanCFOptions& cf_options, TitanStats* stats);
+
+  // Counts a value written by the user.
+  void RecordWrite(uint64_t value_size);
+
+  // Counts a value returned by a point lookup, either inline or read from
+  // a blob file.
+  void RecordRead(uint64_t value_size, bool is_blob);
+
+  // Computes new thresholds from the samples since the last change and
+  // returns true if they differ enough from the current ones to be set.
+  bool Tune(uint64_t* min_blob_size, uint64_t* mid_blob_size);
+
+  // Sets the current thresholds, when they are changed by SetOptions.
+  void SetThresholds(uint64_t min_blob_size, uint64_t mid_blob_size);
+
+  uint64_t min_blob_size() const { return min_blob_size_.load(); }
+  uint64_t mid_blob_size() const { return mid_blob_size_.load(); }
+
+ private:
+  static int SizeClass(uint64_t size);
+
+  // Estimated bytes of I/O of all samples under the given thresholds.
+  double Cost(uint64_t min_blob_size, uint64_t mid_blob_size) const;
+
+  const double lsm_rewrites_;
+  const double gc_rewrites_;
+  const bool separate_before_flush_;
+  const bool tune_mid_blob_size_;
+  TitanStats* stats_;
+
+  std::atomic<uint64_t> min_blob_size_;
+  std::atomic<uint64_t> mid_blob_size_;
+
+  // Samples since the last Tune().
+  std::array<std::atomic<uint64_t>, kNumSizeClasses> writes_;
+  std::array<std::atomic<uint64_t>, kNumSizeClasses> write_bytes_;
+  std::array<std::atomic<uint64_t>, kNumSizeClasses> reads_;
+
+  // Decayed history of the samples, guarded by mutex_.
+  std::mutex mutex_;
+  std::array<double, kNumSizeClasses> class_writes_;
+  std::array<double, kNumSizeClasses> class_write_bytes_;
+  std::array<double, kNumSizeClasses> class_reads_;
+  double pending_writes_{0};
+};
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -0,0 +1,89 @@
+#include "blob_size_controller.h"
+
+#include "test_util/testharness.h"
+
+namespace rocksdb {
+namespace titandb {
+
+class BlobSizeControllerTest : public testing::Test {
+ public:
+  BlobSizeControllerTest() {
+    db_options_.sep_before_flush = true;
+    cf_options_.level_merge = true;
+    cf_options_.min_blob_size = 128;
+    cf_options_.mid_blob_size = 4096;
+  }
+
+  TitanDBOptions db_options_;
+  TitanCFOptions cf_options_;
+};
+
+TEST_F(BlobSizeControllerTest, NotEnoughSamples) {
+  BlobSizeController controller(db_options_, cf_options_, nullptr);
+  for (uint64_t i = 0; i < BlobSizeController::kMinSamples / 2; i++) {
+    controller.RecordWrite(64);
+  }
+  uint64_t min_blob_size = 0;
+  uint64_t mid_blob_size = 0;
+  ASSERT_FALSE(controller.Tune(&min_blob_size, &mid_blob_size));
+}
+
+TEST_F(BlobSizeControllerTest, SmallReadHotValuesStayInline) {
+  BlobSizeController controller(db_options_, cf_options_, nullptr);
+  // Small values read many times more than they are written are cheaper
+  // to keep in the LSM-tree than to read from blob files.
+  for (uint64_t i = 0; i < BlobSizeController::kMinSamples; i++) {
+    controller.RecordWrite(512);
+    for (int j = 0; j < 10; j++) {
+      controller.RecordRead(512, true /*is_blob*/);
+    }
+  }
+  uint64_t min_blob_size = 0;
+  uint64_t mid_blob_size = 0;
+  ASSERT_TRUE(controller.Tune(&min_blob_size, &mid_blob_size));
+  ASSERT_GT(min_blob_size, 512);
+  ASSERT_LE(min_blob_size, mid_blob_size);
+}
+
+TEST_F(BlobSizeControllerTest, WriteOnlyValuesAreSeparated) {
+  BlobSizeController controller(db_options_, cf_options_, nullptr);
+  // Values never read are cheapest to separate before the memtable.
+  for (uint64_t i = 0; i < BlobSizeController::kMinSamples; i++) {
+    controller.RecordWrite(100);
+    controller.RecordWrite(2048);
+  }
+  uint64_t min_blob_size = 0;
+  uint64_t mid_blob_size = 0;
+  ASSERT_TRUE(controller.Tune(&min_blob_size, &mid_blob_size));
+  ASSERT_LE(min_blob_size, 64);
+  ASSERT_LE(mid_blob_size, 64);
+
+  // Applied thresholds are kept while the workload doesn't change.
+  controller.SetThresholds(min_blob_size, mid_blob_size);
+  for (uint64_t i = 0; i < BlobSizeController::kMinSamples; i++) {
+    controller.RecordWrite(100);
+    controller.RecordWrite(2048);
+  }
+  ASSERT_FALSE(controller.Tune(&min_blob_size, &mid_blob_size));
+}
+
+TEST_F(BlobSizeControllerTest, MidBlobSizeNeedsLevelMerge) {
+  cf_options_.level_merge = false;
+  BlobSizeController controller(db_options_, cf_options_, nullptr);
+  for (uint64_t i = 0; i < BlobSizeController::kMinSamples; i++) {
+    controller.RecordWrite(100);
+  }
+  uint64_t min_blob_size = 0;
+  uint64_t mid_blob_size = 0;
+  ASSERT_TRUE(controller.Tune(&min_blob_size, &mid_blob_size));
+  ASSERT_LE(min_blob_size, 64);
+  ASSERT_EQ(mid_blob_size, 4096);
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -2,6 +2,8 @@
 #include "atomic"
 #include "blob_file_set.h"
 #include "iostream"
+#include "titan_perf_context_imp.h"
+#include "util.h"
 
 std::atomic<uint64_t> compute_gc_score{0};
 
@@ -26,6 +28,13 @@ bool BlobStorage::ShouldGCLowLevel() {
 
 Status BlobStorage::Get(const ReadOptions &options, const BlobIndex &index,
                         BlobRecord *record, PinnableSlice *buffer) {
+  if (value_cache_ && value_cache_->Lookup(index.file_number,
+                                           index.blob_handle.offset, buffer)) {
+    TITAN_PERF_COUNTER_ADD(blob_value_cache_hit_count, 1);
+    record->key = Slice();
+    record->value = *buffer;
+    return Status::OK();
+  }
   auto sfile = FindFile(index.file_number).lock();
   if (!sfile) {
     if (db_options_.sep_before_flush) {
@@ -39,8 +48,72 @@ Status BlobStorage::Get(const ReadOptions &options, const BlobIndex &index,
   } else {
     record->only_value = false;
   }
-  return file_cache_->Get(options, sfile->file_number(), sfile->file_size(),
-                          index.blob_handle, record, buffer);
+  Status s = file_cache_->Get(options, sfile->file_number(),
+                              sfile->file_size(), index.blob_handle, record,
+                              buffer);
+  if (s.ok() && value_cache_ && options.fill_cache) {
+    value_cache_->MaybeInsert(index.file_number, index.blob_handle.offset,
+                              record->value);
+  }
+  return s;
+}
+
+void BlobStorage::MultiGet(const ReadOptions &options, size_t num,
+                           const BlobIndex *indexes, BlobRecord *records,
+                           PinnableSlice *buffers, Status *statuses) {
+  std::vector<BlobReadRequest> requests;
+  std::vector<size_t> positions;
+  requests.reserve(num);
+  positions.reserve(num);
+  for (size_t i = 0; i < num; i++) {
+    const BlobIndex &index = indexes[i];
+    if (value_cache_ && value_cache_->Lookup(index.file_number,
+                                             index.blob_handle.offset,
+                                             &buffers[i])) {
+      TITAN_PERF_COUNTER_ADD(blob_value_cache_hit_count, 1);
+      records[i].key = Slice();
+      records[i].value = buffers[i];
+      statuses[i] = Status::OK();
+      continue;
+    }
+    auto sfile = FindFile(index.file_number).lock();
+    if (!sfile) {
+      statuses[i] = db_options_.sep_before_flush
+                        ? ReadBuildingFile(options, index, &records[i])
+                        : Status::Corruption("Missing blob file: " +
+                                             std::to_string(index.file_number));
+      continue;
+    }
+    records[i].only_value =
+        cf_options_.level_merge && sfile->file_type() == kSorted;
+    BlobReadRequest request;
+    request.file_number = sfile->file_number();
+    request.file_size = sfile->file_size();
+    request.handle = index.blob_handle;
+    request.record = &records[i];
+    request.buffer = &buffers[i];
+    requests.push_back(request);
+    positions.push_back(i);
+  }
+  if (requests.empty()) {
+    return;
+  }
+
+  std::vector<BlobReadRequest *> batch;
+  batch.reserve(requests.size());
+  for (auto &request : requests) {
+    batch.push_back(&request);
+  }
+  file_cache_->MultiGet(options, &batch);
+  for (size_t k = 0; k < requests.size(); k++) {
+    size_t i = positions[k];
+    statuses[i] = requests[k].status;
+    if (statuses[i].ok() && value_cache_ && options.fill_cache) {
+      value_cache_->MaybeInsert(indexes[i].file_number,
+                                indexes[i].blob_handle.offset,
+                                records[i].value);
+    }
+  }
 }
 
 Status BlobStorage::ReadBuildingFile(const ReadOptions &options,
@@ -172,6 +245,7 @@ void BlobStorage::AddBlobFile(std::shared_ptr<BlobFileMeta> &file) {
   if (db_options_.sep_before_flush) {
     building_files_.erase(file->file_number());
   }
+  UpdateGCScoreLocked(*file);
 }
 
 Status BlobStorage::AddBuildingFile(uint64_t file_number) {
@@ -179,7 +253,7 @@ Status BlobStorage::AddBuildingFile(uint64_t file_number) {
   Status s;
   {
     std::unique_ptr<RandomAccessFile> file;
-    auto file_name = BlobFileName(db_options_.dirname, file_number);
+    auto file_name = BlobFilePath(db_options_, cf_options_, file_number);
     s = env_->NewRandomAccessFile(file_name, &file, env_options_);
     if (!s.ok()) return s;
     if (db_options_.advise_random_on_open) {
@@ -210,6 +284,7 @@ void BlobStorage::MarkFileObsoleteLocked(std::shared_ptr<BlobFileMeta> file,
   obsolete_files_.push_back(
       std::make_pair(file->file_number(), obsolete_sequence));
   file->FileStateTransit(BlobFileMeta::FileEvent::kDelete);
+  UpdateGCScoreLocked(*file);
   SubStats(stats_, cf_id_, TitanInternalStats::LIVE_BLOB_SIZE,
            file->file_size() - file->discardable_size());
   SubStats(stats_, cf_id_, TitanInternalStats::LIVE_BLOB_FILE_SIZE,
@@ -410,7 +485,7 @@ void BlobStorage::GetObsoleteFiles(std::vector<std::string> *obsolete_files,
                      file_number, obsolete_sequence, oldest_sequence);
       if (obsolete_files) {
         obsolete_files->emplace_back(
-            BlobFileName(db_options_.dirname, file_number));
+            BlobFilePath(db_options_, cf_options_, file_number));
       }
 
       it = obsolete_files_.erase(it);
@@ -421,49 +496,74 @@ void BlobStorage::GetObsoleteFiles(std::vector<std::string> *obsolete_files,
 }
 
 size_t BlobStorage::ComputeGCScore() {
-  // TODO: no need to recompute all everytime
   std::unique_lock<std::mutex> l(mutex_);
   uint64_t start = 0;
   {
     TitanStopWatch sw(env_, start);
-    gc_score_.clear();
-
+    file_gc_score_.clear();
     for (auto &file : files_) {
-      if (file.second->is_obsolete() ||
-          (cf_options_.level_merge && (file.second->file_type() == kSorted || file.second->GetDiscardableRatio() <
-              cf_options_.blob_file_discardable_ratio))) {
-        continue;
-      }
-      gc_score_.push_back({});
-      auto &gcs = gc_score_.back();
-      gcs.file_number = file.first;
-      if (file.second->file_size() <
-          cf_options_.merge_small_file_threshold /* ||
-file.second->gc_mark()*/
-      ) {
-        // for the small file or file with gc mark (usually the file that just
-        // recovered) we want gc these file but more hope to gc other file with
-        // more invalid data
-        gcs.score = cf_options_.blob_file_discardable_ratio;
-      } else {
-        gcs.score = file.second->GetDiscardableRatio();
-      }
+      UpdateGCScoreLocked(*file.second);
     }
+    SortGCScoreLocked();
+  }
+  compute_gc_score += start;
+  return gc_score_.size();
+}
 
-    if (!cf_options_.level_merge) {
-      std::sort(gc_score_.begin(), gc_score_.end(),
-                [](const GCScore &first, const GCScore &second) {
-                  return first.file_number < second.file_number;
-                });
-    } else {
-      std::sort(gc_score_.begin(), gc_score_.end(),
-                [](const GCScore &first, const GCScore &second) {
-                  return first.score > second.score;
-                });
+size_t BlobStorage::UpdateGCScore(
+    const std::vector<std::shared_ptr<BlobFileMeta>> &files) {
+  std::unique_lock<std::mutex> l(mutex_);
+  uint64_t start = 0;
+  {
+    TitanStopWatch sw(env_, start);
+    for (auto &file : files) {
+      UpdateGCScoreLocked(*file);
     }
   }
   compute_gc_score += start;
-  return gc_score_.size();
+  return file_gc_score_.size();
+}
+
+void BlobStorage::UpdateGCScoreLocked(const BlobFileMeta &file) {
+  gc_score_dirty_ = true;
+  if (file.is_obsolete() ||
+      (cf_options_.level_merge &&
+       (file.file_type() == kSorted ||
+        file.GetDiscardableRatio() < cf_options_.blob_file_discardable_ratio))) {
+    file_gc_score_.erase(file.file_number());
+    return;
+  }
+  if (file.file_size() <
+      cf_options_.merge_small_file_threshold /* ||
+file.gc_mark()*/
+  ) {
+    // for the small file or file with gc mark (usually the file that just
+    // recovered) we want gc these file but more hope to gc other file with
+    // more invalid data
+    file_gc_score_[file.file_number()] = cf_options_.blob_file_discardable_ratio;
+  } else {
+    file_gc_score_[file.file_number()] = file.GetDiscardableRatio();
+  }
+}
+
+void BlobStorage::SortGCScoreLocked() {
+  gc_score_.clear();
+  gc_score_.reserve(file_gc_score_.size());
+  for (auto &score : file_gc_score_) {
+    gc_score_.push_back({score.first, score.second});
+  }
+  if (!cf_options_.level_merge) {
+    std::sort(gc_score_.begin(), gc_score_.end(),
+              [](const GCScore &first, const GCScore &second) {
+                return first.file_number < second.file_number;
+              });
+  } else {
+    std::sort(gc_score_.begin(), gc_score_.end(),
+              [](const GCScore &first, const GCScore &second) {
+                return first.score > second.score;
+              });
+  }
+  gc_score_dirty_ = false;
 }
 
 }  // namespace titandb
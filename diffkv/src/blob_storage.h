@@ -3,9 +3,11 @@
 #define __STDC_FORMAT_MACROS
 #endif
 #include <inttypes.h>
+#include <functional>
 #include "blob_file_cache.h"
 #include "blob_format.h"
 #include "blob_gc.h"
+#include "blob_value_cache.h"
 #include "rocksdb/options.h"
 #include "titan_stats.h"
 #include "mutex"
@@ -25,6 +27,7 @@ class BlobStorage {
     this->env_options_ = bs.env_options_;
     this->cf_id_ = bs.cf_id_;
     this->stats_ = bs.stats_;
+    this->value_cache_ = bs.value_cache_;
   }
 
   BlobStorage(const TitanDBOptions& _db_options,
@@ -38,7 +41,11 @@ class BlobStorage {
         file_cache_(_file_cache),
         destroyed_(false),
         stats_(stats),
-        level_blob_size_(cf_options_.num_levels+1) {}
+        level_blob_size_(cf_options_.num_levels+1) {
+    if (cf_options_.blob_value_cache) {
+      value_cache_ = std::make_shared<BlobValueCache>(cf_options_, stats_);
+    }
+  }
 
   ~BlobStorage() {
     for (auto& file : files_) {
@@ -54,15 +61,27 @@ class BlobStorage {
 
   const std::vector<GCScore> gc_score() {
     std::unique_lock<std::mutex> l(mutex_);
+    if (gc_score_dirty_) {
+      SortGCScoreLocked();
+    }
     return gc_score_;
   }
 
   // Gets the blob record pointed by the blob index. The provided
   // buffer is used to store the record data, so the buffer must be
-  // valid when the record is used.
+  // valid when the record is used. The value is served by the blob value
+  // cache if possible, in which case only "record->value" is set.
   Status Get(const ReadOptions& options, const BlobIndex& index,
              BlobRecord* record, PinnableSlice* buffer);
 
+  // Gets the blob records pointed by "num" blob indexes, like Get() does
+  // for each of them, and sets "statuses[i]" for "indexes[i]". The reads
+  // that miss the blob value cache are issued as one batch, see
+  // BlobFileCache::MultiGet().
+  void MultiGet(const ReadOptions& options, size_t num,
+                const BlobIndex* indexes, BlobRecord* records,
+                PinnableSlice* buffers, Status* statuses);
+
   // Creates a prefetcher for the specified file number.
   Status NewPrefetcher(uint64_t file_number,
                        std::unique_ptr<BlobFilePrefetcher>* result);
@@ -104,9 +123,14 @@ class BlobStorage {
     return destroyed_ && obsolete_files_.empty();
   }
 
-  // Computes GC score.
+  // Computes GC score of all the files.
   size_t ComputeGCScore();
 
+  // Recomputes GC score of the given files only, e.g. the files that got
+  // garbage from a compaction. The scores are sorted lazily by the next
+  // gc_score() call. Returns the number of files to GC.
+  size_t UpdateGCScore(const std::vector<std::shared_ptr<BlobFileMeta>>& files);
+
   // Add a new blob file to this blob storage.
   void AddBlobFile(std::shared_ptr<BlobFileMeta>& file);
 
@@ -136,6 +160,18 @@ class BlobStorage {
     return obsolete_files_.size();
   }
 
+  // Calls "fn" on every blob file that is not obsolete, with the mutex of
+  // the storage held.
+  void ForEachLiveBlobFile(
+      const std::function<void(const BlobFileMeta&)>& fn) const {
+    std::unique_lock<std::mutex> l(mutex_);
+    for (const auto& file : files_) {
+      if (!file.second->is_obsolete()) {
+        fn(*file.second);
+      }
+    }
+  }
+
   // Exports all blob files' meta. Only for tests.
   void ExportBlobFiles(
       std::map<uint64_t, std::weak_ptr<BlobFileMeta>>& ret) const;
@@ -154,6 +190,12 @@ class BlobStorage {
                               SequenceNumber obsolete_sequence);
   bool RemoveFile(uint64_t file_number);
 
+  // Updates the GC score of the file, removing the file from GC candidates
+  // if it shouldn't be GCed. REQUIRES: mutex_ held.
+  void UpdateGCScoreLocked(const BlobFileMeta& file);
+  // Rebuilds gc_score_ from file_gc_score_. REQUIRES: mutex_ held.
+  void SortGCScoreLocked();
+
   TitanDBOptions db_options_;
   TitanCFOptions cf_options_;
   EnvOptions env_options_;
@@ -189,7 +231,12 @@ class BlobStorage {
 
   std::shared_ptr<BlobFileCache> file_cache_;
 
+  // GC candidates, file number -> score.
+  std::unordered_map<uint64_t, double> file_gc_score_;
+  // GC candidates in the order to GC them, rebuilt from file_gc_score_
+  // when it's dirty.
   std::vector<GCScore> gc_score_;
+  bool gc_score_dirty_{false};
 
   std::list<std::pair<uint64_t, SequenceNumber>> obsolete_files_;
   // It is marked when the column family handle is destroyed, indicating the
@@ -199,6 +246,9 @@ class BlobStorage {
 
   TitanStats* stats_;
 
+  // Caches values of point lookups, nullptr if disabled.
+  std::shared_ptr<BlobValueCache> value_cache_;
+
   std::vector<std::atomic<uint64_t>> level_blob_size_;
 };
 
@@ -0,0 +1,165 @@
+#include "blob_value_cache.h"
+
+#include <algorithm>
+
+#include "monitoring/statistics.h"
+#include "util/coding.h"
+#include "util/hash.h"
+
+#include "util.h"
+
+namespace rocksdb {
+namespace titandb {
+
+namespace {
+
+// Seeds used to derive the row indexes of the sketch.
+const uint64_t kSketchSeeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                                 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+// Bounds of the number of counters in each row of the sketch.
+const uint64_t kMinSketchEntries = 1 << 10;
+const uint64_t kMaxSketchEntries = 1 << 24;
+
+}  // namespace
+
+const uint32_t FrequencySketch::kMaxFrequency;
+
+FrequencySketch::FrequencySketch(uint64_t expected_entries) {
+  expected_entries =
+      std::min(std::max(expected_entries, kMinSketchEntries), kMaxSketchEntries);
+  uint64_t width = 1;
+  while (width < expected_entries) {
+    width <<= 1;
+  }
+  mask_ = width - 1;
+  // Same as the reference TinyLFU: age the counters every 10 * W accesses.
+  sample_size_ = width * 10;
+  table_.reset(new std::atomic<uint8_t>[width * kDepth]);
+  for (uint64_t i = 0; i < width * kDepth; i++) {
+    table_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t FrequencySketch::IndexOf(uint64_t hash, int row) const {
+  uint64_t h = (hash ^ kSketchSeeds[row]) * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 32;
+  return static_cast<uint64_t>(row) * (mask_ + 1) + (h & mask_);
+}
+
+void FrequencySketch::Increment(uint64_t hash) {
+  bool added = false;
+  for (int row = 0; row < kDepth; row++) {
+    auto& counter = table_[IndexOf(hash, row)];
+    uint8_t count = counter.load(std::memory_order_relaxed);
+    if (count < kMaxFrequency) {
+      counter.store(count + 1, std::memory_order_relaxed);
+      added = true;
+    }
+  }
+  if (added &&
+      additions_.fetch_add(1, std::memory_order_relaxed) + 1 >= sample_size_) {
+    Reset();
+  }
+}
+
+uint32_t FrequencySketch::Frequency(uint64_t hash) const {
+  uint32_t frequency = kMaxFrequency;
+  for (int row = 0; row < kDepth; row++) {
+    frequency = std::min<uint32_t>(
+        frequency, table_[IndexOf(hash, row)].load(std::memory_order_relaxed));
+  }
+  return frequency;
+}
+
+void FrequencySketch::Reset() {
+  // Only one thread needs to age the counters, the others just go on.
+  std::unique_lock<std::mutex> l(reset_mutex_, std::try_to_lock);
+  if (!l.owns_lock() ||
+      additions_.load(std::memory_order_relaxed) < sample_size_) {
+    return;
+  }
+  for (uint64_t i = 0; i < (mask_ + 1) * kDepth; i++) {
+    table_[i].store(table_[i].load(std::memory_order_relaxed) >> 1,
+                    std::memory_order_relaxed);
+  }
+  additions_.store(sample_size_ / 2, std::memory_order_relaxed);
+}
+
+BlobValueCache::BlobValueCache(const TitanCFOptions& cf_options,
+                               TitanStats* stats)
+    : cache_(cf_options.blob_value_cache),
+      mid_blob_size_(std::max<uint64_t>(cf_options.mid_blob_size, 1)),
+      min_frequency_(std::min<uint32_t>(
+          cf_options.blob_value_cache_min_frequency,
+          FrequencySketch::kMaxFrequency)),
+      sketch_(cf_options.blob_value_cache->GetCapacity() /
+              std::max<uint64_t>(
+                  (cf_options.min_blob_size + cf_options.mid_blob_size) / 2,
+                  1)),
+      stats_(stats) {
+  // The cache may be shared by several column families, so every value
+  // cache gets its own key prefix.
+  PutVarint64(&cache_prefix_, cache_->NewId());
+}
+
+void BlobValueCache::EncodeKey(uint64_t file_number, uint64_t offset,
+                               std::string* key) {
+  key->assign(cache_prefix_);
+  PutVarint64(key, file_number);
+  PutVarint64(key, offset);
+}
+
+bool BlobValueCache::Lookup(uint64_t file_number, uint64_t offset,
+                            PinnableSlice* value) {
+  std::string key;
+  EncodeKey(file_number, offset, &key);
+  sketch_.Increment(GetSliceNPHash64(key));
+
+  auto handle = cache_->Lookup(key);
+  if (handle == nullptr) {
+    RecordTick(stats_, TitanStats::BLOB_VALUE_CACHE_MISS);
+    return false;
+  }
+  RecordTick(stats_, TitanStats::BLOB_VALUE_CACHE_HIT);
+  auto cached = reinterpret_cast<std::string*>(cache_->Value(handle));
+  value->PinSlice(*cached, UnrefCacheHandle, cache_.get(), handle);
+  return true;
+}
+
+uint32_t BlobValueCache::AdmissionFrequency(uint64_t value_size) const {
+  // One more access is required for every doubling above mid_blob_size.
+  uint32_t frequency = min_frequency_;
+  for (uint64_t size = mid_blob_size_;
+       size <= value_size && frequency < FrequencySketch::kMaxFrequency;
+       size <<= 1) {
+    frequency++;
+  }
+  return frequency;
+}
+
+bool BlobValueCache::MaybeInsert(uint64_t file_number, uint64_t offset,
+                                 const Slice& value) {
+  std::string key;
+  EncodeKey(file_number, offset, &key);
+
+  size_t charge = value.size() + sizeof(std::string) + key.size();
+  if (cache_->GetUsage() + charge > cache_->GetCapacity() &&
+      sketch_.Frequency(GetSliceNPHash64(key)) <
+          AdmissionFrequency(value.size())) {
+    RecordTick(stats_, TitanStats::BLOB_VALUE_CACHE_REJECT);
+    return false;
+  }
+  auto cached = new std::string(value.data(), value.size());
+  Status s = cache_->Insert(key, cached, charge, &DeleteCacheValue<std::string>);
+  if (!s.ok()) {
+    // The deleter has been called by the cache.
+    RecordTick(stats_, TitanStats::BLOB_VALUE_CACHE_REJECT);
+    return false;
+  }
+  RecordTick(stats_, TitanStats::BLOB_VALUE_CACHE_ADD);
+  return true;
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
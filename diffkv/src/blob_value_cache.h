@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "rocksdb/cache.h"
+#include "titan/options.h"
+#include "titan_stats.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// A count-min sketch with 4-bit saturating counters that estimates how
+// often a key has been accessed recently. All counters are halved once
+// the number of recorded accesses reaches the sample size, so the
+// estimation follows the working set instead of the whole history.
+//
+// Increments are not linearizable: concurrent updates of the same
+// counter may lose one of them, which is fine for an estimation.
+class FrequencySketch {
+ public:
+  // Sizes the sketch for about "expected_entries" distinct keys.
+  explicit FrequencySketch(uint64_t expected_entries);
+
+  // Records one access of the key with the specified hash.
+  void Increment(uint64_t hash);
+
+  // Returns the estimated access count of the key, in [0, kMaxFrequency].
+  uint32_t Frequency(uint64_t hash) const;
+
+  uint64_t sample_size() const { return sample_size_; }
+
+  static const uint32_t kMaxFrequency = 15;
+
+ private:
+  static const int kDepth = 4;
+
+  uint64_t IndexOf(uint64_t hash, int row) const;
+  void Reset();
+
+  uint64_t mask_;
+  uint64_t sample_size_;
+  std::unique_ptr<std::atomic<uint8_t>[]> table_;
+  std::atomic<uint64_t> additions_{0};
+  std::mutex reset_mutex_;
+};
+
+// Caches the values of blob records for point lookups.
+//
+// Unlike `blob_cache`, which caches every record it reads, values are only
+// admitted when the cache still has room or when the frequency sketch
+// says the key is hot enough. This keeps one-hit wonders of skewed
+// workloads from evicting the hot set. Bigger values need a higher
+// frequency to be admitted, since each of them evicts more entries.
+class BlobValueCache {
+ public:
+  BlobValueCache(const TitanCFOptions& cf_options, TitanStats* stats);
+
+  // Looks up the value of the record at "offset" in the specified file.
+  // On hit, pins the cached value in "value" and returns true. Every
+  // lookup is counted by the frequency sketch.
+  bool Lookup(uint64_t file_number, uint64_t offset, PinnableSlice* value);
+
+  // Offers the value of the record at "offset" in the specified file to
+  // the cache. Returns whether the value is admitted.
+  bool MaybeInsert(uint64_t file_number, uint64_t offset, const Slice& value);
+
+  // Returns the frequency an entry of "value_size" bytes needs to be
+  // admitted into a full cache.
+  uint32_t AdmissionFrequency(uint64_t value_size) const;
+
+ private:
+  void EncodeKey(uint64_t file_number, uint64_t offset, std::string* key);
+
+  std::shared_ptr<Cache> cache_;
+  std::string cache_prefix_;
+  uint64_t mid_blob_size_;
+  uint32_t min_frequency_;
+  FrequencySketch sketch_;
+  TitanStats* stats_;
+};
+
+}  // namespace titandb
+}  // namespace rocksdb
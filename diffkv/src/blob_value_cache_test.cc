@@ -0,0 +1,94 @@
+#include "blob_value_cache.h"
+
+#include "test_util/testharness.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+namespace titandb {
+
+class BlobValueCacheTest : public testing::Test {};
+
+TEST(BlobValueCacheTest, FrequencySketch) {
+  FrequencySketch sketch(1024);
+  uint64_t hot = GetSliceNPHash64("hot");
+  uint64_t cold = GetSliceNPHash64("cold");
+  ASSERT_EQ(sketch.Frequency(hot), 0);
+  for (int i = 0; i < 5; i++) {
+    sketch.Increment(hot);
+  }
+  sketch.Increment(cold);
+  ASSERT_EQ(sketch.Frequency(hot), 5);
+  ASSERT_EQ(sketch.Frequency(cold), 1);
+
+  // Counters saturate.
+  for (int i = 0; i < 100; i++) {
+    sketch.Increment(hot);
+  }
+  ASSERT_EQ(sketch.Frequency(hot), FrequencySketch::kMaxFrequency);
+
+  // Counters are halved once the sample size is reached.
+  for (uint64_t i = 0; i < sketch.sample_size(); i++) {
+    sketch.Increment(GetSliceNPHash64(std::to_string(i)));
+  }
+  ASSERT_LE(sketch.Frequency(hot), FrequencySketch::kMaxFrequency / 2 + 1);
+}
+
+TEST(BlobValueCacheTest, Admission) {
+  TitanCFOptions cf_options;
+  cf_options.min_blob_size = 128;
+  cf_options.mid_blob_size = 4096;
+  cf_options.blob_value_cache_min_frequency = 2;
+  cf_options.blob_value_cache = NewLRUCache(64 << 10, 0 /* num_shard_bits */);
+  BlobValueCache cache(cf_options, nullptr);
+
+  ASSERT_EQ(cache.AdmissionFrequency(128), 2);
+  ASSERT_EQ(cache.AdmissionFrequency(4096), 3);
+  ASSERT_EQ(cache.AdmissionFrequency(16384), 5);
+
+  PinnableSlice value;
+  std::string small(1024, 'a');
+  // Admitted while the cache has room.
+  uint64_t offset = 0;
+  for (;; offset++) {
+    ASSERT_FALSE(cache.Lookup(1, offset, &value));
+    if (!cache.MaybeInsert(1, offset, small)) {
+      break;
+    }
+    ASSERT_TRUE(cache.Lookup(1, offset, &value));
+    ASSERT_EQ(value, small);
+    value.Reset();
+  }
+  ASSERT_GT(offset * small.size(),
+            cf_options.blob_value_cache->GetCapacity() / 2);
+
+  // The cache is full, one-hit values are rejected.
+  offset += 16;
+  ASSERT_FALSE(cache.Lookup(1, offset, &value));
+  ASSERT_FALSE(cache.MaybeInsert(1, offset, small));
+  ASSERT_FALSE(cache.Lookup(1, offset, &value));
+  // Until they have been read often enough.
+  ASSERT_TRUE(cache.MaybeInsert(1, offset, small));
+  ASSERT_TRUE(cache.Lookup(1, offset, &value));
+  ASSERT_EQ(value, small);
+  value.Reset();
+
+  // Big values need more accesses.
+  std::string big(8192, 'b');
+  offset++;
+  for (uint32_t i = 0; i < cache.AdmissionFrequency(big.size()) - 1; i++) {
+    ASSERT_FALSE(cache.Lookup(2, offset, &value));
+    ASSERT_FALSE(cache.MaybeInsert(2, offset, big));
+  }
+  ASSERT_FALSE(cache.Lookup(2, offset, &value));
+  ASSERT_TRUE(cache.MaybeInsert(2, offset, big));
+  ASSERT_TRUE(cache.Lookup(2, offset, &value));
+  ASSERT_EQ(value, big);
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
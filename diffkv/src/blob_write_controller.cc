@@ -0,0 +1,110 @@
+#include "blob_write_controller.h"
+
+#include <algorithm>
+
+#include "monitoring/statistics.h"
+#include "titan_perf_context_imp.h"
+
+namespace rocksdb {
+namespace titandb {
+
+namespace {
+
+// RocksDB's default delayed write rate without a rate limiter.
+const uint64_t kDefaultDelayedWriteRate = 16 << 20;
+
+}  // namespace
+
+const uint64_t BlobWriteController::kMinRateDivisor;
+
+BlobWriteController::BlobWriteController(const TitanDBOptions& options,
+                                         TitanStats* stats,
+                                         std::function<void()> on_stop)
+    : env_(options.env),
+      stats_(stats),
+      stop_size_(options.block_write_size),
+      slowdown_size_(options.slowdown_write_size > 0
+                         ? std::min(options.slowdown_write_size,
+                                    options.block_write_size)
+                         : options.block_write_size / 4 * 3),
+      max_delayed_write_rate_(options.delayed_write_rate > 0
+                                  ? options.delayed_write_rate
+                                  : kDefaultDelayedWriteRate),
+      on_stop_(std::move(on_stop)),
+      controller_(max_delayed_write_rate_) {}
+
+bool BlobWriteController::Update(uint64_t blob_file_size) {
+  if (!enabled()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> l(mutex_);
+  int old_state = state_.load(std::memory_order_relaxed);
+  int new_state = kNormal;
+  if (blob_file_size >= stop_size_) {
+    if (!stop_token_) {
+      stop_token_ = controller_.GetStopToken();
+    }
+    delay_token_.reset();
+    new_state = kStopped;
+  } else if (blob_file_size > slowdown_size_) {
+    double distance = static_cast<double>(stop_size_ - blob_file_size) /
+                      (stop_size_ - slowdown_size_);
+    uint64_t rate =
+        std::max(static_cast<uint64_t>(max_delayed_write_rate_ * distance),
+                 max_delayed_write_rate_ / kMinRateDivisor);
+    if (!delay_token_) {
+      delay_token_ = controller_.GetDelayToken(rate);
+    } else {
+      controller_.set_delayed_write_rate(rate);
+    }
+    delayed_write_rate_.store(rate, std::memory_order_relaxed);
+    stop_token_.reset();
+    new_state = kDelayed;
+  } else {
+    delay_token_.reset();
+    stop_token_.reset();
+  }
+  state_.store(new_state, std::memory_order_relaxed);
+  if (new_state != kStopped) {
+    cv_.notify_all();
+  }
+  return old_state == kNormal && new_state != kNormal;
+}
+
+void BlobWriteController::MaybeStallWrite(uint64_t num_bytes) {
+  if (!IsThrottled()) {
+    return;
+  }
+  TITAN_PERF_COUNTER_ADD(write_stall_count, 1);
+  TITAN_PERF_TIMER_GUARD(write_stall_nanos);
+  uint64_t start = env_->NowMicros();
+  if (IsStopped() && on_stop_) {
+    on_stop_();
+  }
+  uint64_t delay = 0;
+  {
+    std::unique_lock<std::mutex> l(mutex_);
+    if (controller_.IsStopped() && !shutting_down_) {
+      RecordTick(stats_, TitanStats::BLOB_WRITE_STOPPED);
+      cv_.wait(l, [this]() {
+        return !controller_.IsStopped() || shutting_down_;
+      });
+    }
+    delay = controller_.GetDelay(env_, num_bytes);
+  }
+  if (delay > 0) {
+    RecordTick(stats_, TitanStats::BLOB_WRITE_DELAYED);
+    env_->SleepForMicroseconds(static_cast<int>(delay));
+  }
+  RecordTick(stats_, TitanStats::BLOB_WRITE_STALL_MICROS,
+             env_->NowMicros() - start);
+}
+
+void BlobWriteController::Shutdown() {
+  std::lock_guard<std::mutex> l(mutex_);
+  shutting_down_ = true;
+  cv_.notify_all();
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "db/write_controller.h"
+#include "rocksdb/env.h"
+#include "titan/options.h"
+#include "titan_stats.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// Throttles foreground writes as the blob files of a DB grow, so that GC
+// gets to reclaim space before writers have to be stopped.
+//
+// The size of the blob files counts live values as well as the garbage
+// GC has yet to reclaim. Below slowdown_write_size writes go at full
+// speed. Between slowdown_write_size and block_write_size every write is
+// delayed by a RocksDB WriteController, whose rate falls linearly with the
+// distance left to block_write_size. At block_write_size writes are
+// stopped until GC or compaction brings the size back below it.
+class BlobWriteController {
+ public:
+  // A hundredth of the delayed write rate is kept near block_write_size.
+  static const uint64_t kMinRateDivisor = 100;
+
+  // "on_stop" is called by a writer about to wait on a stop, without any
+  // lock held, so that GC gets scheduled even if no compaction runs.
+  BlobWriteController(const TitanDBOptions& options, TitanStats* stats,
+                      std::function<void()> on_stop = nullptr);
+
+  // Whether writes may be held at all.
+  bool enabled() const { return stop_size_ > 0; }
+
+  // Recomputes the delay from the current size of the blob files. Returns
+  // true if writes went from full speed to delayed or stopped.
+  bool Update(uint64_t blob_file_size);
+
+  // Whether writes are delayed or stopped.
+  bool IsThrottled() const {
+    return state_.load(std::memory_order_relaxed) != kNormal;
+  }
+
+  bool IsStopped() const {
+    return state_.load(std::memory_order_relaxed) == kStopped;
+  }
+
+  // Current delayed write rate, or zero if writes are not delayed.
+  uint64_t delayed_write_rate() const {
+    return IsThrottled() ? delayed_write_rate_.load(std::memory_order_relaxed)
+                         : 0;
+  }
+
+  // Called by a writer before it writes "num_bytes". Waits while writes
+  // are stopped, then sleeps for the delay of its bytes.
+  void MaybeStallWrite(uint64_t num_bytes);
+
+  // Releases writers waiting on a stop, at close.
+  void Shutdown();
+
+ private:
+  enum State : int { kNormal, kDelayed, kStopped };
+
+  Env* env_;
+  TitanStats* stats_;
+  const uint64_t stop_size_;
+  const uint64_t slowdown_size_;
+  const uint64_t max_delayed_write_rate_;
+  const std::function<void()> on_stop_;
+
+  std::atomic<int> state_{kNormal};
+  std::atomic<uint64_t> delayed_write_rate_{0};
+
+  // Guards controller_ and the tokens, which RocksDB expects to be used
+  // under a single mutex.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  WriteController controller_;
+  std::unique_ptr<WriteControllerToken> delay_token_;
+  std::unique_ptr<WriteControllerToken> stop_token_;
+  bool shutting_down_{false};
+};
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -0,0 +1,99 @@
+#include "blob_write_controller.h"
+
+#include <thread>
+
+#include "test_util/testharness.h"
+
+namespace rocksdb {
+namespace titandb {
+
+class BlobWriteControllerTest : public testing::Test {
+ public:
+  BlobWriteControllerTest() {
+    options_.env = Env::Default();
+    options_.block_write_size = 1000;
+    options_.delayed_write_rate = 1 << 20;
+  }
+
+  TitanDBOptions options_;
+};
+
+TEST_F(BlobWriteControllerTest, Disabled) {
+  options_.block_write_size = 0;
+  BlobWriteController controller(options_, nullptr);
+  ASSERT_FALSE(controller.enabled());
+  ASSERT_FALSE(controller.Update(uint64_t{1} << 40));
+  ASSERT_FALSE(controller.IsThrottled());
+  controller.MaybeStallWrite(1 << 20);
+}
+
+TEST_F(BlobWriteControllerTest, DelayGrowsWithSize) {
+  BlobWriteController controller(options_, nullptr);
+  ASSERT_FALSE(controller.Update(500));
+  ASSERT_FALSE(controller.IsThrottled());
+  ASSERT_EQ(controller.delayed_write_rate(), 0);
+
+  // The delay starts at 3/4 of block_write_size, at the full rate.
+  ASSERT_TRUE(controller.Update(800));
+  ASSERT_TRUE(controller.IsThrottled());
+  ASSERT_FALSE(controller.IsStopped());
+  uint64_t rate = controller.delayed_write_rate();
+  ASSERT_EQ(rate, (1 << 20) / 5 * 4);
+
+  // The rate falls as the size grows, down to a floor.
+  ASSERT_FALSE(controller.Update(900));
+  ASSERT_LT(controller.delayed_write_rate(), rate);
+  ASSERT_FALSE(controller.Update(999));
+  ASSERT_EQ(controller.delayed_write_rate(),
+            (1 << 20) / BlobWriteController::kMinRateDivisor);
+
+  // Writes of a few refill intervals' worth of bytes are delayed.
+  uint64_t start = options_.env->NowMicros();
+  for (int i = 0; i < 10; i++) {
+    controller.MaybeStallWrite(1 << 8);
+  }
+  ASSERT_GT(options_.env->NowMicros() - start, 10000);
+
+  ASSERT_FALSE(controller.Update(100));
+  ASSERT_FALSE(controller.IsThrottled());
+}
+
+TEST_F(BlobWriteControllerTest, StopUntilSizeDrops) {
+  options_.slowdown_write_size = options_.block_write_size;
+  std::atomic<int> num_stops{0};
+  BlobWriteController controller(options_, nullptr, [&]() { num_stops++; });
+  // Without a slowdown zone writes go from full speed to stopped.
+  ASSERT_FALSE(controller.Update(999));
+  ASSERT_TRUE(controller.Update(1000));
+  ASSERT_TRUE(controller.IsStopped());
+
+  std::atomic<bool> written{false};
+  std::thread writer([&]() {
+    controller.MaybeStallWrite(100);
+    written = true;
+  });
+  options_.env->SleepForMicroseconds(10000);
+  ASSERT_FALSE(written);
+  ASSERT_EQ(1, num_stops.load());
+  ASSERT_FALSE(controller.Update(2000));
+  ASSERT_FALSE(written);
+  ASSERT_FALSE(controller.Update(500));
+  writer.join();
+  ASSERT_TRUE(written);
+}
+
+TEST_F(BlobWriteControllerTest, Shutdown) {
+  BlobWriteController controller(options_, nullptr);
+  ASSERT_TRUE(controller.Update(1000));
+  std::thread writer([&]() { controller.MaybeStallWrite(100); });
+  controller.Shutdown();
+  writer.join();
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #include "logging/log_buffer.h"
 #include "port/port.h"
 #include "util/autovector.h"
+#include "util/string_util.h"
 
 #include "atomic"
 #include "base_db_listener.h"
@@ -16,10 +17,13 @@
 #include "blob_file_iterator.h"
 #include "blob_file_size_collector.h"
 #include "blob_gc.h"
+#include "blob_io_scheduler.h"
 #include "db_iter.h"
 #include "iostream"
 #include "table_factory.h"
 #include "titan_build_version.h"
+#include "titan_perf_context_imp.h"
+#include "util.h"
 
 extern std::atomic<uint64_t> bytes_written;
 extern std::atomic<uint64_t> gc_update_lsm;
@@ -47,7 +51,9 @@ namespace titandb {
 
 class TitanDBImpl::FileManager : public BlobFileManager {
  public:
-  FileManager(TitanDBImpl* db) : db_(db) {}
+  FileManager(TitanDBImpl* db,
+              const std::vector<std::string>& blob_dirs = {})
+      : db_(db), blob_dirs_(blob_dirs) {}
 
   Status NewFile(std::unique_ptr<BlobFileHandle>* handle) override {
     return NewFile(handle, db_->env_options_);
@@ -56,7 +62,8 @@ class TitanDBImpl::FileManager : public BlobFileManager {
   Status NewFile(std::unique_ptr<BlobFileHandle>* handle,
                  const EnvOptions& options) override {
     auto number = db_->blob_file_set_->NewFileNumber();
-    auto name = BlobFileName(db_->dirname_, number);
+    auto name =
+        BlobFileName(BlobFileDir(db_->dirname_, blob_dirs_, number), number);
 
     Status s;
     std::unique_ptr<WritableFileWriter> file;
@@ -151,6 +158,7 @@ class TitanDBImpl::FileManager : public BlobFileManager {
   };
 
   TitanDBImpl* db_;
+  const std::vector<std::string> blob_dirs_;
 };
 
 TitanDBImpl::TitanDBImpl(const TitanDBOptions& options,
@@ -159,8 +167,7 @@ TitanDBImpl::TitanDBImpl(const TitanDBOptions& options,
       dbname_(dbname),
       env_(options.env),
       env_options_(options),
-      db_options_(options),
-      size_cv_(&size_mutex_) {
+      db_options_(options) {
   if (db_options_.dirname.empty()) {
     db_options_.dirname = dbname_ + "/titandb";
   }
@@ -168,6 +175,8 @@ TitanDBImpl::TitanDBImpl(const TitanDBOptions& options,
   if (db_options_.statistics != nullptr) {
     stats_.reset(new TitanStats(db_options_.statistics.get()));
   }
+  write_controller_.reset(new BlobWriteController(
+      db_options_, stats_.get(), [this]() { ScheduleGCForStalledWrites(); }));
   blob_manager_.reset(new FileManager(this));
 }
 
@@ -195,6 +204,29 @@ void TitanDBImpl::StartBackgroundTasks() {
 Status TitanDBImpl::ValidateOptions(
     const TitanDBOptions& options,
     const std::vector<TitanCFDescriptor>& column_families) const {
+  for (auto& cf : column_families) {
+    for (auto& dir : cf.options.blob_dirs) {
+      if (dir.empty()) {
+        return Status::InvalidArgument("empty blob dir of column family " +
+                                       cf.name);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status TitanDBImpl::NewBlobFileManager(
+    const TitanCFOptions& cf_options,
+    std::shared_ptr<BlobFileManager>* manager) {
+  if (cf_options.blob_dirs.empty()) {
+    *manager = blob_manager_;
+    return Status::OK();
+  }
+  for (auto& dir : cf_options.blob_dirs) {
+    Status s = env_->CreateDirIfMissing(dir);
+    if (!s.ok()) return s;
+  }
+  manager->reset(new FileManager(this, cf_options.blob_dirs));
   return Status::OK();
 }
 
@@ -220,9 +252,14 @@ Status TitanDBImpl::Open(const std::vector<TitanCFDescriptor>& descs,
   std::vector<ColumnFamilyDescriptor> init_descs;
   // Descriptors for actually open DB.
   std::vector<ColumnFamilyDescriptor> base_descs;
+  // Managers of the blob files of each column family.
+  std::vector<std::shared_ptr<BlobFileManager>> blob_manager;
   for (auto& desc : descs) {
     init_descs.emplace_back(desc.name, desc.options);
     base_descs.emplace_back(desc.name, desc.options);
+    blob_manager.emplace_back();
+    s = NewBlobFileManager(desc.options, &blob_manager.back());
+    if (!s.ok()) return s;
   }
   std::map<uint32_t, TitanCFOptions> column_families;
 
@@ -260,14 +297,28 @@ Status TitanDBImpl::Open(const std::vector<TitanCFDescriptor>& descs,
       // While we need to preserve original table_factory for GetOptions.
       auto& base_table_factory = base_descs[i].options.table_factory;
       assert(base_table_factory != nullptr);
+      std::shared_ptr<HotKeyTracker> hot_key_tracker;
+      if (descs[i].options.inline_hot_value_frequency > 0) {
+        hot_key_tracker = std::make_shared<HotKeyTracker>(descs[i].options);
+        hot_key_trackers_.emplace(cf_id, hot_key_tracker);
+      }
+      if (descs[i].options.blob_io_scheduler) {
+        io_schedulers_.emplace(cf_id, descs[i].options.blob_io_scheduler);
+      }
       auto titan_table_factory = std::make_shared<TitanTableFactory>(
-          db_options_, descs[i].options, blob_manager_, &mutex_,
-          blob_file_set_.get(), stats_.get());
+          db_options_, descs[i].options, blob_manager[i], &mutex_,
+          blob_file_set_.get(), stats_.get(), garbage_meter_, hot_key_tracker);
       cf_info_.emplace(cf_id,
                        TitanColumnFamilyInfo(
                            {cf_name, ImmutableTitanCFOptions(descs[i].options),
                             MutableTitanCFOptions(descs[i].options),
-                            base_table_factory, titan_table_factory}));
+                            base_table_factory, titan_table_factory,
+                            blob_manager[i]}));
+      if (descs[i].options.adaptive_blob_size) {
+        blob_size_controllers_.emplace(
+            cf_id, std::make_shared<BlobSizeController>(
+                       db_options_, descs[i].options, stats_.get()));
+      }
       // builders_.emplace(cf_id,
       // ForegroundBuilder(cf_id,
       // blob_manager_,blob_file_set_->GetBlobStorage(cf_id) ,db_options_,
@@ -286,13 +337,20 @@ Status TitanDBImpl::Open(const std::vector<TitanCFDescriptor>& descs,
 
   if (stats_.get()) {
     stats_->Initialize(column_families);
+    for (auto& cf : column_families) {
+      SetStats(stats_.get(), cf.first, TitanInternalStats::MIN_BLOB_SIZE,
+               cf.second.min_blob_size);
+      SetStats(stats_.get(), cf.first, TitanInternalStats::MID_BLOB_SIZE,
+               cf.second.mid_blob_size);
+    }
   }
 
   s = blob_file_set_->Open(column_families);
   if (db_options_.sep_before_flush) {
     for (auto cf : column_families) {
       builders_.emplace(
-          cf.first, ForegroundBuilder(cf.first, blob_manager_,
+          cf.first, ForegroundBuilder(cf.first,
+                                      cf_info_.at(cf.first).blob_manager,
                                       blob_file_set_->GetBlobStorage(cf.first),
                                       db_options_, cf.second, stats_.get()));
       builders_[cf.first].Init();
@@ -302,8 +360,10 @@ Status TitanDBImpl::Open(const std::vector<TitanCFDescriptor>& descs,
 
   // Initialize GC thread pool.
   if (!db_options_.disable_background_gc && db_options_.max_background_gc > 0) {
-    env_->IncBackgroundThreadsIfNeeded(db_options_.max_background_gc,
-                                       Env::Priority::USER);
+    env_->IncBackgroundThreadsIfNeeded(
+        db_options_.max_background_gc *
+            std::max(db_options_.max_gc_subjobs, 1),
+        Env::Priority::USER);
   }
 
   s = DB::Open(db_options_, dbname_, base_descs, handles, &db_);
@@ -327,6 +387,10 @@ Status TitanDBImpl::Open(const std::vector<TitanCFDescriptor>& descs,
 
 Status TitanDBImpl::Close() {
   Status s;
+  // The destructor closes again after an explicit Close()
+  if (db_ == nullptr) {
+    return s;
+  }
   std::cerr<<"close impl\n";
   PurgeObsoleteFiles();
   CloseImpl();
@@ -355,7 +419,6 @@ Status TitanDBImpl::CloseImpl() {
   {
     std::cerr<<"lock in close impl"<<std::endl;
     MutexLock l(&mutex_);
-    MutexLock l1(&size_mutex_);
     std::cerr<<"got lock"<<std::endl;
     // Although `shuting_down_` is atomic bool object, we should set it under
     // the protection of mutex_, otherwise, there maybe something wrong with it,
@@ -365,9 +428,8 @@ Status TitanDBImpl::CloseImpl() {
     // 3, B thread: unschedule all bg work
     // 4, A thread: schedule bg work
     shuting_down_.store(true, std::memory_order_release);
-    block_for_size_.store(false);
-    size_cv_.SignalAll();
   }
+  write_controller_->Shutdown();
 
   int gc_unscheduled = env_->UnSchedule(this, Env::Priority::USER);
   {
@@ -396,13 +458,17 @@ Status TitanDBImpl::CreateColumnFamilies(
   std::vector<ColumnFamilyDescriptor> base_descs;
   std::vector<std::shared_ptr<TableFactory>> base_table_factory;
   std::vector<std::shared_ptr<TitanTableFactory>> titan_table_factory;
+  std::vector<std::shared_ptr<BlobFileManager>> blob_manager;
   for (auto& desc : descs) {
     ColumnFamilyOptions options = desc.options;
+    blob_manager.emplace_back();
+    Status s = NewBlobFileManager(desc.options, &blob_manager.back());
+    if (!s.ok()) return s;
     // Replaces the provided table factory with TitanTableFactory.
     base_table_factory.emplace_back(options.table_factory);
     titan_table_factory.emplace_back(std::make_shared<TitanTableFactory>(
-        db_options_, desc.options, blob_manager_, &mutex_, blob_file_set_.get(),
-        stats_.get()));
+        db_options_, desc.options, blob_manager.back(), &mutex_,
+        blob_file_set_.get(), stats_.get(), garbage_meter_));
     options.table_factory = titan_table_factory.back();
     options.table_properties_collector_factories.emplace_back(
         std::make_shared<BlobFileSizeCollectorFactory>());
@@ -425,7 +491,7 @@ Status TitanDBImpl::CreateColumnFamilies(
             TitanColumnFamilyInfo(
                 {handle->GetName(), ImmutableTitanCFOptions(descs[i].options),
                  MutableTitanCFOptions(descs[i].options), base_table_factory[i],
-                 titan_table_factory[i]}));
+                 titan_table_factory[i], blob_manager[i]}));
       }
       blob_file_set_->AddColumnFamilies(column_families);
     }
@@ -559,20 +625,11 @@ Status TitanDBImpl::Put(const rocksdb::WriteOptions& options,
                         const rocksdb::Slice& key,
                         const rocksdb::Slice& value) {
   if (HasBGError()) return GetBGError();
-  // std::cerr<<"block write size is "<<db_options_.block_write_size<<".\n";
-  while (db_options_.block_write_size>0 && block_for_size_.load()){
-    std::cerr<<"blocked by size_cv\n";
-      {
-        uint32_t cf_id = column_family->GetID();
-        auto bs = blob_file_set_->GetBlobStorage(cf_id).lock();
-        bs->ComputeGCScore();
-        AddToGCQueue(cf_id);
-        MaybeScheduleGC();
-      }
-    MutexLock l(&size_mutex_);
-    if(block_for_size_.load()){
-    size_cv_.Wait();
-    std::cerr<<"wait done\n";
+  write_controller_->MaybeStallWrite(key.size() + value.size());
+  if (!blob_size_controllers_.empty()) {
+    auto controller = blob_size_controllers_.find(column_family->GetID());
+    if (controller != blob_size_controllers_.end()) {
+      controller->second->RecordWrite(value.size());
     }
   }
   // if (db_options_.sep_before_flush && value.size() >
@@ -590,7 +647,59 @@ Status TitanDBImpl::Put(const rocksdb::WriteOptions& options,
 
 Status TitanDBImpl::Write(const rocksdb::WriteOptions& options,
                           rocksdb::WriteBatch* updates) {
-  return HasBGError() ? GetBGError() : db_->Write(options, updates);
+  if (HasBGError()) return GetBGError();
+  write_controller_->MaybeStallWrite(updates->GetDataSize());
+  if (!blob_size_controllers_.empty()) {
+    RecordWriteSizes(updates);
+  }
+  return db_->Write(options, updates);
+}
+
+void TitanDBImpl::RecordWriteSizes(WriteBatch* updates) {
+  class ValueSizeRecorder : public WriteBatch::Handler {
+   public:
+    explicit ValueSizeRecorder(
+        const std::unordered_map<uint32_t,
+                                 std::shared_ptr<BlobSizeController>>&
+            controllers)
+        : controllers_(controllers) {}
+
+    Status PutCF(uint32_t column_family_id, const Slice& /*key*/,
+                 const Slice& value) override {
+      auto controller = controllers_.find(column_family_id);
+      if (controller != controllers_.end()) {
+        controller->second->RecordWrite(value.size());
+      }
+      return Status::OK();
+    }
+
+    Status DeleteCF(uint32_t, const Slice&) override { return Status::OK(); }
+
+    Status SingleDeleteCF(uint32_t, const Slice&) override {
+      return Status::OK();
+    }
+
+    Status DeleteRangeCF(uint32_t, const Slice&, const Slice&) override {
+      return Status::OK();
+    }
+
+    Status MergeCF(uint32_t, const Slice&, const Slice&) override {
+      return Status::OK();
+    }
+
+    Status PutBlobIndexCF(uint32_t, const Slice&, const Slice&) override {
+      return Status::OK();
+    }
+
+   private:
+    const std::unordered_map<uint32_t, std::shared_ptr<BlobSizeController>>&
+        controllers_;
+  };
+
+  // Sampling is best-effort, so a batch that can't be parsed is left to
+  // fail in the base DB.
+  ValueSizeRecorder recorder(blob_size_controllers_);
+  updates->Iterate(&recorder);
 }
 
 Status TitanDBImpl::Delete(const rocksdb::WriteOptions& options,
@@ -623,13 +732,22 @@ Status TitanDBImpl::Flush(const rocksdb::FlushOptions& options,
 
 Status TitanDBImpl::Get(const ReadOptions& options, ColumnFamilyHandle* handle,
                         const Slice& key, PinnableSlice* value) {
+  // Foreground latency drives the budget of background blob I/O.
+  BlobIOScheduler* io_scheduler = GetIOScheduler(handle->GetID());
+  uint64_t start = io_scheduler != nullptr ? env_->NowMicros() : 0;
+  Status s;
   if (options.snapshot) {
-    return GetImpl(options, handle, key, value);
+    s = GetImpl(options, handle, key, value);
+  } else {
+    ReadOptions ro(options);
+    ManagedSnapshot snapshot(this);
+    ro.snapshot = snapshot.snapshot();
+    s = GetImpl(ro, handle, key, value);
   }
-  ReadOptions ro(options);
-  ManagedSnapshot snapshot(this);
-  ro.snapshot = snapshot.snapshot();
-  return GetImpl(ro, handle, key, value);
+  if (io_scheduler != nullptr) {
+    io_scheduler->RecordForegroundLatency(env_->NowMicros() - start);
+  }
+  return s;
 }
 
 Status TitanDBImpl::GetImpl(const ReadOptions& options,
@@ -637,9 +755,23 @@ Status TitanDBImpl::GetImpl(const ReadOptions& options,
                             PinnableSlice* value) {
   Status s;
   bool is_blob_index = false;
-  s = db_impl_->GetImpl(options, handle, key, value, nullptr /*value_found*/,
-                        nullptr /*read_callback*/, &is_blob_index);
-  if (!s.ok() || !is_blob_index) return s;
+  {
+    TITAN_PERF_TIMER_GUARD(get_lsm_nanos);
+    s = db_impl_->GetImpl(options, handle, key, value, nullptr /*value_found*/,
+                          nullptr /*read_callback*/, &is_blob_index);
+  }
+  BlobSizeController* controller = GetBlobSizeController(handle->GetID());
+  if (!s.ok()) return s;
+  HotKeyTracker* tracker = GetHotKeyTracker(handle->GetID());
+  if (tracker != nullptr) {
+    tracker->RecordRead(key);
+  }
+  if (!is_blob_index) {
+    if (controller != nullptr) {
+      controller->RecordRead(value->size(), false /*is_blob*/);
+    }
+    return s;
+  }
 
   StopWatch get_sw(env_, stats_.get(), BLOB_DB_GET_MICROS);
   // RecordTick(stats_.get(), BLOB_DB_NUM_GET);
@@ -678,6 +810,9 @@ Status TitanDBImpl::GetImpl(const ReadOptions& options,
   if (s.ok()) {
     value->Reset();
     value->PinSelf(record.value);
+    if (controller != nullptr) {
+      controller->RecordRead(value->size(), true /*is_blob*/);
+    }
   }
   return s;
 }
@@ -702,17 +837,124 @@ std::vector<Status> TitanDBImpl::MultiGetImpl(
   std::vector<Status> res;
   res.resize(keys.size());
   values->resize(keys.size());
+  // Values in blob files are read in one batch per column family, once
+  // all the keys are looked up in the LSM-tree.
+  std::map<uint32_t, std::vector<size_t>> blob_keys;
+  std::vector<BlobIndex> indexes(keys.size());
   for (size_t i = 0; i < keys.size(); i++) {
     auto value = &(*values)[i];
     PinnableSlice pinnable_value(value);
-    res[i] = GetImpl(options, handles[i], keys[i], &pinnable_value);
-    if (res[i].ok() && pinnable_value.IsPinned()) {
-      value->assign(pinnable_value.data(), pinnable_value.size());
+    bool is_blob_index = false;
+    {
+      TITAN_PERF_TIMER_GUARD(get_lsm_nanos);
+      res[i] = db_impl_->GetImpl(options, handles[i], keys[i],
+                                 &pinnable_value, nullptr /*value_found*/,
+                                 nullptr /*read_callback*/, &is_blob_index);
+    }
+    if (!res[i].ok()) {
+      continue;
+    }
+    uint32_t cf_id = handles[i]->GetID();
+    HotKeyTracker* tracker = GetHotKeyTracker(cf_id);
+    if (tracker != nullptr) {
+      tracker->RecordRead(keys[i]);
+    }
+    if (!is_blob_index) {
+      if (pinnable_value.IsPinned()) {
+        value->assign(pinnable_value.data(), pinnable_value.size());
+      }
+      BlobSizeController* controller = GetBlobSizeController(cf_id);
+      if (controller != nullptr) {
+        controller->RecordRead(value->size(), false /*is_blob*/);
+      }
+      continue;
+    }
+    res[i] = indexes[i].DecodeFrom(&pinnable_value);
+    assert(res[i].ok());
+    if (res[i].ok()) {
+      blob_keys[cf_id].push_back(i);
+    }
+  }
+
+  for (auto& cf : blob_keys) {
+    const auto& positions = cf.second;
+    mutex_.Lock();
+    auto storage = blob_file_set_->GetBlobStorage(cf.first).lock();
+    mutex_.Unlock();
+    if (!storage) {
+      ROCKS_LOG_ERROR(db_options_.info_log,
+                      "Column family id:%" PRIu32 " not Found.", cf.first);
+      for (size_t i : positions) {
+        res[i] = Status::NotFound("Column family id: " +
+                                  std::to_string(cf.first) + " not Found.");
+      }
+      continue;
+    }
+
+    size_t num = positions.size();
+    std::vector<BlobIndex> cf_indexes;
+    cf_indexes.reserve(num);
+    for (size_t i : positions) {
+      cf_indexes.push_back(indexes[i]);
+    }
+    std::vector<BlobRecord> records(num);
+    std::vector<PinnableSlice> buffers(num);
+    std::vector<Status> statuses(num);
+    {
+      StopWatch read_sw(env_, stats_.get(), BLOB_DB_BLOB_FILE_READ_MICROS);
+      storage->MultiGet(options, num, cf_indexes.data(), records.data(),
+                        buffers.data(), statuses.data());
+    }
+
+    BlobSizeController* controller = GetBlobSizeController(cf.first);
+    for (size_t k = 0; k < num; k++) {
+      size_t i = positions[k];
+      res[i] = statuses[k];
+      if (res[i].IsCorruption()) {
+        ROCKS_LOG_ERROR(db_options_.info_log,
+                        "Key:%s Snapshot:%" PRIu64 " GetBlobFile err:%s\n",
+                        keys[i].ToString(true).c_str(),
+                        options.snapshot->GetSequenceNumber(),
+                        res[i].ToString().c_str());
+      }
+      if (!res[i].ok()) {
+        continue;
+      }
+      (*values)[i].assign(records[k].value.data(), records[k].value.size());
+      if (controller != nullptr) {
+        controller->RecordRead(records[k].value.size(), true /*is_blob*/);
+      }
     }
   }
   return res;
 }
 
+BlobSizeController* TitanDBImpl::GetBlobSizeController(uint32_t cf_id) {
+  if (blob_size_controllers_.empty()) {
+    return nullptr;
+  }
+  auto it = blob_size_controllers_.find(cf_id);
+  return it != blob_size_controllers_.end() ? it->second.get() : nullptr;
+}
+
+HotKeyTracker* TitanDBImpl::GetHotKeyTracker(uint32_t cf_id) {
+  if (hot_key_trackers_.empty()) {
+    return nullptr;
+  }
+  auto it = hot_key_trackers_.find(cf_id);
+  return it != hot_key_trackers_.end() ? it->second.get() : nullptr;
+}
+
+BlobIOScheduler* TitanDBImpl::GetIOScheduler(uint32_t cf_id) {
+  if (!io_schedulers_.empty()) {
+    auto it = io_schedulers_.find(cf_id);
+    if (it != io_schedulers_.end()) {
+      return it->second.get();
+    }
+  }
+  return db_options_.blob_io_scheduler.get();
+}
+
 Iterator* TitanDBImpl::NewIterator(const TitanReadOptions& options,
                                    ColumnFamilyHandle* handle) {
   TitanReadOptions options_copy = options;
@@ -854,31 +1096,10 @@ Status TitanDBImpl::DeleteFilesInRanges(ColumnFamilyHandle* column_family,
   }
 
   auto cf_id = column_family->GetID();
-  std::map<uint64_t, uint64_t> blob_files_discardable_size;
+  BlobFileSizes blob_files_discardable_size;
   for (auto& collection : props) {
-    auto& prop = collection.second;
-    auto ucp_iter = prop->user_collected_properties.find(
-        BlobFileSizeCollector::kPropertiesName);
-    // this sst file doesn't contain any blob index
-    if (ucp_iter == prop->user_collected_properties.end()) {
-      continue;
-    }
-    std::map<uint64_t, uint64_t> sst_blob_files_size;
-    std::string str = ucp_iter->second;
-    Slice slice{str};
-    if (!BlobFileSizeCollector::Decode(&slice, &sst_blob_files_size)) {
-      // TODO: Should treat it as background error and make DB read-only.
-      ROCKS_LOG_ERROR(db_options_.info_log,
-                      "failed to decode table property, "
-                      "deleted file: %s, property size: %" ROCKSDB_PRIszt ".",
-                      collection.first.c_str(), str.size());
-      assert(false);
-      continue;
-    }
-
-    for (auto& it : sst_blob_files_size) {
-      blob_files_discardable_size[it.first] += it.second;
-    }
+    GetBlobFileSizes(collection.first, collection.second.get(),
+                     &blob_files_discardable_size);
   }
 
   // Here could be a running compaction install a new version after obtain
@@ -1051,12 +1272,73 @@ Status TitanDBImpl::SetOptions(
     }
     opts.erase(p);
   }
+  uint64_t blob_sizes[2] = {0, 0};
+  bool set_blob_sizes[2] = {false, false};
+  const char* blob_size_names[2] = {"min_blob_size", "mid_blob_size"};
+  for (int i = 0; i < 2; i++) {
+    auto ps = opts.find(blob_size_names[i]);
+    if (ps == opts.end()) {
+      continue;
+    }
+    try {
+      blob_sizes[i] = ParseUint64(ps->second);
+    } catch (const std::exception&) {
+      return Status::InvalidArgument(std::string("Invalid ") +
+                                     blob_size_names[i] + ": " + ps->second);
+    }
+    set_blob_sizes[i] = true;
+    opts.erase(ps);
+  }
+  bool set_blob_size = set_blob_sizes[0] || set_blob_sizes[1];
+  if (set_blob_size) {
+    MutexLock l(&mutex_);
+    assert(cf_info_.count(column_family->GetID()) > 0);
+    const MutableTitanCFOptions& mutable_opts =
+        cf_info_[column_family->GetID()].mutable_cf_options;
+    if (!set_blob_sizes[0]) {
+      blob_sizes[0] = mutable_opts.min_blob_size;
+    }
+    if (!set_blob_sizes[1]) {
+      blob_sizes[1] = mutable_opts.mid_blob_size;
+    }
+    if (blob_sizes[0] > blob_sizes[1]) {
+      return Status::InvalidArgument(
+          "min_blob_size can't be larger than mid_blob_size");
+    }
+  }
   if (opts.size() > 0) {
     s = db_->SetOptions(column_family, opts);
     if (!s.ok()) {
       return s;
     }
   }
+  if (set_blob_size) {
+    uint32_t cf_id = column_family->GetID();
+    uint64_t min_blob_size = blob_sizes[0];
+    uint64_t mid_blob_size = blob_sizes[1];
+    MutexLock l(&mutex_);
+    TitanColumnFamilyInfo& cf_info = cf_info_[cf_id];
+    cf_info.mutable_cf_options.min_blob_size = min_blob_size;
+    cf_info.mutable_cf_options.mid_blob_size = mid_blob_size;
+    cf_info.titan_table_factory->SetBlobSizes(min_blob_size, mid_blob_size);
+    auto builder = builders_.find(cf_id);
+    if (builder != builders_.end()) {
+      builder->second.SetBlobSizes(min_blob_size, mid_blob_size);
+    }
+    auto controller = blob_size_controllers_.find(cf_id);
+    if (controller != blob_size_controllers_.end()) {
+      controller->second->SetThresholds(min_blob_size, mid_blob_size);
+    }
+    SetStats(stats_.get(), cf_id, TitanInternalStats::MIN_BLOB_SIZE,
+             min_blob_size);
+    SetStats(stats_.get(), cf_id, TitanInternalStats::MID_BLOB_SIZE,
+             mid_blob_size);
+    ROCKS_LOG_INFO(db_options_.info_log,
+                   "[%s] Set min_blob_size: %" PRIu64
+                   ", mid_blob_size: %" PRIu64,
+                   column_family->GetName().c_str(), min_blob_size,
+                   mid_blob_size);
+  }
   // Make sure base db's SetOptions success before setting blob_run_mode.
   if (set_blob_run_mode) {
     uint32_t cf_id = column_family->GetID();
@@ -1100,6 +1382,46 @@ TitanDBOptions TitanDBImpl::GetTitanDBOptions() const {
 
 bool TitanDBImpl::GetProperty(ColumnFamilyHandle* column_family,
                               const Slice& property, std::string* value) {
+  if (property == TitanDB::Properties::kPerfContext) {
+    *value = get_titan_perf_context()->ToString(true /*exclude_zero_counters*/);
+    return true;
+  }
+  if (property == TitanDB::Properties::kBlobDirStats) {
+    std::shared_ptr<BlobStorage> blob_storage;
+    {
+      MutexLock l(&mutex_);
+      blob_storage =
+          blob_file_set_->GetBlobStorage(column_family->GetID()).lock();
+    }
+    if (blob_storage == nullptr) {
+      return false;
+    }
+    struct DirStats {
+      uint64_t num_files = 0;
+      uint64_t file_size = 0;
+      uint64_t discardable_size = 0;
+    };
+    const auto& blob_dirs = blob_storage->cf_options().blob_dirs;
+    std::map<std::string, DirStats> dir_stats;
+    for (auto& dir : blob_dirs) {
+      dir_stats[dir];
+    }
+    blob_storage->ForEachLiveBlobFile([&](const BlobFileMeta& file) {
+      auto& stats =
+          dir_stats[BlobFileDir(dirname_, blob_dirs, file.file_number())];
+      stats.num_files++;
+      stats.file_size += file.file_size();
+      stats.discardable_size += file.discardable_size();
+    });
+    value->clear();
+    for (auto& dir : dir_stats) {
+      *value += dir.first + ": files " + std::to_string(dir.second.num_files) +
+                " size " + std::to_string(dir.second.file_size) +
+                " discardable " +
+                std::to_string(dir.second.discardable_size) + "\n";
+    }
+    return true;
+  }
   std::cout << "## write size ##\n";
   std::cout << "blob builder written bytes: " << bytes_written / 1000000.0
             << std::endl;
@@ -1131,6 +1453,102 @@ bool TitanDBImpl::GetProperty(ColumnFamilyHandle* column_family,
   std::cout << "blob finish time: "
             << foreground_blob_finish_time / 1000000.0 << std::endl;
 
+  if (stats_.get() != nullptr) {
+    uint64_t hit = stats_->getTickerCount(TitanStats::BLOB_VALUE_CACHE_HIT);
+    uint64_t miss = stats_->getTickerCount(TitanStats::BLOB_VALUE_CACHE_MISS);
+    std::cout << "\n## blob value cache ##\n";
+    std::cout << "hit: " << hit << " miss: " << miss << std::endl;
+    std::cout << "hit rate: "
+              << (hit + miss == 0 ? 0.0 : hit * 1.0 / (hit + miss))
+              << std::endl;
+    std::cout << "admitted: "
+              << stats_->getTickerCount(TitanStats::BLOB_VALUE_CACHE_ADD)
+              << " rejected: "
+              << stats_->getTickerCount(TitanStats::BLOB_VALUE_CACHE_REJECT)
+              << std::endl;
+  }
+
+  if (stats_.get() != nullptr && !hot_key_trackers_.empty()) {
+    std::cout << "\n## hot value inlining ##\n";
+    std::cout << "inlined: "
+              << stats_->getTickerCount(TitanStats::BLOB_HOT_VALUE_INLINED)
+              << " kept inline: "
+              << stats_->getTickerCount(TitanStats::BLOB_HOT_VALUE_KEPT)
+              << std::endl;
+  }
+
+  if (stats_.get() != nullptr && write_controller_->enabled()) {
+    std::cout << "\n## blob write stall ##\n";
+    std::cout << "delayed: "
+              << stats_->getTickerCount(TitanStats::BLOB_WRITE_DELAYED)
+              << " stopped: "
+              << stats_->getTickerCount(TitanStats::BLOB_WRITE_STOPPED)
+              << " stall time(s): "
+              << stats_->getTickerCount(TitanStats::BLOB_WRITE_STALL_MICROS) /
+                     1000000.0
+              << " delayed write rate: "
+              << write_controller_->delayed_write_rate() << std::endl;
+  }
+
+  if (stats_.get() != nullptr && !blob_size_controllers_.empty()) {
+    std::cout << "\n## adaptive blob size ##\n";
+    for (auto& controller : blob_size_controllers_) {
+      std::cout << "cf " << controller.first
+                << " min_blob_size: " << controller.second->min_blob_size()
+                << " mid_blob_size: " << controller.second->mid_blob_size()
+                << std::endl;
+    }
+    std::cout << "changes: "
+              << stats_->getTickerCount(TitanStats::BLOB_SIZE_CHANGES)
+              << std::endl;
+    std::cout << "inline write MB: "
+              << stats_->getTickerCount(
+                     TitanStats::BLOB_SIZE_INLINE_WRITE_BYTES) /
+                     1000000.0
+              << " separated write MB: "
+              << stats_->getTickerCount(
+                     TitanStats::BLOB_SIZE_SEPARATED_WRITE_BYTES) /
+                     1000000.0
+              << std::endl;
+    std::cout << "inline read MB: "
+              << stats_->getTickerCount(
+                     TitanStats::BLOB_SIZE_INLINE_READ_BYTES) /
+                     1000000.0
+              << " separated read MB: "
+              << stats_->getTickerCount(
+                     TitanStats::BLOB_SIZE_SEPARATED_READ_BYTES) /
+                     1000000.0
+              << std::endl;
+  }
+
+  std::vector<std::pair<std::string, BlobIOScheduler*>> io_schedulers;
+  if (db_options_.blob_io_scheduler) {
+    io_schedulers.emplace_back("", db_options_.blob_io_scheduler.get());
+  }
+  for (auto& cf : io_schedulers_) {
+    io_schedulers.emplace_back(" of cf " + std::to_string(cf.first),
+                               cf.second.get());
+  }
+  for (auto& scheduler : io_schedulers) {
+    auto* io_scheduler = scheduler.second;
+    std::cout << "\n## blob io scheduler" << scheduler.first << " ##\n";
+    std::cout << "rate: " << io_scheduler->GetBytesPerSecond() / 1048576.0
+              << " MB/s of "
+              << io_scheduler->GetMaxBytesPerSecond() / 1048576.0 << " MB/s"
+              << std::endl;
+    std::cout << "flush bytes: "
+              << io_scheduler->GetTotalBytes(BlobIOSource::kFlush) / 1000000.0
+              << " compaction bytes: "
+              << io_scheduler->GetTotalBytes(BlobIOSource::kCompaction) /
+                     1000000.0
+              << " gc bytes: "
+              << io_scheduler->GetTotalBytes(BlobIOSource::kGC) / 1000000.0
+              << std::endl;
+    std::cout << "throttled time: "
+              << io_scheduler->GetTotalThrottledMicros() / 1000000.0
+              << std::endl;
+  }
+
   std::cout << "\n## blob file states in each level ##\n";
   blob_file_set_->PrintFileStates();
   assert(column_family != nullptr);
@@ -1175,26 +1593,42 @@ void TitanDBImpl::OnMemTableSealed() {
   }
 }
 
+void TitanDBImpl::MaybeTuneBlobSizes(uint32_t cf_id) {
+  auto controller = blob_size_controllers_.find(cf_id);
+  if (controller == blob_size_controllers_.end()) {
+    return;
+  }
+  uint64_t min_blob_size = 0;
+  uint64_t mid_blob_size = 0;
+  if (!controller->second->Tune(&min_blob_size, &mid_blob_size)) {
+    return;
+  }
+  std::unique_ptr<ColumnFamilyHandle> cfh =
+      db_impl_->GetColumnFamilyHandleUnlocked(cf_id);
+  if (cfh == nullptr) {
+    return;
+  }
+  Status s = SetOptions(cfh.get(),
+                        {{"min_blob_size", std::to_string(min_blob_size)},
+                         {"mid_blob_size", std::to_string(mid_blob_size)}});
+  if (!s.ok()) {
+    ROCKS_LOG_WARN(db_options_.info_log,
+                   "[%s] Failed to move the blob size thresholds: %s",
+                   cfh->GetName().c_str(), s.ToString().c_str());
+  }
+}
+
 void TitanDBImpl::OnFlushCompleted(const FlushJobInfo& flush_job_info) {
-  const auto& tps = flush_job_info.table_properties;
-  // std::cerr <<"file name"<<  flush_job_info.file_path<< "data size: "<< tps.data_size <<"index size: " << tps.index_size <<std::endl;
-  auto ucp_iter = tps.user_collected_properties.find(
-      BlobFileSizeCollector::kPropertiesName);
+  // Flushes pace the controller, since they follow the volume of writes.
+  MaybeTuneBlobSizes(flush_job_info.cf_id);
+
+  BlobFileSizes blob_files_size;
+  GetBlobFileSizes(flush_job_info.file_path, &flush_job_info.table_properties,
+                   &blob_files_size);
   // sst file doesn't contain any blob index
-  if (ucp_iter == tps.user_collected_properties.end()) {
+  if (blob_files_size.empty()) {
     return;
   }
-  std::map<uint64_t, uint64_t> blob_files_size;
-  Slice src{ucp_iter->second};
-  if (!BlobFileSizeCollector::Decode(&src, &blob_files_size)) {
-    // TODO: Should treat it as background error and make DB read-only.
-    ROCKS_LOG_ERROR(db_options_.info_log,
-                    "OnFlushCompleted[%d]: failed to decode table property, "
-                    "property size: %" ROCKSDB_PRIszt ".",
-                    flush_job_info.job_id, ucp_iter->second.size());
-    assert(false);
-  }
-  assert(!blob_files_size.empty());
 
   {
     MutexLock l(&mutex_);
@@ -1210,6 +1644,7 @@ void TitanDBImpl::OnFlushCompleted(const FlushJobInfo& flush_job_info) {
       return;
     }
     uint64_t delta = 0;
+    std::vector<std::shared_ptr<BlobFileMeta>> files;
     for (const auto& f : blob_files_size) {
       auto file = blob_storage->FindFile(f.first).lock();
       // This file maybe output of a gc job, and it's been GCed out.
@@ -1221,7 +1656,11 @@ void TitanDBImpl::OnFlushCompleted(const FlushJobInfo& flush_job_info) {
                      flush_job_info.job_id, file->file_number());
       uint64_t discardable = 0;
 
-      if (file->discardable_size() == 0) {
+      // Sorted blob files are all live when flushed. Their blob handles
+      // don't add up to the file size in version 2 files.
+      if (file->file_type() == kSorted) {
+        discardable = 0;
+      } else if (file->discardable_size() == 0) {
         discardable = file->file_size() - f.second -
                                  kBlobHeaderSize - kBlobFooterSize;
       } else {
@@ -1233,7 +1672,9 @@ void TitanDBImpl::OnFlushCompleted(const FlushJobInfo& flush_job_info) {
       file->AddDiscardableSize(discardable);
       if (file->file_type() == kSorted) assert(file->discardable_size() == 0);
       file->FileStateTransit(BlobFileMeta::FileEvent::kFlushCompleted);
+      files.emplace_back(std::move(file));
     }
+    blob_storage->UpdateGCScore(files);
   }
   TEST_SYNC_POINT("TitanDBImpl::OnFlushCompleted:Finished");
 }
@@ -1245,74 +1686,75 @@ void TitanDBImpl::OnCompactionCompleted(
     return;
   }
   int mark = 0;
-  std::map<uint64_t, int64_t> blob_files_size_diff;
-  std::set<uint64_t> outputs;
-  std::set<uint64_t> inputs;
-  auto calc_bfs = [&](const std::vector<std::string>& files, int coefficient,
-                      bool output) {
+  BlobFileSizes input_blob_files_size;
+  BlobFileSizes output_blob_files_size;
+  auto calc_bfs = [&](const std::vector<std::string>& files,
+                      BlobFileSizes* blob_files_size, bool output) {
     for (const auto& file : files) {
+      const TableProperties* props = nullptr;
       auto tp_iter = compaction_job_info.table_properties.find(file);
-      if (tp_iter == compaction_job_info.table_properties.end()) {
-        if (output) {
-          ROCKS_LOG_WARN(
-              db_options_.info_log,
-              "OnCompactionCompleted[%d]: No table properties for file %s.",
-              compaction_job_info.job_id, file.c_str());
-        }
-        continue;
-      }
-      auto ucp_iter = tp_iter->second->user_collected_properties.find(
-          BlobFileSizeCollector::kPropertiesName);
-      // this sst file doesn't contain any blob index
-      if (ucp_iter == tp_iter->second->user_collected_properties.end()) {
-        continue;
-      }
-      std::map<uint64_t, uint64_t> input_blob_files_size;
-      std::string s = ucp_iter->second;
-      Slice slice{s};
-      if (!BlobFileSizeCollector::Decode(&slice, &input_blob_files_size)) {
-        // TODO: Should treat it as background error and make DB read-only.
-        ROCKS_LOG_ERROR(
+      if (tp_iter != compaction_job_info.table_properties.end()) {
+        props = tp_iter->second.get();
+      } else if (output) {
+        ROCKS_LOG_WARN(
             db_options_.info_log,
-            "OnCompactionCompleted[%d]: failed to decode table property, "
-            "compaction file: %s, property size: %" ROCKSDB_PRIszt ".",
-            compaction_job_info.job_id, file.c_str(), s.size());
-        assert(false);
-        continue;
-      }
-      for (const auto& input_bfs : input_blob_files_size) {
-        if (output) {
-          if (inputs.find(input_bfs.first) == inputs.end()) {
-            outputs.insert(input_bfs.first);
-          }
-        } else {
-          inputs.insert(input_bfs.first);
-        }
-        auto bfs_iter = blob_files_size_diff.find(input_bfs.first);
-        if (bfs_iter == blob_files_size_diff.end()) {
-          blob_files_size_diff[input_bfs.first] =
-              coefficient * input_bfs.second;
-        } else {
-          bfs_iter->second += coefficient * input_bfs.second;
-        }
+            "OnCompactionCompleted[%d]: No table properties for file %s.",
+            compaction_job_info.job_id, file.c_str());
       }
+      GetBlobFileSizes(file, props, blob_files_size);
     }
   };
 
-  calc_bfs(compaction_job_info.input_files, -1, false);
-  calc_bfs(compaction_job_info.output_files, 1, true);
+  calc_bfs(compaction_job_info.input_files, &input_blob_files_size, false);
+  calc_bfs(compaction_job_info.output_files, &output_blob_files_size, true);
 
+  // Bytes of blob records dropped by this compaction, per blob file.
+  BlobFileSizes garbage;
+  BlobGarbageMeter::ComputeGarbage(input_blob_files_size,
+                                   output_blob_files_size, &garbage);
+  std::set<uint64_t> outputs;
+  for (const auto& bfs : output_blob_files_size) {
+    if (input_blob_files_size.count(bfs.first) == 0) {
+      outputs.insert(bfs.first);
+    }
+  }
+
+  std::shared_ptr<BlobStorage> bs;
   {
     MutexLock l(&mutex_);
-    auto bs = blob_file_set_->GetBlobStorage(compaction_job_info.cf_id).lock();
-    if (!bs) {
-      // TODO: Should treat it as background error and make DB read-only.
-      ROCKS_LOG_ERROR(db_options_.info_log,
-                      "OnCompactionCompleted[%d] Column family id:%" PRIu32
-                      " not Found.",
-                      compaction_job_info.job_id, compaction_job_info.cf_id);
-      return;
+    bs = blob_file_set_->GetBlobStorage(compaction_job_info.cf_id).lock();
+  }
+  if (!bs) {
+    // TODO: Should treat it as background error and make DB read-only.
+    ROCKS_LOG_ERROR(db_options_.info_log,
+                    "OnCompactionCompleted[%d] Column family id:%" PRIu32
+                    " not Found.",
+                    compaction_job_info.job_id, compaction_job_info.cf_id);
+    return;
+  }
+
+  // Discardable sizes are updated without holding the DB mutex.
+  std::vector<std::shared_ptr<BlobFileMeta>> garbage_files;
+  for (const auto& bfs : garbage) {
+    auto file = bs->FindFile(bfs.first).lock();
+    if (!file) {
+      // file has been gc out
+      continue;
     }
+    uint64_t discardable = file->AddDiscardableSize(bfs.second);
+    auto before = file->GetDiscardableRatioLevel(discardable);
+    auto after = file->GetDiscardableRatioLevel(
+        std::min(discardable + bfs.second, file->file_size()));
+    if (before != after) {
+      AddStats(stats_.get(), compaction_job_info.cf_id, after, 1);
+      SubStats(stats_.get(), compaction_job_info.cf_id, before, 1);
+    }
+    garbage_files.emplace_back(std::move(file));
+  }
+  size_t num_gc_files = bs->UpdateGCScore(garbage_files);
+
+  {
+    MutexLock l(&mutex_);
     for (const auto& file_number : outputs) {
       auto file = bs->FindFile(file_number).lock();
       if (!file) {
@@ -1338,39 +1780,27 @@ void TitanDBImpl::OnCompactionCompleted(
     bool count_sorted_run =
         cf_options.level_merge && cf_options.range_merge &&
         cf_options.num_levels - 2 <= compaction_job_info.output_level;
-        /*
-    if(count_sorted_run){
-    std::cerr<<"num levels "<<cf_options.num_levels<<" output level "<<compaction_job_info.output_level<<" input level "<<compaction_job_info.base_input_level<<std::endl;
-    if(cf_options.num_levels - 1 == compaction_job_info.output_level) std::cerr<<compaction_job_info.output_level<<" is "<<cf_options.num_levels - 1<<std::endl;
-    else std::cerr<<"no"<<std::endl;
-    }*/
-    for (const auto& bfs : blob_files_size_diff) {
-      // std::cerr<<"total "<<blob_files_size_diff.size()<<"vtables in output level"<<compaction_job_info.output_level<<std::endl;
-      // blob file size < 0 means discardable size > 0
-      if (bfs.second >= 0) {
-        if (count_sorted_run) {
-          auto file = bs->FindFile(bfs.first).lock();
-          if (file != nullptr && file->file_type() == kSorted && (int)file->file_level()>=cf_options.num_levels-2) {
-            files.emplace_back(std::move(file));
-          }
+    if (count_sorted_run) {
+      // Files without garbage are counted as well.
+      auto add_sorted_run = [&](uint64_t file_number) {
+        auto file = bs->FindFile(file_number).lock();
+        if (file != nullptr && file->file_type() == kSorted &&
+            (int)file->file_level() >= cf_options.num_levels - 2) {
+          files.emplace_back(std::move(file));
+        }
+      };
+      for (const auto& bfs : input_blob_files_size) {
+        if (garbage.count(bfs.first) == 0) {
+          add_sorted_run(bfs.first);
         }
-        continue;
       }
-      auto file = bs->FindFile(bfs.first).lock();
-      if (!file) {
-        // file has been gc out
-        continue;
+      for (const auto& file_number : outputs) {
+        add_sorted_run(file_number);
       }
+    }
+    for (auto& file : garbage_files) {
       if (!file->is_obsolete()) {
-        delta += -bfs.second;
-      }
-      auto before = file->GetDiscardableRatioLevel();
-      file->AddDiscardableSize(static_cast<uint64_t>(-bfs.second));
-      // std::cerr<<"after add "<<file->GetDiscardableRatio()<<std::endl;
-      auto after = file->GetDiscardableRatioLevel();
-      if (before != after) {
-        AddStats(stats_.get(), compaction_job_info.cf_id, after, 1);
-        SubStats(stats_.get(), compaction_job_info.cf_id, before, 1);
+        delta += garbage[file->file_number()];
       }
       if (cf_options.level_merge) {
         // After level merge, most entries of merged blob files are written to
@@ -1382,17 +1812,13 @@ void TitanDBImpl::OnCompactionCompleted(
                               db_impl_->GetLatestSequenceNumber());
           continue;
         } else if (file->file_type() == kSorted &&
-                   (/*file->GetDiscardableRatio() >
-                        cf_options.high_level_blob_discardable_ratio ||
-                    (static_cast<int>(file->file_level()) >=
-                         cf_options.num_levels - 2 &&*/
-                     file->GetDiscardableRatio() >
-                         cf_options.blob_file_discardable_ratio)) {
-          if(file->file_state() != BlobFileMeta::FileState::kToGC)
-            mark++;
+                   file->GetDiscardableRatio() >
+                       cf_options.blob_file_discardable_ratio) {
+          if (file->file_state() != BlobFileMeta::FileState::kToGC) mark++;
           file->FileStateTransit(BlobFileMeta::FileEvent::kNeedGC);
         }
-        if (count_sorted_run && file->file_type() == kSorted && (int)file->file_level()>=cf_options.num_levels-2) {
+        if (count_sorted_run && file->file_type() == kSorted &&
+            (int)file->file_level() >= cf_options.num_levels - 2) {
           files.emplace_back(std::move(file));
         }
       }
@@ -1414,26 +1840,61 @@ void TitanDBImpl::OnCompactionCompleted(
     // bool bg_gc = total_size>live_size&& (double)(total_size-live_size)/total_size > cf_options.blob_file_discardable_ratio; // trigger wisckey gc?
     bool wisc_gc = !cf_options.level_merge && total_size > (uint64_t) (100+100*cf_options.blob_file_discardable_ratio)<<30;
     bool bg_gc = cf_options.level_merge&&db_options_.sep_before_flush;
-    if(db_options_.block_write_size>0){
-    if(total_size>db_options_.block_write_size) {
-      block_for_size_.store(true);
-    } else if(block_for_size_.load()){
-      block_for_size_.store(false);
-      size_cv_.SignalAll();
-    }
+    if (write_controller_->Update(total_size)) {
+      // GC scores are otherwise only updated for the files compaction
+      // left garbage in.
+      bs->ComputeGCScore();
     }
 
-    if (wisc_gc || bg_gc) {
-      if (bs->ComputeGCScore() >
-          (1<<30) / cf_options.blob_file_target_size || block_for_size_.load()) {
-        AddToGCQueue(compaction_job_info.cf_id);
-        MaybeScheduleGC();
-      }
+    // Only GC brings the size of the blob files down once writes are held,
+    // whatever GC the column family runs otherwise.
+    if (write_controller_->IsThrottled() ||
+        ((wisc_gc || bg_gc) &&
+         num_gc_files > (1 << 30) / cf_options.blob_file_target_size)) {
+      AddToGCQueue(compaction_job_info.cf_id);
+      MaybeScheduleGC();
     }
   }
   gc_mark_file += mark;
 }
 
+void TitanDBImpl::OnTableFileDeleted(const TableFileDeletionInfo& info) {
+  // Covers compaction inputs as well as the SSTs of dropped column families
+  // and the outputs of failed compactions, which no other callback sees.
+  garbage_meter_->RemoveTable(TableFileNameToNumber(info.file_path));
+}
+
+void TitanDBImpl::GetBlobFileSizes(const std::string& sst_path,
+                                   const TableProperties* props,
+                                   BlobFileSizes* blob_files_size) {
+  if (garbage_meter_->GetTable(TableFileNameToNumber(sst_path),
+                               blob_files_size) ||
+      props == nullptr) {
+    return;
+  }
+  // The file was written before the DB was opened.
+  auto ucp_iter = props->user_collected_properties.find(
+      BlobFileSizeCollector::kPropertiesName);
+  // this sst file doesn't contain any blob index
+  if (ucp_iter == props->user_collected_properties.end()) {
+    return;
+  }
+  std::map<uint64_t, uint64_t> sst_blob_files_size;
+  Slice slice{ucp_iter->second};
+  if (!BlobFileSizeCollector::Decode(&slice, &sst_blob_files_size)) {
+    // TODO: Should treat it as background error and make DB read-only.
+    ROCKS_LOG_ERROR(db_options_.info_log,
+                    "Failed to decode table property, file: %s, "
+                    "property size: %" ROCKSDB_PRIszt ".",
+                    sst_path.c_str(), ucp_iter->second.size());
+    assert(false);
+    return;
+  }
+  for (const auto& bfs : sst_blob_files_size) {
+    (*blob_files_size)[bfs.first] += bfs.second;
+  }
+}
+
 Status TitanDBImpl::SetBGError(const Status& s) {
   if (s.ok()) return s;
   mutex_.AssertHeld();
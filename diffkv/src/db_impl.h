@@ -6,6 +6,9 @@
 
 #include "blob_file_manager.h"
 #include "blob_file_set.h"
+#include "blob_garbage_meter.h"
+#include "blob_size_controller.h"
+#include "blob_write_controller.h"
 #include "table_builder.h"
 #include "table_factory.h"
 #include "titan/db.h"
@@ -20,6 +23,8 @@ struct TitanColumnFamilyInfo {
   MutableTitanCFOptions mutable_cf_options;
   std::shared_ptr<TableFactory> base_table_factory;
   std::shared_ptr<TitanTableFactory> titan_table_factory;
+  // Creates the blob files of the column family, in its blob_dirs if any.
+  std::shared_ptr<BlobFileManager> blob_manager;
 };
 
 class TitanDBImpl : public TitanDB {
@@ -139,6 +144,8 @@ class TitanDBImpl : public TitanDB {
 
   void OnCompactionCompleted(const CompactionJobInfo& compaction_job_info);
 
+  void OnTableFileDeleted(const TableFileDeletionInfo& info);
+
   void StartBackgroundTasks();
 
   Status TEST_StartGC(uint32_t column_family_id);
@@ -149,6 +156,8 @@ class TitanDBImpl : public TitanDB {
     return bg_gc_running_;
   }
 
+  BlobGarbageMeter* TEST_garbage_meter() { return garbage_meter_.get(); }
+
  private:
   class FileManager;
   friend class FileManager;
@@ -169,6 +178,19 @@ class TitanDBImpl : public TitanDB {
       const std::vector<ColumnFamilyHandle*>& handles,
       const std::vector<Slice>& keys, std::vector<std::string>* values);
 
+  // Returns the controller or tracker of the column family, or nullptr if
+  // it wasn't opened with one.
+  BlobSizeController* GetBlobSizeController(uint32_t cf_id);
+  HotKeyTracker* GetHotKeyTracker(uint32_t cf_id);
+  // Returns the IO scheduler of the column family, or nullptr if neither
+  // it nor the DB has one.
+  BlobIOScheduler* GetIOScheduler(uint32_t cf_id);
+
+  // Creates the blob_dirs of a column family and returns the manager of
+  // its blob files, which is the DB-wide one if it has no blob_dirs.
+  Status NewBlobFileManager(const TitanCFOptions& cf_options,
+                            std::shared_ptr<BlobFileManager>* manager);
+
   Iterator* NewIteratorImpl(const TitanReadOptions& options,
                             ColumnFamilyHandle* handle,
                             std::shared_ptr<ManagedSnapshot> snapshot);
@@ -192,6 +214,11 @@ class TitanDBImpl : public TitanDB {
   // REQUIRE: mutex_ held
   void MaybeScheduleGC();
 
+  // Queues GC for every column family if none is queued or running. Called
+  // by writers stopped on the size of the blob files, which only GC can
+  // release once compactions are done.
+  void ScheduleGCForStalledWrites();
+
   static void BGWorkGC(void* db);
   void BackgroundCallGC();
   Status BackgroundGC(LogBuffer* log_buffer, uint32_t column_family_id);
@@ -223,10 +250,25 @@ class TitanDBImpl : public TitanDB {
     return bg_error_;
   }
 
+  // Counts the values written by the batch for the column families with
+  // adaptive_blob_size.
+  void RecordWriteSizes(WriteBatch* updates);
+
+  // Lets the adaptive separation controller of the column family move its
+  // thresholds through SetOptions.
+  void MaybeTuneBlobSizes(uint32_t cf_id);
+
   void MarkFileIfNeedMerge(
       const std::vector<std::shared_ptr<BlobFileMeta>>& files,
       int max_sorted_runs);
 
+  // Adds the blob references of an SST to "blob_files_size". They are taken
+  // from the garbage meter, or decoded from "props" if the SST was written
+  // before the DB was opened.
+  void GetBlobFileSizes(const std::string& sst_path,
+                        const TableProperties* props,
+                        BlobFileSizes* blob_files_size);
+
   bool HasBGError() { return has_bg_error_.load(); }
 
   void DumpStats();
@@ -262,6 +304,21 @@ class TitanDBImpl : public TitanDB {
 
   std::unordered_map<uint32_t, ForegroundBuilder> builders_;
 
+  // Controllers of the column families opened with adaptive_blob_size.
+  // Only changed during DB open.
+  std::unordered_map<uint32_t, std::shared_ptr<BlobSizeController>>
+      blob_size_controllers_;
+
+  // Read frequency of the keys of the column families opened with
+  // inline_hot_value_frequency. Only changed during DB open.
+  std::unordered_map<uint32_t, std::shared_ptr<HotKeyTracker>>
+      hot_key_trackers_;
+
+  // IO schedulers of the column families opened with their own
+  // blob_io_scheduler. Only changed during DB open.
+  std::unordered_map<uint32_t, std::shared_ptr<BlobIOScheduler>>
+      io_schedulers_;
+
   // handle for purging obsolete blob files at fixed intervals
   std::unique_ptr<RepeatableThread> thread_purge_obsolete_;
 
@@ -271,6 +328,8 @@ class TitanDBImpl : public TitanDB {
   std::unique_ptr<BlobFileSet> blob_file_set_;
   std::set<uint64_t> pending_outputs_;
   std::shared_ptr<BlobFileManager> blob_manager_;
+  std::shared_ptr<BlobGarbageMeter> garbage_meter_{
+      std::make_shared<BlobGarbageMeter>()};
 
   // gc_queue_ hold column families that we need to gc.
   // pending_gc_ hold column families that already on gc_queue_.
@@ -286,9 +345,10 @@ class TitanDBImpl : public TitanDB {
   int drop_cf_requests_ = 0;
 
   std::atomic_bool shuting_down_{false};
-  std::atomic<bool> block_for_size_{false};
-  port::CondVar size_cv_;
-  mutable port::Mutex size_mutex_;
+
+  // Delays and stops foreground writes as the blob files grow towards
+  // block_write_size.
+  std::unique_ptr<BlobWriteController> write_controller_;
 };
 
 }  // namespace titandb
@@ -28,6 +28,17 @@ void TitanDBImpl::MaybeScheduleGC() {
   }
 }
 
+void TitanDBImpl::ScheduleGCForStalledWrites() {
+  MutexLock l(&mutex_);
+  if (!gc_queue_.empty() || bg_gc_scheduled_ > 0) return;
+  for (auto& cf : cf_info_) {
+    if (!blob_file_set_->IsColumnFamilyObsolete(cf.first)) {
+      AddToGCQueue(cf.first);
+    }
+  }
+  MaybeScheduleGC();
+}
+
 void TitanDBImpl::BGWorkGC(void* db) {
   reinterpret_cast<TitanDBImpl*>(db)->BackgroundCallGC();
 }
@@ -113,7 +124,8 @@ Status TitanDBImpl::BackgroundGC(LogBuffer* log_buffer,
       ROCKS_LOG_BUFFER(log_buffer, "Titan GC nothing to do");
     } else {
       BlobGCJob blob_gc_job(blob_gc.get(), db_, &mutex_, db_options_, env_,
-                            env_options_, blob_manager_.get(),
+                            env_options_,
+                            cf_info_[column_family_id].blob_manager.get(),
                             blob_file_set_.get(), log_buffer, &shuting_down_,
                             stats_.get(), &builders_[column_family_id]);
       s = blob_gc_job.Prepare();
@@ -136,18 +148,14 @@ Status TitanDBImpl::BackgroundGC(LogBuffer* log_buffer,
       uint64_t live_size = 0;
       GetIntProperty("rocksdb.titandb.live-blob-file-size",&total_size);
       GetIntProperty("rocksdb.titandb.live-blob-size",&live_size);
-      if(block_for_size_.load()&&total_size<db_options_.block_write_size){
-        MutexLock l(&size_mutex_);
-        block_for_size_.store(false);
-        size_cv_.SignalAll();
-      }
+      write_controller_->Update(total_size);
 
       auto cf_options = blob_storage->cf_options();
       bool wisc_gc = !cf_options.level_merge && total_size> (uint64_t) (100+100*cf_options.blob_file_discardable_ratio)<<30;
       // bool wisc_gc = !cf_options.level_merge && total_size>live_size && (double)(total_size-live_size)/total_size > blob_storage->cf_options().blob_file_discardable_ratio;
 
       bool bg_gc = (bg_gc_scheduled_ - 1 + gc_queue_.size() <
-           2 * static_cast<uint32_t>(db_options_.max_background_gc)) && (block_for_size_.load() || blob_gc->trigger_next());
+           2 * static_cast<uint32_t>(db_options_.max_background_gc)) && (write_controller_->IsThrottled() || blob_gc->trigger_next());
 
       if (bg_gc || wisc_gc) {
         // RecordTick(stats_.get(), TitanStats::GC_TRIGGER_NEXT, 1);
@@ -92,30 +92,24 @@ class TitanDBIterator : public Iterator {
     }
   }
 
-void Scan(const Slice& target, int& len, std::vector<std::string>& keys,
+  void Scan(const Slice& target, int& len, std::vector<std::string>& keys,
             std::vector<std::string>& values) {
-    std::vector<BlobIndex> indexes(len);
+    // Blob values are read in one batch once the keys are collected, so
+    // they don't go through the prefetchers of the iterator.
+    std::vector<BlobIndex> indexes;
+    std::vector<int> blob_positions;
     int i = 0;
     iter_->Seek(target);
     while (i < len && Valid()) {
       if (ShouldGetBlobValue()) {
         assert(iter_->status().ok());
-        status_ = DecodeInto(iter_->value(), &indexes[i]);
+        BlobIndex index;
+        status_ = DecodeInto(iter_->value(), &index);
         if (!status_.ok()) {
           return;
         }
-        auto it = files_.find(indexes[i].file_number);
-        if (it == files_.end()) {
-          std::unique_ptr<BlobFilePrefetcher> prefetcher;
-          status_ =
-              storage_->NewPrefetcher(indexes[i].file_number, &prefetcher);
-          if (!status_.ok()) {
-            return;
-          }
-          it = files_.emplace(indexes[i].file_number, std::move(prefetcher))
-                   .first;
-        }
-        it->second->Prefetch(indexes[i].blob_handle);
+        indexes.push_back(index);
+        blob_positions.push_back(i);
       } else {
         values[i] = iter_->value().ToString();
       }
@@ -124,14 +118,27 @@ void Scan(const Slice& target, int& len, std::vector<std::string>& keys,
       i++;
     }
     len = i;
-    BlobRecord record;
-    PinnableSlice buffer;
-    for (int j=0;j<len;j++){
-      if(values[j].empty()){
-        auto it = files_.find(indexes[j].file_number);
-        it->second->PointGet(options_, indexes[j].blob_handle, &record, &buffer);
-        values[j] = std::move(record.value.ToString());
+    if (indexes.empty()) {
+      return;
+    }
+    size_t num = indexes.size();
+    std::vector<BlobRecord> records(num);
+    std::vector<PinnableSlice> buffers(num);
+    std::vector<Status> statuses(num);
+    storage_->MultiGet(options_, num, indexes.data(), records.data(),
+                       buffers.data(), statuses.data());
+    for (size_t j = 0; j < num; j++) {
+      if (!statuses[j].ok()) {
+        status_ = statuses[j];
+        ROCKS_LOG_ERROR(
+            info_log_,
+            "Titan iterator: failed to read blob value from file %" PRIu64
+            ", offset %" PRIu64 ", size %" PRIu64 ": %s\n",
+            indexes[j].file_number, indexes[j].blob_handle.offset,
+            indexes[j].blob_handle.size, status_.ToString().c_str());
+        continue;
       }
+      values[blob_positions[j]] = records[j].value.ToString();
     }
   }
 
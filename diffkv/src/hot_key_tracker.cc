@@ -0,0 +1,27 @@
+#include "hot_key_tracker.h"
+
+#include <algorithm>
+
+#include "util/hash.h"
+
+namespace rocksdb {
+namespace titandb {
+
+HotKeyTracker::HotKeyTracker(const TitanCFOptions& cf_options)
+    : min_frequency_(std::min<uint32_t>(cf_options.inline_hot_value_frequency,
+                                        FrequencySketch::kMaxFrequency)),
+      max_value_size_(cf_options.inline_hot_value_max_size),
+      sketch_(cf_options.inline_hot_value_sketch_entries) {}
+
+void HotKeyTracker::RecordRead(const Slice& user_key) {
+  sketch_.Increment(GetSliceNPHash64(user_key));
+}
+
+bool HotKeyTracker::ShouldInline(const Slice& user_key,
+                                 uint64_t value_size) const {
+  return min_frequency_ > 0 && value_size <= max_value_size_ &&
+         sketch_.Frequency(GetSliceNPHash64(user_key)) >= min_frequency_;
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
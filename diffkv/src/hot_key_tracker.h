@@ -0,0 +1,32 @@
+#pragma once
+
+#include "rocksdb/slice.h"
+
+#include "blob_value_cache.h"
+#include "titan/options.h"
+
+namespace rocksdb {
+namespace titandb {
+
+// Tracks how often the keys of a column family are read, so that
+// compaction can write the values of read-hot keys back into the SST and
+// serve them with one I/O, and separate them again once they cool down.
+// Only point lookups are counted.
+class HotKeyTracker {
+ public:
+  explicit HotKeyTracker(const TitanCFOptions& cf_options);
+
+  // Counts a point lookup of the user key.
+  void RecordRead(const Slice& user_key);
+
+  // Returns true if the value of the user key should be kept in the SST.
+  bool ShouldInline(const Slice& user_key, uint64_t value_size) const;
+
+ private:
+  const uint32_t min_frequency_;
+  const uint64_t max_value_size_;
+  FrequencySketch sketch_;
+};
+
+}  // namespace titandb
+}  // namespace rocksdb
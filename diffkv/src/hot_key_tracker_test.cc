@@ -0,0 +1,44 @@
+#include "hot_key_tracker.h"
+
+#include "test_util/testharness.h"
+
+namespace rocksdb {
+namespace titandb {
+
+class HotKeyTrackerTest : public testing::Test {};
+
+TEST(HotKeyTrackerTest, Basic) {
+  TitanCFOptions cf_options;
+  cf_options.inline_hot_value_frequency = 3;
+  cf_options.inline_hot_value_max_size = 1024;
+  HotKeyTracker tracker(cf_options);
+
+  for (int i = 0; i < 2; i++) {
+    tracker.RecordRead("hot");
+  }
+  ASSERT_FALSE(tracker.ShouldInline("hot", 100));
+  tracker.RecordRead("hot");
+  ASSERT_TRUE(tracker.ShouldInline("hot", 100));
+  ASSERT_TRUE(tracker.ShouldInline("hot", 1024));
+  // Hot keys with big values are left separated.
+  ASSERT_FALSE(tracker.ShouldInline("hot", 1025));
+  ASSERT_FALSE(tracker.ShouldInline("cold", 100));
+}
+
+TEST(HotKeyTrackerTest, Disabled) {
+  TitanCFOptions cf_options;
+  ASSERT_EQ(cf_options.inline_hot_value_frequency, 0);
+  HotKeyTracker tracker(cf_options);
+  for (int i = 0; i < 20; i++) {
+    tracker.RecordRead("hot");
+  }
+  ASSERT_FALSE(tracker.ShouldInline("hot", 100));
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
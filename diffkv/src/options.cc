@@ -21,22 +21,66 @@ void TitanDBOptions::Dump(Logger* logger) const {
   ROCKS_LOG_HEADER(logger,
                    "TitanDBOptions.max_background_gc          : %" PRIi32,
                    max_background_gc);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.max_gc_subjobs             : %" PRIi32,
+                   max_gc_subjobs);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.blob_io_scheduler          : %p",
+                   blob_io_scheduler.get());
   ROCKS_LOG_HEADER(logger,
                    "TitanDBOptions.purge_obsolete_files_period_sec: %" PRIu32,
                    purge_obsolete_files_period_sec);
   ROCKS_LOG_HEADER(logger,
                    "TitanDBOptions.titan_stats_dump_period_sec: %" PRIu32,
                    titan_stats_dump_period_sec);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.titan_max_manifest_file_size: %" PRIu64,
+                   titan_max_manifest_file_size);
+  ROCKS_LOG_HEADER(logger, "TitanDBOptions.verify_blob_files_on_open  : %d",
+                   static_cast<int>(verify_blob_files_on_open));
+  ROCKS_LOG_HEADER(logger, "TitanDBOptions.sep_before_flush           : %d",
+                   static_cast<int>(sep_before_flush));
+  ROCKS_LOG_HEADER(logger, "TitanDBOptions.num_foreground_builders    : %d",
+                   num_foreground_builders);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.numa_aware_foreground_builders: %d",
+                   static_cast<int>(numa_aware_foreground_builders));
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.blob_read_queue_depth      : %" PRIu32,
+                   blob_read_queue_depth);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.block_write_size           : %" PRIu64,
+                   block_write_size);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanDBOptions.slowdown_write_size        : %" PRIu64,
+                   slowdown_write_size);
 }
 
 TitanCFOptions::TitanCFOptions(const ColumnFamilyOptions& cf_opts,
                                const ImmutableTitanCFOptions& immutable_opts,
                                const MutableTitanCFOptions& mutable_opts)
     : ColumnFamilyOptions(cf_opts),
-      min_blob_size(immutable_opts.min_blob_size),
+      min_blob_size(mutable_opts.min_blob_size),
+      mid_blob_size(mutable_opts.mid_blob_size),
+      adaptive_blob_size(immutable_opts.adaptive_blob_size),
       blob_file_compression(immutable_opts.blob_file_compression),
       blob_file_target_size(immutable_opts.blob_file_target_size),
+      blob_dirs(immutable_opts.blob_dirs),
+      blob_io_scheduler(immutable_opts.blob_io_scheduler),
+      blob_file_use_direct_io(immutable_opts.blob_file_use_direct_io),
+      blob_file_write_buffer_size(immutable_opts.blob_file_write_buffer_size),
+      blob_file_format_version(immutable_opts.blob_file_format_version),
+      blob_file_block_size(immutable_opts.blob_file_block_size),
+      blob_file_compression_options(
+          immutable_opts.blob_file_compression_options),
       blob_cache(immutable_opts.blob_cache),
+      blob_value_cache(immutable_opts.blob_value_cache),
+      blob_value_cache_min_frequency(
+          immutable_opts.blob_value_cache_min_frequency),
+      inline_hot_value_frequency(immutable_opts.inline_hot_value_frequency),
+      inline_hot_value_max_size(immutable_opts.inline_hot_value_max_size),
+      inline_hot_value_sketch_entries(
+          immutable_opts.inline_hot_value_sketch_entries),
       max_gc_batch_size(immutable_opts.max_gc_batch_size),
       min_gc_batch_size(immutable_opts.min_gc_batch_size),
       blob_file_discardable_ratio(immutable_opts.blob_file_discardable_ratio),
@@ -48,6 +92,11 @@ void TitanCFOptions::Dump(Logger* logger) const {
   ROCKS_LOG_HEADER(logger,
                    "TitanCFOptions.min_blob_size                : %" PRIu64,
                    min_blob_size);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.mid_blob_size                : %" PRIu64,
+                   mid_blob_size);
+  ROCKS_LOG_HEADER(logger, "TitanCFOptions.adaptive_blob_size           : %d",
+                   static_cast<int>(adaptive_blob_size));
   std::string compression_str = "unknown";
   for (auto& compression_type : compression_type_string_map) {
     if (compression_type.second == blob_file_compression) {
@@ -60,11 +109,53 @@ void TitanCFOptions::Dump(Logger* logger) const {
   ROCKS_LOG_HEADER(logger,
                    "TitanCFOptions.blob_file_target_size        : %" PRIu64,
                    blob_file_target_size);
+  for (size_t i = 0; i < blob_dirs.size(); i++) {
+    ROCKS_LOG_HEADER(logger, "TitanCFOptions.blob_dirs[%" ROCKSDB_PRIszt
+                             "]                 : %s",
+                     i, blob_dirs[i].c_str());
+  }
+  ROCKS_LOG_HEADER(logger, "TitanCFOptions.blob_io_scheduler            : %p",
+                   blob_io_scheduler.get());
+  ROCKS_LOG_HEADER(logger, "TitanCFOptions.blob_file_use_direct_io      : %d",
+                   blob_file_use_direct_io);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.blob_file_write_buffer_size  : %" PRIu64,
+                   blob_file_write_buffer_size);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.blob_file_format_version     : %" PRIu32,
+                   blob_file_format_version);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.blob_file_block_size         : %" PRIu64,
+                   blob_file_block_size);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.blob_file_max_dict_bytes     : %" PRIu32,
+                   blob_file_compression_options.max_dict_bytes);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.blob_file_zstd_max_train_bytes: %" PRIu32,
+                   blob_file_compression_options.zstd_max_train_bytes);
   ROCKS_LOG_HEADER(logger, "TitanCFOptions.blob_cache                   : %p",
                    blob_cache.get());
   if (blob_cache != nullptr) {
     ROCKS_LOG_HEADER(logger, "%s", blob_cache->GetPrintableOptions().c_str());
   }
+  ROCKS_LOG_HEADER(logger, "TitanCFOptions.blob_value_cache             : %p",
+                   blob_value_cache.get());
+  if (blob_value_cache != nullptr) {
+    ROCKS_LOG_HEADER(logger, "%s",
+                     blob_value_cache->GetPrintableOptions().c_str());
+  }
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.blob_value_cache_min_frequency: %" PRIu32,
+                   blob_value_cache_min_frequency);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.inline_hot_value_frequency   : %" PRIu32,
+                   inline_hot_value_frequency);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.inline_hot_value_max_size    : %" PRIu64,
+                   inline_hot_value_max_size);
+  ROCKS_LOG_HEADER(logger,
+                   "TitanCFOptions.inline_hot_value_sketch_entries: %" PRIu64,
+                   inline_hot_value_sketch_entries);
   ROCKS_LOG_HEADER(logger,
                    "TitanCFOptions.max_gc_batch_size            : %" PRIu64,
                    max_gc_batch_size);
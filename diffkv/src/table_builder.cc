@@ -9,6 +9,10 @@
 #include <future>
 #include <iostream>
 #include "monitoring/statistics.h"
+#include "port/port.h"
+#include "titan_perf_context_imp.h"
+#include "util/coding.h"
+#include "util/hash.h"
 
 std::atomic<uint64_t> blob_merge_time{0};
 std::atomic<uint64_t> blob_read_time{0};
@@ -24,6 +28,8 @@ namespace rocksdb {
 namespace titandb {
 Env *env_ = Env::Default();
 
+const size_t TitanTableBuilder::kMergeBatchSize;
+
 TitanTableBuilder::~TitanTableBuilder() {
   blob_merge_time += blob_merge_time_;
   blob_read_time += blob_read_time_;
@@ -32,7 +38,6 @@ TitanTableBuilder::~TitanTableBuilder() {
 }
 
 void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
-  TitanStopWatch swadd(env_, blob_add_time_);
   if (!ok()) return;
 
   ParsedInternalKey ikey;
@@ -41,10 +46,32 @@ void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
     return;
   }
 
+  if (ikey.type == kTypeBlobIndex && pass_blob_indexes_) {
+    base_builder_->Add(key, value);
+    if (garbage_meter_) {
+      AddBlobRef(value);
+    }
+    return;
+  }
+
+  TitanStopWatch swadd(env_, blob_add_time_);
+
   uint64_t prev_bytes_read = 0;
   uint64_t prev_bytes_written = 0;
   SavePrevIOBytes(&prev_bytes_read, &prev_bytes_written);
 
+  if (ikey.type != kTypeBlobIndex) {
+    FlushPendingMerges();
+  }
+
+  if (ikey.type == kTypeBlobIndex && hot_key_tracker_ != nullptr &&
+      cf_options_.blob_run_mode == TitanBlobRunMode::kNormal &&
+      InlineHotValue(ikey, value)) {
+    UpdateIOBytes(prev_bytes_read, prev_bytes_written, &io_bytes_read_,
+                  &io_bytes_written_);
+    return;
+  }
+
   if (ikey.type == kTypeBlobIndex &&
       cf_options_.blob_run_mode == TitanBlobRunMode::kFallback) {
     // std::cerr<<"fall back"<<std::endl;
@@ -62,6 +89,8 @@ void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
     auto storage = blob_storage_.lock();
     assert(storage != nullptr);
     ReadOptions options;  // dummy option
+    // Values read by compaction shouldn't pollute the blob value cache.
+    options.fill_cache = false;
     Status get_status = storage->Get(options, index, &record, &buffer);
     UpdateIOBytes(prev_bytes_read, prev_bytes_written, &io_bytes_read_,
                   &io_bytes_written_);
@@ -77,10 +106,12 @@ void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
       // output.
       // TODO: return error if it is indeed an error.
       base_builder_->Add(key, value);
+      AddBlobRef(index);
     }
   } else if (ikey.type == kTypeValue &&
              value.size() >= cf_options_.min_blob_size &&
-             cf_options_.blob_run_mode == TitanBlobRunMode::kNormal) {
+             cf_options_.blob_run_mode == TitanBlobRunMode::kNormal &&
+             !KeepHotValue(ikey.user_key, value.size())) {
     // we write to blob file and insert index
     std::string index_value;
     AddBlob(ikey.user_key, value, &index_value);
@@ -108,14 +139,27 @@ void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
     // base_builder_->Add(key, value);
     // return;
     // }
-    auto file_it = encountered_files_.find(index.file_number);
-    if(file_it == encountered_files_.end()){
-      auto storage = blob_storage_.lock();
-      assert(storage != nullptr);
-      auto file = storage->FindFile(index.file_number).lock();
-      file_it = encountered_files_.emplace(index.file_number, std::move(file)).first;
+    if (last_file_ == nullptr || index.file_number != last_file_number_) {
+      auto file_it = encountered_files_.find(index.file_number);
+      if (file_it == encountered_files_.end()) {
+        auto storage = blob_storage_.lock();
+        assert(storage != nullptr);
+        auto file = storage->FindFile(index.file_number).lock();
+        file_it = encountered_files_.emplace(index.file_number, std::move(file))
+                      .first;
+      }
+      last_file_number_ = index.file_number;
+      last_file_ = &file_it->second;
     }
-    if (ShouldMerge(file_it->second)) {
+    if (ShouldMerge(*last_file_) && db_options_.blob_read_queue_depth > 0) {
+      pending_merges_.push_back({key.ToString(), value.ToString(), index});
+      if (pending_merges_.size() >= kMergeBatchSize) {
+        FlushPendingMerges();
+      }
+      return;
+    }
+    FlushPendingMerges();
+    if (ShouldMerge(*last_file_)) {
       auto it = merging_files_.find(index.file_number);
       if (it == merging_files_.end()) {
         std::unique_ptr<BlobFilePrefetcher> prefetcher;
@@ -125,11 +169,13 @@ void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
           std::cerr << "create prefetcher error!" << status_.ToString()
                     << std::endl;
           base_builder_->Add(key, value);
+          AddBlobRef(index);
           return;
         }
         it = merging_files_.emplace(index.file_number, std::move(prefetcher))
                  .first;
       }
+      io_charger_.Charge(index.blob_handle.size);
       BlobRecord record;
       PinnableSlice buffer;
       Status s;
@@ -137,27 +183,141 @@ void TitanTableBuilder::Add(const Slice &key, const Slice &value) {
         TitanStopWatch sw(env_, blob_read_time_);
         s = it->second->Get(ReadOptions(), index.blob_handle, &record, &buffer);
       }
-      if (s.ok()) {
-        std::string index_value;
-        {
-          TitanStopWatch sw(env_, blob_merge_time_);
-          AddBlob(ikey.user_key, record.value, &index_value);
-        }
-        if (ok()) {
-          std::string index_key;
-          ikey.type = kTypeBlobIndex;
-          AppendInternalKey(&index_key, ikey);
-          base_builder_->Add(index_key, index_value);
-          return;
-        } else {
-          std::cerr << "add blob not ok: " << status_.ToString() << std::endl;
-        }
-      }
+      AddMergedBlob(ikey, key, value, index, s, record.value);
+      return;
     }
     base_builder_->Add(key, value);
+    AddBlobRef(index);
   } else {
     base_builder_->Add(key, value);
+    if (ikey.type == kTypeBlobIndex && garbage_meter_) {
+      AddBlobRef(value);
+    }
+  }
+}
+
+void TitanTableBuilder::AddBlobRef(const Slice &index_value) {
+  Slice copy = index_value;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  if (!ref_prefix_.empty() && copy.starts_with(ref_prefix_)) {
+    copy.remove_prefix(ref_prefix_.size());
+    if (GetVarint64(&copy, &offset) && GetVarint64(&copy, &size)) {
+      ref_bytes_ += size;
+    }
+    return;
+  }
+  // An index that can't be decoded is copied as is and not metered.
+  BlobIndex index;
+  if (!index.DecodeFrom(&copy).ok()) {
+    return;
+  }
+  AddBlobRef(index);
+  ref_prefix_.assign(index_value.data(),
+                     1 + VarintLength(index.file_number));
+}
+
+void TitanTableBuilder::AddMergedBlob(ParsedInternalKey ikey, const Slice &key,
+                                      const Slice &value,
+                                      const BlobIndex &index,
+                                      const Status &read_status,
+                                      const Slice &merged_value) {
+  if (read_status.ok()) {
+    std::string index_value;
+    {
+      TitanStopWatch sw(env_, blob_merge_time_);
+      AddBlob(ikey.user_key, merged_value, &index_value);
+    }
+    if (ok()) {
+      std::string index_key;
+      ikey.type = kTypeBlobIndex;
+      AppendInternalKey(&index_key, ikey);
+      base_builder_->Add(index_key, index_value);
+      return;
+    } else {
+      std::cerr << "add blob not ok: " << status_.ToString() << std::endl;
+    }
   }
+  base_builder_->Add(key, value);
+  AddBlobRef(index);
+}
+
+void TitanTableBuilder::FlushPendingMerges() {
+  if (pending_merges_.empty()) {
+    return;
+  }
+  size_t num = pending_merges_.size();
+  std::vector<BlobIndex> indexes;
+  indexes.reserve(num);
+  uint64_t read_bytes = 0;
+  for (const auto &merge : pending_merges_) {
+    indexes.push_back(merge.index);
+    read_bytes += merge.index.blob_handle.size;
+  }
+  io_charger_.Charge(read_bytes);
+  std::vector<BlobRecord> records(num);
+  std::vector<PinnableSlice> buffers(num);
+  std::vector<Status> statuses(num);
+  auto storage = blob_storage_.lock();
+  if (storage != nullptr) {
+    ReadOptions options;
+    // Values read by compaction shouldn't pollute the blob value cache.
+    options.fill_cache = false;
+    TitanStopWatch sw(env_, blob_read_time_);
+    storage->MultiGet(options, num, indexes.data(), records.data(),
+                      buffers.data(), statuses.data());
+  } else {
+    std::fill(statuses.begin(), statuses.end(),
+              Status::Aborted("Blob storage is gone"));
+  }
+  for (size_t i = 0; i < num; i++) {
+    const auto &merge = pending_merges_[i];
+    ParsedInternalKey ikey;
+    ParseInternalKey(merge.key, &ikey);
+    AddMergedBlob(ikey, merge.key, merge.value, merge.index, statuses[i],
+                  records[i].value);
+  }
+  pending_merges_.clear();
+}
+
+bool TitanTableBuilder::InlineHotValue(ParsedInternalKey ikey,
+                                       const Slice &value) {
+  BlobIndex index;
+  Slice copy = value;
+  if (!index.DecodeFrom(&copy).ok() ||
+      !hot_key_tracker_->ShouldInline(ikey.user_key, index.blob_handle.size)) {
+    return false;
+  }
+  auto storage = blob_storage_.lock();
+  if (storage == nullptr) {
+    return false;
+  }
+  io_charger_.Charge(index.blob_handle.size);
+  ReadOptions options;
+  options.fill_cache = false;
+  BlobRecord record;
+  PinnableSlice buffer;
+  if (!storage->Get(options, index, &record, &buffer).ok()) {
+    return false;
+  }
+  FlushPendingMerges();
+  ikey.type = kTypeValue;
+  std::string value_key;
+  AppendInternalKey(&value_key, ikey);
+  base_builder_->Add(value_key, record.value);
+  bytes_read_ += record.size();
+  RecordTick(stats_, TitanStats::BLOB_HOT_VALUE_INLINED);
+  return true;
+}
+
+bool TitanTableBuilder::KeepHotValue(const Slice &user_key,
+                                     uint64_t value_size) {
+  if (hot_key_tracker_ == nullptr ||
+      !hot_key_tracker_->ShouldInline(user_key, value_size)) {
+    return false;
+  }
+  RecordTick(stats_, TitanStats::BLOB_HOT_VALUE_KEPT);
+  return true;
 }
 
 void TitanTableBuilder::AddBlob(const Slice &key, const Slice &value,
@@ -166,7 +326,9 @@ void TitanTableBuilder::AddBlob(const Slice &key, const Slice &value,
   StopWatch write_sw(db_options_.env, stats_, BLOB_DB_BLOB_FILE_WRITE_MICROS);
 
   if (!blob_builder_) {
-    status_ = blob_manager_->NewFile(&blob_handle_);
+    status_ = blob_manager_->NewFile(
+        &blob_handle_,
+        BlobFileEnvOptions(EnvOptions(db_options_), cf_options_));
     if (!ok()) return;
     ROCKS_LOG_INFO(db_options_.info_log,
                    "Titan table builder created new blob file %" PRIu64 ".",
@@ -187,12 +349,14 @@ void TitanTableBuilder::AddBlob(const Slice &key, const Slice &value,
   if (cf_options_.level_merge) record.only_value = true;
   record.key = key;
   record.value = value;
+  io_charger_.Charge(record.size());
   blob_builder_->Add(record, &index.blob_handle);
   // RecordTick(stats_, BLOB_DB_BLOB_FILE_BYTES_WRITTEN,
   // index.blob_handle.size);
   bytes_written_ += record.size();
   if (ok()) {
     index.EncodeTo(index_value);
+    AddBlobRef(index);
     if (blob_handle_->GetFile()->GetFileSize() >=
         cf_options_.blob_file_target_size) {
       FinishBlobFile();
@@ -238,6 +402,8 @@ Status TitanTableBuilder::status() const {
 }
 
 Status TitanTableBuilder::Finish() {
+  FlushPendingMerges();
+  io_charger_.Flush();
   base_builder_->Finish();
   FinishBlobFile();
   status_ = blob_manager_->BatchFinishFiles(cf_id_, finished_blobs_);
@@ -247,10 +413,16 @@ Status TitanTableBuilder::Finish() {
                     status_.ToString().c_str());
   }
   UpdateInternalOpStats();
-  return status();
+  FlushBlobRef();
+  Status s = status();
+  if (s.ok() && garbage_meter_ && sst_number_ != 0 && !blob_refs_.empty()) {
+    garbage_meter_->AddTable(sst_number_, std::move(blob_refs_));
+  }
+  return s;
 }
 
 void TitanTableBuilder::Abandon() {
+  pending_merges_.clear();
   base_builder_->Abandon();
   if (blob_builder_) {
     ROCKS_LOG_INFO(db_options_.info_log,
@@ -299,7 +471,7 @@ void TitanTableBuilder::UpdateInternalOpStats() {
     return;
   }
   InternalOpType op_type = InternalOpType::COMPACTION;
-  if (target_level_ == 0) {
+  if (io_source_ == BlobIOSource::kFlush) {
     op_type = InternalOpType::FLUSH;
   }
   InternalOpStats *internal_op_stats =
@@ -320,11 +492,16 @@ void TitanTableBuilder::UpdateInternalOpStats() {
 
 Status ForegroundBuilder::Add(const Slice &key, const Slice &value,
                               WriteBatch *wb) {
-  if (value.size() < cf_options_.min_blob_size ||
-      (cf_options_.level_merge && value.size() < cf_options_.mid_blob_size)) {
+  if (value.size() < blob_sizes_->min_blob_size.load() ||
+      (cf_options_.level_merge &&
+       value.size() < blob_sizes_->mid_blob_size.load())) {
     return Status::InvalidArgument();
   }
-  int b = num_builders_ > 1 ? hash(key.ToString()) % num_builders_ : 0;
+  int b = LocalNode() * num_partitions_;
+  if (num_partitions_ > 1) {
+    b += static_cast<int>(GetSliceNPHash64(key) % num_partitions_);
+  }
+  TITAN_PERF_TIMER_GUARD(foreground_builder_wait_nanos);
   auto req = Request(key, value, wb);
   auto fut = req.res.get_future();
   // std::cerr<<"put"<<std::endl;
@@ -333,7 +510,24 @@ Status ForegroundBuilder::Add(const Slice &key, const Slice &value,
   return fut.get();
 }
 
+int ForegroundBuilder::LocalNode() const {
+  if (node_cpus_.size() == 1) {
+    return 0;
+  }
+  int cpu = port::PhysicalCoreID();
+  return cpu >= 0 && static_cast<size_t>(cpu) < cpu_nodes_.size()
+             ? cpu_nodes_[cpu]
+             : 0;
+}
+
 void ForegroundBuilder::handleRequest(int b) {
+  const auto &cpus = node_cpus_[b / num_partitions_];
+  if (!cpus.empty() && !PinCurrentThread(cpus)) {
+    ROCKS_LOG_WARN(db_options_.info_log,
+                   "Foreground builder %d of column family %" PRIu32
+                   " can't be pinned to NUMA node %d.",
+                   b, cf_id_, b / num_partitions_);
+  }
   // std::cerr<<"req"<<std::endl;
   while (true) {
     // std::cerr<<"get"<<std::endl;
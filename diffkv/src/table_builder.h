@@ -3,6 +3,9 @@
 #include "blob_file_builder.h"
 #include "blob_file_manager.h"
 #include "blob_file_set.h"
+#include "blob_garbage_meter.h"
+#include "blob_io_scheduler.h"
+#include "hot_key_tracker.h"
 #include "future"
 #include "iostream"
 #include "table/table_builder.h"
@@ -22,7 +25,11 @@ class TitanTableBuilder : public TableBuilder {
                     std::unique_ptr<TableBuilder> base_builder,
                     std::shared_ptr<BlobFileManager> blob_manager,
                     std::weak_ptr<BlobStorage> blob_storage, TitanStats *stats,
-                    int merge_level, int target_level, int start_level = -1)
+                    int merge_level, int target_level, int start_level = -1,
+                    std::shared_ptr<BlobGarbageMeter> garbage_meter = nullptr,
+                    uint64_t sst_number = 0,
+                    std::shared_ptr<HotKeyTracker> hot_key_tracker = nullptr,
+                    BlobIOSource io_source = BlobIOSource::kCompaction)
       : cf_id_(cf_id),
         db_options_(db_options),
         cf_options_(cf_options),
@@ -32,8 +39,20 @@ class TitanTableBuilder : public TableBuilder {
         stats_(stats),
         target_level_(target_level),
         merge_level_(merge_level),
-        start_level_(start_level) {
+        start_level_(start_level),
+        garbage_meter_(garbage_meter),
+        sst_number_(sst_number),
+        hot_key_tracker_(hot_key_tracker),
+        io_source_(io_source),
+        io_charger_(GetBlobIOScheduler(db_options, cf_options), io_source,
+                    stats) {
           merge_low_level_ = blob_storage_.lock()->ShouldGCLowLevel();
+          bool may_merge = cf_options_.level_merge &&
+                           (target_level_ >= merge_level_ || merge_low_level_);
+          pass_blob_indexes_ =
+              cf_options_.blob_run_mode == TitanBlobRunMode::kReadOnly ||
+              (cf_options_.blob_run_mode == TitanBlobRunMode::kNormal &&
+               hot_key_tracker_ == nullptr && !may_merge);
           // std::cerr<<"start level: "<<start_level_<<"merge level: "<<merge_level_<<"target level: "<<target_level_<<"merge_low_level: "<<merge_level_<<".\n";
         }
 
@@ -60,8 +79,50 @@ class TitanTableBuilder : public TableBuilder {
 
   void AddBlob(const Slice &key, const Slice &value, std::string *index_value);
 
+  // Counts a blob index written to the base table. Consecutive indexes
+  // mostly point to the same file, so their sizes are summed until the
+  // file changes and only then added to blob_refs_.
+  void AddBlobRef(const BlobIndex &index) {
+    if (index.file_number != ref_file_number_) {
+      FlushBlobRef();
+      ref_file_number_ = index.file_number;
+      ref_prefix_.clear();
+    }
+    ref_bytes_ += index.blob_handle.size;
+  }
+
+  // Counts a blob index copied as is from its encoding. An index whose
+  // type and file number bytes match the current run only has its size
+  // parsed; the others are decoded in full and start a new run.
+  void AddBlobRef(const Slice &index_value);
+
+  void FlushBlobRef() {
+    if (ref_bytes_ > 0) {
+      blob_refs_[ref_file_number_] += ref_bytes_;
+      ref_bytes_ = 0;
+    }
+  }
+
   bool ShouldMerge(const std::shared_ptr<BlobFileMeta> &file);
 
+  // Writes the value read for a merged blob index into the new blob file,
+  // or the blob index as is if the value couldn't be read.
+  void AddMergedBlob(ParsedInternalKey ikey, const Slice &key,
+                     const Slice &value, const BlobIndex &index,
+                     const Status &read_status, const Slice &merged_value);
+
+  // Reads the values of the pending merges in one batch and adds them.
+  void FlushPendingMerges();
+
+  // Writes the value of a read-hot key back into the base table instead
+  // of its blob index. Returns false if the key isn't hot or the value
+  // can't be read, leaving the blob index to the caller.
+  bool InlineHotValue(ParsedInternalKey ikey, const Slice &value);
+
+  // Returns true if an inline value is kept in the base table because its
+  // key is still hot.
+  bool KeepHotValue(const Slice &user_key, uint64_t value_size);
+
   void FinishBlobFile();
 
   void UpdateInternalOpStats();
@@ -84,6 +145,19 @@ class TitanTableBuilder : public TableBuilder {
   std::unordered_map<uint64_t, std::unique_ptr<BlobFilePrefetcher>>
       merging_files_;
   std::unordered_map<uint64_t, std::shared_ptr<BlobFileMeta>> encountered_files_;
+  // Entry of encountered_files_ of the previous blob index.
+  uint64_t last_file_number_{0};
+  std::shared_ptr<BlobFileMeta> *last_file_{nullptr};
+  // With blob_read_queue_depth, values to merge are read kMergeBatchSize at
+  // a time. Entries are held here until then, and flushed before any other
+  // entry is added to keep the base table in order.
+  struct PendingMerge {
+    std::string key;
+    std::string value;
+    BlobIndex index;
+  };
+  static const size_t kMergeBatchSize = 32;
+  std::vector<PendingMerge> pending_merges_;
   bool merge_low_level_;
   uint64_t blob_merge_time_{0};
   uint64_t blob_read_time_{0};
@@ -98,6 +172,26 @@ class TitanTableBuilder : public TableBuilder {
   int merge_level_;
   int start_level_;
 
+  // Receives the blob references of the base table when it's finished.
+  std::shared_ptr<BlobGarbageMeter> garbage_meter_;
+  uint64_t sst_number_;
+  BlobFileSizes blob_refs_;
+  uint64_t ref_file_number_{0};
+  uint64_t ref_bytes_{0};
+  // Encoded type and file number of the indexes of the current run.
+  std::string ref_prefix_;
+
+  // If true, no value of this compaction is merged or inlined, and blob
+  // indexes are copied to the base table without being looked at beyond
+  // their size.
+  bool pass_blob_indexes_{false};
+
+  std::shared_ptr<HotKeyTracker> hot_key_tracker_;
+  // The job building the table, flush or compaction.
+  BlobIOSource io_source_;
+  // Charges the blob reads and writes of the job.
+  BlobIOCharger io_charger_;
+
   // counters
   uint64_t bytes_read_ = 0;
   uint64_t bytes_written_ = 0;
@@ -123,6 +217,13 @@ class ForegroundBuilder {
 
   Status Add(const Slice &key, const Slice &value, WriteBatch *wb);
 
+  // Moves the separation thresholds, which may happen while values are
+  // being added.
+  void SetBlobSizes(uint64_t min_blob_size, uint64_t mid_blob_size) {
+    blob_sizes_->min_blob_size.store(min_blob_size);
+    blob_sizes_->mid_blob_size.store(mid_blob_size);
+  }
+
   void Finish();
 
   void Flush();
@@ -136,30 +237,60 @@ class ForegroundBuilder {
     }
   }
 
+  // Builders are numbered node by node: builder `node * num_partitions_ +
+  // partition` separates the values of its key partition written from the
+  // node. Without numa_aware_foreground_builders there is a single node
+  // whose threads aren't pinned.
   ForegroundBuilder(uint32_t cf_id,
                     std::shared_ptr<BlobFileManager> blob_file_manager,
                     std::weak_ptr<BlobStorage> blob_storage,
                     const TitanDBOptions &db_options,
                     const TitanCFOptions &cf_options,
                     TitanStats *stats)
-      : num_builders_(db_options.num_foreground_builders),
+      : node_cpus_(db_options.numa_aware_foreground_builders
+                       ? GetNumaNodeCpus(db_options.env)
+                       : std::vector<std::vector<int>>(1)),
+        num_partitions_(std::max(1, db_options.num_foreground_builders)),
+        num_builders_(num_partitions_ * static_cast<int>(node_cpus_.size())),
         cf_id_(cf_id),
         blob_file_manager_(blob_file_manager),
         blob_storage_(blob_storage),
         db_options_(db_options),
         cf_options_(cf_options),
         env_options_(db_options_),
-        handle_(db_options.num_foreground_builders),
-        builder_(db_options.num_foreground_builders),
-        finished_files_(db_options.num_foreground_builders),
-        requests_(db_options.num_foreground_builders),
+        handle_(num_builders_),
+        builder_(num_builders_),
+        finished_files_(num_builders_),
+        requests_(num_builders_),
+        blob_sizes_(std::make_shared<BlobSizes>()),
         stats_(stats) {
-    env_options_.writable_file_max_buffer_size = 4*1024;
+    for (size_t node = 0; node < node_cpus_.size(); node++) {
+      for (int cpu : node_cpus_[node]) {
+        if (static_cast<size_t>(cpu) >= cpu_nodes_.size()) {
+          cpu_nodes_.resize(cpu + 1, 0);
+        }
+        cpu_nodes_[cpu] = static_cast<int>(node);
+      }
+    }
+    SetBlobSizes(cf_options.min_blob_size, cf_options.mid_blob_size);
+    // Unsorted blob files are read while being built, so keep the write
+    // buffer small and the writes buffered by default.
+    env_options_.writable_file_max_buffer_size =
+        cf_options.blob_file_write_buffer_size > 0
+            ? static_cast<size_t>(cf_options.blob_file_write_buffer_size)
+            : 4 * 1024;
+    // They are also read at the file offsets of their blob handles, which
+    // only version 1 files provide.
+    cf_options_.blob_file_format_version = BlobFileHeader::kVersion1;
   }
 
   ForegroundBuilder() = default;
 
  private:
+  // The CPUs of every NUMA node, and the node of every CPU.
+  std::vector<std::vector<int>> node_cpus_;
+  std::vector<int> cpu_nodes_;
+  int num_partitions_;
   int num_builders_;
   uint32_t cf_id_;
   std::shared_ptr<BlobFileManager> blob_file_manager_;
@@ -172,13 +303,26 @@ class ForegroundBuilder {
   std::vector<std::vector<std::pair<std::shared_ptr<BlobFileMeta>,
                                     std::unique_ptr<BlobFileHandle>>>>
       finished_files_;
-  std::hash<std::string> hash{};
-  std::vector<BlockQueue<Request *>> requests_;
+  // Padded so that the queues of builders on different nodes don't share
+  // cache lines.
+  struct RequestQueue : BlockQueue<Request *> {
+    char padding[CACHE_LINE_SIZE];
+  };
+  std::vector<RequestQueue> requests_;
   std::vector<std::thread> pool_{};
+  // Held by pointer to keep the builder movable.
+  struct BlobSizes {
+    std::atomic<uint64_t> min_blob_size{0};
+    std::atomic<uint64_t> mid_blob_size{0};
+  };
+  std::shared_ptr<BlobSizes> blob_sizes_;
   TitanStats *stats_;
 
   void handleRequest(int i);
 
+  // Returns the NUMA node the calling thread runs on.
+  int LocalNode() const;
+
   Status FinishBlob(int b);
 };
 
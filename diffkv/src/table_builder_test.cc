@@ -6,6 +6,7 @@
 #include "blob_file_manager.h"
 #include "blob_file_reader.h"
 #include "blob_file_set.h"
+#include "blob_io_scheduler.h"
 #include "table_builder.h"
 #include "table_factory.h"
 
@@ -181,16 +182,124 @@ class TableBuilderTest : public testing::Test {
 
   void NewTableBuilder(WritableFileWriter* file,
                        std::unique_ptr<TableBuilder>* result,
-                       int target_level = 0) {
+                       int target_level = 0,
+                       TableFileCreationReason reason =
+                           TableFileCreationReason::kFlush) {
     CompressionOptions compression_opts;
     TableBuilderOptions options(cf_ioptions_, cf_moptions_,
                                 cf_ioptions_.internal_comparator, &collectors_,
                                 kNoCompression, 0 /*sample_for_compression*/,
                                 compression_opts, false /*skip_filters*/,
-                                kDefaultColumnFamilyName, target_level);
+                                kDefaultColumnFamilyName, target_level,
+                                0 /*creation_time*/, 0 /*oldest_key_time*/,
+                                0 /*target_file_size*/,
+                                0 /*file_creation_time*/, -1 /*start_level*/,
+                                reason);
     result->reset(table_factory_->NewTableBuilder(options, 0, file));
   }
 
+  // Compacts a level 0 SST to the last level, which merges its values to
+  // new blob files, read one by one or in batches of
+  // "blob_read_queue_depth".
+  void TestLevelMerge(uint32_t blob_read_queue_depth) {
+    cf_options_.level_merge = true;
+    db_options_.blob_read_queue_depth = blob_read_queue_depth;
+    // The blob storage reads the records of sorted files by the options
+    // it's created with.
+    blob_file_set_.reset(new BlobFileSet(db_options_, nullptr));
+    std::map<uint32_t, TitanCFOptions> cfs{{0, cf_options_}};
+    blob_file_set_->AddColumnFamilies(cfs);
+    blob_manager_.reset(new FileManager(db_options_, blob_file_set_.get()));
+    table_factory_.reset(new TitanTableFactory(db_options_, cf_options_,
+                                               blob_manager_, &mutex_,
+                                               blob_file_set_.get(), nullptr));
+    std::unique_ptr<WritableFileWriter> base_file;
+    NewBaseFileWriter(&base_file);
+    std::unique_ptr<TableBuilder> table_builder;
+    NewTableBuilder(base_file.get(), &table_builder, 0 /* target_level */);
+
+    // Generate a level 0 sst with blob file
+    const int n = 255;
+    for (unsigned char i = 0; i < n; i++) {
+      std::string key(1, i);
+      InternalKey ikey(key, 1, kTypeValue);
+      std::string value(kMinBlobSize, i);
+      table_builder->Add(ikey.Encode(), value);
+    }
+    ASSERT_OK(table_builder->Finish());
+    ASSERT_OK(base_file->Sync(true));
+    ASSERT_OK(base_file->Close());
+
+    std::unique_ptr<TableReader> base_reader;
+    NewTableReader(base_name_, &base_reader);
+    ReadOptions ro;
+    std::unique_ptr<InternalIterator> first_iter;
+    first_iter.reset(base_reader->NewIterator(
+        ro, nullptr /*prefix_extractor*/, nullptr /*arena*/,
+        false /*skip_filters*/, TableReaderCaller::kUncategorized));
+
+    // Base file of last level sst
+    std::string second_base_name = base_name_ + "second";
+    NewFileWriter(second_base_name, &base_file);
+    NewTableBuilder(base_file.get(), &table_builder, cf_options_.num_levels - 1);
+
+    first_iter->SeekToFirst();
+    // Compact level0 sst to last level, values will be merge to another blob file
+    for (unsigned char i = 0; i < n; i++) {
+      ASSERT_TRUE(first_iter->Valid());
+      table_builder->Add(first_iter->key(), first_iter->value());
+      first_iter->Next();
+    }
+    ASSERT_OK(table_builder->Finish());
+    ASSERT_OK(base_file->Sync(true));
+    ASSERT_OK(base_file->Close());
+
+    std::unique_ptr<TableReader> second_base_reader;
+    NewTableReader(second_base_name, &second_base_reader);
+    std::unique_ptr<InternalIterator> second_iter;
+    second_iter.reset(second_base_reader->NewIterator(
+        ro, nullptr /*prefix_extractor*/, nullptr /*arena*/,
+        false /*skip_filters*/, TableReaderCaller::kUncategorized));
+
+    // Compare key, index and blob records after level merge
+    first_iter->SeekToFirst();
+    second_iter->SeekToFirst();
+    auto storage = blob_file_set_->GetBlobStorage(0).lock();
+    for (unsigned char i = 0; i < n; i++) {
+      ASSERT_TRUE(first_iter->Valid());
+      ASSERT_TRUE(second_iter->Valid());
+
+      // Compare sst key
+      ParsedInternalKey first_ikey, second_ikey;
+      ASSERT_TRUE(ParseInternalKey(first_iter->key(), &first_ikey));
+      ASSERT_TRUE(ParseInternalKey(second_iter->key(), &second_ikey));
+      ASSERT_EQ(first_ikey.type, kTypeBlobIndex);
+      ASSERT_EQ(second_ikey.type, kTypeBlobIndex);
+      ASSERT_EQ(first_ikey.user_key, second_ikey.user_key);
+
+      // Compare blob records
+      Slice first_value = first_iter->value();
+      Slice second_value = second_iter->value();
+      BlobIndex first_index, second_index;
+      BlobRecord first_record, second_record;
+      PinnableSlice first_buffer, second_buffer;
+      ASSERT_OK(first_index.DecodeFrom(&first_value));
+      ASSERT_OK(second_index.DecodeFrom(&second_value));
+      ASSERT_FALSE(first_index == second_index);
+      ASSERT_OK(
+          storage->Get(ReadOptions(), first_index, &first_record, &first_buffer));
+      ASSERT_OK(storage->Get(ReadOptions(), second_index, &second_record,
+                             &second_buffer));
+      ASSERT_EQ(first_record.key, second_record.key);
+      ASSERT_EQ(first_record.value, second_record.value);
+
+      first_iter->Next();
+      second_iter->Next();
+    }
+
+    env_->DeleteFile(second_base_name);
+  }
+
   port::Mutex mutex_;
 
   Env* env_{Env::Default()};
@@ -385,23 +494,34 @@ TEST_F(TableBuilderTest, TargetSize) {
 
 // Compact a level 0 file to last level, to test level merge is functional and
 // correct
-TEST_F(TableBuilderTest, LevelMerge) {
-  cf_options_.level_merge = true;
-  table_factory_.reset(new TitanTableFactory(db_options_, cf_options_,
-                                             blob_manager_, &mutex_,
-                                             blob_file_set_.get(), nullptr));
+TEST_F(TableBuilderTest, LevelMerge) { TestLevelMerge(0); }
+
+TEST_F(TableBuilderTest, LevelMergeBatched) { TestLevelMerge(4); }
+
+TEST_F(TableBuilderTest, InlineHotValues) {
+  cf_options_.inline_hot_value_frequency = 2;
+  auto hot_key_tracker = std::make_shared<HotKeyTracker>(cf_options_);
+  table_factory_.reset(new TitanTableFactory(
+      db_options_, cf_options_, blob_manager_, &mutex_, blob_file_set_.get(),
+      nullptr, nullptr /*garbage_meter*/, hot_key_tracker));
+
+  // Even keys are read often enough to be hot.
+  const int n = 100;
+  for (char i = 0; i < n; i += 2) {
+    std::string key(1, i);
+    hot_key_tracker->RecordRead(key);
+    hot_key_tracker->RecordRead(key);
+  }
+
+  // Flush keeps the values of hot keys in the SST.
   std::unique_ptr<WritableFileWriter> base_file;
   NewBaseFileWriter(&base_file);
   std::unique_ptr<TableBuilder> table_builder;
-  NewTableBuilder(base_file.get(), &table_builder, 0 /* target_level */);
-
-  // Generate a level 0 sst with blob file
-  const int n = 255;
-  for (unsigned char i = 0; i < n; i++) {
+  NewTableBuilder(base_file.get(), &table_builder);
+  for (char i = 0; i < n; i++) {
     std::string key(1, i);
     InternalKey ikey(key, 1, kTypeValue);
-    std::string value(kMinBlobSize, i);
-    table_builder->Add(ikey.Encode(), value);
+    table_builder->Add(ikey.Encode(), std::string(kMinBlobSize, i));
   }
   ASSERT_OK(table_builder->Finish());
   ASSERT_OK(base_file->Sync(true));
@@ -414,20 +534,42 @@ TEST_F(TableBuilderTest, LevelMerge) {
   first_iter.reset(base_reader->NewIterator(
       ro, nullptr /*prefix_extractor*/, nullptr /*arena*/,
       false /*skip_filters*/, TableReaderCaller::kUncategorized));
+  first_iter->SeekToFirst();
+  for (char i = 0; i < n; i++) {
+    ASSERT_TRUE(first_iter->Valid());
+    ParsedInternalKey ikey;
+    ASSERT_TRUE(ParseInternalKey(first_iter->key(), &ikey));
+    ASSERT_EQ(ikey.type, i % 2 == 0 ? kTypeValue : kTypeBlobIndex);
+    first_iter->Next();
+  }
 
-  // Base file of last level sst
+  // Odd keys get hot and even keys cool down, so compaction swaps them.
+  // The values it reads back into the SST are charged to it as well as
+  // the ones it writes out.
+  auto io_scheduler = NewBlobIOScheduler(1ull << 40, 0, env_);
+  cf_options_.blob_io_scheduler = io_scheduler;
+  hot_key_tracker = std::make_shared<HotKeyTracker>(cf_options_);
+  for (char i = 1; i < n; i += 2) {
+    std::string key(1, i);
+    hot_key_tracker->RecordRead(key);
+    hot_key_tracker->RecordRead(key);
+  }
+  table_factory_.reset(new TitanTableFactory(
+      db_options_, cf_options_, blob_manager_, &mutex_, blob_file_set_.get(),
+      nullptr, nullptr /*garbage_meter*/, hot_key_tracker));
   std::string second_base_name = base_name_ + "second";
   NewFileWriter(second_base_name, &base_file);
-  NewTableBuilder(base_file.get(), &table_builder, cf_options_.num_levels - 1);
-
+  NewTableBuilder(base_file.get(), &table_builder, 1 /* target_level */,
+                  TableFileCreationReason::kCompaction);
   first_iter->SeekToFirst();
-  // Compact level0 sst to last level, values will be merge to another blob file
-  for (unsigned char i = 0; i < n; i++) {
+  for (char i = 0; i < n; i++) {
     ASSERT_TRUE(first_iter->Valid());
     table_builder->Add(first_iter->key(), first_iter->value());
     first_iter->Next();
   }
   ASSERT_OK(table_builder->Finish());
+  ASSERT_GE(io_scheduler->GetTotalBytes(BlobIOSource::kCompaction),
+            n * kMinBlobSize);
   ASSERT_OK(base_file->Sync(true));
   ASSERT_OK(base_file->Close());
 
@@ -437,46 +579,90 @@ TEST_F(TableBuilderTest, LevelMerge) {
   second_iter.reset(second_base_reader->NewIterator(
       ro, nullptr /*prefix_extractor*/, nullptr /*arena*/,
       false /*skip_filters*/, TableReaderCaller::kUncategorized));
-
-  // Compare key, index and blob records after level merge
-  first_iter->SeekToFirst();
   second_iter->SeekToFirst();
   auto storage = blob_file_set_->GetBlobStorage(0).lock();
-  for (unsigned char i = 0; i < n; i++) {
-    ASSERT_TRUE(first_iter->Valid());
+  for (char i = 0; i < n; i++) {
     ASSERT_TRUE(second_iter->Valid());
-
-    // Compare sst key
-    ParsedInternalKey first_ikey, second_ikey;
-    ASSERT_TRUE(ParseInternalKey(first_iter->key(), &first_ikey));
-    ASSERT_TRUE(ParseInternalKey(first_iter->key(), &second_ikey));
-    ASSERT_EQ(first_ikey.type, kTypeBlobIndex);
-    ASSERT_EQ(second_ikey.type, kTypeBlobIndex);
-    ASSERT_EQ(first_ikey.user_key, second_ikey.user_key);
-
-    // Compare blob records
-    Slice first_value = first_iter->value();
-    Slice second_value = second_iter->value();
-    BlobIndex first_index, second_index;
-    BlobRecord first_record, second_record;
-    PinnableSlice first_buffer, second_buffer;
-    ASSERT_OK(first_index.DecodeFrom(&first_value));
-    ASSERT_OK(second_index.DecodeFrom(&second_value));
-    ASSERT_FALSE(first_index == second_index);
-    ASSERT_OK(
-        storage->Get(ReadOptions(), first_index, &first_record, &first_buffer));
-    ASSERT_OK(storage->Get(ReadOptions(), second_index, &second_record,
-                           &second_buffer));
-    ASSERT_EQ(first_record.key, second_record.key);
-    ASSERT_EQ(first_record.value, second_record.value);
-
-    first_iter->Next();
+    ParsedInternalKey ikey;
+    ASSERT_TRUE(ParseInternalKey(second_iter->key(), &ikey));
+    ASSERT_EQ(ikey.user_key, std::string(1, i));
+    if (i % 2 == 1) {
+      ASSERT_EQ(ikey.type, kTypeValue);
+      ASSERT_EQ(second_iter->value(), std::string(kMinBlobSize, i));
+    } else {
+      ASSERT_EQ(ikey.type, kTypeBlobIndex);
+      Slice value = second_iter->value();
+      BlobIndex index;
+      ASSERT_OK(index.DecodeFrom(&value));
+      BlobRecord record;
+      PinnableSlice buffer;
+      ASSERT_OK(storage->Get(ReadOptions(), index, &record, &buffer));
+      ASSERT_EQ(record.value, std::string(kMinBlobSize, i));
+    }
     second_iter->Next();
   }
 
   env_->DeleteFile(second_base_name);
 }
 
+TEST_F(TableBuilderTest, PassBlobIndexes) {
+  auto garbage_meter = std::make_shared<BlobGarbageMeter>();
+  table_factory_.reset(new TitanTableFactory(db_options_, cf_options_,
+                                             blob_manager_, &mutex_,
+                                             blob_file_set_.get(), nullptr,
+                                             garbage_meter));
+  // Compaction without level merge copies blob indexes as they are and
+  // only counts their sizes per blob file.
+  const uint64_t kSSTNumber = 10;
+  std::string sst_name = TableFileName({{tmpdir_, 0}}, kSSTNumber, 0);
+  std::unique_ptr<WritableFileWriter> base_file;
+  NewFileWriter(sst_name, &base_file);
+  std::unique_ptr<TableBuilder> table_builder;
+  NewTableBuilder(base_file.get(), &table_builder, 1 /* target_level */);
+  const uint64_t file_numbers[] = {1, 1, 2, 2, 2, 1, 3, 300, 300};
+  const int n = sizeof(file_numbers) / sizeof(file_numbers[0]);
+  std::vector<std::string> index_values;
+  for (int i = 0; i < n; i++) {
+    BlobIndex index;
+    index.file_number = file_numbers[i];
+    index.blob_handle.offset = i * 1000;
+    index.blob_handle.size = 100 + i;
+    std::string index_value;
+    index.EncodeTo(&index_value);
+    index_values.push_back(index_value);
+    InternalKey ikey(std::string(1, 'a' + i), 1, kTypeBlobIndex);
+    table_builder->Add(ikey.Encode(), index_value);
+  }
+  ASSERT_OK(table_builder->Finish());
+  ASSERT_OK(base_file->Sync(true));
+  ASSERT_OK(base_file->Close());
+
+  BlobFileSizes refs;
+  ASSERT_TRUE(garbage_meter->GetTable(kSSTNumber, &refs));
+  ASSERT_EQ(refs, (BlobFileSizes{{1, 100 + 101 + 105},
+                                 {2, 102 + 103 + 104},
+                                 {3, 106},
+                                 {300, 107 + 108}}));
+
+  std::unique_ptr<TableReader> base_reader;
+  NewTableReader(sst_name, &base_reader);
+  std::unique_ptr<InternalIterator> iter(base_reader->NewIterator(
+      ReadOptions(), nullptr /*prefix_extractor*/, nullptr /*arena*/,
+      false /*skip_filters*/, TableReaderCaller::kUncategorized));
+  iter->SeekToFirst();
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(iter->Valid());
+    ParsedInternalKey ikey;
+    ASSERT_TRUE(ParseInternalKey(iter->key(), &ikey));
+    ASSERT_EQ(ikey.type, kTypeBlobIndex);
+    ASSERT_EQ(iter->value(), index_values[i]);
+    iter->Next();
+  }
+  ASSERT_FALSE(iter->Valid());
+
+  env_->DeleteFile(sst_name);
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
 
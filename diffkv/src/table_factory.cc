@@ -1,10 +1,32 @@
 #include "table_factory.h"
 
+#include "file/filename.h"
 #include "table_builder.h"
 
 namespace rocksdb {
 namespace titandb {
 
+namespace {
+
+// Returns the number of the SST written to "file", or 0 if it's not an SST
+// of the DB, e.g. in tests.
+uint64_t GetSSTNumber(WritableFileWriter* file) {
+  if (file == nullptr) {
+    return 0;
+  }
+  std::string fname = file->file_name();
+  uint64_t number = 0;
+  FileType type;
+  if (!ParseFileName(fname.substr(fname.find_last_of('/') + 1), &number,
+                     &type) ||
+      type != kTableFile) {
+    return 0;
+  }
+  return number;
+}
+
+}  // namespace
+
 Status TitanTableFactory::NewTableReader(
     const TableReaderOptions& options,
     std::unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
@@ -22,6 +44,8 @@ TableBuilder* TitanTableFactory::NewTableBuilder(
       base_factory_->NewTableBuilder(options, column_family_id, file));
   TitanCFOptions cf_options = cf_options_;
   cf_options.blob_run_mode = blob_run_mode_.load();
+  cf_options.min_blob_size = min_blob_size_.load();
+  cf_options.mid_blob_size = mid_blob_size_.load();
   std::weak_ptr<BlobStorage> blob_storage;
 
   // since we force use dynamic_level_bytes=true when level_merge=true, the last
@@ -39,11 +63,14 @@ TableBuilder* TitanTableFactory::NewTableBuilder(
   }
 
   //way to add lazy merge
-  return new TitanTableBuilder(column_family_id, db_options_, cf_options,
-                                std::move(base_builder), blob_manager_,
-                                blob_storage, stats_,
-                                merge_level /* merge level */,
-                                options.level, options.start_level);
+  return new TitanTableBuilder(
+      column_family_id, db_options_, cf_options, std::move(base_builder),
+      blob_manager_, blob_storage, stats_, merge_level /* merge level */,
+      options.level, options.start_level, garbage_meter_, GetSSTNumber(file),
+      hot_key_tracker_,
+      options.reason == TableFileCreationReason::kCompaction
+          ? BlobIOSource::kCompaction
+          : BlobIOSource::kFlush);
   
 }
 
@@ -4,6 +4,8 @@
 
 #include "blob_file_manager.h"
 #include "blob_file_set.h"
+#include "blob_garbage_meter.h"
+#include "hot_key_tracker.h"
 #include "rocksdb/table.h"
 #include "titan/options.h"
 #include "titan_stats.h"
@@ -17,15 +19,21 @@ class TitanTableFactory : public TableFactory {
                     const TitanCFOptions& cf_options,
                     std::shared_ptr<BlobFileManager> blob_manager,
                     port::Mutex* db_mutex, BlobFileSet* blob_file_set,
-                    TitanStats* stats)
+                    TitanStats* stats,
+                    std::shared_ptr<BlobGarbageMeter> garbage_meter = nullptr,
+                    std::shared_ptr<HotKeyTracker> hot_key_tracker = nullptr)
       : db_options_(db_options),
         cf_options_(cf_options),
         blob_run_mode_(cf_options.blob_run_mode),
+        min_blob_size_(cf_options.min_blob_size),
+        mid_blob_size_(cf_options.mid_blob_size),
         base_factory_(cf_options.table_factory),
         blob_manager_(blob_manager),
         db_mutex_(db_mutex),
         blob_file_set_(blob_file_set),
-        stats_(stats) {}
+        stats_(stats),
+        garbage_meter_(garbage_meter),
+        hot_key_tracker_(hot_key_tracker) {}
 
   const char* Name() const override { return "TitanTable"; }
 
@@ -57,6 +65,11 @@ class TitanTableFactory : public TableFactory {
 
   void SetBlobRunMode(TitanBlobRunMode mode) { blob_run_mode_.store(mode); }
 
+  void SetBlobSizes(uint64_t min_blob_size, uint64_t mid_blob_size) {
+    min_blob_size_.store(min_blob_size);
+    mid_blob_size_.store(mid_blob_size);
+  }
+
   bool IsDeleteRangeSupported() const override {
     return base_factory_->IsDeleteRangeSupported();
   }
@@ -65,11 +78,15 @@ class TitanTableFactory : public TableFactory {
   const TitanDBOptions db_options_;
   const TitanCFOptions cf_options_;
   std::atomic<TitanBlobRunMode> blob_run_mode_;
+  std::atomic<uint64_t> min_blob_size_;
+  std::atomic<uint64_t> mid_blob_size_;
   std::shared_ptr<TableFactory> base_factory_;
   std::shared_ptr<BlobFileManager> blob_manager_;
   port::Mutex* db_mutex_;
   BlobFileSet* blob_file_set_;
   TitanStats* stats_;
+  std::shared_ptr<BlobGarbageMeter> garbage_meter_;
+  std::shared_ptr<HotKeyTracker> hot_key_tracker_;
 };
 
 }  // namespace titandb
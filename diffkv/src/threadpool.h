@@ -86,5 +86,5 @@ class ThreadPool {
   // for workers coordination
   std::condition_variable cond;
   // termination sign
-  bool terminated;
+  bool terminated{false};
 };
\ No newline at end of file
@@ -205,7 +205,8 @@ class TitanDBTest : public testing::Test {
     std::unique_ptr<RandomAccessFileReader> readable_file;
     std::string file_name = BlobFileName(options_.dirname, file_number);
     ASSERT_OK(env_->GetFileSize(file_name, &file_size));
-    NewBlobFileReader(file_number, 0, options_, env_opt, env_, &readable_file);
+    NewBlobFileReader(file_number, 0, options_, options_, env_opt, env_,
+                      &readable_file);
     BlobFileIterator iter(std::move(readable_file), file_number, file_size,
                           options_);
     iter.SeekToFirst();
@@ -335,6 +336,89 @@ TEST_F(TitanDBTest, Basic) {
 
 TEST_F(TitanDBTest, TableFactory) { TestTableFactory(); }
 
+TEST_F(TitanDBTest, MultiGet) {
+  options_.blob_read_queue_depth = 4;
+  Open();
+  AddCF("cf");
+  // Values of both sizes, in SSTs and in the memtable.
+  std::map<std::string, std::string> data;
+  for (uint64_t k = 1; k <= 100; k++) {
+    Put(k, &data);
+  }
+  Flush();
+  for (uint64_t k = 101; k <= 150; k++) {
+    Put(k, &data);
+  }
+  ManagedSnapshot snapshot(db_);
+  auto old_data = data;
+  for (uint64_t k = 1; k <= 150; k += 3) {
+    Delete(k);
+    data.erase(GenKey(k));
+  }
+
+  // Keys of both column families, found or not, are read in one call.
+  auto check = [&](const ReadOptions& ropts,
+                   const std::map<std::string, std::string>& expected) {
+    std::vector<ColumnFamilyHandle*> handles;
+    std::vector<std::string> key_strs;
+    for (uint64_t k = 0; k <= 160; k++) {
+      for (auto* handle : {db_->DefaultColumnFamily(), cf_handles_[0]}) {
+        handles.push_back(handle);
+        key_strs.push_back(GenKey(k));
+      }
+    }
+    std::vector<Slice> keys(key_strs.begin(), key_strs.end());
+    std::vector<std::string> values;
+    auto res = db_->MultiGet(ropts, handles, keys, &values);
+    ASSERT_EQ(keys.size(), res.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      auto it = expected.find(key_strs[i]);
+      if (it == expected.end()) {
+        ASSERT_TRUE(res[i].IsNotFound());
+      } else {
+        ASSERT_OK(res[i]);
+        ASSERT_EQ(it->second, values[i]);
+      }
+    }
+  };
+  check(ReadOptions(), data);
+  ReadOptions ropts;
+  ropts.snapshot = snapshot.snapshot();
+  check(ropts, old_data);
+}
+
+TEST_F(TitanDBTest, LevelMergeBatched) {
+  options_.level_merge = true;
+  options_.level_compaction_dynamic_level_bytes = true;
+  options_.blob_read_queue_depth = 4;
+  Open();
+  std::map<std::string, std::string> data;
+  for (int round = 0; round < 3; round++) {
+    for (uint64_t k = 1; k <= 100; k++) {
+      Put(k * 3 + round, &data);
+    }
+    Flush();
+    // Values of level 0 blob files are merged to new files of the last
+    // level, read in batches.
+    CompactAll();
+    VerifyDB(data);
+  }
+  std::map<uint64_t, std::weak_ptr<BlobFileMeta>> blob_files;
+  GetBlobStorage().lock()->ExportBlobFiles(blob_files);
+  int num_last_level_files = 0;
+  for (auto& file : blob_files) {
+    auto meta = file.second.lock();
+    ASSERT_TRUE(meta != nullptr);
+    if (!meta->is_obsolete()) {
+      ASSERT_EQ(options_.num_levels - 1, meta->file_level());
+      num_last_level_files++;
+    }
+  }
+  ASSERT_GT(num_last_level_files, 0);
+  Reopen();
+  VerifyDB(data);
+}
+
 TEST_F(TitanDBTest, DbIter) {
   Open();
   std::map<std::string, std::string> data;
@@ -525,6 +609,55 @@ TEST_F(TitanDBTest, DropColumnFamily) {
   Close();
 }
 
+TEST_F(TitanDBTest, GarbageMeterForgetsDeletedTables) {
+  Open();
+  AddCF("1");
+  const uint64_t kNumEntries = 100;
+  for (uint64_t i = 1; i <= kNumEntries; i++) {
+    Put(i);
+  }
+  Flush();
+  auto* meter = db_impl_->TEST_garbage_meter();
+  auto table_numbers = [&](const std::string& cf_name) {
+    std::vector<LiveFileMetaData> metadata;
+    db_->GetLiveFilesMetaData(&metadata);
+    std::vector<uint64_t> numbers;
+    for (auto& f : metadata) {
+      if (f.column_family_name == cf_name) {
+        numbers.push_back(TableFileNameToNumber(f.name));
+      }
+    }
+    return numbers;
+  };
+  auto num_known = [&](const std::vector<uint64_t>& numbers) {
+    size_t n = 0;
+    for (auto number : numbers) {
+      BlobFileSizes sizes;
+      n += meter->GetTable(number, &sizes);
+    }
+    return n;
+  };
+
+  // The SSTs of a dropped column family are deleted once its handle is
+  // destroyed.
+  auto dropped = table_numbers("1");
+  ASSERT_EQ(1, dropped.size());
+  ASSERT_EQ(1, num_known(dropped));
+  DropCF("1");
+  ASSERT_EQ(0, num_known(dropped));
+
+  // So are the inputs of a compaction.
+  for (uint64_t i = 1; i <= kNumEntries; i++) {
+    Put(i);
+  }
+  Flush();
+  auto inputs = table_numbers(kDefaultColumnFamilyName);
+  ASSERT_EQ(2, inputs.size());
+  ASSERT_EQ(2, num_known(inputs));
+  CompactAll();
+  ASSERT_EQ(0, num_known(inputs));
+}
+
 TEST_F(TitanDBTest, DestroyColumnFamilyHandle) {
   Open();
   const uint64_t kNumCF = 3;
@@ -637,7 +770,7 @@ TEST_F(TitanDBTest, VersionEditError) {
   auto cf_id = db_->DefaultColumnFamily()->GetID();
   VersionEdit edit;
   edit.SetColumnFamilyID(cf_id);
-  edit.AddBlobFile(std::make_shared<BlobFileMeta>(1, 1, 0, 0, "", ""));
+  edit.AddBlobFile(std::make_shared<BlobFileMeta>(1, 1, 0, 0, "", "", kUnSorted));
   ASSERT_OK(LogAndApply(edit));
 
   VerifyDB(data);
@@ -645,7 +778,7 @@ TEST_F(TitanDBTest, VersionEditError) {
   // add same blob file twice
   VersionEdit edit1;
   edit1.SetColumnFamilyID(cf_id);
-  edit1.AddBlobFile(std::make_shared<BlobFileMeta>(1, 1, 0, 0, "", ""));
+  edit1.AddBlobFile(std::make_shared<BlobFileMeta>(1, 1, 0, 0, "", "", kUnSorted));
   ASSERT_NOK(LogAndApply(edit));
 
   Reopen();
@@ -1200,6 +1333,141 @@ TEST_F(TitanDBTest, GCBeforeFlushCommit) {
   SyncPoint::GetInstance()->ClearAllCallBacks();
 }
 
+TEST_F(TitanDBTest, WritesResumeAfterBlockWriteSize) {
+  const int kNumKeys = 100;
+  const uint64_t kFileSize = kNumKeys * 1024;
+  options_.min_blob_size = 0;
+  options_.blob_file_compression = kNoCompression;
+  options_.disable_background_gc = false;
+  // Two blob files stop writes, one does not. The slowdown zone is left out
+  // so that writes go from full speed to stopped.
+  options_.block_write_size = kFileSize * 3 / 2;
+  options_.slowdown_write_size = options_.block_write_size;
+  Open();
+
+  std::map<std::string, std::string> data;
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < kNumKeys; i++) {
+      std::string key = GenKey(i);
+      std::string value(1024, static_cast<char>('a' + round));
+      ASSERT_OK(db_->Put(WriteOptions(), key, value));
+      data[key] = value;
+    }
+    Flush();
+  }
+  // The compaction finds the blob files past block_write_size, and has to
+  // get GC to drop the first one, all garbage, for the next write to go
+  // through.
+  CompactAll();
+  std::string key = GenKey(kNumKeys);
+  ASSERT_OK(db_->Put(WriteOptions(), key, "v"));
+  data[key] = "v";
+
+  uint64_t live_blob_file_size = 0;
+  ASSERT_TRUE(db_->GetIntProperty("rocksdb.titandb.live-blob-file-size",
+                                  &live_blob_file_size));
+  ASSERT_LT(live_blob_file_size, options_.block_write_size);
+  VerifyDB(data);
+}
+
+TEST_F(TitanDBTest, BlobDirs) {
+  std::vector<std::string> blob_dirs = {dbname_ + "_blob0",
+                                        dbname_ + "_blob1"};
+  for (auto& dir : blob_dirs) {
+    DeleteDir(env_, dir);
+  }
+  options_.min_blob_size = 0;
+  options_.blob_dirs = blob_dirs;
+  Open();
+
+  // Every blob file lives in the blob dir of its number, and none in the
+  // DB-wide one.
+  auto check_files = [&]() {
+    std::map<uint64_t, std::weak_ptr<BlobFileMeta>> blob_files;
+    GetBlobStorage().lock()->ExportBlobFiles(blob_files);
+    for (auto& f : blob_files) {
+      auto file = f.second.lock();
+      ASSERT_TRUE(file != nullptr);
+      const std::string& dir = blob_dirs[f.first % blob_dirs.size()];
+      ASSERT_EQ(file->is_obsolete(), !env_->FileExists(BlobFileName(
+                                                           dir, f.first))
+                                          .ok());
+      ASSERT_TRUE(
+          env_->FileExists(BlobFileName(options_.dirname, f.first))
+              .IsNotFound());
+    }
+  };
+
+  std::map<std::string, std::string> data;
+  for (int round = 0; round < 4; round++) {
+    for (uint64_t i = 0; i < 100; i++) {
+      std::string key = GenKey(i);
+      std::string value = std::string(100, 'a' + round);
+      ASSERT_OK(db_->Put(WriteOptions(), key, value));
+      data[key] = value;
+    }
+    Flush();
+    check_files();
+  }
+  std::string dir_stats;
+  ASSERT_TRUE(db_->GetProperty("rocksdb.titandb.blob-dir-stats", &dir_stats));
+  for (auto& dir : blob_dirs) {
+    ASSERT_NE(dir_stats.find(dir + ": files "), std::string::npos);
+  }
+
+  // Recovery deletes the blob files the manifest doesn't know of.
+  const uint64_t kStrayFileNumber = 1000001;
+  std::string stray_file = BlobFileName(
+      blob_dirs[kStrayFileNumber % blob_dirs.size()], kStrayFileNumber);
+  {
+    std::unique_ptr<WritableFile> file;
+    ASSERT_OK(env_->NewWritableFile(stray_file, &file, EnvOptions()));
+    ASSERT_OK(file->Append("stray"));
+    ASSERT_OK(file->Close());
+  }
+  Reopen();
+  ASSERT_TRUE(env_->FileExists(stray_file).IsNotFound());
+  check_files();
+  VerifyDB(data);
+
+  // GC rewrites the live values of the files it picks into new files in
+  // the blob dirs and deletes the old ones from there.
+  CompactAll();
+  uint32_t cf_id = db_->DefaultColumnFamily()->GetID();
+  std::vector<std::string> gc_files;
+  {
+    std::map<uint64_t, std::weak_ptr<BlobFileMeta>> blob_files;
+    GetBlobStorage().lock()->ExportBlobFiles(blob_files);
+    for (auto& f : blob_files) {
+      auto file = f.second.lock();
+      if (!file->is_obsolete()) {
+        file->set_gc_mark(true);
+        gc_files.push_back(
+            BlobFileName(blob_dirs[f.first % blob_dirs.size()], f.first));
+      }
+    }
+  }
+  ASSERT_OK(db_impl_->TEST_StartGC(cf_id));
+  ASSERT_OK(db_impl_->TEST_PurgeObsoleteFiles());
+  check_files();
+  int num_deleted = 0;
+  for (auto& f : gc_files) {
+    if (env_->FileExists(f).IsNotFound()) {
+      num_deleted++;
+    }
+  }
+  ASSERT_GT(num_deleted, 0);
+  VerifyDB(data);
+  Reopen();
+  check_files();
+  VerifyDB(data);
+
+  Close();
+  for (auto& dir : blob_dirs) {
+    DeleteDir(env_, dir);
+  }
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
 
@@ -0,0 +1,64 @@
+#include "titan_perf_context_imp.h"
+
+#include <sstream>
+
+namespace rocksdb {
+namespace titandb {
+
+#if defined(NPERF_CONTEXT) || !defined(ROCKSDB_SUPPORT_THREAD_LOCAL)
+TitanPerfContext titan_perf_context;
+#else
+thread_local TitanPerfContext titan_perf_context;
+#endif
+
+TitanPerfContext* get_titan_perf_context() { return &titan_perf_context; }
+
+void TitanPerfContext::Reset() {
+#ifndef NPERF_CONTEXT
+  get_lsm_nanos = 0;
+  blob_file_open_count = 0;
+  blob_file_open_nanos = 0;
+  blob_value_cache_hit_count = 0;
+  blob_read_count = 0;
+  blob_read_byte = 0;
+  blob_read_nanos = 0;
+  blob_decompress_nanos = 0;
+  write_stall_count = 0;
+  write_stall_nanos = 0;
+  foreground_builder_wait_nanos = 0;
+#endif
+}
+
+#define TITAN_PERF_CONTEXT_OUTPUT(counter)       \
+  if (!exclude_zero_counters || (counter > 0)) { \
+    ss << #counter << " = " << counter << ", ";  \
+  }
+
+std::string TitanPerfContext::ToString(bool exclude_zero_counters) const {
+#ifdef NPERF_CONTEXT
+  (void)exclude_zero_counters;
+  return "";
+#else
+  std::ostringstream ss;
+  TITAN_PERF_CONTEXT_OUTPUT(get_lsm_nanos);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_file_open_count);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_file_open_nanos);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_value_cache_hit_count);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_read_count);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_read_byte);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_read_nanos);
+  TITAN_PERF_CONTEXT_OUTPUT(blob_decompress_nanos);
+  TITAN_PERF_CONTEXT_OUTPUT(write_stall_count);
+  TITAN_PERF_CONTEXT_OUTPUT(write_stall_nanos);
+  TITAN_PERF_CONTEXT_OUTPUT(foreground_builder_wait_nanos);
+  std::string str = ss.str();
+  // Drops the trailing ", ".
+  if (str.size() >= 2) {
+    str.erase(str.size() - 2);
+  }
+  return str;
+#endif
+}
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "monitoring/perf_step_timer.h"
+#include "titan/perf_context.h"
+
+namespace rocksdb {
+namespace titandb {
+
+#if defined(NPERF_CONTEXT) || !defined(ROCKSDB_SUPPORT_THREAD_LOCAL)
+extern TitanPerfContext titan_perf_context;
+#else
+extern thread_local TitanPerfContext titan_perf_context;
+#endif
+
+#if defined(NPERF_CONTEXT)
+
+#define TITAN_PERF_TIMER_GUARD(metric)
+#define TITAN_PERF_TIMER_STOP(metric)
+#define TITAN_PERF_COUNTER_ADD(metric, value)
+
+#else
+
+// Declares a timer adding the time until it is stopped or goes out of
+// scope to the metric.
+#define TITAN_PERF_TIMER_GUARD(metric)                                  \
+  PerfStepTimer titan_perf_step_timer_##metric(                         \
+      &(titan_perf_context.metric));                                    \
+  titan_perf_step_timer_##metric.Start();
+
+#define TITAN_PERF_TIMER_STOP(metric) titan_perf_step_timer_##metric.Stop();
+
+#define TITAN_PERF_COUNTER_ADD(metric, value) \
+  if (perf_level >= PerfLevel::kEnableCount) { \
+    titan_perf_context.metric += value;        \
+  }
+
+#endif
+
+}  // namespace titandb
+}  // namespace rocksdb
@@ -24,6 +24,10 @@ static const std::string num_discardable_ratio_le80_file =
     "num-discardable-ratio-le80-file";
 static const std::string num_discardable_ratio_le100_file =
     "num-discardable-ratio-le100-file";
+static const std::string min_blob_size = "min-blob-size";
+static const std::string mid_blob_size = "mid-blob-size";
+static const std::string perf_context = "perf-context";
+static const std::string blob_dir_stats = "blob-dir-stats";
 
 const std::string TitanDB::Properties::kLiveBlobSize =
     titandb_prefix + live_blob_size;
@@ -45,6 +49,14 @@ const std::string TitanDB::Properties::kNumDiscardableRatioLE80File =
     titandb_prefix + num_discardable_ratio_le80_file;
 const std::string TitanDB::Properties::kNumDiscardableRatioLE100File =
     titandb_prefix + num_discardable_ratio_le100_file;
+const std::string TitanDB::Properties::kMinBlobSize =
+    titandb_prefix + min_blob_size;
+const std::string TitanDB::Properties::kMidBlobSize =
+    titandb_prefix + mid_blob_size;
+const std::string TitanDB::Properties::kPerfContext =
+    titandb_prefix + perf_context;
+const std::string TitanDB::Properties::kBlobDirStats =
+    titandb_prefix + blob_dir_stats;
 
 const std::unordered_map<std::string, TitanInternalStats::StatsType>
     TitanInternalStats::stats_type_string_map = {
@@ -68,6 +80,8 @@ const std::unordered_map<std::string, TitanInternalStats::StatsType>
          TitanInternalStats::NUM_DISCARDABLE_RATIO_LE80},
         {TitanDB::Properties::kNumDiscardableRatioLE100File,
          TitanInternalStats::NUM_DISCARDABLE_RATIO_LE100},
+        {TitanDB::Properties::kMinBlobSize, TitanInternalStats::MIN_BLOB_SIZE},
+        {TitanDB::Properties::kMidBlobSize, TitanInternalStats::MID_BLOB_SIZE},
 };
 
 const std::array<std::string,
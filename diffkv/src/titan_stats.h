@@ -61,6 +61,10 @@ class TitanInternalStats {
     NUM_DISCARDABLE_RATIO_LE80,
     NUM_DISCARDABLE_RATIO_LE100,
 
+    // The current separation thresholds.
+    MIN_BLOB_SIZE,
+    MID_BLOB_SIZE,
+
     INTERNAL_STATS_ENUM_MAX,
   };
 
@@ -88,6 +92,10 @@ class TitanInternalStats {
     stats_[type].store(0, std::memory_order_relaxed);
   }
 
+  void SetStats(StatsType type, uint64_t value) {
+    stats_[type].store(value, std::memory_order_relaxed);
+  }
+
   void AddStats(StatsType type, uint64_t value) {
     auto& v = stats_[type];
     v.fetch_add(value, std::memory_order_relaxed);
@@ -140,6 +148,38 @@ class TitanStats : public Statistics {
     BLOB_CACHE_HIT = TICKER_ENUM_MAX + 1,
     BLOB_CACHE_MISS,
 
+    BLOB_VALUE_CACHE_HIT,
+    BLOB_VALUE_CACHE_MISS,
+    BLOB_VALUE_CACHE_ADD,
+    // Values not admitted by the frequency sketch.
+    BLOB_VALUE_CACHE_REJECT,
+
+    // Bytes charged to the blob I/O scheduler by each source, in the
+    // order of BlobIOSource.
+    BLOB_IO_FLUSH_BYTES,
+    BLOB_IO_COMPACTION_BYTES,
+    BLOB_IO_GC_BYTES,
+    BLOB_IO_THROTTLED_MICROS,
+
+    // Thresholds changed by the adaptive separation controller, and the
+    // bytes of the values it sampled on either side of min_blob_size.
+    BLOB_SIZE_CHANGES,
+    BLOB_SIZE_INLINE_WRITE_BYTES,
+    BLOB_SIZE_SEPARATED_WRITE_BYTES,
+    BLOB_SIZE_INLINE_READ_BYTES,
+    BLOB_SIZE_SEPARATED_READ_BYTES,
+
+    // Values of read-hot keys written back into SSTs by compaction, and
+    // inline values left in SSTs because their keys are still hot.
+    BLOB_HOT_VALUE_INLINED,
+    BLOB_HOT_VALUE_KEPT,
+
+    // Writes delayed and stopped as the blob files grow towards
+    // block_write_size, and the time writers were held for.
+    BLOB_WRITE_DELAYED,
+    BLOB_WRITE_STOPPED,
+    BLOB_WRITE_STALL_MICROS,
+
     GC_NO_NEED,
     GC_REMAIN,
 
@@ -162,7 +202,11 @@ class TitanStats : public Statistics {
     INTERNAL_HISTOGRAM_ENUM_MAX,
   };
 
-  TitanStats(Statistics* stats) : stats_(stats) {}
+  TitanStats(Statistics* stats) : stats_(stats) {
+    for (auto& ticker : tickers_) {
+      ticker.store(0, std::memory_order_relaxed);
+    }
+  }
 
   // TODO: Initialize corresponding internal stats struct for Column families
   // created after DB open.
@@ -297,6 +341,16 @@ inline void ResetStats(TitanStats* stats, uint32_t cf_id,
   }
 }
 
+inline void SetStats(TitanStats* stats, uint32_t cf_id,
+                     TitanInternalStats::StatsType type, uint64_t value) {
+  if (stats) {
+    auto p = stats->internal_stats(cf_id);
+    if (p) {
+      p->SetStats(type, value);
+    }
+  }
+}
+
 inline void AddStats(TitanStats* stats, uint32_t cf_id,
                      TitanInternalStats::StatsType type, uint64_t value) {
   if (stats) {
@@ -1,7 +1,20 @@
 #include "util.h"
 
+#ifdef OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <thread>
+
+#include "file/filename.h"
 #include "util/stop_watch.h"
 
+#include "titan_perf_context_imp.h"
+
 namespace rocksdb {
 namespace titandb {
 
@@ -82,6 +95,7 @@ Slice Compress(const CompressionInfo& info, const Slice& input,
 
 Status Uncompress(const UncompressionInfo& info, const Slice& input,
                   OwnedSlice* output) {
+  TITAN_PERF_TIMER_GUARD(blob_decompress_nanos);
   int size = 0;
   CacheAllocationPtr ubuf;
   assert(info.type() != kNoCompression);
@@ -159,6 +173,206 @@ void UnrefCacheHandle(void* arg1, void* arg2) {
   cache->Release(h);
 }
 
+AlignedBufferPool::AlignedBufferPool(size_t alignment,
+                                     size_t max_pooled_bytes)
+    : alignment_(alignment),
+      max_pooled_bytes_per_shard_(max_pooled_bytes / kNumShards) {
+  assert(alignment_ > 0 && (alignment_ & (alignment_ - 1)) == 0);
+}
+
+AlignedBufferPool::~AlignedBufferPool() {
+  for (auto& shard : shards_) {
+    for (auto& free_list : shard.free_lists) {
+      for (char* p : free_list) {
+        delete[] GetHeader(p).raw;
+      }
+    }
+  }
+}
+
+AlignedBufferPool::Shard* AlignedBufferPool::CurrentShard() {
+  return &shards_[std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                  kNumShards];
+}
+
+void* AlignedBufferPool::Allocate(size_t size) {
+  size_t size_class = 0;
+  while (size_class < kNumSizeClasses && SizeOfClass(size_class) < size) {
+    size_class++;
+  }
+  if (size_class < kNumSizeClasses) {
+    Shard* shard = CurrentShard();
+    {
+      std::lock_guard<std::mutex> l(shard->mutex);
+      auto& free_list = shard->free_lists[size_class];
+      if (!free_list.empty()) {
+        char* p = free_list.back();
+        free_list.pop_back();
+        shard->pooled_bytes -= SizeOfClass(size_class);
+        return p;
+      }
+    }
+    size = SizeOfClass(size_class);
+  }
+  BufferHeader header;
+  header.raw = new char[sizeof(header) + size + alignment_];
+  header.size = size;
+  auto p = reinterpret_cast<char*>(
+      (reinterpret_cast<uintptr_t>(header.raw) + sizeof(header) + alignment_ -
+       1) &
+      ~(alignment_ - 1));
+  memcpy(p - sizeof(header), &header, sizeof(header));
+  return p;
+}
+
+void AlignedBufferPool::Deallocate(void* p) {
+  BufferHeader header = GetHeader(p);
+  if (header.size <= SizeOfClass(kNumSizeClasses - 1)) {
+    size_t size_class = 0;
+    while (SizeOfClass(size_class) < header.size) {
+      size_class++;
+    }
+    // Freed by another thread than the one that allocated it, the buffer
+    // moves to the shard of the freeing thread.
+    Shard* shard = CurrentShard();
+    std::lock_guard<std::mutex> l(shard->mutex);
+    if (shard->pooled_bytes + header.size <= max_pooled_bytes_per_shard_) {
+      shard->free_lists[size_class].push_back(reinterpret_cast<char*>(p));
+      shard->pooled_bytes += header.size;
+      return;
+    }
+  }
+  delete[] header.raw;
+}
+
+size_t AlignedBufferPool::UsableSize(void* p,
+                                     size_t /*allocation_size*/) const {
+  return GetHeader(p).size;
+}
+
+EnvOptions BlobFileEnvOptions(const EnvOptions& env_options,
+                              const TitanCFOptions& cf_options) {
+  EnvOptions result = env_options;
+  if (cf_options.blob_file_use_direct_io) {
+    result.use_direct_reads = true;
+    result.use_direct_writes = true;
+    // Direct writes can't be merged by the page cache, so coalesce them in
+    // a bigger buffer.
+    result.writable_file_max_buffer_size =
+        std::max<size_t>(result.writable_file_max_buffer_size, 4 << 20);
+  }
+  if (cf_options.blob_file_write_buffer_size > 0) {
+    result.writable_file_max_buffer_size =
+        static_cast<size_t>(cf_options.blob_file_write_buffer_size);
+  }
+  return result;
+}
+
+const std::string& BlobFileDir(const std::string& dirname,
+                               const std::vector<std::string>& blob_dirs,
+                               uint64_t file_number) {
+  if (blob_dirs.empty()) {
+    return dirname;
+  }
+  return blob_dirs[file_number % blob_dirs.size()];
+}
+
+std::string BlobFilePath(const TitanDBOptions& db_options,
+                         const TitanCFOptions& cf_options,
+                         uint64_t file_number) {
+  return BlobFileName(
+      BlobFileDir(db_options.dirname, cf_options.blob_dirs, file_number),
+      file_number);
+}
+
+BlobIOScheduler* GetBlobIOScheduler(const TitanDBOptions& db_options,
+                                    const TitanCFOptions& cf_options) {
+  return cf_options.blob_io_scheduler ? cf_options.blob_io_scheduler.get()
+                                      : db_options.blob_io_scheduler.get();
+}
+
+bool ParseCpuList(const std::string& cpulist, std::vector<int>* cpus) {
+  cpus->clear();
+  size_t pos = 0;
+  while (pos < cpulist.size() && cpulist[pos] != '\n') {
+    size_t end = cpulist.find_first_of(",\n", pos);
+    if (end == std::string::npos) {
+      end = cpulist.size();
+    }
+    std::string range = cpulist.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    char* parsed = nullptr;
+    long first = strtol(range.c_str(), &parsed, 10);
+    long last = first;
+    if (dash != std::string::npos) {
+      if (parsed != range.c_str() + dash) {
+        return false;
+      }
+      last = strtol(range.c_str() + dash + 1, &parsed, 10);
+    }
+    if (range.empty() || *parsed != '\0' || first < 0 || last < first) {
+      return false;
+    }
+    for (long cpu = first; cpu <= last; cpu++) {
+      cpus->push_back(static_cast<int>(cpu));
+    }
+    pos = end < cpulist.size() && cpulist[end] == ',' ? end + 1 : end;
+  }
+  return !cpus->empty();
+}
+
+std::vector<std::vector<int>> GetNumaNodeCpus(Env* env) {
+  const std::string kNodeDir = "/sys/devices/system/node";
+  std::vector<std::pair<int, std::vector<int>>> nodes;
+  std::vector<std::string> children;
+  if (env->GetChildren(kNodeDir, &children).ok()) {
+    for (const auto& child : children) {
+      if (child.size() <= 4 || child.compare(0, 4, "node") != 0 ||
+          !std::all_of(child.begin() + 4, child.end(), ::isdigit)) {
+        continue;
+      }
+      std::string cpulist;
+      std::vector<int> cpus;
+      // Nodes with memory only have no CPUs.
+      if (ReadFileToString(env, kNodeDir + "/" + child + "/cpulist", &cpulist)
+              .ok() &&
+          ParseCpuList(cpulist, &cpus)) {
+        nodes.emplace_back(std::stoi(child.substr(4)), std::move(cpus));
+      }
+    }
+  }
+  std::sort(nodes.begin(), nodes.end());
+  std::vector<std::vector<int>> node_cpus;
+  for (auto& node : nodes) {
+    node_cpus.push_back(std::move(node.second));
+  }
+  if (node_cpus.empty()) {
+    node_cpus.emplace_back();
+    for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+      node_cpus.back().push_back(static_cast<int>(cpu));
+    }
+  }
+  return node_cpus;
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus) {
+#ifdef OS_LINUX
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  return CPU_COUNT(&cpu_set) > 0 &&
+         pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) ==
+             0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
 Status SyncTitanManifest(Env* env, TitanStats* stats,
                          const ImmutableDBOptions* db_options,
                          WritableFileWriter* file) {
@@ -5,7 +5,10 @@
 #include "util/compression.h"
 #include "util/file_reader_writer.h"
 
+#include <cstring>
 #include <list>
+#include <mutex>
+#include "rocksdb/memory_allocator.h"
 #include "titan_stats.h"
 
 namespace rocksdb {
@@ -65,8 +68,15 @@ class OwnedSlice : public Slice {
     return buffer_.release();
   }
 
-  static void CleanupFunc(void* buffer, void*) {
-    delete[] reinterpret_cast<char*>(buffer);
+  // The allocator the buffer must be returned to, nullptr if the buffer
+  // is allocated by new[].
+  MemoryAllocator* allocator() const { return buffer_.get_deleter().allocator; }
+
+  // Frees a buffer returned by `release()`, the allocator is passed as
+  // the second argument.
+  static void CleanupFunc(void* buffer, void* allocator) {
+    CustomDeleter(reinterpret_cast<MemoryAllocator*>(allocator))(
+        reinterpret_cast<char*>(buffer));
   }
 
  private:
@@ -104,6 +114,102 @@ Status Uncompress(const UncompressionInfo& info, const Slice& input,
 
 void UnrefCacheHandle(void* cache, void* handle);
 
+// Pools the aligned buffers used by direct I/O reads, so reading a record
+// needs neither a fresh allocation nor a copy out of a bounce buffer.
+// Buffers are rounded up to power-of-two size classes; buffers bigger
+// than the largest class are allocated and freed directly. The size of a
+// buffer is kept in a header in front of it, and free buffers are kept in
+// shards picked by the calling thread, so concurrent readers rarely
+// share a lock. The pool must outlive all the buffers it hands out.
+class AlignedBufferPool : public MemoryAllocator {
+ public:
+  // Buffers are aligned to "alignment", at most "max_pooled_bytes" of
+  // free buffers are kept.
+  AlignedBufferPool(size_t alignment, size_t max_pooled_bytes);
+
+  ~AlignedBufferPool();
+
+  const char* Name() const override { return "AlignedBufferPool"; }
+
+  void* Allocate(size_t size) override;
+
+  void Deallocate(void* p) override;
+
+  size_t UsableSize(void* p, size_t allocation_size) const override;
+
+  size_t alignment() const { return alignment_; }
+
+ private:
+  static const size_t kNumSizeClasses = 9;
+  static const size_t kNumShards = 16;
+
+  // Stored right in front of every buffer handed out.
+  struct BufferHeader {
+    // The allocation returned by new[], which may be unaligned.
+    char* raw;
+    size_t size;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    size_t pooled_bytes{0};
+    std::vector<char*> free_lists[kNumSizeClasses];
+  };
+
+  size_t SizeOfClass(size_t size_class) const {
+    return alignment_ << size_class;
+  }
+
+  static BufferHeader GetHeader(const void* p) {
+    BufferHeader header;
+    memcpy(&header, reinterpret_cast<const char*>(p) - sizeof(header),
+           sizeof(header));
+    return header;
+  }
+
+  Shard* CurrentShard();
+
+  const size_t alignment_;
+  // Limit of free buffers kept by each shard.
+  const size_t max_pooled_bytes_per_shard_;
+  Shard shards_[kNumShards];
+};
+
+// Returns the env options to read and write blob files of the column
+// family, which enables direct I/O and sizes the write buffer as
+// configured in "cf_options".
+EnvOptions BlobFileEnvOptions(const EnvOptions& env_options,
+                              const TitanCFOptions& cf_options);
+
+// Returns the directory of blob file "file_number" of a column family whose
+// blob files go to "blob_dirs", or to "dirname" if there are none. Files
+// are striped over the directories by file number.
+const std::string& BlobFileDir(const std::string& dirname,
+                               const std::vector<std::string>& blob_dirs,
+                               uint64_t file_number);
+
+// Returns the path of blob file "file_number" of the column family.
+std::string BlobFilePath(const TitanDBOptions& db_options,
+                         const TitanCFOptions& cf_options,
+                         uint64_t file_number);
+
+// Returns the scheduler of the blob IO of the column family, which is its
+// own blob_io_scheduler if set and the DB's otherwise. May be nullptr.
+BlobIOScheduler* GetBlobIOScheduler(const TitanDBOptions& db_options,
+                                    const TitanCFOptions& cf_options);
+
+// Parses a list of CPUs in the format of the kernel's cpulist files, such
+// as "0-3,8,10-11", into "*cpus".
+bool ParseCpuList(const std::string& cpulist, std::vector<int>* cpus);
+
+// Returns the CPUs of every NUMA node, as listed in /sys/devices/system/node.
+// If the topology can't be read, returns a single node with all CPUs.
+std::vector<std::vector<int>> GetNumaNodeCpus(Env* env);
+
+// Restricts the calling thread to run on the CPUs. Returns false if it
+// isn't supported on the platform or fails.
+bool PinCurrentThread(const std::vector<int>& cpus);
+
 template <class T>
 void DeleteCacheValue(const Slice&, void* value) {
   delete reinterpret_cast<T*>(value);
@@ -1,6 +1,10 @@
 #include "util.h"
 
+#include <set>
+
+#include "blob_io_scheduler.h"
 #include "test_util/testharness.h"
+#include "util/random.h"
 
 namespace rocksdb {
 namespace titandb {
@@ -30,6 +34,123 @@ TEST(UtilTest, Compression) {
   }
 }
 
+TEST(UtilTest, AlignedBufferPool) {
+  const size_t kAlignment = 4096;
+  AlignedBufferPool pool(kAlignment, 64 << 10);
+  auto p1 = reinterpret_cast<char*>(pool.Allocate(100));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(p1) % kAlignment, 0);
+  ASSERT_EQ(pool.UsableSize(p1, 100), kAlignment);
+  auto p2 = reinterpret_cast<char*>(pool.Allocate(kAlignment + 1));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(p2) % kAlignment, 0);
+  ASSERT_EQ(pool.UsableSize(p2, kAlignment + 1), 2 * kAlignment);
+  memset(p1, 'a', kAlignment);
+  memset(p2, 'b', 2 * kAlignment);
+
+  // Freed buffers are reused by allocations of the same size class.
+  pool.Deallocate(p1);
+  pool.Deallocate(p2);
+  ASSERT_EQ(pool.Allocate(kAlignment), p1);
+  ASSERT_EQ(pool.Allocate(2 * kAlignment - 1), p2);
+  pool.Deallocate(p1);
+  pool.Deallocate(p2);
+
+  // Buffers beyond the largest size class aren't pooled.
+  auto p3 = pool.Allocate(4 << 20);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(p3) % kAlignment, 0);
+  pool.Deallocate(p3);
+
+  // Buffers are owned by the pool through CacheAllocationPtr too.
+  OwnedSlice slice;
+  CacheAllocationPtr buffer(reinterpret_cast<char*>(pool.Allocate(10)), &pool);
+  slice.reset(std::move(buffer), 10);
+  ASSERT_EQ(slice.allocator(), &pool);
+  OwnedSlice::CleanupFunc(slice.release(), &pool);
+}
+
+TEST(UtilTest, AlignedBufferPoolConcurrent) {
+  const size_t kAlignment = 512;
+  AlignedBufferPool pool(kAlignment, 1 << 20);
+  // Buffers allocated by one thread are freed by another.
+  const int kNumThreads = 8;
+  const int kNumBuffers = 1000;
+  std::vector<std::vector<char*>> buffers(kNumThreads);
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rnd(t + 1);
+      for (int i = 0; i < kNumBuffers; i++) {
+        size_t size = 1 + rnd.Uniform(64 << 10);
+        auto p = reinterpret_cast<char*>(pool.Allocate(size));
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(p) % kAlignment, 0);
+        ASSERT_GE(pool.UsableSize(p, size), size);
+        memset(p, 'a' + t, size);
+        buffers[t].push_back(p);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (char* p : buffers[(t + 1) % kNumThreads]) {
+        pool.Deallocate(p);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(UtilTest, NumaNodeCpus) {
+  std::vector<int> cpus;
+  ASSERT_TRUE(ParseCpuList("0-3,8,10-11\n", &cpus));
+  ASSERT_EQ(cpus, (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_TRUE(ParseCpuList("5", &cpus));
+  ASSERT_EQ(cpus, (std::vector<int>{5}));
+  ASSERT_FALSE(ParseCpuList("\n", &cpus));
+  ASSERT_FALSE(ParseCpuList("3-1", &cpus));
+  ASSERT_FALSE(ParseCpuList("0,,1", &cpus));
+  ASSERT_FALSE(ParseCpuList("a-b", &cpus));
+
+  // Every CPU belongs to a single node.
+  auto node_cpus = GetNumaNodeCpus(Env::Default());
+  ASSERT_GE(node_cpus.size(), 1);
+  std::set<int> all_cpus;
+  for (const auto& node : node_cpus) {
+    for (int cpu : node) {
+      ASSERT_TRUE(all_cpus.insert(cpu).second);
+    }
+  }
+}
+
+TEST(UtilTest, BlobFileDir) {
+  TitanDBOptions db_options;
+  db_options.dirname = "/db/titandb";
+  TitanCFOptions cf_options;
+  ASSERT_EQ(BlobFilePath(db_options, cf_options, 7), "/db/titandb/000007.blob");
+
+  // Files are striped over the blob dirs by file number.
+  cf_options.blob_dirs = {"/ssd0", "/ssd1", "/ssd2"};
+  ASSERT_EQ(BlobFilePath(db_options, cf_options, 7), "/ssd1/000007.blob");
+  ASSERT_EQ(BlobFileDir(db_options.dirname, cf_options.blob_dirs, 9), "/ssd0");
+  ASSERT_EQ(BlobFileDir(db_options.dirname, cf_options.blob_dirs, 11),
+            "/ssd2");
+
+  // The column family's IO scheduler takes precedence over the DB's.
+  ASSERT_EQ(GetBlobIOScheduler(db_options, cf_options), nullptr);
+  db_options.blob_io_scheduler =
+      std::make_shared<BlobIOScheduler>(1 << 20, 1000, Env::Default());
+  ASSERT_EQ(GetBlobIOScheduler(db_options, cf_options),
+            db_options.blob_io_scheduler.get());
+  cf_options.blob_io_scheduler =
+      std::make_shared<BlobIOScheduler>(1 << 20, 1000, Env::Default());
+  ASSERT_EQ(GetBlobIOScheduler(db_options, cf_options),
+            cf_options.blob_io_scheduler.get());
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
 
@@ -68,7 +68,7 @@ class VersionTest : public testing::Test {
   void AddBlobFiles(uint32_t cf_id, uint64_t start, uint64_t end) {
     auto storage = column_families_[cf_id];
     for (auto i = start; i < end; i++) {
-      auto file = std::make_shared<BlobFileMeta>(i, i, 0, 0, "", "");
+      auto file = std::make_shared<BlobFileMeta>(i, i, 0, 0, "", "", kUnSorted);
       storage->files_.emplace(i, file);
     }
   }
@@ -105,6 +105,14 @@ class VersionTest : public testing::Test {
     }
   }
 
+  uint64_t ManifestSize() {
+    return blob_file_set_->manifest_->file()->GetFileSize();
+  }
+
+  uint64_t ManifestSnapshotSize() {
+    return blob_file_set_->manifest_snapshot_size_;
+  }
+
   void CheckColumnFamiliesSize(uint64_t size) {
     ASSERT_EQ(blob_file_set_->column_families_.size(), size);
   }
@@ -130,8 +138,8 @@ TEST_F(VersionTest, VersionEdit) {
   input.SetNextFileNumber(1);
   input.SetColumnFamilyID(2);
   CheckCodec(input);
-  auto file1 = std::make_shared<BlobFileMeta>(3, 4, 0, 0, "", "");
-  auto file2 = std::make_shared<BlobFileMeta>(5, 6, 0, 0, "", "");
+  auto file1 = std::make_shared<BlobFileMeta>(3, 4, 0, 0, "", "", kUnSorted);
+  auto file2 = std::make_shared<BlobFileMeta>(5, 6, 0, 0, "", "", kUnSorted);
   input.AddBlobFile(file1);
   input.AddBlobFile(file2);
   input.DeleteBlobFile(7);
@@ -143,7 +151,7 @@ VersionEdit AddBlobFilesEdit(uint32_t cf_id, uint64_t start, uint64_t end) {
   VersionEdit edit;
   edit.SetColumnFamilyID(cf_id);
   for (auto i = start; i < end; i++) {
-    auto file = std::make_shared<BlobFileMeta>(i, i, 0, 0, "", "");
+    auto file = std::make_shared<BlobFileMeta>(i, i, 0, 0, "", "", kUnSorted);
     edit.AddBlobFile(file);
   }
   return edit;
@@ -315,7 +323,8 @@ TEST_F(VersionTest, DeleteBlobsInRange) {
   for (size_t i = 0; i < metas.size(); i++) {
     auto file = std::make_shared<BlobFileMeta>(i + 1, i + 1, 0, 0,
                                                std::move(metas[i].first),
-                                               std::move(metas[i].second));
+                                               std::move(metas[i].second),
+                                               kUnSorted);
     edit.AddBlobFile(file);
   }
   EditCollector collector;
@@ -366,9 +375,9 @@ TEST_F(VersionTest, DeleteBlobsInRange) {
 TEST_F(VersionTest, BlobFileMetaV1ToV2) {
   VersionEdit edit;
   edit.SetColumnFamilyID(1);
-  edit.AddBlobFile(std::make_shared<BlobFileMeta>(1, 1, 0, 0, "", ""));
+  edit.AddBlobFile(std::make_shared<BlobFileMeta>(1, 1, 0, 0, "", "", kUnSorted));
   edit.DeleteBlobFile(1);
-  edit.AddBlobFile(std::make_shared<BlobFileMeta>(2, 2, 0, 0, "", ""));
+  edit.AddBlobFile(std::make_shared<BlobFileMeta>(2, 2, 0, 0, "", "", kUnSorted));
   std::string str;
   LegacyEncode(edit, &str);
 
@@ -377,6 +386,77 @@ TEST_F(VersionTest, BlobFileMetaV1ToV2) {
   CheckCodec(edit1);
 }
 
+TEST_F(VersionTest, ManifestSnapshot) {
+  db_options_.titan_max_manifest_file_size = 1;
+  Reset();
+  const uint64_t kNumFiles = 100;
+  for (uint64_t i = 1; i <= kNumFiles; i++) {
+    VersionEdit edit;
+    edit.SetColumnFamilyID(1);
+    edit.AddBlobFile(
+        std::make_shared<BlobFileMeta>(i, i, 0, 0, "", "", kUnSorted));
+    if (i % 2 == 0) {
+      edit.DeleteBlobFile(i - 1);
+    }
+    ASSERT_OK(blob_file_set_->LogAndApply(edit));
+    // The manifest is rolled once it's twice the size of its snapshot.
+    ASSERT_LE(ManifestSize(), 2 * ManifestSnapshotSize() + 64);
+  }
+  std::vector<std::string> obsolete_files;
+  blob_file_set_->GetObsoleteFiles(&obsolete_files, kMaxSequenceNumber);
+  size_t num_obsolete_manifests = 0;
+  for (auto& file : obsolete_files) {
+    if (file.find("MANIFEST") != std::string::npos) {
+      num_obsolete_manifests++;
+    }
+  }
+  ASSERT_GT(num_obsolete_manifests, 1);
+
+  std::map<uint32_t, TitanCFOptions> cfs{{1, cf_options_}};
+  blob_file_set_.reset(new BlobFileSet(db_options_, nullptr));
+  ASSERT_OK(blob_file_set_->Open(cfs));
+  auto storage = blob_file_set_->GetBlobStorage(1).lock();
+  ASSERT_EQ(storage->NumBlobFiles(), kNumFiles / 2);
+  for (uint64_t i = 2; i <= kNumFiles; i += 2) {
+    ASSERT_NE(storage->FindFile(i).lock(), nullptr);
+  }
+}
+
+TEST_F(VersionTest, VerifyBlobFilesOnOpen) {
+  db_options_.verify_blob_files_on_open = true;
+  db_options_.max_file_opening_threads = 4;
+  Reset();
+  std::string contents;
+  BlobFileHeader().EncodeTo(&contents);
+  BlobFileFooter().EncodeTo(&contents);
+  VersionEdit edit;
+  edit.SetColumnFamilyID(1);
+  for (uint64_t i = 1; i <= 10; i++) {
+    ASSERT_OK(WriteStringToFile(env_, contents,
+                                BlobFileName(db_options_.dirname, i)));
+    edit.AddBlobFile(std::make_shared<BlobFileMeta>(i, contents.size(), 0, 0,
+                                                    "", "", kUnSorted));
+  }
+  ASSERT_OK(blob_file_set_->LogAndApply(edit));
+
+  std::map<uint32_t, TitanCFOptions> cfs{{1, cf_options_}};
+  blob_file_set_.reset(new BlobFileSet(db_options_, nullptr));
+  ASSERT_OK(blob_file_set_->Open(cfs));
+
+  // Corrupts the checksum of a footer.
+  contents.back() ^= 1;
+  ASSERT_OK(WriteStringToFile(env_, contents,
+                              BlobFileName(db_options_.dirname, 5)));
+  blob_file_set_.reset(new BlobFileSet(db_options_, nullptr));
+  ASSERT_TRUE(blob_file_set_->Open(cfs).IsCorruption());
+
+  // So does a truncated file.
+  ASSERT_OK(WriteStringToFile(env_, contents.substr(1),
+                              BlobFileName(db_options_.dirname, 5)));
+  blob_file_set_.reset(new BlobFileSet(db_options_, nullptr));
+  ASSERT_TRUE(blob_file_set_->Open(cfs).IsCorruption());
+}
+
 }  // namespace titandb
 }  // namespace rocksdb
 
@@ -4,7 +4,8 @@
 if [ $# -ne 1 ]; then
   echo -n "./benchmark.sh [bulkload/fillseq/overwrite/filluniquerandom/"
   echo    "readrandom/readwhilewriting/readwhilemerging/updaterandom/"
-  echo    "mergerandom/randomtransaction/compact]"
+  echo    "mergerandom/randomtransaction/compact/blob_io_compare/"
+  echo    "blob_format_compare/open]"
   exit 0
 fi
 
@@ -47,6 +48,7 @@ num_nexts_per_seek=${NUM_NEXTS_PER_SEEK:-100}
 cache_size=${CACHE_SIZE:-$((1 * G))}
 compression_max_dict_bytes=${COMPRESSION_MAX_DICT_BYTES:-0}
 compression_type=${COMPRESSION_TYPE:-snappy}
+blob_block_size=${BLOB_BLOCK_SIZE:-$((16 * K))}
 duration=${DURATION:-0}
 
 num_keys=${NUM_KEYS:-$((1 * G))}
@@ -353,6 +355,95 @@ function run_readwhile {
   summarize_result $output_dir/${out_name} readwhile${operation}.t${num_threads} readwhile${operation}
 }
 
+# Runs readwhilewriting with buffered and then direct I/O of blob files.
+# Overwrites keep GC busy, so both modes see GC and foreground I/O mixed.
+function run_blob_io_compare {
+  for direct_io in 0 1; do
+    echo "Reading $num_keys random keys while writing, blob direct I/O: $direct_io"
+    test_name="readwhilewriting.blob_direct_io${direct_io}.t${num_threads}"
+    out_name="benchmark_${test_name}.log"
+    cmd="./titandb_bench --benchmarks=readwhilewriting \
+         --use_existing_db=1 \
+         $const_params \
+         --threads=$num_threads \
+         --titan_blob_file_use_direct_io=$direct_io \
+         --seed=$( date +%s ) \
+         2>&1 | tee -a $output_dir/${out_name}"
+    echo $cmd | tee $output_dir/${out_name}
+    eval $cmd
+    summarize_result $output_dir/${out_name} ${test_name} readwhilewriting
+  done
+}
+
+# Loads the same keys into blob files of format version 1 and 2, then
+# reads them randomly. Blob files are read with direct I/O, so the file
+# system inputs reported by time(1) give the read amplification.
+function run_blob_format_compare {
+  for version in 1 2; do
+    db_dir=$DB_DIR/blob_format_v${version}
+    format_params="--db=$db_dir \
+         --wal_dir=$db_dir \
+         --titan_blob_file_format_version=$version \
+         --titan_blob_file_block_size=$blob_block_size \
+         --titan_blob_file_max_dict_bytes=$compression_max_dict_bytes \
+         --titan_blob_file_use_direct_io=1"
+
+    echo "Loading $num_keys keys into blob files of format version $version"
+    test_name="fillrandom.blob_format_v${version}"
+    out_name="benchmark_${test_name}.log"
+    cmd="./titandb_bench --benchmarks=fillrandom,compact \
+         --use_existing_db=0 \
+         $params_level_compact \
+         $format_params \
+         --threads=1 \
+         --seed=$( date +%s ) \
+         2>&1 | tee -a $output_dir/${out_name}"
+    echo $cmd | tee $output_dir/${out_name}
+    eval $cmd
+    blob_bytes=$( du -sb $db_dir/titandb | awk '{ print $1 }' )
+    echo "Blob files of format version $version: $blob_bytes bytes" \
+         | tee -a $output_dir/${out_name}
+
+    echo "Reading $num_keys random keys from blob files of format version $version"
+    test_name="readrandom.blob_format_v${version}.t${num_threads}"
+    out_name="benchmark_${test_name}.log"
+    cmd="/usr/bin/time -v ./titandb_bench --benchmarks=readrandom \
+         --use_existing_db=1 \
+         $params_level_compact \
+         $format_params \
+         --threads=$num_threads \
+         --seed=$( date +%s ) \
+         2>&1 | tee -a $output_dir/${out_name}"
+    echo $cmd | tee $output_dir/${out_name}
+    eval $cmd
+    read_bytes=$( grep "File system inputs" $output_dir/${out_name} \
+                  | awk '{ print $4 * 512 }' )
+    echo "Read amplification: $( echo "scale=2; $read_bytes / ( $num_keys * $value_size )" | bc )" \
+         | tee -a $output_dir/${out_name}
+    summarize_result $output_dir/${out_name} ${test_name} readrandom
+  done
+}
+
+# Reopens an existing DB without and then with blob file verification and
+# reports the time each open takes.
+function run_open {
+  for verify in 0 1; do
+    echo "Reopening the DB, verify blob files: $verify"
+    test_name="open.verify${verify}"
+    out_name="benchmark_${test_name}.log"
+    cmd="./titandb_bench --benchmarks=open \
+         --use_existing_db=1 \
+         $const_params \
+         --titan_verify_blob_files_on_open=$verify \
+         2>&1 | tee -a $output_dir/${out_name}"
+    echo $cmd | tee $output_dir/${out_name}
+    eval $cmd
+    grep "to reopen the DB" $output_dir/${out_name} | tail -1 \
+        | awk -v name=$test_name '{ print name "\t" $3 " ms" }' \
+        | tee -a $output_dir/report.txt
+  done
+}
+
 function run_rangewhile {
   operation=$1
   full_name=$2
@@ -446,6 +537,12 @@ for job in ${jobs[@]}; do
     run_readwhile writing
   elif [ $job = readwhilemerging ]; then
     run_readwhile merging
+  elif [ $job = blob_io_compare ]; then
+    run_blob_io_compare
+  elif [ $job = blob_format_compare ]; then
+    run_blob_format_compare
+  elif [ $job = open ]; then
+    run_open
   elif [ $job = fwdrangewhilewriting ]; then
     run_rangewhile writing $job false
   elif [ $job = revrangewhilewriting ]; then
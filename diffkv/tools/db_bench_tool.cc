@@ -61,6 +61,7 @@
 #include "test_util/testutil.h"
 #include "test_util/transaction_test_util.h"
 #include "titan/db.h"
+#include "titan/perf_context.h"
 #include "util/cast_util.h"
 #include "util/compression.h"
 #include "util/crc32c.h"
@@ -194,6 +195,7 @@ DEFINE_string(
     "Meta operations:\n"
     "\tcompact     -- Compact the entire DB; If multiple, randomly choose one\n"
     "\tcompactall  -- Compact the entire DB\n"
+    "\topen        -- Close the DB and report the time to reopen it\n"
     "\tstats       -- Print DB stats\n"
     "\tresetstats  -- Reset DB stats\n"
     "\tlevelstats  -- Print the number of files and bytes per level\n"
@@ -780,6 +782,35 @@ DEFINE_uint64(titan_min_blob_size, 0,
               "Smallest blob to store in a file. Blobs smaller than this "
               "will be inlined with the key in the LSM tree.");
 
+DEFINE_bool(titan_adaptive_blob_size,
+            rocksdb::titandb::TitanOptions().adaptive_blob_size,
+            "Move min_blob_size and mid_blob_size at runtime from the sizes "
+            "of the values written and read.");
+
+DEFINE_int32(titan_inline_hot_value_frequency,
+             rocksdb::titandb::TitanOptions().inline_hot_value_frequency,
+             "Read frequency that makes compaction write a separated value "
+             "back into the SST, 0 to disable it.");
+
+DEFINE_uint64(titan_inline_hot_value_max_size,
+              rocksdb::titandb::TitanOptions().inline_hot_value_max_size,
+              "Largest value kept in the SST for a read-hot key.");
+
+DEFINE_uint64(titan_blob_read_queue_depth,
+              rocksdb::titandb::TitanOptions().blob_read_queue_depth,
+              "Number of threads issuing the blob reads of MultiGet, scans "
+              "and level merge, 0 to read them in the calling thread.");
+
+DEFINE_uint64(titan_block_write_size,
+              rocksdb::titandb::TitanOptions().block_write_size,
+              "Stop writes while the blob files are larger than this, "
+              "0 to never hold writes for the size of blob files.");
+
+DEFINE_uint64(titan_slowdown_write_size,
+              rocksdb::titandb::TitanOptions().slowdown_write_size,
+              "Delay writes once the blob files are larger than this, "
+              "0 for 3/4 of titan_block_write_size.");
+
 DEFINE_bool(titan_disable_background_gc,
             rocksdb::titandb::TitanOptions().disable_background_gc,
             "Disable Titan background GC");
@@ -788,9 +819,70 @@ DEFINE_int32(titan_max_background_gc,
              rocksdb::titandb::TitanOptions().max_background_gc,
              "Titan max background GC threads.");
 
+DEFINE_int32(titan_max_gc_subjobs,
+             rocksdb::titandb::TitanOptions().max_gc_subjobs,
+             "Max number of concurrent sub jobs of a Titan GC job.");
+
 DEFINE_int64(titan_blob_cache_size, 0,
              "Size of Titan blob cache. Disabled by default.");
 
+DEFINE_bool(titan_blob_file_use_direct_io,
+            rocksdb::titandb::TitanOptions().blob_file_use_direct_io,
+            "Read and write Titan blob files with direct I/O.");
+
+DEFINE_uint64(titan_blob_file_write_buffer_size,
+              rocksdb::titandb::TitanOptions().blob_file_write_buffer_size,
+              "Write buffer size of Titan blob files, 0 to use the default.");
+
+DEFINE_int32(titan_blob_file_format_version,
+             rocksdb::titandb::TitanOptions().blob_file_format_version,
+             "Format version of Titan sorted blob files. Version 2 packs "
+             "records into compressed blocks.");
+
+DEFINE_uint64(titan_blob_file_block_size,
+              rocksdb::titandb::TitanOptions().blob_file_block_size,
+              "Uncompressed block size of version 2 Titan blob files.");
+
+DEFINE_int32(titan_blob_file_max_dict_bytes, 0,
+             "Max dictionary size of version 2 Titan blob files, 0 to "
+             "compress without dictionary.");
+
+DEFINE_int32(titan_blob_file_zstd_max_train_bytes, 0,
+             "Bytes of blocks to train the zstd dictionary of version 2 "
+             "Titan blob files, 0 to use sampled blocks as dictionary.");
+
+DEFINE_int64(titan_blob_value_cache_size, 0,
+             "Size of Titan blob value cache, which only admits frequently "
+             "read values. Disabled by default.");
+
+DEFINE_int32(titan_blob_value_cache_min_frequency,
+             rocksdb::titandb::TitanOptions().blob_value_cache_min_frequency,
+             "Access frequency needed to be admitted into a full Titan "
+             "blob value cache.");
+
+DEFINE_uint64(titan_blob_io_bytes_per_sec, 0,
+              "Budget of Titan background blob I/O shared by flush, "
+              "compaction and GC. 0 means unlimited.");
+
+DEFINE_uint64(titan_blob_io_target_p99_micros, 0,
+              "If non-zero, the Titan blob I/O budget is lowered while the "
+              "p99 latency of foreground reads exceeds it.");
+
+DEFINE_string(titan_blob_dirs, "",
+              "Comma-separated directories the Titan blob files are striped "
+              "over, e.g. one per device. Empty to keep them in the Titan "
+              "dirname.");
+
+DEFINE_uint64(titan_max_manifest_file_size,
+              rocksdb::titandb::TitanOptions().titan_max_manifest_file_size,
+              "Size of the Titan manifest that triggers rewriting it as a "
+              "snapshot, 0 to only rewrite it on open.");
+
+DEFINE_bool(titan_verify_blob_files_on_open,
+            rocksdb::titandb::TitanOptions().verify_blob_files_on_open,
+            "Check the footers of all Titan blob files when opening the DB, "
+            "with --max_file_opening_threads threads.");
+
 DEFINE_uint64(blob_db_bytes_per_sync, 0, "Bytes to sync blob file at.");
 
 DEFINE_uint64(blob_db_file_size, 256 * 1024 * 1024,
@@ -2892,6 +2984,8 @@ class Benchmark {
         method = &Benchmark::Compact;
       } else if (name == "compactall") {
         CompactAll();
+      } else if (name == "open") {
+        ReopenDBs();
       } else if (name == "crc32c") {
         method = &Benchmark::Crc32c;
       } else if (name == "xxhash") {
@@ -3137,6 +3231,7 @@ class Benchmark {
 
     SetPerfLevel(static_cast<PerfLevel>(shared->perf_level));
     perf_context.EnablePerLevelPerfContext();
+    rocksdb::titandb::get_titan_perf_context()->Reset();
     thread->stats.Start(thread->tid);
     (arg->bm->*(arg->method))(thread);
     thread->stats.Stop();
@@ -3854,13 +3949,44 @@ class Benchmark {
 
     options.listeners.emplace_back(listener_);
     opts->min_blob_size = FLAGS_titan_min_blob_size;
+    opts->adaptive_blob_size = FLAGS_titan_adaptive_blob_size;
+    opts->inline_hot_value_frequency = FLAGS_titan_inline_hot_value_frequency;
+    opts->inline_hot_value_max_size = FLAGS_titan_inline_hot_value_max_size;
+    opts->blob_read_queue_depth =
+        static_cast<uint32_t>(FLAGS_titan_blob_read_queue_depth);
+    opts->block_write_size = FLAGS_titan_block_write_size;
+    opts->slowdown_write_size = FLAGS_titan_slowdown_write_size;
     opts->disable_background_gc = FLAGS_titan_disable_background_gc;
     opts->max_background_gc = FLAGS_titan_max_background_gc;
+    opts->max_gc_subjobs = FLAGS_titan_max_gc_subjobs;
     opts->min_gc_batch_size = 128 << 20;
     opts->blob_file_compression = FLAGS_compression_type_e;
+    opts->blob_file_use_direct_io = FLAGS_titan_blob_file_use_direct_io;
+    opts->blob_file_write_buffer_size = FLAGS_titan_blob_file_write_buffer_size;
+    opts->blob_file_format_version = FLAGS_titan_blob_file_format_version;
+    opts->blob_file_block_size = FLAGS_titan_blob_file_block_size;
+    opts->blob_file_compression_options.max_dict_bytes =
+        FLAGS_titan_blob_file_max_dict_bytes;
+    opts->blob_file_compression_options.zstd_max_train_bytes =
+        FLAGS_titan_blob_file_zstd_max_train_bytes;
     if (FLAGS_titan_blob_cache_size > 0) {
       opts->blob_cache = NewLRUCache(FLAGS_titan_blob_cache_size);
     }
+    if (FLAGS_titan_blob_value_cache_size > 0) {
+      opts->blob_value_cache = NewLRUCache(FLAGS_titan_blob_value_cache_size);
+      opts->blob_value_cache_min_frequency =
+          FLAGS_titan_blob_value_cache_min_frequency;
+    }
+    opts->titan_max_manifest_file_size = FLAGS_titan_max_manifest_file_size;
+    opts->verify_blob_files_on_open = FLAGS_titan_verify_blob_files_on_open;
+    if (FLAGS_titan_blob_io_bytes_per_sec > 0) {
+      opts->blob_io_scheduler = rocksdb::titandb::NewBlobIOScheduler(
+          FLAGS_titan_blob_io_bytes_per_sec,
+          FLAGS_titan_blob_io_target_p99_micros, FLAGS_env);
+    }
+    if (!FLAGS_titan_blob_dirs.empty()) {
+      opts->blob_dirs = rocksdb::StringSplit(FLAGS_titan_blob_dirs, ',');
+    }
     if (FLAGS_num_multi_db <= 1) {
       OpenDb(options, FLAGS_db, &db_);
     } else {
@@ -5285,7 +5411,10 @@ class Benchmark {
     thread->stats.AddBytes(bytes);
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
   }
 
@@ -5370,7 +5499,10 @@ class Benchmark {
 
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
   }
 
@@ -5464,7 +5596,10 @@ class Benchmark {
 
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
   }
 
@@ -5797,7 +5932,10 @@ class Benchmark {
 
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
   }
 
@@ -5931,7 +6069,10 @@ class Benchmark {
     thread->stats.AddMessage(msg);
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
   }
 
@@ -6688,7 +6829,10 @@ class Benchmark {
 
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
     thread->stats.AddBytes(static_cast<int64_t>(inserter.GetBytesInserted()));
   }
@@ -6850,7 +6994,10 @@ class Benchmark {
     thread->stats.AddMessage(msg);
     if (FLAGS_perf_level > rocksdb::PerfLevel::kDisable) {
       thread->stats.AddMessage(std::string("PERF_CONTEXT:\n") +
-                               get_perf_context()->ToString());
+                               get_perf_context()->ToString() +
+                               "\nTITAN_PERF_CONTEXT:\n" +
+                               rocksdb::titandb::get_titan_perf_context()
+                                   ->ToString());
     }
   }
 
@@ -6944,6 +7091,22 @@ class Benchmark {
     }
   }
 
+  // Closes the DBs and reports the time it takes to open them again, which
+  // includes recovering the Titan manifest.
+  void ReopenDBs() {
+    if (db_.db != nullptr) {
+      db_.DeleteDBs();
+    }
+    for (auto& db_with_cfh : multi_dbs_) {
+      db_with_cfh.DeleteDBs();
+    }
+    multi_dbs_.clear();
+    uint64_t start = FLAGS_env->NowMicros();
+    Open(&open_options_);
+    fprintf(stdout, "%-12s : %11.3f ms to reopen the DB\n", "open",
+            (FLAGS_env->NowMicros() - start) / 1000.0);
+  }
+
   void ResetStats() {
     if (db_.db != nullptr) {
       db_.db->ResetStats();
@@ -127,3 +127,25 @@ function terarkdb() {
         --${ycsb_params} 
 }
 
+
+# diffkv write stall: p99 write latency of fillrandom with writes stopped at
+# block_write_size, compared to writes delayed from 3/4 of it.
+function diffkv_write_stall() {
+    block_write_size=$((8 << 30))
+    for slowdown_write_size in ${block_write_size} 0; do
+        rm -rf ${db_dir}/*
+        rm ${wal_dir}/*
+        sync
+        echo 3 >/proc/sys/vm/drop_caches
+        ${DIFFKV_HOME}/build/titandb_bench \
+            ${const_params} \
+            --benchmarks=fillrandom,stats \
+            --statistics=true \
+            --use_titan=true \
+            --titan_max_background_gc=2 \
+            --titan_disable_background_gc=false \
+            --titan_block_write_size=${block_write_size} \
+            --titan_slowdown_write_size=${slowdown_write_size} |
+            grep -E "fillrandom|Percentiles|blob write stall|delayed:"
+    done
+}
@@ -52,7 +52,7 @@ TableBuilder* NewTableBuilder(
     const CompressionOptions& compression_opts, int level,
     double compaction_load, const std::string* compression_dict,
     bool skip_filters, uint64_t creation_time, uint64_t oldest_key_time,
-    SstPurpose sst_purpose) {
+    SstPurpose sst_purpose, bool one_entry_per_block) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
@@ -61,7 +61,8 @@ TableBuilder* NewTableBuilder(
                           int_tbl_prop_collector_factories, compression_type,
                           compression_opts, compression_dict, skip_filters,
                           column_family_name, level, compaction_load,
-                          creation_time, oldest_key_time, sst_purpose),
+                          creation_time, oldest_key_time, sst_purpose,
+                          one_entry_per_block),
       column_family_id, file);
 }
 
@@ -89,7 +90,8 @@ Status BuildTable(
     EventLogger* event_logger, int job_id, const Env::IOPriority io_priority,
     std::vector<TableProperties>* table_properties_vec, int level,
     double compaction_load, const uint64_t creation_time,
-    const uint64_t oldest_key_time, Env::WriteLifeTimeHint write_hint) {
+    const uint64_t oldest_key_time, Env::WriteLifeTimeHint write_hint,
+    Env::WriteLifeTimeHint blob_write_hint) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
@@ -171,11 +173,11 @@ Status BuildTable(
       void* trans_to_separate_callback_args = nullptr;
 
       Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                             const Slice& meta, bool is_merge,
-                             bool is_index) override {
+                             const Slice& meta, bool is_merge, bool is_index,
+                             const ValueHandle& handle) override {
         return SeparateHelper::TransToSeparate(
             internal_key, value, value.file_number(), meta, is_merge, is_index,
-            value_meta_extractor.get());
+            value_meta_extractor.get(), handle);
       }
 
       Status TransToSeparate(const Slice& internal_key,
@@ -273,7 +275,7 @@ Status BuildTable(
           return status;
         }
         blob_file->SetIOPriority(io_priority);
-        blob_file->SetWriteLifeTimeHint(write_hint);
+        blob_file->SetWriteLifeTimeHint(blob_write_hint);
 
         separate_helper.file_writer.reset(
             new WritableFileWriter(std::move(blob_file), fname, env_options,
@@ -283,7 +285,8 @@ Status BuildTable(
             int_tbl_prop_collector_factories_for_blob, column_family_id,
             column_family_name, separate_helper.file_writer.get(), compression,
             compression_opts, -1 /* level */, 0 /* compaction_load */, nullptr,
-            true));
+            true, 0 /* creation_time */, 0 /* oldest_key_time */, kEssenceSst,
+            mutable_cf_options.blob_offset_index));
         blob_builder = separate_helper.builder.get();
       }
       if (status.ok()) {
@@ -291,10 +294,12 @@ Status BuildTable(
       }
       if (status.ok()) {
         blob_meta->UpdateBoundaries(key, GetInternalKeySeqno(key));
+        ValueHandle handle;
+        blob_builder->GetLastEntryHandle(&handle);
         status = SeparateHelper::TransToSeparate(
             key, value, blob_meta->fd.GetNumber(), Slice(),
             GetInternalKeyType(key) == kTypeMerge, false,
-            separate_helper.value_meta_extractor.get());
+            separate_helper.value_meta_extractor.get(), handle);
       }
       return status;
     };
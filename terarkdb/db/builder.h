@@ -55,7 +55,8 @@ TableBuilder* NewTableBuilder(
     const CompressionOptions& compression_opts, int level,
     double compaction_load, const std::string* compression_dict = nullptr,
     bool skip_filters = false, uint64_t creation_time = 0,
-    uint64_t oldest_key_time = 0, SstPurpose sst_purpose = kEssenceSst);
+    uint64_t oldest_key_time = 0, SstPurpose sst_purpose = kEssenceSst,
+    bool one_entry_per_block = false);
 
 // Build a Table file from the contents of *iter.  The generated file
 // will be named according to number specified in meta. On success, the rest of
@@ -91,6 +92,7 @@ extern Status BuildTable(
     std::vector<TableProperties>* table_properties = nullptr, int level = -1,
     double compaction_load = 0, const uint64_t creation_time = 0,
     const uint64_t oldest_key_time = 0,
-    Env::WriteLifeTimeHint write_hint = Env::WLTH_NOT_SET);
+    Env::WriteLifeTimeHint write_hint = Env::WLTH_NOT_SET,
+    Env::WriteLifeTimeHint blob_write_hint = Env::WLTH_NOT_SET);
 
 }  // namespace TERARKDB_NAMESPACE
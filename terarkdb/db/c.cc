@@ -2487,6 +2487,16 @@ void rocksdb_options_set_max_dependence_blob_overlap(rocksdb_options_t* opt,
   opt->rep.max_dependence_blob_overlap = v;
 }
 
+void rocksdb_options_set_blob_offset_index(rocksdb_options_t* opt,
+                                           unsigned char v) {
+  opt->rep.blob_offset_index = v;
+}
+
+void rocksdb_options_set_map_sst_flatten_threshold(rocksdb_options_t* opt,
+                                                    uint64_t v) {
+  opt->rep.map_sst_flatten_threshold = v;
+}
+
 void rocksdb_options_set_maintainer_job_ratio(rocksdb_options_t* opt,
                                               double v) {
   opt->rep.maintainer_job_ratio = v;
@@ -3023,6 +3033,16 @@ void rocksdb_readoptions_set_readahead_size(rocksdb_readoptions_t* opt,
   opt->rep.readahead_size = v;
 }
 
+void rocksdb_readoptions_set_blob_lookahead(rocksdb_readoptions_t* opt,
+                                            size_t v) {
+  opt->rep.blob_lookahead = v;
+}
+
+void rocksdb_readoptions_set_blob_readahead_budget(rocksdb_readoptions_t* opt,
+                                                   size_t v) {
+  opt->rep.blob_readahead_budget = v;
+}
+
 void rocksdb_readoptions_set_prefix_same_as_start(rocksdb_readoptions_t* opt,
                                                   unsigned char v) {
   opt->rep.prefix_same_as_start = v;
@@ -423,6 +423,7 @@ ColumnFamilyData::ColumnFamilyData(
       initialized_(false),
       dropped_(false),
       optimize_filters_for_hits_(cf_options.optimize_filters_for_hits),
+      map_sst_flatten_requested_(false),
       internal_comparator_(cf_options.comparator),
       initial_cf_options_(SanitizeOptions(db_options, cf_options)),
       ioptions_(db_options, initial_cf_options_),
@@ -995,11 +996,13 @@ Compaction* ColumnFamilyData::PickCompaction(
 }
 
 Compaction* ColumnFamilyData::PickGarbageCollection(
-    const MutableCFOptions& mutable_options, LogBuffer* log_buffer) {
+    const MutableCFOptions& mutable_options, uint32_t max_subcompactions,
+    LogBuffer* log_buffer) {
   StopWatch sw(ioptions_.env, ioptions_.statistics,
                PICK_GARBAGE_COLLECTION_TIME);
   auto* result = compaction_picker_->PickGarbageCollection(
-      GetName(), mutable_options, current_->storage_info(), log_buffer);
+      GetName(), mutable_options, current_->storage_info(), max_subcompactions,
+      log_buffer);
   if (result != nullptr) {
     result->SetInputVersion(current_);
     result->set_compaction_load(0);
@@ -1296,6 +1299,22 @@ Env::WriteLifeTimeHint ColumnFamilyData::CalculateSSTWriteHint(int level) {
       level - base_level + static_cast<int>(Env::WLTH_MEDIUM));
 }
 
+Env::WriteLifeTimeHint ColumnFamilyData::CalculateBlobWriteHint(
+    int generation) {
+  // Blob ssts don't die with their level but as their values get overwritten,
+  // so classify them by the garbage rate this cf currently observes. Values
+  // that survived a rewrite are likelier to live on, push them one class up.
+  double garbage_ratio = current_->storage_info()->total_garbage_ratio();
+  int hint = static_cast<int>(Env::WLTH_LONG);
+  if (garbage_ratio >= 0.5) {
+    hint = static_cast<int>(Env::WLTH_SHORT);
+  } else if (garbage_ratio >= GetLatestMutableCFOptions()->blob_gc_ratio) {
+    hint = static_cast<int>(Env::WLTH_MEDIUM);
+  }
+  return static_cast<Env::WriteLifeTimeHint>(
+      std::min(hint + generation, static_cast<int>(Env::WLTH_EXTREME)));
+}
+
 Status ColumnFamilyData::AddDirectories() {
   Status s;
   assert(data_dirs_.empty());
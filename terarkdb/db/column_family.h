@@ -278,7 +278,10 @@ class ColumnFamilyData {
                              const std::vector<SequenceNumber>& snapshots,
                              LogBuffer* log_buffer);
 
+  // "max_subcompactions" is the number of subcompactions the job can run,
+  // which sizes the pick.
   Compaction* PickGarbageCollection(const MutableCFOptions& mutable_options,
+                                    uint32_t max_subcompactions,
                                     LogBuffer* log_buffer);
   // Check if the passed range overlap with any running compactions.
   // REQUIRES: DB mutex held
@@ -383,6 +386,17 @@ class ColumnFamilyData {
     return queued_for_garbage_collection_;
   }
 
+  // Set by a read that found a map sst range worth flattening, taken by the
+  // reader to schedule the compaction. Not protected by DB mutex
+  void RequestMapSstFlatten() {
+    map_sst_flatten_requested_.store(true, std::memory_order_relaxed);
+  }
+  bool TakeMapSstFlattenRequest() {
+    return map_sst_flatten_requested_.load(std::memory_order_relaxed) &&
+           map_sst_flatten_requested_.exchange(false,
+                                               std::memory_order_relaxed);
+  }
+
   enum class WriteStallCause {
     kNone,
     kMemtableLimit,
@@ -415,6 +429,10 @@ class ColumnFamilyData {
 
   Env::WriteLifeTimeHint CalculateSSTWriteHint(int level);
 
+  // Lifetime hint for a blob sst. generation counts the rewrites its values
+  // already survived: 0 for flush, 1 for compaction, 2 for garbage collection.
+  Env::WriteLifeTimeHint CalculateBlobWriteHint(int generation);
+
   Status AddDirectories();
 
   Directory* GetDataDir(size_t path_id) const;
@@ -438,6 +456,7 @@ class ColumnFamilyData {
   std::atomic<bool> initialized_;
   std::atomic<bool> dropped_;                    // true if client dropped it
   std::atomic<bool> optimize_filters_for_hits_;  // for read output mutex
+  std::atomic<bool> map_sst_flatten_requested_;
 
   const InternalKeyComparator internal_comparator_;
   const ColumnFamilyOptions initial_cf_options_;
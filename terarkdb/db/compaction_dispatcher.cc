@@ -18,6 +18,19 @@
 #include <inttypes.h>
 
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#ifndef OS_WIN
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #ifdef WITH_TERARK_ZIP
 #include <terark/num_to_str.hpp>
@@ -45,6 +58,8 @@
 #include "table/two_level_iterator.h"
 #include "util/c_style_callback.h"
 #include "util/filename.h"
+#include "util/string_util.h"
+#include "util/sync_point.h"
 
 #ifndef WITH_TERARK_ZIP
 #define USE_AJSON 1
@@ -272,11 +287,11 @@ class WorkerSeparateHelper : public SeparateHelper, public LazyBufferState {
 
   using SeparateHelper::TransToSeparate;
   Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                         const Slice& meta, bool is_merge,
-                         bool is_index) override {
+                         const Slice& meta, bool is_merge, bool is_index,
+                         const ValueHandle& handle) override {
     return SeparateHelper::TransToSeparate(
         internal_key, value, value.file_number(), meta, is_merge, is_index,
-        value_meta_extractor_.get());
+        value_meta_extractor_.get(), handle);
   }
 
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
@@ -1178,4 +1193,301 @@ std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
   return std::make_shared<CommandLineCompactionDispatcher>(std::move(cmd));
 }
 
+#ifndef OS_WIN
+class LocalProcessCompactionDispatcher : public RemoteCompactionDispatcher {
+ public:
+  explicit LocalProcessCompactionDispatcher(
+      const LocalCompactionDispatcherOptions& options)
+      : options_(options), running_(0), shutdown_(false) {
+    options_.num_workers = std::max<size_t>(options_.num_workers, 1);
+    options_.max_pending_jobs =
+        std::max(options_.max_pending_jobs, options_.num_workers);
+    for (size_t i = 0; i < options_.num_workers; ++i) {
+      threads_.emplace_back(&LocalProcessCompactionDispatcher::BGWork, this);
+    }
+  }
+
+  ~LocalProcessCompactionDispatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+    }
+    job_cv_.notify_all();
+    slot_cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    for (auto& job : jobs_) {
+      job->promise.set_value(make_error(Status::ShutdownInProgress()));
+    }
+  }
+
+  std::future<std::string> DoCompaction(std::string data) override {
+    std::unique_ptr<Job> job(new Job);
+    job->data = std::move(data);
+    if (options_.worker_command.empty()) {
+      // Forked workers put their outputs next to the db files, where the
+      // compaction job renames them
+      CompactionWorkerContext context;
+      ajson::load_from_buff(context, Slice(job->data));
+      job->output_dir =
+          context.cf_paths.empty() ? "." : context.cf_paths.front();
+    }
+    std::future<std::string> future = job->promise.get_future();
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_cv_.wait(lock, [this] {
+      return shutdown_ || jobs_.size() + running_ < options_.max_pending_jobs;
+    });
+    if (shutdown_) {
+      job->promise.set_value(make_error(Status::ShutdownInProgress()));
+    } else {
+      jobs_.emplace_back(std::move(job));
+      job_cv_.notify_one();
+    }
+    return future;
+  }
+
+  const char* Name() const override {
+    return "LocalProcessCompactionDispatcher";
+  }
+
+ private:
+  struct Job {
+    std::string data;
+    std::string output_dir;
+    std::promise<std::string> promise;
+  };
+
+  class ForkedWorker : public Worker {
+   public:
+    ForkedWorker(const LocalCompactionDispatcherOptions& options,
+                 const std::string& output_dir)
+        : Worker(options.env_options, options.env), output_dir_(output_dir) {}
+
+    std::string GenerateOutputFileName(size_t file_index) override {
+      return output_dir_ + "/" + OutputFilePrefix(getpid()) +
+             ToString(file_index);
+    }
+
+   private:
+    std::string output_dir_;
+  };
+
+  static std::string OutputFilePrefix(pid_t pid) {
+    return "compaction-worker-" + ToString(pid) + "-";
+  }
+
+  static bool WriteAll(int fd, const std::string& data) {
+    for (size_t pos = 0; pos < data.size();) {
+      ssize_t len = ::write(fd, data.data() + pos, data.size() - pos);
+      if (len < 0 && errno == EINTR) {
+        continue;
+      }
+      if (len <= 0) {
+        return false;
+      }
+      pos += len;
+    }
+    return true;
+  }
+
+  static void ReadAll(int fd, std::string* data) {
+    char buf[65536];
+    for (;;) {
+      ssize_t len = ::read(fd, buf, sizeof buf);
+      if (len < 0 && errno == EINTR) {
+        continue;
+      }
+      if (len <= 0) {
+        return;
+      }
+      data->append(buf, len);
+    }
+  }
+
+  void BGWork() {
+    // A worker dying before it reads its job must not take us down with it
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      job_cv_.wait(lock, [this] { return shutdown_ || !jobs_.empty(); });
+      if (shutdown_) {
+        break;
+      }
+      std::unique_ptr<Job> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      ++running_;
+      lock.unlock();
+
+      std::string result;
+      Status s;
+      for (int attempt = 0;; ++attempt) {
+        s = RunWorker(*job, &result);
+        if (s.ok() || attempt >= options_.max_retries) {
+          break;
+        }
+        result.clear();
+      }
+      job->promise.set_value(s.ok() ? std::move(result)
+                                    : make_error(std::move(s)));
+
+      lock.lock();
+      --running_;
+      slot_cv_.notify_one();
+    }
+  }
+
+  Status RunWorker(const Job& job, std::string* result) {
+    bool kill_worker = false;
+    TEST_SYNC_POINT_CALLBACK("LocalProcessCompactionDispatcher::RunWorker",
+                             &kill_worker);
+    int job_pipe[2], result_pipe[2];
+    pid_t pid;
+    {
+      // Pipes are made and workers forked under one lock, so a forked worker
+      // knows every pipe end it must not hold open
+      std::lock_guard<std::mutex> lock(fork_mutex_);
+      if (pipe(job_pipe) != 0) {
+        return Status::IOError("LocalProcessCompactionDispatcher pipe",
+                               strerror(errno));
+      }
+      if (pipe(result_pipe) != 0) {
+        Status s = Status::IOError("LocalProcessCompactionDispatcher pipe",
+                                   strerror(errno));
+        close(job_pipe[0]);
+        close(job_pipe[1]);
+        return s;
+      }
+      fcntl(job_pipe[1], F_SETFD, FD_CLOEXEC);
+      fcntl(result_pipe[0], F_SETFD, FD_CLOEXEC);
+      pid = fork();
+      if (pid == 0) {
+        RunChild(job, job_pipe, result_pipe);
+      }
+      close(job_pipe[0]);
+      close(result_pipe[1]);
+      if (pid < 0) {
+        Status s = Status::IOError("LocalProcessCompactionDispatcher fork",
+                                   strerror(errno));
+        close(job_pipe[1]);
+        close(result_pipe[0]);
+        return s;
+      }
+      parent_fds_.insert(job_pipe[1]);
+      parent_fds_.insert(result_pipe[0]);
+    }
+    if (kill_worker) {
+      kill(pid, SIGKILL);
+    }
+    // A worker that died early makes this fail with EPIPE, waitpid tells why
+    WriteAll(job_pipe[1], job.data);
+    close(job_pipe[1]);
+    ReadAll(result_pipe[0], result);
+    close(result_pipe[0]);
+    {
+      std::lock_guard<std::mutex> lock(fork_mutex_);
+      parent_fds_.erase(job_pipe[1]);
+      parent_fds_.erase(result_pipe[0]);
+    }
+    int wstatus = 0;
+    while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {
+    }
+
+    Status s;
+    if (WIFSIGNALED(wstatus)) {
+      s = Status::Aborted("Compaction worker killed by signal",
+                          ToString(WTERMSIG(wstatus)));
+    } else if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+      s = Status::Aborted("Compaction worker failed",
+                          "exit code " + ToString(WEXITSTATUS(wstatus)));
+    } else if (result->empty()) {
+      s = Status::Aborted("Compaction worker returned nothing");
+    }
+    if (!s.ok() && !job.output_dir.empty()) {
+      // Drop whatever the dead worker left behind
+      std::vector<std::string> children;
+      std::string prefix = OutputFilePrefix(pid);
+      if (options_.env->GetChildren(job.output_dir, &children).ok()) {
+        for (auto& child : children) {
+          if (Slice(child).starts_with(prefix)) {
+            options_.env->DeleteFile(job.output_dir + "/" + child);
+          }
+        }
+      }
+    }
+    return s;
+  }
+
+  // Runs in the forked worker, never returns
+  void RunChild(const Job& job, int job_pipe[2], int result_pipe[2]) {
+    dup2(job_pipe[0], STDIN_FILENO);
+    dup2(result_pipe[1], STDOUT_FILENO);
+    close(job_pipe[0]);
+    close(job_pipe[1]);
+    close(result_pipe[0]);
+    close(result_pipe[1]);
+    for (int fd : parent_fds_) {
+      close(fd);
+    }
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_UNBLOCK, &sigpipe, nullptr);
+
+    if (options_.worker_memory_limit != 0) {
+      rlim_t limit = options_.worker_memory_limit;
+      if (options_.worker_command.empty()) {
+        // A fork starts with all of our mappings
+        FILE* statm = fopen("/proc/self/statm", "r");
+        unsigned long pages = 0;
+        if (statm != nullptr) {
+          if (fscanf(statm, "%lu", &pages) == 1) {
+            limit += rlim_t(pages) * sysconf(_SC_PAGESIZE);
+          }
+          fclose(statm);
+        }
+      }
+      struct rlimit rl;
+      rl.rlim_cur = rl.rlim_max = limit;
+      setrlimit(RLIMIT_AS, &rl);
+    }
+    if (!options_.worker_command.empty()) {
+      execl("/bin/sh", "sh", "-c", options_.worker_command.c_str(),
+            (char*)nullptr);
+      _exit(127);
+    }
+    std::string data, result;
+    ReadAll(STDIN_FILENO, &data);
+    ForkedWorker worker(options_, job.output_dir);
+    result = worker.DoCompaction(data);
+    _exit(WriteAll(STDOUT_FILENO, result) ? 0 : 1);
+  }
+
+  LocalCompactionDispatcherOptions options_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable slot_cv_;
+  std::deque<std::unique_ptr<Job>> jobs_;
+  size_t running_;
+  bool shutdown_;
+  std::mutex fork_mutex_;
+  std::unordered_set<int> parent_fds_;
+};
+#endif  // !OS_WIN
+
+std::shared_ptr<CompactionDispatcher> NewLocalProcessCompactionDispatcher(
+    const LocalCompactionDispatcherOptions& options) {
+#ifndef OS_WIN
+  return std::make_shared<LocalProcessCompactionDispatcher>(options);
+#else
+  (void)options;
+  return nullptr;
+#endif
+}
+
 }  // namespace TERARKDB_NAMESPACE
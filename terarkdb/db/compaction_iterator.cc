@@ -235,6 +235,7 @@ void CompactionIterator::Next() {
       key_ = merge_out_iter_.key();
       value_ = LazyBufferReference(merge_out_iter_.value());
       value_meta_.clear();
+      value_handle_ = ValueHandle();
       bool valid_key __attribute__((__unused__));
       valid_key = ParseInternalKey(key_, &ikey_);
       // MergeUntil stops when it encounters a corrupt key and does not
@@ -390,7 +391,8 @@ void CompactionIterator::NextFromInput() {
       // First occurrence of this user key
       // Copy key for output
       key_ = current_key_.SetInternalKey(key_, &ikey_);
-      value_ = input_.value(current_key_.GetUserKey(), &value_meta_);
+      value_ = input_.value(current_key_.GetUserKey(), &value_meta_,
+                           &value_handle_);
       current_user_key_ = ikey_.user_key;
       has_current_user_key_ = true;
       has_outputted_key_ = false;
@@ -413,7 +415,8 @@ void CompactionIterator::NextFromInput() {
       // if we have versions on both sides of a snapshot
       current_key_.UpdateInternalKey(ikey_.sequence, ikey_.type);
       key_ = current_key_.GetInternalKey();
-      value_ = input_.value(current_key_.GetUserKey(), &value_meta_);
+      value_ = input_.value(current_key_.GetUserKey(), &value_meta_,
+                           &value_handle_);
       ikey_.user_key = current_key_.GetUserKey();
 
       // Note that newer version of a key is ordered before older versions. If a
@@ -692,6 +695,7 @@ void CompactionIterator::NextFromInput() {
         key_ = merge_out_iter_.key();
         value_ = LazyBufferReference(merge_out_iter_.value());
         value_meta_.clear();
+        value_handle_ = ValueHandle();
         bool valid_key __attribute__((__unused__));
         valid_key = ParseInternalKey(key_, &ikey_);
         // MergeUntil stops when it encounters a corrupt key and does not
@@ -810,7 +814,7 @@ void CompactionIterator::PrepareOutput() {
       current_key_.UpdateInternalKey(ikey_.sequence, ikey_.type);
       s = input_.separate_helper()->TransToSeparate(
           current_key_.GetInternalKey(), value_, value_meta_,
-          ikey_.type == kTypeMergeIndex, false);
+          ikey_.type == kTypeMergeIndex, false, ValueHandle());
       if (!s.ok()) {
         valid_ = false;
         status_ = std::move(s);
@@ -843,7 +847,7 @@ void CompactionIterator::PrepareOutput() {
     } else {
       auto s = input_.separate_helper()->TransToSeparate(
           current_key_.GetInternalKey(), value_, value_meta_,
-          ikey_.type == kTypeMergeIndex, true);
+          ikey_.type == kTypeMergeIndex, true, value_handle_);
       if (!s.ok()) {
         valid_ = false;
         status_ = std::move(s);
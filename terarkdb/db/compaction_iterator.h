@@ -179,6 +179,7 @@ class CompactionIterator {
   // current output.
   LazyBuffer value_;
   std::string value_meta_;
+  ValueHandle value_handle_;
   // The status is OK unless compaction iterator encounters a merge operand
   // while not having a merge operator defined.
   Status status_;
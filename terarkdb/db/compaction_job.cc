@@ -219,6 +219,9 @@ struct CompactionJob::SubcompactionState {
   // A flag determine whether the key has been seen in ShouldStopBefore()
   bool seen_key = false;
   std::string compression_dict;
+  // The blob ssts a garbage collection subcompaction rewrites. No two
+  // subcompactions share an input blob sst.
+  std::vector<FileMetaData*> garbage_collection_inputs;
 
   SubcompactionState(Compaction* c, const Slice* _start, const Slice* _end,
                      uint64_t size = 0)
@@ -264,6 +267,7 @@ struct CompactionJob::SubcompactionState {
     overlapped_bytes = std::move(o.overlapped_bytes);
     seen_key = std::move(o.seen_key);
     compression_dict = std::move(o.compression_dict);
+    garbage_collection_inputs = std::move(o.garbage_collection_inputs);
     return *this;
   }
 
@@ -710,7 +714,8 @@ CompactionJob::CompactionJob(
       bottommost_level_(false),
       paranoid_file_checks_(paranoid_file_checks),
       measure_io_stats_(measure_io_stats),
-      write_hint_(Env::WLTH_NOT_SET) {
+      write_hint_(Env::WLTH_NOT_SET),
+      blob_write_hint_(Env::WLTH_NOT_SET) {
   assert(log_buffer_ != nullptr);
   const auto* cfd = compact_->compaction->column_family_data();
   ThreadStatusUtil::SetColumnFamily(cfd, cfd->ioptions()->env,
@@ -776,10 +781,17 @@ int CompactionJob::Prepare(int sub_compaction_slots) {
              compact_->compaction->level()) > 0);
   write_hint_ =
       c->column_family_data()->CalculateSSTWriteHint(c->output_level());
+  blob_write_hint_ = c->column_family_data()->CalculateBlobWriteHint(
+      c->compaction_type() == kGarbageCollection ? 2 : 1);
   // Is this compaction producing files at the bottommost level?
   bottommost_level_ = c->bottommost_level();
 
-  if (c->compaction_type() != kMapCompaction && !c->input_range().empty()) {
+  if (c->compaction_type() == kGarbageCollection) {
+    GenGarbageCollectionInputs(sub_compaction_slots + 1);
+    MeasureTime(stats_, NUM_SUBCOMPACTIONS_SCHEDULED,
+                compact_->sub_compact_states.size());
+  } else if (c->compaction_type() != kMapCompaction &&
+             !c->input_range().empty()) {
     auto& input_range = c->input_range();
     size_t n =
         std::min({uint32_t(sub_compaction_slots + 1),
@@ -978,6 +990,57 @@ void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads) {
   }
 }
 
+// Splits the input blob ssts of a garbage collection into groups of
+// neighboring key ranges with a similar amount of live data, one group per
+// subcompaction. Every value of an input must go to the same output, as the
+// dependence map sends each file number to a single blob sst, so unlike
+// GenSubcompactionBoundaries this never splits a file.
+void CompactionJob::GenGarbageCollectionInputs(int max_usable_threads) {
+  auto* c = compact_->compaction;
+  assert(c->num_input_levels() == 1 && c->level() == -1);
+  const Comparator* ucmp = c->column_family_data()->user_comparator();
+  std::vector<FileMetaData*> files = c->inputs()->front().files;
+  std::sort(files.begin(), files.end(),
+            [ucmp](const FileMetaData* l, const FileMetaData* r) {
+              return ucmp->Compare(l->smallest.user_key(),
+                                   r->smallest.user_key()) < 0;
+            });
+  std::vector<uint64_t> live_sizes;
+  uint64_t sum = 0;
+  for (auto f : files) {
+    uint64_t num_entries = std::max<uint64_t>(1, f->prop.num_entries);
+    uint64_t num_live =
+        num_entries - std::min(num_entries, f->num_antiquation);
+    live_sizes.emplace_back(f->fd.GetFileSize() * num_live / num_entries);
+    sum += live_sizes.back();
+  }
+  size_t subcompactions =
+      std::min({size_t(std::max(1, max_usable_threads)), files.size(),
+                size_t(c->max_subcompactions())});
+
+  // Greedily add files to the subcompaction until the sum of their live
+  // sizes becomes >= the expected mean size of a subcompaction
+  double mean = sum * 1.0 / subcompactions;
+  std::vector<FileMetaData*> group;
+  uint64_t group_size = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    group.emplace_back(files[i]);
+    group_size += live_sizes[i];
+    size_t files_left = files.size() - i - 1;
+    if (files_left == 0 ||
+        (subcompactions > 1 && group_size >= mean &&
+         files_left >= subcompactions - 1)) {
+      compact_->sub_compact_states.emplace_back(c, nullptr, nullptr,
+                                                group_size);
+      compact_->sub_compact_states.back().garbage_collection_inputs =
+          std::move(group);
+      group.clear();
+      group_size = 0;
+      --subcompactions;
+    }
+  }
+}
+
 static std::shared_ptr<CompactionDispatcher> GetCmdLineDispatcher() {
   const char* cmdline = getenv("TerarkDB_compactionWorkerCommandLine");
   if (cmdline) {
@@ -1134,7 +1197,8 @@ Status CompactionJob::Run() {
     }
     results_fn.emplace_back(dispatcher->StartCompaction(context));
   }
-  Status status = Status::Corruption();
+  // The first failed sub compaction fails the job
+  Status status;
   for (size_t i = 0; i < compact_->sub_compact_states.size(); ++i) {
     auto& sub_compact = compact_->sub_compact_states[i];
     CompactionWorkerResult result;
@@ -1216,16 +1280,14 @@ Status CompactionJob::Run() {
           sub_compact.actual_end = std::move(result.actual_end);
         }
       }
-      if (s.ok()) {
-        status = Status::OK();
-      } else {
+      if (!s.ok()) {
         ROCKS_LOG_ERROR(
             db_options_.info_log,
             "[%s] [JOB %d] remote sub_compact failed with status = %s",
             sub_compact.compaction->column_family_data()->GetName().c_str(),
             job_id_, s.ToString().c_str());
         LogFlush(db_options_.info_log);
-        if (!status.ok()) {
+        if (status.ok()) {
           status = s;
         }
       }
@@ -1237,7 +1299,7 @@ Status CompactionJob::Run() {
           sub_compact.compaction->column_family_data()->GetName().c_str(),
           job_id_, ex.what());
       LogFlush(db_options_.info_log);
-      if (!status.ok()) {
+      if (status.ok()) {
         status = Status::Corruption("remote sub_compact failed with exception",
                                     ex.what());
       }
@@ -1247,6 +1309,8 @@ Status CompactionJob::Run() {
   if (status.ok()) {
     status = VerifyFiles();
   }
+  // Install() reads the outcome from here, as it does after RunSelf()
+  compact_->status = status;
   return status;
 }
 
@@ -1588,11 +1652,11 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     void* trans_to_separate_callback_args = nullptr;
 
     Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                           const Slice& meta, bool is_merge,
-                           bool is_index) override {
+                           const Slice& meta, bool is_merge, bool is_index,
+                           const ValueHandle& handle) override {
       return SeparateHelper::TransToSeparate(
           internal_key, value, value.file_number(), meta, is_merge, is_index,
-          value_meta_extractor.get());
+          value_meta_extractor.get(), handle);
     }
 
     Status TransToSeparate(const Slice& key, LazyBuffer& value) override {
@@ -1639,10 +1703,12 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     }
     if (s.ok()) {
       blob_meta->UpdateBoundaries(key, GetInternalKeySeqno(key));
+      ValueHandle handle;
+      blob_builder->GetLastEntryHandle(&handle);
       s = SeparateHelper::TransToSeparate(
           key, value, blob_meta->fd.GetNumber(), Slice(),
           GetInternalKeyType(key) == kTypeMerge, false,
-          separate_helper.value_meta_extractor.get());
+          separate_helper.value_meta_extractor.get(), handle);
     }
     return s;
   };
@@ -2038,12 +2104,42 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   sub_compact->status = status;
 }  // namespace TERARKDB_NAMESPACE
 
+InternalIterator* CompactionJob::NewGarbageCollectionInputIterator(
+    const SubcompactionState* sub_compact) {
+  auto c = sub_compact->compaction;
+  auto cfd = c->column_family_data();
+  ReadOptions read_options;
+  read_options.verify_checksums = true;
+  read_options.fill_cache = false;
+  read_options.total_order_seek = true;
+  auto& files = sub_compact->garbage_collection_inputs;
+  auto& dependence_map = c->input_version()->storage_info()->dependence_map();
+  std::vector<InternalIterator*> list;
+  list.reserve(files.size());
+  for (auto f : files) {
+    list.emplace_back(cfd->table_cache()->NewIterator(
+        read_options, env_options_for_read_, *f, dependence_map,
+        nullptr /* range_del_agg */,
+        c->mutable_cf_options()->prefix_extractor.get(),
+        nullptr /* table_reader_ptr */,
+        nullptr /* no per level latency histogram */,
+        true /* for_compaction */, nullptr /* arena */,
+        false /* skip_filters */, -1 /* level */));
+  }
+  return NewMergingIterator(&cfd->internal_comparator(), list.data(),
+                            static_cast<int>(list.size()));
+}
+
 void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   assert(sub_compact != nullptr);
   ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
+  auto& files = sub_compact->garbage_collection_inputs;
+  assert(!files.empty());
+  TEST_SYNC_POINT_CALLBACK("CompactionJob::ProcessGarbageCollection:Inputs",
+                           &files);
 
-  std::unique_ptr<InternalIterator> input(versions_->MakeInputIterator(
-      sub_compact->compaction, nullptr, env_options_for_read_));
+  std::unique_ptr<InternalIterator> input(
+      NewGarbageCollectionInputIterator(sub_compact));
 
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
@@ -2073,8 +2169,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   std::mutex conflict_map_mutex;
 
   auto create_iter = [&](Arena* /* arena */) {
-    return versions_->MakeInputIterator(sub_compact->compaction, nullptr,
-                                        env_options_for_read_);
+    return NewGarbageCollectionInputIterator(sub_compact);
   };
   auto filter_conflict = [&](const Slice& ikey, const LazyBuffer& value) {
     std::lock_guard<std::mutex> lock(conflict_map_mutex);
@@ -2107,8 +2202,13 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
     uint64_t file_number_mismatch = 0;
   } counter;
   std::vector<std::pair<uint64_t, FileMetaData*>> blob_meta_cache;
-  assert(!sub_compact->compaction->inputs()->empty());
-  blob_meta_cache.reserve(sub_compact->compaction->inputs()->front().size());
+  blob_meta_cache.reserve(files.size());
+  // Input keys come in order, so liveness lookups share cursors
+  Version::SortedKeyGetter key_getter(input_version);
+  bool report_detailed_time = ShouldReportDetailedTime(env_, stats_);
+  StopWatchNano phase_timer(env_);
+  uint64_t probe_nanos = 0;
+  uint64_t rewrite_nanos = 0;
   while (status.ok() && !cfd->IsDropped() && input->Valid()) {
     ++counter.input;
     Slice curr_key = input->key();
@@ -2138,6 +2238,9 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
       blob_meta_cache.emplace_back(blob_file_number, blob_meta);
       assert(blob_meta->fd.GetNumber() == blob_file_number);
     }
+    if (report_detailed_time) {
+      phase_timer.Start();
+    }
     do {
       if (ikey.type != kTypeValue && ikey.type != kTypeMerge) {
         ++counter.garbage_type;
@@ -2148,8 +2251,8 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
       ValueType type = kTypeDeletion;
       SequenceNumber seq = kMaxSequenceNumber;
       LazyBuffer value;
-      input_version->GetKey(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
-                            &seq, &value, *blob_meta);
+      key_getter.GetKey(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
+                        &seq, &value, *blob_meta);
       if (s.IsNotFound()) {
         ++counter.get_not_found;
         break;
@@ -2177,6 +2280,9 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
         break;
       }
       curr_file_number = value.file_number();
+      if (report_detailed_time) {
+        probe_nanos += phase_timer.ElapsedNanos(true);
+      }
 
       assert(sub_compact->blob_builder != nullptr);
       assert(sub_compact->current_blob_output() != nullptr);
@@ -2188,6 +2294,10 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
                                                                 ikey.sequence);
       sub_compact->num_output_records++;
     } while (false);
+    if (report_detailed_time) {
+      (curr_file_number != uint64_t(-1) ? rewrite_nanos : probe_nanos) +=
+          phase_timer.ElapsedNanos();
+    }
 
     if (counter.input > 1 && comp.Compare(curr_key, last_key) == 0 &&
         (last_file_number & curr_file_number) != uint64_t(-1)) {
@@ -2212,12 +2322,19 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   if (status.ok()) {
     status = input->status();
   }
+  if (report_detailed_time) {
+    MeasureTime(stats_, GC_PROBE_TIME, probe_nanos / 1000);
+    MeasureTime(stats_, GC_REWRITE_TIME, rewrite_nanos / 1000);
+  }
   std::vector<uint64_t> inheritance_tree;
   size_t inheritance_tree_pruge_count = 0;
   if (status.ok()) {
-    status = BuildInheritanceTree(
-        *sub_compact->compaction->inputs(), dependence_map, input_version,
-        &inheritance_tree, &inheritance_tree_pruge_count);
+    std::vector<CompactionInputFiles> inputs(1);
+    inputs.front().level = -1;
+    inputs.front().files = files;
+    status = BuildInheritanceTree(inputs, dependence_map, input_version,
+                                  &inheritance_tree,
+                                  &inheritance_tree_pruge_count);
   }
   Status s = FinishCompactionOutputBlob(status, sub_compact, inheritance_tree);
   if (status.ok()) {
@@ -2225,9 +2342,10 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   }
   if (status.ok()) {
     auto& meta = sub_compact->blob_outputs.front().meta;
-    auto& inputs = *sub_compact->compaction->inputs();
-    assert(inputs.size() == 1 && inputs.front().level == -1);
-    auto& files = inputs.front().files;
+    uint64_t num_antiquation = 0;
+    for (auto f : files) {
+      num_antiquation += f->num_antiquation;
+    }
     ROCKS_LOG_INFO(
         db_options_.info_log,
         "[%s] [JOB %d] Table #%" PRIu64 " GC: %" PRIu64
@@ -2237,7 +2355,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
         " file number mismatch ], inheritance tree: %zd -> %zd",
         cfd->GetName().c_str(), job_id_, meta.fd.GetNumber(), counter.input,
         files.size(), counter.input - meta.prop.num_entries,
-        sub_compact->compaction->num_antiquation() * 100. / counter.input,
+        num_antiquation * 100. / counter.input,
         counter.garbage_type, counter.get_not_found,
         counter.file_number_mismatch,
         meta.prop.inheritance.size() + inheritance_tree_pruge_count,
@@ -3030,7 +3148,7 @@ Status CompactionJob::OpenCompactionOutputBlob(
 
   sub_compact->blob_outputs.push_back(out);
   writable_file->SetIOPriority(Env::IO_LOW);
-  writable_file->SetWriteLifeTimeHint(write_hint_);
+  writable_file->SetWriteLifeTimeHint(blob_write_hint_);
   writable_file->SetPreallocationBlockSize(static_cast<size_t>(
       sub_compact->compaction->OutputFilePreallocationSize()));
   const auto& listeners =
@@ -3065,7 +3183,11 @@ Status CompactionJob::OpenCompactionOutputBlob(
       sub_compact->compaction->output_compression(),
       sub_compact->compaction->output_compression_opts(), -1 /* level */,
       c->compaction_load(), nullptr, true /* skip_filters */,
-      output_file_creation_time, 0 /* oldest_key_time */, kEssenceSst));
+      output_file_creation_time, 0 /* oldest_key_time */, kEssenceSst,
+      // GC outputs are reached through the dependence map, whose value
+      // indexes still name the old blob ssts, so handles would be useless.
+      moptions.blob_offset_index &&
+          c->compaction_type() != kGarbageCollection));
   LogFlush(db_options_.info_log);
   return s;
 }
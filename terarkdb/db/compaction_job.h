@@ -115,6 +115,7 @@ class CompactionJob {
 
   void AggregateStatistics();
   void GenSubcompactionBoundaries(int max_usable_threads);
+  void GenGarbageCollectionInputs(int max_usable_threads);
 
   // update the thread status for starting a compaction.
   void ReportStartedCompaction(Compaction* compaction);
@@ -124,6 +125,8 @@ class CompactionJob {
   void ProcessCompaction(SubcompactionState* sub_compact);
   void ProcessKeyValueCompaction(SubcompactionState* sub_compact);
   void ProcessGarbageCollection(SubcompactionState* sub_compact);
+  InternalIterator* NewGarbageCollectionInputIterator(
+      const SubcompactionState* sub_compact);
 
   Status FinishCompactionOutputFile(
       const Status& input_status, SubcompactionState* sub_compact,
@@ -200,6 +203,7 @@ class CompactionJob {
   // Stores the approx size of keys covered in the range of each subcompaction
   std::vector<uint64_t> sizes_;
   Env::WriteLifeTimeHint write_hint_;
+  Env::WriteLifeTimeHint blob_write_hint_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -17,6 +17,7 @@
 
 #include <limits>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -71,15 +72,24 @@ struct LevelMapSection {
   ptrdiff_t start_index, limit_index;
   double weight;
 };
+// score is the garbage ratio of the blob, estimate_size the live bytes GC has
+// to rewrite and reclaimable_size the bytes it gives back. rank is reclaimed
+// bytes per rewritten byte, the pay off of collecting the blob.
 struct GarbageFileInfo {
   FileMetaData* f;
   double score;
+  double rank;
   uint64_t estimate_size;
-  GarbageFileInfo(FileMetaData* _f) : f(_f), score(0.0), estimate_size(0) {
+  uint64_t reclaimable_size;
+  GarbageFileInfo(FileMetaData* _f)
+      : f(_f), score(0.0), rank(0.0), estimate_size(0), reclaimable_size(0) {
     if (f == nullptr) return;
     score = std::min(
         1.0, f->num_antiquation / std::max<double>(1, f->prop.num_entries));
     estimate_size = static_cast<uint64_t>(f->fd.file_size * (1 - score));
+    reclaimable_size = f->fd.file_size - std::min<uint64_t>(f->fd.file_size,
+                                                            estimate_size);
+    rank = double(reclaimable_size) / std::max<uint64_t>(1, estimate_size);
   }
 };
 struct FileUseInfo {
@@ -840,12 +850,15 @@ void CompactionPicker::GetGrandparents(
 // Try to perform garbage collection from certain column family.
 // Resulting as a pointer of compaction, nullptr as nothing to do.
 // GC picker's principle:
-// 1. pick the largest score blob, which must more than gc ratio
+// 1. pick the blob reclaiming the most bytes per rewritten byte, whose garbage
+//    ratio must more than gc ratio
 // 2. fragment should be take away by the way
 // 3. it marked for compaction
+// 4. each subcompaction takes up to 8 blobs, and writes them into one output
 Compaction* CompactionPicker::PickGarbageCollection(
     const std::string& /*cf_name*/, const MutableCFOptions& mutable_cf_options,
-    VersionStorageInfo* vstorage, LogBuffer* /*log_buffer*/) {
+    VersionStorageInfo* vstorage, uint32_t max_subcompactions,
+    LogBuffer* /*log_buffer*/) {
   // Setting fragment_size as one eighth target_blob_file_size prevents
   // selecting massive files to single compaction which would pin down the
   // maximum deletable file number for a long time resulting possible storage
@@ -857,18 +870,19 @@ Compaction* CompactionPicker::PickGarbageCollection(
   if (fragment_size == 0) {
     fragment_size = target_blob_file_size / 8;
   }
+  max_subcompactions = std::max<uint32_t>(1, max_subcompactions);
   // Preferentially select files marked by high priority
   auto candidate_cmp = [](const GarbageFileInfo& l, const GarbageFileInfo& r) {
     assert(l.f != nullptr && !l.f->being_compacted);
     assert(r.f != nullptr && !l.f->being_compacted);
     return (l.f->marked_for_compaction < r.f->marked_for_compaction) ||
            (l.f->marked_for_compaction == r.f->marked_for_compaction &&
-            l.score < r.score);
+            l.rank < r.rank);
   };
 
   auto& hidden_files = vstorage->LevelFiles(-1);
   uint64_t idx = 0;
-  // Find largest score blob
+  // Find largest rank blob
   GarbageFileInfo dirtiest_blob{nullptr};
   for (; idx < hidden_files.size() && !hidden_files[idx]->is_gc_forbidden();
        ++idx) {
@@ -955,10 +969,12 @@ Compaction* CompactionPicker::PickGarbageCollection(
 
   std::make_heap(candidate_blob_vec.begin(), candidate_blob_vec.end(),
                  candidate_cmp);
-  while (!candidate_blob_vec.empty() && input.files.size() < 8) {
+  while (!candidate_blob_vec.empty() &&
+         input.files.size() < 8 * max_subcompactions) {
     auto f = candidate_blob_vec.front().f;
     uint64_t estimate_size = candidate_blob_vec.front().estimate_size;
-    if (total_estimate_size + estimate_size < target_blob_file_size) {
+    if (total_estimate_size + estimate_size <
+        target_blob_file_size * max_subcompactions) {
       total_estimate_size += estimate_size;
       num_antiquation += f->num_antiquation;
       f->set_gc_candidate();
@@ -982,7 +998,7 @@ Compaction* CompactionPicker::PickGarbageCollection(
       ioptions_, vstorage, mutable_cf_options, bottommost_level, 1, true);
   params.compression_opts =
       GetCompressionOptions(ioptions_, vstorage, bottommost_level, true);
-  params.max_subcompactions = 1;
+  params.max_subcompactions = max_subcompactions;
   params.score = vstorage->total_garbage_ratio();
   params.compaction_type = kGarbageCollection;
   params.compaction_reason = ConvertInputsCompactionReason(
@@ -1767,6 +1783,19 @@ Compaction* CompactionPicker::PickCompositeCompaction(
   double max_read_amp_ratio = -std::numeric_limits<double>::infinity();
   double read_amp = 1;
   uint32_t max_subcompactions = mutable_cf_options.max_subcompactions;
+  uint64_t flatten_threshold = mutable_cf_options.map_sst_flatten_threshold;
+  uint64_t max_read_cost = 0;
+  // The extra probes paid by sampled reads of the hottest map sst range
+  auto map_read_cost = [](const std::vector<FileMetaData*>& files) {
+    uint64_t read_cost = 0;
+    for (auto f : files) {
+      auto map_reads = f->stats.map_reads.load(std::memory_order_relaxed);
+      if (f->prop.is_map_sst() && map_reads != nullptr) {
+        read_cost = std::max(read_cost, map_reads->max_extra_probes());
+      }
+    }
+    return read_cost;
+  };
   // Traverse all sorted_runs from the highest to bottomest finding selection.
   for (auto& sr : sorted_runs) {
     // Skip if this sorted run was occupied by other compaction.
@@ -1796,13 +1825,27 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     if (level_read_amp <= 1) {
       level_read_amp_ratio = -level_read_amp_ratio;
     }
-    if (level_read_amp_ratio >= max_read_amp_ratio) {
-      max_read_amp_ratio = level_read_amp_ratio;
-      read_amp = level_read_amp;
-      input.level = sr.level;
-      if (sr.level == 0) {
-        input.files = {sr.file};
+    uint64_t read_cost = 0;
+    if (flatten_threshold > 0) {
+      read_cost = map_read_cost(sr.level > 0 ? vstorage->LevelFiles(sr.level)
+                                             : std::vector<FileMetaData*>{
+                                                   sr.file});
+    }
+    if (flatten_threshold > 0 && read_cost >= flatten_threshold) {
+      // Sorted runs with a range read past the threshold go first
+      if (read_cost <= max_read_cost) {
+        continue;
       }
+      max_read_cost = read_cost;
+    } else if (max_read_cost > 0 ||
+               level_read_amp_ratio < max_read_amp_ratio) {
+      continue;
+    }
+    max_read_amp_ratio = level_read_amp_ratio;
+    read_amp = level_read_amp;
+    input.level = sr.level;
+    if (sr.level == 0) {
+      input.files = {sr.file};
     }
   }
   // Return nullptr if traverse gets nothing.
@@ -1921,6 +1964,73 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     return IsPerfectRange(r, f, *icmp_);
   };
 
+  // Extra probes paid by the sampled reads of each map sst range, keyed by
+  // the largest key of the range
+  std::unordered_map<std::string, uint64_t> range_read_costs;
+  if (flatten_threshold > 0) {
+    for (auto f : input.files) {
+      auto map_reads = f->stats.map_reads.load(std::memory_order_relaxed);
+      if (!f->prop.is_map_sst() || map_reads == nullptr) {
+        continue;
+      }
+      for (auto& pair : map_reads->GetRanges()) {
+        range_read_costs.emplace(
+            pair.first, pair.second.num_probes - pair.second.num_reads);
+      }
+    }
+  }
+  auto range_read_cost = [&](const MapSstElement& e) -> uint64_t {
+    auto find = range_read_costs.find(e.largest_key.ToString());
+    return find == range_read_costs.end() ? 0 : find->second;
+  };
+
+  auto link_garbage = [vstorage](const MapSstElement& e,
+                                 uint64_t* total_file_size) -> uint64_t {
+    uint64_t total_garbage = 0;
+    *total_file_size = 0;
+    for (auto& l : e.link) {
+      auto& dependence_map = vstorage->dependence_map();
+      auto find = dependence_map.find(l.file_number);
+      if (find == dependence_map.end()) {
+        // TODO log error
+        continue;
+      }
+      auto f = find->second;
+      if (f->prop.is_map_sst()) {
+        // TODO log error
+        continue;
+      }
+      uint64_t file_size = f->fd.GetFileSize();
+      assert(file_size > 0);
+      *total_file_size += file_size;
+      total_garbage += file_size * f->num_antiquation /
+                       std::max<uint64_t>(1, f->prop.num_entries);
+    }
+    return total_garbage;
+  };
+
+  // With a flatten threshold, a range that only costs extra probes is
+  // rewritten once its reads paid enough of them. Until then it stays mapped,
+  // unless its links hold garbage worth collecting. The garbage is estimated
+  // from the dependence counts, so it is held to the same ratio as blob GC
+  bool left_mapped = false;
+  auto keep_mapped = [&](const MapSstElement& e) {
+    if (is_perfect(e)) {
+      return true;
+    }
+    if (flatten_threshold == 0 || e.marked_for_compaction ||
+        range_read_cost(e) >= flatten_threshold) {
+      return false;
+    }
+    uint64_t total_file_size;
+    uint64_t total_garbage = link_garbage(e, &total_file_size);
+    if (total_garbage >= total_file_size * mutable_cf_options.blob_gc_ratio) {
+      return false;
+    }
+    left_mapped = true;
+    return true;
+  };
+
   auto file_number_score = [vstorage](const MapSstElement& e) -> double {
     if (e.link.size() != 1) {
       return 0;
@@ -1950,30 +2060,16 @@ Compaction* CompactionPicker::PickCompositeCompaction(
     if (!ReadMapElement(map_element, iter.get(), log_buffer, cf_name)) {
       return nullptr;
     }
-    if (is_perfect(map_element)) {
+    if (keep_mapped(map_element)) {
       continue;
     }
     double p = map_element.link.size();
-    uint64_t total_file_size = 0, total_garbage = 0;
-    for (auto& l : map_element.link) {
-      auto& dependence_map = vstorage->dependence_map();
-      auto find = dependence_map.find(l.file_number);
-      if (find == dependence_map.end()) {
-        // TODO log error
-        continue;
-      }
-      auto f = find->second;
-      if (f->prop.is_map_sst()) {
-        // TODO log error
-        continue;
-      }
-      uint64_t file_size = f->fd.GetFileSize();
-      assert(file_size > 0);
-      total_file_size += file_size;
-      total_garbage += file_size * f->num_antiquation /
-                       std::max<uint64_t>(1, f->prop.num_entries);
-    }
+    uint64_t total_file_size;
+    uint64_t total_garbage = link_garbage(map_element, &total_file_size);
     p *= 1 + 1.0 * total_garbage / total_file_size;
+    if (flatten_threshold > 0) {
+      p *= 1 + 1.0 * range_read_cost(map_element) / flatten_threshold;
+    }
     p += file_number_score(map_element);
     PickerCompositeHeapItem item = {
         ArenaPinSlice(map_element.largest_key, &arena), p};
@@ -2025,7 +2121,7 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       if (!ReadMapElement(map_element, iter.get(), log_buffer, cf_name)) {
         return nullptr;
       }
-      if (unique_check.count(iter->key()) > 0 || is_perfect(map_element)) {
+      if (unique_check.count(iter->key()) > 0 || keep_mapped(map_element)) {
         AssignUserKey(range.limit, map_element.smallest_key);
         break;
       } else {
@@ -2045,7 +2141,7 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       if (!ReadMapElement(map_element, iter.get(), log_buffer, cf_name)) {
         return nullptr;
       }
-      if (is_perfect(map_element)) {
+      if (keep_mapped(map_element)) {
         break;
       }
       AssignUserKey(range.start, map_element.smallest_key);
@@ -2065,6 +2161,10 @@ Compaction* CompactionPicker::PickCompositeCompaction(
       return new_compaction();
     }
   }
+  // Unmapping the level would rewrite the ranges left mapped
+  if (left_mapped) {
+    return nullptr;
+  }
   // for unmap level 0
   if (input.level != 0) {
     max_subcompactions = 1;
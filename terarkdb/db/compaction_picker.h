@@ -106,10 +106,12 @@ class CompactionPicker {
       VersionStorageInfo* vstorage,
       const std::vector<SequenceNumber>& snapshots, LogBuffer* log_buffer) = 0;
 
-  // Pick compaction which level has map or link sst
+  // Pick compaction which level has map or link sst. The job may be split
+  // into up to "max_subcompactions" subcompactions.
   Compaction* PickGarbageCollection(const std::string& cf_name,
                                     const MutableCFOptions& mutable_cf_options,
                                     VersionStorageInfo* vstorage,
+                                    uint32_t max_subcompactions,
                                     LogBuffer* log_buffer);
 
   virtual void InitFilesBeingCompact(const MutableCFOptions& mutable_cf_options,
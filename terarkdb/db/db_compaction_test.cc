@@ -425,6 +425,91 @@ TEST_F(DBCompactionTest, LazyCompactionTest) {
   }
 }
 
+TEST_F(DBCompactionTest, FlattenReadHotMapSstRange) {
+  Options options = CurrentOptions();
+  options.enable_lazy_compaction = true;
+  options.level0_file_num_compaction_trigger = 4;
+  options.map_sst_flatten_threshold = 4 * 1024;
+  DestroyAndReopen(options);
+
+  // Two ranges, each interleaving the keys of two files, so that a read
+  // missing in either range probes both files
+  Random rnd(301);
+  std::map<std::string, std::string> values;
+  std::set<std::string> range_files[2];
+  for (int r = 0; r < 2; ++r) {
+    for (int f = 0; f < 2; ++f) {
+      for (int i = f; i < 400; i += 2) {
+        char key[8];
+        snprintf(key, sizeof(key), "%c%03d", 'a' + r, i);
+        values[key] = RandomString(&rnd, 1000);
+        ASSERT_OK(Put(key, values[key]));
+      }
+      ASSERT_OK(Flush());
+    }
+    std::vector<LiveFileMetaData> files;
+    dbfull()->GetLiveFilesMetaData(&files);
+    for (auto& f : files) {
+      if (range_files[0].count(f.name) == 0) {
+        range_files[r].emplace(f.name);
+      }
+    }
+  }
+  ASSERT_EQ(2, range_files[0].size());
+  ASSERT_EQ(2, range_files[1].size());
+  // The level 0 files are linked by a map sst, that no read needs flattened
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ("0,1", FilesPerLevel(0));
+  ASSERT_OK(dbfull()->SetOptions({{"disable_auto_compactions", "true"}}));
+
+  auto live_files = [&] {
+    std::vector<LiveFileMetaData> files;
+    dbfull()->GetLiveFilesMetaData(&files);
+    std::set<std::string> names;
+    for (auto& f : files) {
+      names.emplace(f.name);
+    }
+    return names;
+  };
+  auto read_misses = [&](char range) {
+    std::string value;
+    for (int i = 0; i < 20000; ++i) {
+      char key[8];
+      snprintf(key, sizeof(key), "%c%03dx", range, i % 390 + 5);
+      ASSERT_TRUE(db_->Get(ReadOptions(), key, &value).IsNotFound());
+    }
+  };
+  auto is_subset = [](const std::set<std::string>& a,
+                      const std::set<std::string>& b) {
+    return std::includes(b.begin(), b.end(), a.begin(), a.end());
+  };
+  ASSERT_TRUE(is_subset(range_files[0], live_files()));
+  ASSERT_TRUE(is_subset(range_files[1], live_files()));
+
+  // Reads pay two probes in the range they go through
+  read_misses('a');
+  std::string read_amp;
+  ASSERT_TRUE(db_->GetProperty(DB::Properties::kMapSstReadAmp, &read_amp));
+  ASSERT_NE(std::string::npos, read_amp.find(" 2.00 ["));
+
+  // The read range is rewritten, the other one stays mapped
+  ASSERT_OK(dbfull()->SetOptions({{"disable_auto_compactions", "false"}}));
+  dbfull()->TEST_WaitForCompact();
+  auto files = live_files();
+  ASSERT_FALSE(is_subset(range_files[0], files));
+  ASSERT_TRUE(is_subset(range_files[1], files));
+
+  // Reads get the other range rewritten as well
+  read_misses('b');
+  dbfull()->TEST_WaitForCompact();
+  files = live_files();
+  ASSERT_FALSE(is_subset(range_files[1], files));
+
+  for (auto& pair : values) {
+    ASSERT_EQ(pair.second, Get(pair.first));
+  }
+}
+
 TEST_P(DBCompactionTestWithParam, CompactionsPreserveDeletes) {
   //  For each options type we test following
   //  - Enable preserve_deletes
@@ -2526,6 +2611,7 @@ TEST_F(DBCompactionTest, ManualAutoRace) {
   // Eventually the cancelled compaction will be rescheduled and executed.
   dbfull()->TEST_WaitForCompact();
   ASSERT_EQ("0,1", FilesPerLevel(0));
+  ASSERT_OK(dbfull()->SetOptions({{"disable_auto_compactions", "true"}}));
   TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
 }
 
@@ -4333,6 +4419,557 @@ TEST_F(DBCompactionTest, BlobOverlapThredhold) {
   ASSERT_EQ(call_back_cnt, 2);
 }
 
+TEST_F(DBCompactionTest, BlobOffsetIndex) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_offset_index = true;
+  DestroyAndReopen(opts);
+
+  auto value_of = [](int i) { return std::string(100, 'a' + i % 26); };
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(Key(i), value_of(i)));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 500; i < 1500; ++i) {
+    ASSERT_OK(Put(Key(i), value_of(i + 1)));
+  }
+  ASSERT_OK(Flush());
+
+  // Blob ssts hold one entry per data block.
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  int blob_ssts = 0;
+  for (auto& p : props) {
+    if (p.second->num_entries > 1 &&
+        p.second->num_data_blocks == p.second->num_entries) {
+      ++blob_ssts;
+    }
+  }
+  ASSERT_GE(blob_ssts, 2);
+
+  auto verify = [&] {
+    for (int i = 0; i < 1500; ++i) {
+      ASSERT_EQ(Get(Key(i)), value_of(i < 500 ? i : i + 1));
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int i = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++i) {
+      ASSERT_EQ(iter->key().ToString(), Key(i));
+      ASSERT_EQ(iter->value().ToString(), value_of(i < 500 ? i : i + 1));
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(i, 1500);
+  };
+  verify();
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  verify();
+  Reopen(opts);
+  verify();
+}
+
+TEST_F(DBCompactionTest, BlobOffsetIndexReadOptions) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_offset_index = true;
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(8 << 20);
+  opts.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(opts);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(Key(i), std::string(100, 'a' + i % 26)));
+  }
+  ASSERT_OK(Flush());
+  Reopen(opts);
+
+  // Reading the first key caches the LSM block of all of them, but only
+  // the blob block of its own value.
+  std::string value;
+  ASSERT_OK(db_->Get(ReadOptions(), Key(0), &value));
+  ReadOptions cache_only;
+  cache_only.read_tier = kBlockCacheTier;
+  ASSERT_OK(db_->Get(cache_only, Key(0), &value));
+  ASSERT_TRUE(db_->Get(cache_only, Key(1), &value).IsIncomplete());
+
+  // Values read without fill_cache stay out of the block cache.
+  ReadOptions no_fill;
+  no_fill.fill_cache = false;
+  ASSERT_OK(db_->Get(no_fill, Key(1), &value));
+  ASSERT_EQ(value, std::string(100, 'b'));
+  ASSERT_TRUE(db_->Get(cache_only, Key(1), &value).IsIncomplete());
+  ASSERT_OK(db_->Get(ReadOptions(), Key(1), &value));
+  ASSERT_OK(db_->Get(cache_only, Key(1), &value));
+  ASSERT_EQ(value, std::string(100, 'b'));
+}
+
+TEST_F(DBCompactionTest, ParallelGarbageCollection) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.max_background_compactions = 4;
+  opts.max_subcompactions = 4;
+  opts.blob_gc_ratio = 0.1;
+  DestroyAndReopen(opts);
+
+  auto value_of = [](int i, int round) {
+    return std::string(100, 'a' + (i + round) % 26);
+  };
+  // Four blob ssts with disjoint key ranges
+  for (int f = 0; f < 4; ++f) {
+    for (int i = f * 250; i < (f + 1) * 250; ++i) {
+      ASSERT_OK(Put(Key(i), value_of(i, 0)));
+    }
+    ASSERT_OK(Flush());
+  }
+
+  std::atomic<int> subcompactions{0};
+  std::atomic<int> gc_jobs{0};
+  std::mutex mutex;
+  std::set<uint64_t> gc_inputs;
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::ProcessGarbageCollection:Inputs", [&](void* arg) {
+        auto files = reinterpret_cast<std::vector<FileMetaData*>*>(arg);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto f : *files) {
+          // Subcompactions never share an input
+          ASSERT_TRUE(gc_inputs.insert(f->fd.GetNumber()).second);
+        }
+        ++subcompactions;
+      });
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun",
+      [&](void* /*arg*/) { ++gc_jobs; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // Leave half of every blob sst as garbage
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_OK(Put(Key(i), value_of(i, 1)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  for (int i = 0; i < 1000 && gc_jobs.load() == 0; ++i) {
+    env_->SleepForMicroseconds(10000);
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_GT(gc_jobs.load(), 0);
+  ASSERT_GT(subcompactions.load(), gc_jobs.load());
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), value_of(i, i % 2 == 0 ? 1 : 0));
+  }
+  Reopen(opts);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), value_of(i, i % 2 == 0 ? 1 : 0));
+  }
+}
+
+TEST_F(DBCompactionTest, GarbageCollectionPickFollowsSlots) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  // No compaction slot is left for subcompactions
+  opts.max_background_compactions = 1;
+  opts.max_subcompactions = 4;
+  opts.blob_gc_ratio = 0.1;
+  DestroyAndReopen(opts);
+
+  auto value_of = [](int i, int round) {
+    return std::string(100, 'a' + (i + round) % 26);
+  };
+  // More blob ssts than a single subcompaction takes
+  for (int f = 0; f < 12; ++f) {
+    for (int i = f * 100; i < (f + 1) * 100; ++i) {
+      ASSERT_OK(Put(Key(i), value_of(i, 0)));
+    }
+    ASSERT_OK(Flush());
+  }
+
+  std::atomic<int> subcompactions{0};
+  std::atomic<int> gc_jobs{0};
+  std::atomic<size_t> max_inputs{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::ProcessGarbageCollection:Inputs", [&](void* arg) {
+        auto files = reinterpret_cast<std::vector<FileMetaData*>*>(arg);
+        if (files->size() > max_inputs.load()) {
+          max_inputs = files->size();
+        }
+        ++subcompactions;
+      });
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun",
+      [&](void* /*arg*/) { ++gc_jobs; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  for (int i = 0; i < 1200; i += 2) {
+    ASSERT_OK(Put(Key(i), value_of(i, 1)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  for (int i = 0; i < 1000 && gc_jobs.load() == 0; ++i) {
+    env_->SleepForMicroseconds(10000);
+  }
+  dbfull()->TEST_WaitForCompact();
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  // Without free slots a job is picked for one subcompaction
+  ASSERT_GT(gc_jobs.load(), 0);
+  ASSERT_EQ(subcompactions.load(), gc_jobs.load());
+  ASSERT_LE(max_inputs.load(), 8);
+  for (int i = 0; i < 1200; ++i) {
+    ASSERT_EQ(Get(Key(i)), value_of(i, i % 2 == 0 ? 1 : 0));
+  }
+}
+
+TEST_F(DBCompactionTest, GarbageCollectionSortedProbe) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.1;
+  opts.statistics = CreateDBStatistics();
+  opts.statistics->stats_level_ = kAll;
+  DestroyAndReopen(opts);
+
+  auto value_of = [](int i, int round) {
+    return std::string(100, 'a' + (i + round) % 26);
+  };
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(Key(i), value_of(i, 0)));
+  }
+  ASSERT_OK(Flush());
+
+  std::atomic<int> gc_jobs{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun",
+      [&](void* /*arg*/) { ++gc_jobs; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // Leave every third value as garbage
+  for (int i = 0; i < 1000; i += 3) {
+    ASSERT_OK(Put(Key(i), value_of(i, 1)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  for (int i = 0; i < 1000 && gc_jobs.load() == 0; ++i) {
+    env_->SleepForMicroseconds(10000);
+  }
+  dbfull()->TEST_WaitForCompact();
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_GT(gc_jobs.load(), 0);
+  uint64_t get_keys = opts.statistics->getTickerCount(GC_GET_KEYS);
+  uint64_t seeks = opts.statistics->getTickerCount(GC_GET_KEYS_SEEK);
+  uint64_t reuses = opts.statistics->getTickerCount(GC_GET_KEYS_REUSE);
+  ASSERT_GT(get_keys, 0);
+  // Sorted lookups mostly step forward from the previous one
+  ASSERT_GT(reuses, seeks);
+  HistogramData probe_time;
+  opts.statistics->histogramData(GC_PROBE_TIME, &probe_time);
+  ASSERT_GT(probe_time.count, 0);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), value_of(i, i % 3 == 0 ? 1 : 0));
+  }
+}
+
+// Runs GC on the garbage "make_garbage" leaves and returns the number of GC
+// jobs that ran
+static int RunGarbageCollection(DBTestBase* test,
+                                const std::function<void()>& make_garbage) {
+  std::atomic<int> gc_jobs{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun",
+      [&](void* /*arg*/) { ++gc_jobs; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  make_garbage();
+  for (int i = 0; i < 1000 && gc_jobs.load() == 0; ++i) {
+    test->env_->SleepForMicroseconds(10000);
+  }
+  test->dbfull()->TEST_WaitForCompact();
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  return gc_jobs.load();
+}
+
+TEST_F(DBCompactionTest, GarbageCollectionSortedProbeDeletes) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.1;
+  DestroyAndReopen(opts);
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(Key(i), std::string(100, 'a' + i % 26)));
+  }
+  ASSERT_OK(Flush());
+
+  // Deleted values are garbage, the ones next to them still live
+  ASSERT_GT(RunGarbageCollection(this,
+                                 [&] {
+                                   for (int i = 0; i < 1000; i += 3) {
+                                     ASSERT_OK(Delete(Key(i)));
+                                   }
+                                   ASSERT_OK(Flush());
+                                   ASSERT_OK(db_->CompactRange(
+                                       CompactRangeOptions(), nullptr,
+                                       nullptr));
+                                 }),
+            0);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), i % 3 == 0 ? "NOT_FOUND"
+                                      : std::string(100, 'a' + i % 26));
+  }
+  Reopen(opts);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), i % 3 == 0 ? "NOT_FOUND"
+                                      : std::string(100, 'a' + i % 26));
+  }
+}
+
+TEST_F(DBCompactionTest, GarbageCollectionSortedProbeMerges) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.1;
+  opts.merge_operator.reset(new StringAppendTESTOperator(','));
+  DestroyAndReopen(opts);
+
+  // Separated merge operands on top of separated values
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 1000; ++i) {
+    expected[Key(i)] = std::string(100, 'a' + i % 26);
+    ASSERT_OK(Put(Key(i), expected[Key(i)]));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 1000; i += 2) {
+    std::string operand(100, 'A' + i % 26);
+    ASSERT_OK(Merge(Key(i), operand));
+    expected[Key(i)] += "," + operand;
+  }
+  ASSERT_OK(Flush());
+
+  ASSERT_GT(RunGarbageCollection(this,
+                                 [&] {
+                                   for (int i = 0; i < 1000; i += 4) {
+                                     expected[Key(i)] = std::string(100, 'z');
+                                     ASSERT_OK(Put(Key(i), expected[Key(i)]));
+                                   }
+                                   ASSERT_OK(Flush());
+                                   ASSERT_OK(db_->CompactRange(
+                                       CompactRangeOptions(), nullptr,
+                                       nullptr));
+                                 }),
+            0);
+  for (auto& kv : expected) {
+    ASSERT_EQ(Get(kv.first), kv.second);
+  }
+}
+
+TEST_F(DBCompactionTest, GarbageCollectionSortedProbeMapSst) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.1;
+  opts.enable_lazy_compaction = true;
+  opts.level0_file_num_compaction_trigger = 2;
+  DestroyAndReopen(opts);
+
+  auto value_of = [](int i, int round) {
+    return std::string(100, 'a' + (i + round) % 26);
+  };
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(Key(i), value_of(i, 0)));
+  }
+  ASSERT_OK(Flush());
+
+  // The overwrites end up in a map sst over both lsm ssts, so GC has to
+  // look through it
+  auto has_map_sst = [&] {
+    auto vstorage = dbfull()
+                        ->TEST_GetVersionSet()
+                        ->GetColumnFamilySet()
+                        ->GetColumnFamily("default")
+                        ->current()
+                        ->storage_info();
+    for (int level = 0; level < vstorage->num_levels(); ++level) {
+      for (auto f : vstorage->LevelFiles(level)) {
+        if (f->prop.is_map_sst()) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+  ASSERT_GT(RunGarbageCollection(this,
+                                 [&] {
+                                   for (int i = 0; i < 1000; i += 2) {
+                                     ASSERT_OK(Put(Key(i), value_of(i, 1)));
+                                   }
+                                   ASSERT_OK(Flush());
+                                   dbfull()->TEST_WaitForCompact();
+                                   ASSERT_TRUE(has_map_sst());
+                                 }),
+            0);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), value_of(i, i % 2 == 0 ? 1 : 0));
+  }
+}
+
+TEST_F(DBCompactionTest, MapSstDeletionsCountAsBlobGarbage) {
+  Options opts = CurrentOptions();
+  opts.compression = kNoCompression;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.5;
+  opts.enable_lazy_compaction = true;
+  opts.level0_file_num_compaction_trigger = 2;
+  opts.map_sst_flatten_threshold = 1 << 20;
+  DestroyAndReopen(opts);
+
+  auto hidden_files = [&] {
+    return dbfull()
+        ->TEST_GetVersionSet()
+        ->GetColumnFamilySet()
+        ->GetColumnFamily("default")
+        ->current()
+        ->storage_info()
+        ->LevelFiles(-1);
+  };
+  uint64_t blob_number = uint64_t(-1);
+  auto garbage_ratio = [&] {
+    for (auto f : hidden_files()) {
+      if (f->fd.GetNumber() == blob_number) {
+        return double(f->num_antiquation) / f->prop.num_entries;
+      }
+    }
+    ADD_FAILURE() << "Missing blob sst " << blob_number;
+    return 0.0;
+  };
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(Key(i), std::string(100, 'a' + i % 26)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ(1, hidden_files().size());
+  blob_number = hidden_files().front()->fd.GetNumber();
+  ASSERT_EQ(0, garbage_ratio());
+
+  // The tombstones are only linked next to the values they delete, a third
+  // of the blob sst is garbage, too little for it to be collected
+  for (int i = 0; i < 1000; i += 3) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  ASSERT_OK(Flush());
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ("0,1", FilesPerLevel(0));
+  double estimation = garbage_ratio();
+  ASSERT_GT(estimation, 0.25);
+  ASSERT_LT(estimation, 0.45);
+
+  // The estimation survives a reopen
+  Reopen(opts);
+  ASSERT_EQ(estimation, garbage_ratio());
+
+  // And holds against the exact count of a real rewrite
+  opts.enable_lazy_compaction = false;
+  Reopen(opts);
+  CompactRangeOptions cro;
+  cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ(1, hidden_files().size());
+  ASSERT_EQ(0.334, garbage_ratio());
+  ASSERT_LT(std::abs(estimation - 0.334), 0.1);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), i % 3 == 0 ? "NOT_FOUND"
+                                      : std::string(100, 'a' + i % 26));
+  }
+}
+
+#if defined(WITH_TERARK_ZIP) && !defined(OS_WIN)
+TEST_F(DBCompactionTest, LocalProcessCompactionDispatcher) {
+  LocalCompactionDispatcherOptions dispatcher_options;
+  dispatcher_options.num_workers = 2;
+  dispatcher_options.max_retries = 2;
+  dispatcher_options.env = env_;
+  Options opts = CurrentOptions();
+  opts.enable_lazy_compaction = false;
+  opts.disable_auto_compactions = true;
+  opts.compaction_dispatcher =
+      NewLocalProcessCompactionDispatcher(dispatcher_options);
+  DestroyAndReopen(opts);
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 200; ++i) {
+      ASSERT_OK(Put(Key(i), "v" + ToString(round) + "-" + ToString(i)));
+    }
+    ASSERT_OK(Flush());
+  }
+
+  // The first worker dies, its job runs again in a new one
+  std::atomic<int> attempts{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "LocalProcessCompactionDispatcher::RunWorker", [&](void* arg) {
+        *static_cast<bool*>(arg) = attempts.fetch_add(1) == 0;
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_GE(attempts.load(), 2);
+  ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_EQ(Get(Key(i)), "v2-" + ToString(i));
+  }
+  // Nothing the killed worker wrote is left behind
+  std::vector<std::string> children;
+  ASSERT_OK(env_->GetChildren(dbname_, &children));
+  for (auto& child : children) {
+    ASSERT_FALSE(Slice(child).starts_with("compaction-worker-")) << child;
+  }
+}
+
+TEST_F(DBCompactionTest, LocalProcessCompactionDispatcherGivesUp) {
+  LocalCompactionDispatcherOptions dispatcher_options;
+  dispatcher_options.num_workers = 1;
+  dispatcher_options.max_retries = 1;
+  dispatcher_options.env = env_;
+  Options opts = CurrentOptions();
+  opts.enable_lazy_compaction = false;
+  opts.disable_auto_compactions = true;
+  opts.compaction_dispatcher =
+      NewLocalProcessCompactionDispatcher(dispatcher_options);
+  DestroyAndReopen(opts);
+
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_OK(Put(Key(i), "v" + ToString(round)));
+    }
+    ASSERT_OK(Flush());
+  }
+
+  // Every worker dies, the compaction fails once the retries are used up
+  std::atomic<int> attempts{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "LocalProcessCompactionDispatcher::RunWorker", [&](void* arg) {
+        attempts.fetch_add(1);
+        *static_cast<bool*>(arg) = true;
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_NOK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_EQ(attempts.load(), 2);
+  ASSERT_EQ(NumTableFilesAtLevel(0), 2);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(Get(Key(i)), "v1");
+  }
+}
+#endif  // WITH_TERARK_ZIP && !OS_WIN
+
 #endif  // !defined(ROCKSDB_LITE)
 }  // namespace TERARKDB_NAMESPACE
 
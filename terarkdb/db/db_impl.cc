@@ -2110,6 +2110,12 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
                      &max_covering_tombstone_seq, value_found, nullptr, nullptr,
                      callback);
     RecordTick(stats_, MEMTABLE_MISS);
+    if (cfd->TakeMapSstFlattenRequest()) {
+      InstrumentedMutexLock l(&mutex_);
+      cfd->current()->storage_info()->ResetPickCompactionFail();
+      SchedulePendingCompaction(cfd);
+      MaybeScheduleFlushOrCompaction();
+    }
   }
 
   if (s.ok() && lazy_val != nullptr) {
@@ -2279,14 +2285,20 @@ std::vector<Status> DBImpl::MultiGet(
   // First look in the memtable, then in the immutable memtable (if any).
   // s is both in/out. When in, s could either be OK or MergeInProgress.
   // merge_operands will contain the sequence of merges in the latter case.
+  // Separated values found in SSTs are left unfetched in lazy_values, and
+  // read afterwards, see below.
   size_t num_found = 0;
   size_t counting = num_keys;
+  std::vector<LazyBuffer> lazy_values;
+  lazy_values.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    lazy_values.emplace_back(&(*values)[i]);
+  }
   auto get_one = [&](size_t i) {
     // Contain a list of merge operations if merge occurs.
     MergeContext merge_context;
     Status& s = stat_list[i];
-    std::string* value = &(*values)[i];
-    LazyBuffer lazy_val(value);
+    LazyBuffer& lazy_val = lazy_values[i];
 
     LookupKey lkey(keys[i], snapshot);
     auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
@@ -2313,18 +2325,25 @@ std::vector<Status> DBImpl::MultiGet(
     }
     if (!done) {
       PERF_TIMER_GUARD(get_from_output_files_time);
-      super_version->current->Get(read_options, keys[i], lkey, &lazy_val, &s,
-                                  &merge_context, &max_covering_tombstone_seq);
+      super_version->current->Get(
+          read_options, keys[i], lkey, &lazy_val, &s, &merge_context,
+          &max_covering_tombstone_seq, nullptr /* value_found */,
+          nullptr /* key_exists */, nullptr /* seq */, nullptr /* callback */,
+          true /* defer_separated_value */);
       RecordTick(stats_, MEMTABLE_MISS);
     }
+    counting--;
+  };
+  auto finish_one = [&](size_t i) {
+    Status& s = stat_list[i];
+    std::string* value = &(*values)[i];
     if (s.ok()) {
-      s = std::move(lazy_val).dump(value);
+      s = std::move(lazy_values[i]).dump(value);
     }
     if (s.ok()) {
       bytes_read += value->size();
       num_found++;
     }
-    counting--;
   };
 #ifdef WITH_BOOSTLIB
   if (read_options.aio_concurrency && immutable_db_options_.use_aio_reads) {
@@ -2357,6 +2376,64 @@ std::vector<Status> DBImpl::MultiGet(
   }
 #endif
 
+  // Read the separated values left unfetched, grouped by the blob sst that
+  // holds them and in key order within it, so that each blob sst is read in
+  // one forward pass over blocks that are loaded once.
+  std::vector<size_t> deferred;
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (stat_list[i].ok() && !lazy_values[i].valid()) {
+      deferred.push_back(i);
+    } else {
+      finish_one(i);
+    }
+  }
+  std::sort(deferred.begin(), deferred.end(), [&](size_t l, size_t r) {
+    uint64_t l_file = lazy_values[l].file_number();
+    uint64_t r_file = lazy_values[r].file_number();
+    if (l_file != r_file) {
+      return l_file < r_file;
+    }
+    auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[l]);
+    return cfh->cfd()->user_comparator()->Compare(keys[l], keys[r]) < 0;
+  });
+  auto fetch_file = [&](size_t begin, size_t end) {
+    for (size_t j = begin; j < end; ++j) {
+      finish_one(deferred[j]);
+    }
+    counting--;
+  };
+  std::vector<std::pair<size_t, size_t>> file_ranges;
+  for (size_t begin = 0; begin < deferred.size();) {
+    uint64_t file_number = lazy_values[deferred[begin]].file_number();
+    size_t end = begin + 1;
+    while (end < deferred.size() &&
+           lazy_values[deferred[end]].file_number() == file_number) {
+      ++end;
+    }
+    file_ranges.emplace_back(begin, end);
+    begin = end;
+  }
+  counting = file_ranges.size();
+#ifdef WITH_BOOSTLIB
+  if (read_options.aio_concurrency && immutable_db_options_.use_aio_reads) {
+    // Blob ssts are read concurrently, one fiber each
+    auto tls = &gt_fibers;
+    for (auto& range : file_ranges) {
+      tls->push([&, range]() { fetch_file(range.first, range.second); });
+    }
+    while (counting) {
+      tls->m_fy.unchecked_yield();
+    }
+  } else {
+#endif
+    for (auto& range : file_ranges) {
+      fetch_file(range.first, range.second);
+    }
+#ifdef WITH_BOOSTLIB
+  }
+#endif
+  lazy_values.clear();
+
   // Post processing (decrement reference counts and record statistics)
   PERF_TIMER_GUARD(get_post_process_time);
   autovector<SuperVersion*> superversions_to_delete;
@@ -2977,7 +2977,13 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
       // until we make a copy in the following code
       TEST_SYNC_POINT(
           "DBImpl::BackgroundGarbageCollection():BeforePickGarbageCollection");
-      c.reset(cfd->PickGarbageCollection(*mutable_cf_options, log_buffer));
+      // Pick only as many blob ssts as the free compaction slots can rewrite
+      // in parallel, the job runs in a single subcompaction otherwise.
+      uint32_t max_subcompactions =
+          1 + GetSubCompactionSlots(
+                  std::max(1u, mutable_cf_options->max_subcompactions));
+      c.reset(cfd->PickGarbageCollection(*mutable_cf_options,
+                                         max_subcompactions, log_buffer));
       TEST_SYNC_POINT(
           "DBImpl::BackgroundGarbageCollection():AfterPickGarbageCollection");
 
@@ -3043,7 +3049,9 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
         &event_logger_, c->mutable_cf_options()->paranoid_file_checks,
         c->mutable_cf_options()->report_bg_io_stats, dbname_,
         &garbage_collection_job_stats);
-    garbage_collection_job.Prepare(0 /* sub_compaction_slots */);
+    int sub_compaction_scheduled = garbage_collection_job.Prepare(
+        GetSubCompactionSlots(c->max_subcompactions()));
+    bg_compaction_scheduled_ += sub_compaction_scheduled;
     NotifyOnCompactionBegin(c->column_family_data(), c.get(), status,
                             garbage_collection_job_stats, job_context->job_id);
 
@@ -3051,6 +3059,7 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
     garbage_collection_job.Run();
     TEST_SYNC_POINT("DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun");
     mutex_.Lock();
+    bg_compaction_scheduled_ -= sub_compaction_scheduled;
     status = garbage_collection_job.Install(*c->mutable_cf_options());
     if (status.ok()) {
       InstallSuperVersionAndScheduleWork(
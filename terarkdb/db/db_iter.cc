@@ -122,6 +122,7 @@ class DBIter final : public Iterator {
         iter_(iter),
         sequence_(s),
         separate_helper_(separate_helper),
+        read_options_(read_options),
         direction_(kForward),
         valid_(false),
         current_entry_is_merged_(false),
@@ -140,6 +141,7 @@ class DBIter final : public Iterator {
     prefix_extractor_ = mutable_cf_options.prefix_extractor.get();
     max_skip_ = max_sequential_skip_in_iterations;
     max_skippable_internal_keys_ = read_options.max_skippable_internal_keys;
+    ResetScanHelper();
     SetSVDestructCallback(sv_destruct_callback);
   }
   virtual ~DBIter() {
@@ -164,6 +166,7 @@ class DBIter final : public Iterator {
             self->PinLazyBuffer();
             self->separate_helper_ =
                 new_sv == nullptr ? nullptr : new_sv->current;
+            self->ResetScanHelper();
           },
           this);
     }
@@ -174,6 +177,7 @@ class DBIter final : public Iterator {
     assert(iter_ == nullptr);
     iter_ = iter;
     separate_helper_ = separate_helper;
+    ResetScanHelper();
     SetSVDestructCallback(sv_destruct_callback);
   }
   virtual ReadRangeDelAggregator* GetRangeDelAggregator() {
@@ -252,10 +256,21 @@ class DBIter final : public Iterator {
     if (separate_helper_ == nullptr || ikey.type != index_type) {
       return iter_->value();
     } else {
-      return separate_helper_->TransToCombined(saved_key_.GetUserKey(),
-                                               ikey.sequence, iter_->value());
+      if (scan_helper_) {
+        return scan_helper_->TransToCombined(saved_key_.GetUserKey(),
+                                             ikey.sequence, iter_->value());
+      }
+      return separate_helper_->TransToCombinedForRead(
+          saved_key_.GetUserKey(), ikey.sequence, iter_->value(),
+          read_options_);
     }
   }
+  // Buffers taken from the old scan helper must be pinned before this
+  void ResetScanHelper() {
+    scan_helper_.reset(separate_helper_ == nullptr
+                           ? nullptr
+                           : separate_helper_->NewScanHelper(read_options_));
+  }
 
   void PrevInternal();
   bool TooManyInternalKeysSkipped(bool increment = true);
@@ -294,6 +309,9 @@ class DBIter final : public Iterator {
   InternalIterator* iter_;
   SequenceNumber sequence_;
   const SeparateHelper* separate_helper_;
+  // See ReadOptions::blob_lookahead
+  std::unique_ptr<SeparateHelper> scan_helper_;
+  const ReadOptions read_options_;
 
   mutable Status status_;
   IterKey saved_key_;
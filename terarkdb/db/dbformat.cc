@@ -201,14 +201,24 @@ void IterKey::EnlargeBuffer(size_t key_size) {
 Status SeparateHelper::TransToSeparate(
     const Slice& internal_key, LazyBuffer& value, uint64_t file_number,
     const Slice& meta, bool is_merge, bool is_index,
-    const ValueExtractor* value_meta_extractor) {
+    const ValueExtractor* value_meta_extractor, const ValueHandle& handle) {
   assert(file_number != uint64_t(-1));
+  char buffer[sizeof(uint64_t) + kMaxVarint64Length * 2];
+  char* end = buffer + sizeof(uint64_t);
+  if (handle.valid()) {
+    EncodeFixed64(buffer, file_number | kValueHandleFlag);
+    end = EncodeVarint64(end, handle.offset);
+    end = EncodeVarint64(end, handle.size);
+  } else {
+    EncodeFixed64(buffer, file_number);
+  }
+  Slice head(buffer, end - buffer);
   if (value_meta_extractor == nullptr || is_merge) {
-    value.reset(EncodeFileNumber(file_number), true, file_number);
+    value.reset(head, true, file_number);
     return Status::OK();
   }
   if (is_index) {
-    Slice parts[] = {EncodeFileNumber(file_number), meta};
+    Slice parts[] = {head, meta};
     value.reset(SliceParts(parts, 2), file_number);
     return Status::OK();
   } else {
@@ -220,7 +230,7 @@ Status SeparateHelper::TransToSeparate(
     s = value_meta_extractor->Extract(ExtractUserKey(internal_key),
                                       value.slice(), &value_meta);
     if (s.ok()) {
-      Slice parts[] = {EncodeFileNumber(file_number), value_meta};
+      Slice parts[] = {head, value_meta};
       value.reset(SliceParts(parts, 2), file_number);
     }
     return s;
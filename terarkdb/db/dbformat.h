@@ -784,10 +784,24 @@ struct ParsedInternalKeyComparator {
   const InternalKeyComparator* cmp;
 };
 
+// Position of a separated value in its blob sst, see
+// ColumnFamilyOptions::blob_offset_index.
+struct ValueHandle {
+  uint64_t offset = 0;
+  uint64_t size = 0;
+
+  bool valid() const { return size != 0; }
+};
+
+// A value index is the number of the blob sst holding the value followed
+// by the value meta. With blob_offset_index the top bit of the file number
+// is set, and the offset and size of the value follow it as varint64.
 class SeparateHelper {
  public:
   virtual ~SeparateHelper() = default;
 
+  static const uint64_t kValueHandleFlag = 1ull << 63;
+
   static Slice EncodeFileNumber(uint64_t& file_number) {
     if (!port::kLittleEndian) {
       file_number = EndianTransform(file_number, sizeof file_number);
@@ -801,25 +815,43 @@ class SeparateHelper {
     if (!port::kLittleEndian) {
       file_number = EndianTransform(file_number, sizeof file_number);
     }
-    return file_number;
+    return file_number & ~kValueHandleFlag;
+  }
+  // Returns false if the value index carries no handle.
+  static bool DecodeValueHandle(const Slice& slice, ValueHandle* handle) {
+    assert(slice.size() >= sizeof(uint64_t));
+    if ((DecodeFixed64(slice.data()) & kValueHandleFlag) == 0) {
+      return false;
+    }
+    Slice input(slice.data() + sizeof(uint64_t),
+                slice.size() - sizeof(uint64_t));
+    return GetVarint64(&input, &handle->offset) &&
+           GetVarint64(&input, &handle->size);
   }
   static Slice DecodeValueMeta(const Slice& slice) {
     assert(slice.size() >= sizeof(uint64_t));
-    return Slice(slice.data() + sizeof(uint64_t),
-                 slice.size() - sizeof(uint64_t));
+    Slice meta(slice.data() + sizeof(uint64_t),
+               slice.size() - sizeof(uint64_t));
+    if ((DecodeFixed64(slice.data()) & kValueHandleFlag) != 0) {
+      uint64_t offset, size;
+      GetVarint64(&meta, &offset);
+      GetVarint64(&meta, &size);
+    }
+    return meta;
   }
 
   static Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
                                 uint64_t file_number, const Slice& meta,
                                 bool is_merge, bool is_index,
-                                const ValueExtractor* value_meta_extractor);
+                                const ValueExtractor* value_meta_extractor,
+                                const ValueHandle& handle = ValueHandle());
 
   virtual Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
                                  const Slice& meta, bool is_merge,
-                                 bool is_index) {
+                                 bool is_index, const ValueHandle& handle) {
     assert(value.file_number() != uint64_t(-1));
     return TransToSeparate(internal_key, value, value.file_number(), meta,
-                           is_merge, is_index, nullptr);
+                           is_merge, is_index, nullptr, handle);
   }
 
   virtual Status TransToSeparate(const Slice& /*internal_key*/,
@@ -829,6 +861,22 @@ class SeparateHelper {
 
   virtual LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                                      const LazyBuffer& value) const = 0;
+
+  // Same as TransToCombined, but the value is fetched with the fill_cache,
+  // verify_checksums and read_tier of "read_options", for user reads.
+  virtual LazyBuffer TransToCombinedForRead(
+      const Slice& user_key, uint64_t sequence, const LazyBuffer& value,
+      const ReadOptions& /*read_options*/) const {
+    return TransToCombined(user_key, sequence, value);
+  }
+
+  // Returns a helper that combines a forward scan's separated values, or
+  // nullptr if the scan should go through this helper. The caller owns the
+  // result, see ReadOptions::blob_lookahead.
+  virtual SeparateHelper* NewScanHelper(
+      const ReadOptions& /*read_options*/) const {
+    return nullptr;
+  }
 };
 
 extern Slice ArenaPinSlice(const Slice& slice, Arena* arena);
@@ -300,6 +300,7 @@ Status FlushJob::WriteLevel0Table() {
   Status s;
   {
     auto write_hint = cfd_->CalculateSSTWriteHint(0);
+    auto blob_write_hint = cfd_->CalculateBlobWriteHint(0);
     db_mutex_->Unlock();
     if (log_buffer_) {
       log_buffer_->FlushBufferToLog();
@@ -397,7 +398,7 @@ Status FlushJob::WriteLevel0Table() {
           mutable_cf_options_.paranoid_file_checks, cfd_->internal_stats(),
           TableFileCreationReason::kFlush, event_logger_, job_context_->job_id,
           Env::IO_HIGH, &table_properties_, 0 /* level */, flush_load_,
-          current_time, oldest_key_time, write_hint);
+          current_time, oldest_key_time, write_hint, blob_write_hint);
       if (s.ok() && cfd_->ioptions()->ttl_extractor_factory != nullptr) {
         ROCKS_LOG_INFO(db_options_.info_log,
                        "FlushOutput earliest_time_begin_compact = %" PRIu64
@@ -218,6 +218,7 @@ static const std::string cfstats_no_file_histogram =
 static const std::string cf_file_histogram = "cf-file-histogram";
 static const std::string dbstats = "dbstats";
 static const std::string levelstats = "levelstats";
+static const std::string map_sst_read_amp = "map-sst-read-amp";
 static const std::string num_immutable_mem_table = "num-immutable-mem-table";
 static const std::string num_immutable_mem_table_flushed =
     "num-immutable-mem-table-flushed";
@@ -282,6 +283,8 @@ const std::string DB::Properties::kCFFileHistogram =
     rocksdb_prefix + cf_file_histogram;
 const std::string DB::Properties::kDBStats = rocksdb_prefix + dbstats;
 const std::string DB::Properties::kLevelStats = rocksdb_prefix + levelstats;
+const std::string DB::Properties::kMapSstReadAmp =
+    rocksdb_prefix + map_sst_read_amp;
 const std::string DB::Properties::kNumImmutableMemTable =
     rocksdb_prefix + num_immutable_mem_table;
 const std::string DB::Properties::kNumImmutableMemTableFlushed =
@@ -364,6 +367,9 @@ const std::unordered_map<std::string, DBPropertyInfo>
           nullptr, nullptr}},
         {DB::Properties::kLevelStats,
          {false, &InternalStats::HandleLevelStats, nullptr, nullptr, nullptr}},
+        {DB::Properties::kMapSstReadAmp,
+         {false, &InternalStats::HandleMapSstReadAmp, nullptr, nullptr,
+          nullptr}},
         {DB::Properties::kStats,
          {false, &InternalStats::HandleStats, nullptr, nullptr, nullptr}},
         {DB::Properties::kCFStats,
@@ -578,6 +584,46 @@ bool InternalStats::HandleLevelStats(std::string* value, Slice /*suffix*/) {
   return true;
 }
 
+bool InternalStats::HandleMapSstReadAmp(std::string* value, Slice /*suffix*/) {
+  char buf[1000];
+  const auto* vstorage = cfd_->current()->storage_info();
+  const auto& icomp = cfd_->internal_comparator();
+  snprintf(buf, sizeof(buf),
+           "Level     File      Reads     Probes ReadAmp Range\n"
+           "--------------------------------------------------\n");
+  value->append(buf);
+
+  typedef std::pair<std::string, MapSstReadStats::Range> RangeReads;
+  for (int level = 0; level < number_levels_; level++) {
+    for (auto f : vstorage->LevelFiles(level)) {
+      auto map_reads = f->stats.map_reads.load(std::memory_order_relaxed);
+      if (!f->prop.is_map_sst() || map_reads == nullptr) {
+        continue;
+      }
+      auto ranges = map_reads->GetRanges();
+      std::vector<RangeReads> sorted_ranges(ranges.begin(), ranges.end());
+      std::sort(sorted_ranges.begin(), sorted_ranges.end(),
+                [&icomp](const RangeReads& a, const RangeReads& b) {
+                  return icomp.Compare(a.first, b.first) < 0;
+                });
+      for (auto& range : sorted_ranges) {
+        const auto& reads = range.second;
+        snprintf(buf, sizeof(buf),
+                 "%5d %8" PRIu64 " %10" PRIu64 " %10" PRIu64 " %7.2f ", level,
+                 f->fd.GetNumber(), reads.num_reads, reads.num_probes,
+                 1. * reads.num_probes / std::max<uint64_t>(1, reads.num_reads));
+        value->append(buf);
+        value->append("[");
+        value->append(ExtractUserKey(reads.smallest_key).ToString(true));
+        value->append(", ");
+        value->append(ExtractUserKey(range.first).ToString(true));
+        value->append("]\n");
+      }
+    }
+  }
+  return true;
+}
+
 bool InternalStats::HandleStats(std::string* value, Slice suffix) {
   if (!HandleCFStats(value, suffix)) {
     return false;
@@ -282,6 +282,55 @@ class MapSstElementIterator : public MapSstRangeIterator {
       status_ = iter->status();
     }
   }
+  // Tombstones of a newer link delete values the older links of the range
+  // still reference. Nothing rewrites them until the range gets compacted, so
+  // discount the older links by the entries those tombstones likely shadow,
+  // spread over them by their entry count. The blob files they point to then
+  // see the garbage as soon as the map sst is installed.
+  template <class PutDependence>
+  void PutRangeDependence(const std::vector<MapSstElement::LinkTarget>& links,
+                          const PutDependence& put_dependence) {
+    struct LinkEstimation {
+      const MapSstElement::LinkTarget* link;
+      SequenceNumber seqno;
+      double entries;
+      double deletions;
+    };
+    std::vector<LinkEstimation> estimations;
+    estimations.reserve(links.size());
+    double total_entries = 0;
+    for (auto& link : links) {
+      auto f = iterator_cache_.GetFileMetaData(link.file_number);
+      if (links.size() == 1 || f == nullptr || f->prop.num_entries == 0) {
+        put_dependence(link.file_number, link.size);
+        continue;
+      }
+      double entries = double(f->prop.num_entries) * link.size /
+                       std::max<uint64_t>(1, f->fd.file_size);
+      estimations.emplace_back(LinkEstimation{
+          &link, f->fd.largest_seqno, entries,
+          entries * f->prop.num_deletions / f->prop.num_entries});
+      total_entries += entries;
+    }
+    std::sort(estimations.begin(), estimations.end(),
+              [](const LinkEstimation& l, const LinkEstimation& r) {
+                return l.seqno > r.seqno;
+              });
+    double shadowing = 0;
+    for (auto& e : estimations) {
+      double shadowed = 0;
+      if (total_entries > 0) {
+        shadowed = std::min(e.entries, shadowing * e.entries / total_entries);
+      }
+      shadowing += e.deletions - shadowed;
+      total_entries -= e.entries;
+      uint64_t size = e.link->size;
+      if (e.entries > 0) {
+        size -= std::min(size, uint64_t(size * shadowed / e.entries));
+      }
+      put_dependence(e.link->file_number, size);
+    }
+  }
   void PrepareNext() {
     while (true) {
       if (where_ == ranges_.end()) {
@@ -325,7 +374,6 @@ class MapSstElementIterator : public MapSstRangeIterator {
       };
       if (stable) {
         for (auto& link : links) {
-          put_dependence(link.file_number, link.size);
           range_size += link.size;
         }
       } else {
@@ -384,7 +432,6 @@ class MapSstElementIterator : public MapSstRangeIterator {
               return;
             }
           }
-          put_dependence(link.file_number, link.size);
         }
         links.erase(std::remove_if(links.begin(), links.end(),
                                    [](const MapSstElement::LinkTarget& link) {
@@ -395,6 +442,7 @@ class MapSstElementIterator : public MapSstRangeIterator {
           continue;
         }
       }
+      PutRangeDependence(links, put_dependence);
       sst_read_amp_ = std::max(sst_read_amp_, map_elements_.link.size());
       sst_read_amp_ratio_ += map_elements_.link.size() * range_size;
       sst_read_amp_size_ += range_size;
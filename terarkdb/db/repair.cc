@@ -421,6 +421,7 @@ class Repairer {
       SnapshotChecker* snapshot_checker = DisableGCSnapshotChecker::Instance();
 
       auto write_hint = cfd->CalculateSSTWriteHint(0);
+      auto blob_write_hint = cfd->CalculateBlobWriteHint(0);
       auto get_arena_input_iter = [&](Arena& arena) {
         return mem->NewIterator(ro, &arena);
       };
@@ -446,8 +447,9 @@ class Repairer {
           snapshot_checker, kNoCompression, CompressionOptions(), false,
           nullptr /* internal_stats */, TableFileCreationReason::kRecovery,
           nullptr /* event_logger */, 0 /* job_id */, Env::IO_HIGH,
-          nullptr /* table_properties */, -1 /* level */, current_time,
-          write_hint);
+          nullptr /* table_properties */, -1 /* level */,
+          0 /* compaction_load */, current_time, 0 /* oldest_key_time */,
+          write_hint, blob_write_hint);
       ROCKS_LOG_INFO(db_options_.info_log,
                      "Log #%" PRIu64 ": %d ops saved to Table #%" PRIu64 " %s",
                      log, counter, meta[0].fd.GetNumber(),
@@ -12,6 +12,7 @@
 #include "db/dbformat.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/version_edit.h"
+#include "monitoring/file_read_sample.h"
 #include "monitoring/perf_context_imp.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/terark_namespace.h"
@@ -373,7 +374,8 @@ InternalIterator* TableCache::NewIterator(
         }
         auto map_sst_iter = NewMapSstIterator(
             &file_meta, result, dependence_map, ioptions_.internal_comparator,
-            lazy_create_iter, c_style_callback(*lazy_create_iter), arena);
+            lazy_create_iter, c_style_callback(*lazy_create_iter), arena,
+            !for_compaction /* sample_reads */);
         if (arena != nullptr) {
           map_sst_iter->RegisterCleanup(
               [](void* arg1, void* arg2) {
@@ -433,6 +435,24 @@ InternalIterator* TableCache::NewIterator(
   return result;
 }
 
+bool TableCache::SkipForGarbageCollection(const FileMetaData& file_meta,
+                                          const Slice& k,
+                                          const FileMetaData& blob) {
+  // fast path for GC
+  RecordTick(ioptions_.statistics, GC_TOUCH_FILES);
+  SequenceNumber ikey_seq = GetInternalKeySeqno(k);
+  if (ikey_seq < file_meta.fd.smallest_seqno ||
+      ikey_seq > file_meta.fd.largest_seqno) {
+    RecordTick(ioptions_.statistics, GC_SKIP_GET_BY_SEQ);
+    return true;
+  }
+  if (!file_meta.prop.is_map_sst() && InheritanceMismatch(file_meta, blob)) {
+    RecordTick(ioptions_.statistics, GC_SKIP_GET_BY_FILE);
+    return true;
+  }
+  return false;
+}
+
 Status TableCache::Get(const ReadOptions& options,
                        const FileMetaData& file_meta,
                        const DependenceMap& dependence_map, const Slice& k,
@@ -440,20 +460,9 @@ Status TableCache::Get(const ReadOptions& options,
                        const SliceTransform* prefix_extractor,
                        HistogramImpl* file_read_hist, bool skip_filters,
                        int level, const FileMetaData* inheritance) {
-  if (inheritance != nullptr) {
-    // fast path for GC
-    RecordTick(ioptions_.statistics, GC_TOUCH_FILES);
-    SequenceNumber ikey_seq = GetInternalKeySeqno(k);
-    if (ikey_seq < file_meta.fd.smallest_seqno ||
-        ikey_seq > file_meta.fd.largest_seqno) {
-      RecordTick(ioptions_.statistics, GC_SKIP_GET_BY_SEQ);
-      return Status::OK();
-    }
-    if (!file_meta.prop.is_map_sst() &&
-        InheritanceMismatch(file_meta, *inheritance)) {
-      RecordTick(ioptions_.statistics, GC_SKIP_GET_BY_FILE);
-      return Status::OK();
-    }
+  if (inheritance != nullptr &&
+      SkipForGarbageCollection(file_meta, k, *inheritance)) {
+    return Status::OK();
   }
   auto& fd = file_meta.fd;
   IterKey key_buffer;
@@ -483,6 +492,8 @@ Status TableCache::Get(const ReadOptions& options,
       ReadOptions forward_options = options;
       forward_options.ignore_range_deletions |=
           file_meta.prop.map_handle_range_deletions();
+      // GC lookups are not user reads
+      bool sample = get_context->sample() && inheritance == nullptr;
       auto get_from_map = [&](const Slice& largest_key,
                               LazyBuffer&& map_value) {
         s = map_value.fetch();
@@ -573,9 +584,17 @@ Status TableCache::Get(const ReadOptions& options,
 
           if (!s.ok() || get_context->is_finished()) {
             // error or found, recovery min_seq_type_backup is unnecessary
+            if (s.ok() && sample) {
+              sample_map_range_read_inc(file_meta, smallest_key, largest_key,
+                                        i + 1);
+            }
             return false;
           }
         }
+        if (sample) {
+          sample_map_range_read_inc(file_meta, smallest_key, largest_key,
+                                    link_count);
+        }
         // recovery min_seq_backup
         get_context->SetMinSequenceAndType(min_seq_type_backup);
         return is_largest_user_key;
@@ -594,6 +613,34 @@ Status TableCache::Get(const ReadOptions& options,
   return s;
 }
 
+Status TableCache::GetByHandle(const ReadOptions& options,
+                               const FileMetaData& file_meta, const Slice& k,
+                               const ValueHandle& value_handle,
+                               GetContext* get_context) {
+  assert(!file_meta.prop.is_map_sst());
+  auto& fd = file_meta.fd;
+  Status s;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    s = FindTable(env_options_, fd, &handle, nullptr /* prefix_extractor */,
+                  options.read_tier == kBlockCacheTier /* no_io */);
+    if (s.ok()) {
+      t = GetTableReaderFromHandle(handle);
+    }
+  }
+  if (s.ok()) {
+    s = t->GetByHandle(options, k, value_handle, get_context);
+  } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+    get_context->MarkKeyMayExist();
+    s = Status::OK();
+  }
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+  return s;
+}
+
 Status TableCache::GetTableProperties(
     const EnvOptions& env_options, const FileMetaData& file_meta,
     std::shared_ptr<const TableProperties>* properties,
@@ -76,6 +76,18 @@ class TableCache {
              HistogramImpl* file_read_hist = nullptr, bool skip_filters = false,
              int level = -1, const FileMetaData* inheritance = nullptr);
 
+  // Returns true if a GC lookup of internal key "k", for a value in blob sst
+  // "blob", can't be answered by "file_meta", judged from its sequence range
+  // and its dependences alone.
+  bool SkipForGarbageCollection(const FileMetaData& file_meta, const Slice& k,
+                                const FileMetaData& blob);
+
+  // Read the entry of user key "k" at "value_handle" in a blob sst, see
+  // TableReader::GetByHandle.
+  Status GetByHandle(const ReadOptions& options, const FileMetaData& file_meta,
+                     const Slice& k, const ValueHandle& value_handle,
+                     GetContext* get_context);
+
   // Evict any entry for the specified file number
   static void Evict(Cache* cache, uint64_t file_number);
 
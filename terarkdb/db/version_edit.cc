@@ -87,6 +87,56 @@ uint64_t PackFileNumberAndPathId(uint64_t number, uint64_t path_id) {
   return number | (path_id * (kFileNumberMask + 1));
 }
 
+void MapSstReadStats::Add(const Slice& smallest_key, const Slice& largest_key,
+                          uint64_t num_reads, uint64_t num_probes) {
+  uint64_t extra_probes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& range = ranges_[largest_key.ToString()];
+    if (range.num_reads == 0) {
+      range.smallest_key = smallest_key.ToString();
+    }
+    range.num_reads += num_reads;
+    range.num_probes += num_probes;
+    extra_probes = range.num_probes - range.num_reads;
+  }
+  uint64_t max_extra_probes = this->max_extra_probes();
+  while (extra_probes > max_extra_probes &&
+         !max_extra_probes_.compare_exchange_weak(max_extra_probes,
+                                                  extra_probes,
+                                                  std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t MapSstReadStats::ExtraProbes(const Slice& largest_key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto find = ranges_.find(largest_key.ToString());
+  if (find == ranges_.end()) {
+    return 0;
+  }
+  return find->second.num_probes - find->second.num_reads;
+}
+
+std::unordered_map<std::string, MapSstReadStats::Range>
+MapSstReadStats::GetRanges() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ranges_;
+}
+
+MapSstReadStats* FileSampledStats::GetMapReads() const {
+  MapSstReadStats* map_reads_ptr = map_reads.load(std::memory_order_acquire);
+  if (map_reads_ptr == nullptr) {
+    auto* new_map_reads = new MapSstReadStats();
+    if (map_reads.compare_exchange_strong(map_reads_ptr, new_map_reads,
+                                          std::memory_order_acq_rel)) {
+      map_reads_ptr = new_map_reads;
+    } else {
+      delete new_map_reads;
+    }
+  }
+  return map_reads_ptr;
+}
+
 std::vector<SequenceNumber> FileMetaData::ShrinkSnapshot(
     const std::vector<SequenceNumber>& snapshots) const {
   std::vector<SequenceNumber> ret = snapshots;
@@ -10,8 +10,10 @@
 #pragma once
 #include <algorithm>
 #include <atomic>
+#include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -68,16 +70,66 @@ struct FileDescriptor {
   uint64_t GetFileSize() const { return file_size; }
 };
 
+// Sampled user reads through the ranges of a map sst. A read of a range
+// probes every file the range links to until the key is found, so
+// "probes - reads" is what the reads have paid for the range being mapped.
+class MapSstReadStats {
+ public:
+  struct Range {
+    std::string smallest_key;
+    uint64_t num_reads = 0;
+    uint64_t num_probes = 0;
+  };
+
+  // Add reads of the range [smallest_key, largest_key] that probed
+  // "num_probes" link files in total
+  void Add(const Slice& smallest_key, const Slice& largest_key,
+           uint64_t num_reads, uint64_t num_probes);
+
+  // Probes beyond the first one, summed over the reads of the range ending
+  // at largest_key
+  uint64_t ExtraProbes(const Slice& largest_key) const;
+
+  // The largest ExtraProbes() of all ranges
+  uint64_t max_extra_probes() const {
+    return max_extra_probes_.load(std::memory_order_relaxed);
+  }
+
+  // Returns true only for the first call after max_extra_probes() reached
+  // "threshold"
+  bool TakeFlattenRequest(uint64_t threshold) {
+    return max_extra_probes() >= threshold &&
+           !flatten_requested_.exchange(true, std::memory_order_relaxed);
+  }
+
+  // Ranges keyed by their largest key
+  std::unordered_map<std::string, Range> GetRanges() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Range> ranges_;
+  std::atomic<uint64_t> max_extra_probes_{0};
+  std::atomic<bool> flatten_requested_{false};
+};
+
 struct FileSampledStats {
-  FileSampledStats() : num_reads_sampled(0) {}
-  FileSampledStats(const FileSampledStats& other) { *this = other; }
+  FileSampledStats() : num_reads_sampled(0), map_reads(nullptr) {}
+  FileSampledStats(const FileSampledStats& other) : FileSampledStats() {
+    *this = other;
+  }
   FileSampledStats& operator=(const FileSampledStats& other) {
     num_reads_sampled = other.num_reads_sampled.load();
     return *this;
   }
+  ~FileSampledStats() { delete map_reads.load(std::memory_order_relaxed); }
+
+  // Reads through the ranges of a map sst, created by the first of them
+  MapSstReadStats* GetMapReads() const;
 
   // number of user reads to this file.
   mutable std::atomic<uint64_t> num_reads_sampled;
+  // not copied, every file starts with its own
+  mutable std::atomic<MapSstReadStats*> map_reads;
 };
 
 struct TablePropertyCache {
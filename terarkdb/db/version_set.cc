@@ -1272,20 +1272,61 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
       refs_(0),
       env_options_(env_opt),
       mutable_cf_options_(mutable_cf_options),
-      version_number_(version_number) {}
+      version_number_(version_number),
+      value_handle_state_(this) {}
+
+// Separated values are fetched with the read options of the caller, kept in
+// the top byte of the sequence in the context of their buffer.
+namespace {
+const int kReadFlagsShift = 56;
+const uint64_t kFillCacheFlag = 1;
+const uint64_t kVerifyChecksumsFlag = 2;
+const int kReadTierShift = 2;
+
+uint64_t EncodeReadFlags(const ReadOptions& read_options) {
+  uint64_t flags = static_cast<uint64_t>(read_options.read_tier)
+                   << kReadTierShift;
+  if (read_options.fill_cache) {
+    flags |= kFillCacheFlag;
+  }
+  if (read_options.verify_checksums) {
+    flags |= kVerifyChecksumsFlag;
+  }
+  return flags << kReadFlagsShift;
+}
+
+ReadOptions DecodeReadFlags(uint64_t data) {
+  uint64_t flags = data >> kReadFlagsShift;
+  ReadOptions read_options;
+  read_options.fill_cache = (flags & kFillCacheFlag) != 0;
+  read_options.verify_checksums = (flags & kVerifyChecksumsFlag) != 0;
+  read_options.read_tier = static_cast<ReadTier>(flags >> kReadTierShift);
+  return read_options;
+}
+}  // namespace
 
 Status Version::fetch_buffer(LazyBuffer* buffer) const {
   auto context = get_context(buffer);
   Slice user_key(reinterpret_cast<const char*>(context->data[0]),
                  context->data[1]);
-  uint64_t sequence = context->data[2];
+  uint64_t sequence = context->data[2] & kMaxSequenceNumber;
   auto pair = *reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
+  return FetchSeparatedValue(DecodeReadFlags(context->data[2]), user_key,
+                             sequence, pair, buffer);
+}
+
+Status Version::FetchSeparatedValue(const ReadOptions& read_options,
+                                    const Slice& user_key, uint64_t sequence,
+                                    const DependenceMap::value_type& pair,
+                                    LazyBuffer* buffer) const {
   if (pair.second->fd.GetNumber() != pair.first) {
     RecordTick(db_statistics_, READ_BLOB_INVALID);
   } else {
     RecordTick(db_statistics_, READ_BLOB_VALID);
   }
-  bool value_found = false;
+  // Cleared if the value is not in the block cache and read_tier doesn't
+  // allow IO
+  bool value_found = true;
   SequenceNumber context_seq;
   GetContext get_context(cfd_->internal_comparator().user_comparator(), nullptr,
                          cfd_->ioptions()->info_log, db_statistics_,
@@ -1294,12 +1335,15 @@ Status Version::fetch_buffer(LazyBuffer* buffer) const {
   IterKey iter_key;
   iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
   auto s = table_cache_->Get(
-      ReadOptions(), *pair.second, storage_info_.dependence_map(),
+      read_options, *pair.second, storage_info_.dependence_map(),
       iter_key.GetInternalKey(), &get_context,
       mutable_cf_options_.prefix_extractor.get(), nullptr, true);
   if (!s.ok()) {
     return s;
   }
+  if (!value_found) {
+    return Status::Incomplete("Separate value not in block cache");
+  }
   if (context_seq != sequence || (get_context.State() != GetContext::kFound &&
                                   get_context.State() != GetContext::kMerge)) {
     if (get_context.State() == GetContext::kCorrupt) {
@@ -1316,8 +1360,58 @@ Status Version::fetch_buffer(LazyBuffer* buffer) const {
   return Status::OK();
 }
 
+Status Version::ValueHandleState::fetch_buffer(LazyBuffer* buffer) const {
+  auto context = get_context(buffer);
+  Slice user_key(reinterpret_cast<const char*>(context->data[0]),
+                 static_cast<uint32_t>(context->data[1]));
+  ValueHandle handle;
+  handle.offset = context->data[2];
+  handle.size = context->data[1] >> 32;
+  uint64_t sequence = context->data[3] & kMaxSequenceNumber;
+  ReadOptions read_options = DecodeReadFlags(context->data[3]);
+  auto& dependence_map = version_->storage_info_.dependence_map();
+  auto find = dependence_map.find(buffer->file_number());
+  assert(find != dependence_map.end());
+  auto pair = *find;
+  assert(pair.second->fd.GetNumber() == pair.first);
+  bool value_found = true;
+  GetContext get_context(
+      version_->cfd_->internal_comparator().user_comparator(), nullptr,
+      version_->cfd_->ioptions()->info_log, version_->db_statistics_,
+      GetContext::kNotFound, user_key, buffer, &value_found, nullptr, nullptr,
+      nullptr, version_->env_);
+  IterKey iter_key;
+  iter_key.SetInternalKey(user_key, kMaxSequenceNumber, kValueTypeForSeek);
+  auto s = version_->table_cache_->GetByHandle(
+      read_options, *pair.second, iter_key.GetInternalKey(), handle,
+      &get_context);
+  if (get_context.State() == GetContext::kCorrupt) {
+    return std::move(get_context).CorruptReason();
+  }
+  if (s.ok() && !value_found) {
+    return Status::Incomplete("Separate value not in block cache");
+  }
+  if (s.IsNotFound() || s.IsNotSupported() ||
+      (s.ok() && get_context.State() != GetContext::kFound &&
+       get_context.State() != GetContext::kMerge)) {
+    // The block at the handle doesn't hold the value, look it up by key.
+    return version_->FetchSeparatedValue(read_options, user_key, sequence,
+                                         pair, buffer);
+  }
+  if (s.ok()) {
+    RecordTick(version_->db_statistics_, READ_BLOB_VALID);
+  }
+  return s;
+}
+
 LazyBuffer Version::TransToCombined(const Slice& user_key, uint64_t sequence,
                                     const LazyBuffer& value) const {
+  return TransToCombinedForRead(user_key, sequence, value, ReadOptions());
+}
+
+LazyBuffer Version::TransToCombinedForRead(
+    const Slice& user_key, uint64_t sequence, const LazyBuffer& value,
+    const ReadOptions& read_options) const {
   auto s = value.fetch();
   if (!s.ok()) {
     return LazyBuffer(std::move(s));
@@ -1327,21 +1421,162 @@ LazyBuffer Version::TransToCombined(const Slice& user_key, uint64_t sequence,
   auto find = dependence_map.find(file_number);
   if (find == dependence_map.end()) {
     return LazyBuffer(Status::Corruption("Separate value dependence missing"));
+  }
+  ValueHandle handle;
+  // A handle is only good in the blob sst it was taken in, not in the one
+  // GC moved the value to.
+  if (find->second->fd.GetNumber() == file_number &&
+      !find->second->prop.is_map_sst() &&
+      SeparateHelper::DecodeValueHandle(value.slice(), &handle) &&
+      handle.size <= port::kMaxUint32 && user_key.size() <= port::kMaxUint32) {
+    return LazyBuffer(
+        &value_handle_state_,
+        {reinterpret_cast<uint64_t>(user_key.data()),
+         user_key.size() | (handle.size << 32), handle.offset,
+         sequence | EncodeReadFlags(read_options)},
+        Slice::Invalid(), file_number);
   } else {
     return LazyBuffer(
         this,
-        {reinterpret_cast<uint64_t>(user_key.data()), user_key.size(), sequence,
+        {reinterpret_cast<uint64_t>(user_key.data()), user_key.size(),
+         sequence | EncodeReadFlags(read_options),
          reinterpret_cast<uint64_t>(&*find)},
         Slice::Invalid(), find->second->fd.GetNumber());
   }
 }
 
+SeparateHelper* Version::NewScanHelper(
+    const ReadOptions& read_options) const {
+  if (read_options.blob_lookahead == 0) {
+    return nullptr;
+  }
+  return new BlobScanHelper(this, read_options);
+}
+
+Version::BlobScanHelper::BlobScanHelper(const Version* version,
+                                        const ReadOptions& read_options)
+    : version_(version), lookahead_(read_options.blob_lookahead), clock_(0) {
+  read_options_.verify_checksums = read_options.verify_checksums;
+  read_options_.fill_cache = read_options.fill_cache;
+  read_options_.read_tier = read_options.read_tier;
+  read_options_.total_order_seek = true;
+  read_options_.readahead_size =
+      read_options.blob_readahead_budget / kMaxCursors;
+  cursors_.reserve(kMaxCursors);
+}
+
+LazyBuffer Version::BlobScanHelper::TransToCombined(
+    const Slice& user_key, uint64_t sequence, const LazyBuffer& value) const {
+  auto s = value.fetch();
+  if (!s.ok()) {
+    return LazyBuffer(std::move(s));
+  }
+  uint64_t file_number = SeparateHelper::DecodeFileNumber(value.slice());
+  auto& dependence_map = version_->storage_info_.dependence_map();
+  auto find = dependence_map.find(file_number);
+  if (find == dependence_map.end()) {
+    return LazyBuffer(Status::Corruption("Separate value dependence missing"));
+  }
+  if (find->second->prop.is_map_sst()) {
+    return version_->TransToCombined(user_key, sequence, value);
+  }
+  return LazyBuffer(
+      this,
+      {reinterpret_cast<uint64_t>(user_key.data()), user_key.size(), sequence,
+       reinterpret_cast<uint64_t>(&*find)},
+      Slice::Invalid(), find->second->fd.GetNumber());
+}
+
+Version::BlobScanHelper::Cursor* Version::BlobScanHelper::GetCursor(
+    const FileMetaData& file) const {
+  Cursor* victim = nullptr;
+  for (auto& cursor : cursors_) {
+    if (cursor.file == &file) {
+      cursor.last_use = ++clock_;
+      return &cursor;
+    }
+    if (victim == nullptr || cursor.last_use < victim->last_use) {
+      victim = &cursor;
+    }
+  }
+  if (cursors_.size() < kMaxCursors) {
+    cursors_.emplace_back();
+    victim = &cursors_.back();
+  }
+  const Version* v = version_;
+  victim->iter.reset(v->table_cache_->NewIterator(
+      read_options_, v->env_options_, file, v->storage_info_.dependence_map(),
+      nullptr /* range_del_agg */,
+      v->mutable_cf_options_.prefix_extractor.get(),
+      nullptr /* table_reader_ptr */, nullptr /* file_read_hist */,
+      false /* for_compaction */, nullptr /* arena */,
+      true /* skip_filters */));
+  victim->file = &file;
+  victim->last_use = ++clock_;
+  return victim;
+}
+
+Status Version::BlobScanHelper::fetch_buffer(LazyBuffer* buffer) const {
+  auto context = get_context(buffer);
+  Slice user_key(reinterpret_cast<const char*>(context->data[0]),
+                 context->data[1]);
+  uint64_t sequence = context->data[2];
+  auto pair = *reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
+  const Version* v = version_;
+  if (pair.second->fd.GetNumber() != pair.first) {
+    RecordTick(v->db_statistics_, READ_BLOB_INVALID);
+  } else {
+    RecordTick(v->db_statistics_, READ_BLOB_VALID);
+  }
+  PERF_TIMER_GUARD(blob_scan_read_time);
+  PERF_COUNTER_ADD(blob_scan_read_count, 1);
+
+  InternalIterator* iter = GetCursor(*pair.second)->iter.get();
+  IterKey iter_key;
+  iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
+  Slice target = iter_key.GetInternalKey();
+  auto icmp = v->internal_comparator();
+  for (size_t steps = 0; iter->Valid() && steps < lookahead_ &&
+                         icmp->Compare(iter->key(), target) < 0;
+       ++steps) {
+    iter->Next();
+  }
+  ParsedInternalKey found;
+  auto match = [&] {
+    return iter->Valid() && ParseInternalKey(iter->key(), &found) &&
+           found.sequence == sequence &&
+           icmp->user_comparator()->Compare(found.user_key, user_key) == 0;
+  };
+  if (!match()) {
+    PERF_COUNTER_ADD(blob_scan_seek_count, 1);
+    iter->Seek(target);
+    if (!match()) {
+      if (!iter->status().ok()) {
+        return iter->status();
+      }
+      char buf[128];
+      snprintf(buf, sizeof buf,
+               "file number = %" PRIu64 "(%" PRIu64 "), sequence = %" PRIu64,
+               pair.second->fd.GetNumber(), pair.first, sequence);
+      return Status::Corruption("Separate value missing", buf);
+    }
+  }
+  // The cursor moves on with the next fetch, keep a copy
+  LazyBuffer value = iter->value();
+  auto s = value.fetch();
+  if (!s.ok()) {
+    return s;
+  }
+  buffer->reset(value.slice(), true, pair.second->fd.GetNumber());
+  return Status::OK();
+}
+
 void Version::Get(const ReadOptions& read_options, const Slice& user_key,
                   const LookupKey& k, LazyBuffer* value, Status* status,
                   MergeContext* merge_context,
                   SequenceNumber* max_covering_tombstone_seq, bool* value_found,
                   bool* key_exists, SequenceNumber* seq,
-                  ReadCallback* callback) {
+                  ReadCallback* callback, bool defer_separated_value) {
   Slice ikey = k.internal_key();
 
   assert(status->ok() || status->IsMergeInProgress());
@@ -1356,6 +1591,10 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
       status->ok() ? GetContext::kNotFound : GetContext::kMerge, user_key,
       value, value_found, merge_context, this, max_covering_tombstone_seq,
       this->env_, seq, callback);
+  if (defer_separated_value) {
+    get_context.DeferSeparatedValue();
+  }
+  get_context.SetReadOptions(&read_options);
 
   FilePicker fp(
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
@@ -1384,6 +1623,12 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
         IsFilterSkipped(static_cast<int>(fp.GetHitFileLevel()),
                         fp.IsHitFileLastInLevel()),
         fp.GetCurrentLevel());
+    if (get_context.sample() && f->file_metadata->prop.is_map_sst() &&
+        mutable_cf_options_.map_sst_flatten_threshold > 0 &&
+        f->file_metadata->stats.GetMapReads()->TakeFlattenRequest(
+            mutable_cf_options_.map_sst_flatten_threshold)) {
+      cfd_->RequestMapSstFlatten();
+    }
     // TODO: examine the behavior for corrupted key
     if (timer_enabled) {
       PERF_COUNTER_BY_LEVEL_ADD(get_from_table_nanos, timer.ElapsedNanos(),
@@ -1465,6 +1710,7 @@ void Version::GetKey(const Slice& user_key, const Slice& ikey, Status* status,
                          GetContext::kNotFound, user_key, value, &value_found,
                          nullptr, nullptr, nullptr, env_, seq);
   ReadOptions options;
+  options.fill_cache = false;
 
   FilePicker fp(
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
@@ -1501,6 +1747,132 @@ void Version::GetKey(const Slice& user_key, const Slice& ikey, Status* status,
   *status = Status::NotFound();
 }
 
+Version::SortedKeyGetter::SortedKeyGetter(Version* version)
+    : version_(version) {
+  auto vstorage = version->storage_info();
+  size_t num_level0_files = vstorage->num_non_empty_levels_ > 0
+                                ? vstorage->level_files_brief_[0].num_files
+                                : 0;
+  cursors_.resize(num_level0_files + vstorage->num_levels());
+}
+
+void Version::SortedKeyGetter::GetKey(const Slice& user_key, const Slice& ikey,
+                                      Status* status, ValueType* type,
+                                      SequenceNumber* seq, LazyBuffer* value,
+                                      const FileMetaData& blob) {
+  Version* v = version_;
+  RecordTick(v->db_statistics_, GC_GET_KEYS);
+  auto icmp = v->internal_comparator();
+  auto ucmp = v->user_comparator();
+  if (!last_ikey_.empty() && icmp->Compare(ikey, last_ikey_) < 0) {
+    // Out of order, every cursor needs a fresh seek
+    for (auto& cursor : cursors_) {
+      cursor.positioned = false;
+    }
+  }
+  last_ikey_.assign(ikey.data(), ikey.size());
+
+  auto& vstorage = v->storage_info_;
+  FilePicker fp(vstorage.files_, user_key, ikey, &vstorage.level_files_brief_,
+                vstorage.num_non_empty_levels_, &vstorage.file_indexer_, ucmp,
+                icmp);
+  for (FdWithKeyRange* f = fp.GetNextFile(); f != nullptr;
+       f = fp.GetNextFile()) {
+    int level = fp.GetCurrentLevel();
+    const FileMetaData& file = *f->file_metadata;
+    if (ucmp->Compare(user_key, ExtractUserKey(f->smallest_key)) < 0 ||
+        ucmp->Compare(user_key, ExtractUserKey(f->largest_key)) > 0 ||
+        v->table_cache_->SkipForGarbageCollection(file, ikey, blob)) {
+      continue;
+    }
+    if (file.prop.is_map_sst()) {
+      // A map sst forwards the lookup to the ssts it depends on, which
+      // Version::GetKey handles
+      v->GetKey(user_key, ikey, status, type, seq, value, blob);
+      return;
+    }
+    size_t num_level0_files = vstorage.level_files_brief_[0].num_files;
+    size_t index = level == 0 ? f - vstorage.level_files_brief_[0].files
+                              : num_level0_files + level - 1;
+    assert(index < cursors_.size());
+    InternalIterator* iter = Probe(&cursors_[index], file, level, ikey);
+    if (!iter->Valid()) {
+      if (!iter->status().ok()) {
+        *status = iter->status();
+        return;
+      }
+      continue;
+    }
+    ParsedInternalKey found;
+    if (!ParseInternalKey(iter->key(), &found)) {
+      *status = Status::Corruption("SortedKeyGetter invalid InternalKey");
+      return;
+    }
+    if (ucmp->Compare(found.user_key, user_key) != 0) {
+      continue;
+    }
+    *seq = found.sequence;
+    switch (found.type) {
+      case kTypeValue:
+      case kTypeMerge:
+      case kTypeValueIndex:
+      case kTypeMergeIndex:
+        *type = found.type;
+        *value = iter->value();
+        *status = Status::OK();
+        return;
+      case kTypeDeletion:
+      case kTypeSingleDeletion:
+        *status = Status::NotFound();
+        return;
+      default:
+        *status = Status::Corruption("SortedKeyGetter unexpected value type");
+        return;
+    }
+  }
+  *status = Status::NotFound();
+}
+
+InternalIterator* Version::SortedKeyGetter::Probe(Cursor* cursor,
+                                                  const FileMetaData& file,
+                                                  int level,
+                                                  const Slice& ikey) {
+  Version* v = version_;
+  if (cursor->file != &file) {
+    // Same as the input iterators of GC, these reads are not user reads
+    ReadOptions options;
+    options.verify_checksums = true;
+    options.fill_cache = false;
+    options.total_order_seek = true;
+    cursor->iter.reset(v->table_cache_->NewIterator(
+        options, v->env_options_, file, v->storage_info_.dependence_map(),
+        nullptr /* range_del_agg */,
+        v->mutable_cf_options_.prefix_extractor.get(),
+        nullptr /* table_reader_ptr */, nullptr /* file_read_hist */,
+        true /* for_compaction */, nullptr /* arena */,
+        true /* skip_filters */, level));
+    cursor->file = &file;
+    cursor->positioned = false;
+  }
+  InternalIterator* iter = cursor->iter.get();
+  if (cursor->positioned) {
+    auto icmp = v->internal_comparator();
+    for (int steps = 0; iter->Valid() && steps < kMaxSteps &&
+                        icmp->Compare(iter->key(), ikey) < 0;
+         ++steps) {
+      iter->Next();
+    }
+    if (!iter->Valid() || icmp->Compare(iter->key(), ikey) >= 0) {
+      RecordTick(v->db_statistics_, GC_GET_KEYS_REUSE);
+      return iter;
+    }
+  }
+  RecordTick(v->db_statistics_, GC_GET_KEYS_SEEK);
+  iter->Seek(ikey);
+  cursor->positioned = true;
+  return iter;
+}
+
 bool Version::IsFilterSkipped(int level, bool is_file_last_in_level) {
   // Reaching the bottom level implies misses at all upper levels, so we'll
   // skip checking the filters when we predict a hit.
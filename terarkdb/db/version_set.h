@@ -255,6 +255,9 @@ class VersionStorageInfo {
   // Is picker compaction fail
   bool IsPickCompactionFail() const { return is_pick_compaction_fail; }
 
+  // Let the picker retry this version, for changes it doesn't see by itself
+  void ResetPickCompactionFail() { is_pick_compaction_fail = false; }
+
   // Set picker garbage collection fail
   void SetPickGarbageCollectionFail() {
     is_pick_garbage_collection_fail = true;
@@ -684,18 +687,59 @@ class Version : public SeparateHelper, private LazyBufferState {
   //                      *key_exists will be set to false.
   // If seq is non-null, *seq will be set to the sequence number found
   // for the key if a key was found.
+  // If defer_separated_value is true, a separated value is left unfetched in
+  // *value, and stays readable for as long as this version is referenced.
   //
   // REQUIRES: lock is not held
   void Get(const ReadOptions&, const Slice& user_key, const LookupKey& key,
            LazyBuffer* value, Status* status, MergeContext* merge_context,
            SequenceNumber* max_covering_tombstone_seq,
            bool* value_found = nullptr, bool* key_exists = nullptr,
-           SequenceNumber* seq = nullptr, ReadCallback* callback = nullptr);
+           SequenceNumber* seq = nullptr, ReadCallback* callback = nullptr,
+           bool defer_separated_value = false);
 
+  // Finds the newest entry of "user_key" not newer than "ikey", skipping
+  // the files that can't hold a reference to the blob sst "blob". GC uses
+  // it through SortedKeyGetter for keys that a map sst covers.
   void GetKey(const Slice& user_key, const Slice& ikey, Status* status,
               ValueType* type, SequenceNumber* seq, LazyBuffer* value,
               const FileMetaData& blob);
 
+  // Answers GetKey for internal keys that come in ascending order, as GC
+  // reads them from its input blob ssts. A cursor is kept on each level, and
+  // on each file of level 0, so a lookup reuses the index and data blocks of
+  // the previous one, and steps forward to a nearby key instead of seeking.
+  // The version must outlive the getter.
+  class SortedKeyGetter {
+   public:
+    explicit SortedKeyGetter(Version* version);
+
+    // Same as Version::GetKey. "value" is valid until the next call.
+    void GetKey(const Slice& user_key, const Slice& ikey, Status* status,
+                ValueType* type, SequenceNumber* seq, LazyBuffer* value,
+                const FileMetaData& blob);
+
+   private:
+    struct Cursor {
+      const FileMetaData* file = nullptr;
+      std::unique_ptr<InternalIterator> iter;
+      // iter rests on the first entry not less than the last key looked up
+      bool positioned = false;
+    };
+
+    // Moves the cursor of "file" to the first entry not less than "ikey"
+    InternalIterator* Probe(Cursor* cursor, const FileMetaData& file,
+                            int level, const Slice& ikey);
+
+    // Lookups stepping over more entries than this seek instead
+    static const int kMaxSteps = 8;
+
+    Version* version_;
+    // One cursor per file of level 0, then one per level below it
+    std::vector<Cursor> cursors_;
+    std::string last_ikey_;
+  };
+
   // Loads some stats information from files. Call without mutex held. It needs
   // to be called before applying the version to the version set.
   void PrepareApply(const MutableCFOptions& mutable_cf_options);
@@ -824,6 +868,68 @@ class Version : public SeparateHelper, private LazyBufferState {
   // used for debugging and logging purposes only.
   uint64_t version_number_;
 
+  // Fetches separated values whose value index carries a ValueHandle
+  // straight from their data block in the blob sst.
+  class ValueHandleState : public LazyBufferState {
+   public:
+    explicit ValueHandleState(const Version* version) : version_(version) {}
+
+    void destroy(LazyBuffer* /*buffer*/) const override {}
+
+    Status pin_buffer(LazyBuffer* /*buffer*/) const override {
+      return Status::OK();
+    }
+
+    Status fetch_buffer(LazyBuffer* buffer) const override;
+
+   private:
+    const Version* version_;
+  };
+  ValueHandleState value_handle_state_;
+
+  // Combines the separated values of a forward scan through a cursor per blob
+  // sst. Values written in key order are found a few entries after the one
+  // read before, so a fetch steps the cursor forward instead of looking the
+  // value up from the index block, and the table reader's readahead turns the
+  // reads into sequential IO. Owned by the iterator, which must drop its
+  // buffers before the helper and the helper before the version.
+  class BlobScanHelper : public SeparateHelper, private LazyBufferState {
+   public:
+    BlobScanHelper(const Version* version, const ReadOptions& read_options);
+
+    LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
+                               const LazyBuffer& value) const override;
+
+   private:
+    struct Cursor {
+      const FileMetaData* file = nullptr;
+      std::unique_ptr<InternalIterator> iter;
+      uint64_t last_use = 0;
+    };
+
+    void destroy(LazyBuffer* /*buffer*/) const override {}
+
+    Status pin_buffer(LazyBuffer* /*buffer*/) const override {
+      return Status::OK();
+    }
+
+    Status fetch_buffer(LazyBuffer* buffer) const override;
+
+    // Returns the cursor of "file", evicting the least recently used one if
+    // all kMaxCursors are taken
+    Cursor* GetCursor(const FileMetaData& file) const;
+
+    // Blob ssts scanned at the same time, and so the share of
+    // blob_readahead_budget each cursor gets
+    static const size_t kMaxCursors = 16;
+
+    const Version* version_;
+    ReadOptions read_options_;
+    size_t lookahead_;
+    mutable std::vector<Cursor> cursors_;
+    mutable uint64_t clock_;
+  };
+
   Version(ColumnFamilyData* cfd, VersionSet* vset, const EnvOptions& env_opt,
           MutableCFOptions mutable_cf_options, uint64_t version_number = 0);
 
@@ -837,9 +943,23 @@ class Version : public SeparateHelper, private LazyBufferState {
 
   Status fetch_buffer(LazyBuffer* buffer) const override;
 
+  // Looks the separated value of "user_key" at "sequence" up by key in the
+  // blob sst of "pair".
+  Status FetchSeparatedValue(const ReadOptions& read_options,
+                             const Slice& user_key, uint64_t sequence,
+                             const DependenceMap::value_type& pair,
+                             LazyBuffer* buffer) const;
+
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                              const LazyBuffer& value) const override;
 
+  LazyBuffer TransToCombinedForRead(
+      const Slice& user_key, uint64_t sequence, const LazyBuffer& value,
+      const ReadOptions& read_options) const override;
+
+  SeparateHelper* NewScanHelper(
+      const ReadOptions& read_options) const override;
+
   // No copying allowed
   Version(const Version&);
   void operator=(const Version&);
@@ -56,4 +56,37 @@ class RemoteCompactionDispatcher : public CompactionDispatcher {
 extern std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
     std::string cmd);
 
+struct LocalCompactionDispatcherOptions {
+  // Worker processes running at the same time
+  size_t num_workers = 2;
+
+  // Jobs queued or running, StartCompaction blocks the compaction thread
+  // while the dispatcher is full
+  size_t max_pending_jobs = 16;
+
+  // Bytes of address space a worker may map on top of what it starts with,
+  // 0 for no limit. A worker going over it fails like a crashed one.
+  size_t worker_memory_limit = 0;
+
+  // Times a job is run again after its worker dies or is killed
+  int max_retries = 2;
+
+  // A program reading a job on stdin and writing its result on stdout, see
+  // tools/remote_compaction_worker_101.cc. If empty, the worker is a fork of
+  // this process, so every comparator, merge operator, table factory... the
+  // job names is registered the same way as here.
+  std::string worker_command;
+
+  // Used by forked workers
+  EnvOptions env_options;
+  Env* env = Env::Default();
+};
+
+// Runs key-value compactions in child processes, exchanging the serialized
+// job and result over pipes, so their CPU and allocations stay out of the
+// serving process. Returns nullptr where processes can't be forked.
+extern std::shared_ptr<CompactionDispatcher>
+NewLocalProcessCompactionDispatcher(
+    const LocalCompactionDispatcherOptions& options);
+
 }  // namespace TERARKDB_NAMESPACE
@@ -557,6 +557,11 @@ class DB {
     //      of files per level and total size of each level (MB).
     static const std::string kLevelStats;
 
+    //  "rocksdb.map-sst-read-amp" - returns a multi-line string with the
+    //      sampled reads through each range of the map ssts, the files they
+    //      probed and the resulting read amplification of the range.
+    static const std::string kMapSstReadAmp;
+
     //  "rocksdb.num-immutable-mem-table" - returns number of immutable
     //      memtables that have not yet been flushed.
     static const std::string kNumImmutableMemTable;
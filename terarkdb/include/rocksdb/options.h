@@ -328,6 +328,20 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // 0 to unlimited
   size_t max_dependence_blob_overlap = 1024;
 
+  // Write each separated value into a data block of its own and keep the
+  // offset and size of that block in the value index, so that reading the
+  // value skips the keyed lookup into the blob sst. Values moved by GC fall
+  // back to the keyed lookup.
+  // Only supported by BlockBasedTable, other tables ignore it.
+  bool blob_offset_index = false;
+
+  // With enable_lazy_compaction, a range of a map sst is rewritten into
+  // plain ssts once the sampled reads through it have probed this many files
+  // beyond the first link. Ranges that are read less stay mapped unless they
+  // are marked for compaction or their links hold blob_gc_ratio of garbage.
+  // 0 to rewrite every range with more than one link, regardless of reads
+  uint64_t map_sst_flatten_threshold = 0;
+
   // Maintainer job ratio
   // 0 to 1
   double maintainer_job_ratio = 0.1;
@@ -1249,6 +1263,20 @@ struct ReadOptions {
   // now only used by MultiGet
   int aio_concurrency;
 
+  // If non-zero, iterators fetch separated values through a forward cursor
+  // per blob sst instead of a point lookup per value. A cursor steps over up
+  // to blob_lookahead entries to reach the next wanted value before falling
+  // back to a seek, so values laid out in key order are read sequentially.
+  // Default: 0 (point lookup per value)
+  size_t blob_lookahead;
+
+  // Memory budget for the readahead buffers of the blob cursors above. It is
+  // split evenly over the open cursors and each share is used as the cursor's
+  // readahead_size. 0 keeps the automatic readahead of the table reader.
+  // Only used when blob_lookahead is non-zero.
+  // Default: 0
+  size_t blob_readahead_budget;
+
   // A callback to determine whether relevant keys for this scan exist in a
   // given table based on the table's properties. The callback is passed the
   // properties of each table during iteration. If the callback returns false,
@@ -101,6 +101,12 @@ struct PerfContext {
   // How many values were fed into merge operator by iterators.
   //
   uint64_t internal_merge_count;
+  // How many separated values iterators read through blob cursors, how many
+  // of those reads had to seek the cursor and the total nanos spent on them.
+  //
+  uint64_t blob_scan_read_count;
+  uint64_t blob_scan_seek_count;
+  uint64_t blob_scan_read_time;
 
   uint64_t get_snapshot_time;        // total nanos spent on getting snapshot
   uint64_t get_from_memtable_time;   // total nanos spent on querying memtables
@@ -258,6 +258,10 @@ enum Tickers : uint32_t {
   GC_TOUCH_FILES,
   GC_SKIP_GET_BY_SEQ,
   GC_SKIP_GET_BY_FILE,
+  // # of GC lookups that had to seek a cursor, and that were answered by
+  // where the cursor already was or a few steps forward.
+  GC_GET_KEYS_SEEK,
+  GC_GET_KEYS_REUSE,
 
   READ_BLOB_VALID,
   READ_BLOB_INVALID,
@@ -324,6 +328,10 @@ enum Histograms : uint32_t {
   PICK_GARBAGE_COLLECTION_TIME,
   INSTALL_SUPER_VERSION_TIME,
   BUILD_VERSION_TIME,
+  // Time a GC subcompaction spent checking which values are live, and
+  // writing them out.
+  GC_PROBE_TIME,
+  GC_REWRITE_TIME,
 
   HISTOGRAM_ENUM_MAX,
 };
@@ -3480,8 +3480,12 @@ class TickerTypeJni {
         return 0x65;
       case TERARKDB_NAMESPACE::Tickers::READ_BLOB_INVALID:
         return 0x66;
-      case TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX:
+      case TERARKDB_NAMESPACE::Tickers::GC_GET_KEYS_SEEK:
         return 0x67;
+      case TERARKDB_NAMESPACE::Tickers::GC_GET_KEYS_REUSE:
+        return 0x68;
+      case TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX:
+        return 0x69;
       default:
         // undefined/default
         return 0x0;
@@ -3699,6 +3703,10 @@ class TickerTypeJni {
       case 0x66:
         return TERARKDB_NAMESPACE::Tickers::READ_BLOB_INVALID;
       case 0x67:
+        return TERARKDB_NAMESPACE::Tickers::GC_GET_KEYS_SEEK;
+      case 0x68:
+        return TERARKDB_NAMESPACE::Tickers::GC_GET_KEYS_REUSE;
+      case 0x69:
         return TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX;
 
       default:
@@ -3788,8 +3796,12 @@ class HistogramTypeJni {
         return 0x22;
       case TERARKDB_NAMESPACE::Histograms::BUILD_VERSION_TIME:
         return 0x23;
-      case TERARKDB_NAMESPACE::Histograms::HISTOGRAM_ENUM_MAX:
+      case TERARKDB_NAMESPACE::Histograms::GC_PROBE_TIME:
         return 0x24;
+      case TERARKDB_NAMESPACE::Histograms::GC_REWRITE_TIME:
+        return 0x25;
+      case TERARKDB_NAMESPACE::Histograms::HISTOGRAM_ENUM_MAX:
+        return 0x26;
 
       default:
         // undefined/default
@@ -3875,6 +3887,10 @@ class HistogramTypeJni {
       case 0x23:
         return TERARKDB_NAMESPACE::Histograms::BUILD_VERSION_TIME;
       case 0x24:
+        return TERARKDB_NAMESPACE::Histograms::GC_PROBE_TIME;
+      case 0x25:
+        return TERARKDB_NAMESPACE::Histograms::GC_REWRITE_TIME;
+      case 0x26:
         return TERARKDB_NAMESPACE::Histograms::HISTOGRAM_ENUM_MAX;
 
       default:
@@ -38,6 +38,9 @@ int main() {
 #include "rocksdb/write_buffer_manager.h"
 #include "util/arena.h"
 #include "util/gflags_compat.h"
+#ifdef WITH_TERARK_ZIP
+#include "memtable/terark_zip_memtable.h"
+#endif
 #include "util/mutexlock.h"
 #include "util/stop_watch.h"
 #include "util/testutil.h"
@@ -109,6 +112,12 @@ DEFINE_int64(
     hash_function_count, 4,
     "hash_function_count parameter to pass into NewHashCuckooRepFactory");
 
+DEFINE_int64(
+    patricia_trie_size, 64 << 20,
+    "Size of the first trie of patricia_trie, each next one doubles it. A "
+    "small size spreads the entries over several tries, that reads and scans "
+    "merge");
+
 DEFINE_int32(
     num_threads, 1,
     "Number of concurrent threads to run. If the benchmark includes writes,\n"
@@ -583,7 +592,13 @@ int main(int argc, char** argv) {
 #ifndef ROCKSDB_LITE
   } else if (FLAGS_memtablerep == "patricia_trie") {
 #ifdef WITH_TERARK_ZIP
-    factory.reset(TERARKDB_NAMESPACE::NewPatriciaTrieRepFactory());
+    std::shared_ptr<TERARKDB_NAMESPACE::MemTableRepFactory> fallback(
+        new TERARKDB_NAMESPACE::SkipListFactory);
+    factory.reset(new TERARKDB_NAMESPACE::PatriciaTrieRepFactory(
+        fallback,
+        TERARKDB_NAMESPACE::terark_memtable_details::ConcurrentType::Native,
+        TERARKDB_NAMESPACE::terark_memtable_details::PatriciaKeyType::UserKey,
+        FLAGS_patricia_trie_size));
 #else
     fprintf(stderr,
             "ERROR: NewPatriciaTrieRepFactory only works WITH_TERARK_ZIP=ON\n");
@@ -558,33 +558,49 @@ void PatriciaRepIterator<heap_mode>::HeapItem::Prev() {
   tag = vec.data[index].tag;
 }
 
+template <bool heap_mode>
+template <int direction>
+void PatriciaRepIterator<heap_mode>::Adjust(size_t i) {
+  size_t* tree = multi_.tree;
+  for (size_t node = (i + multi_.count) / 2; node > 0; node /= 2) {
+    if (Before<direction>(tree[node], i)) {
+      std::swap(tree[node], i);
+    }
+  }
+  multi_.winner = i;
+}
+
 template <bool heap_mode>
 template <int direction, class func_t>
 void PatriciaRepIterator<heap_mode>::Rebuild(func_t&& callback_func) {
   static_assert(direction == 1 || direction == -1, "direction must be 1 or -1");
+  size_t count = multi_.count;
+  bool any_valid = false;
+  for (size_t i = 0; i < count; ++i) {
+    any_valid |= callback_func(&multi_.array[i]);
+  }
+  if (!any_valid) {
+    direction_ = 0;
+    return;
+  }
   direction_ = direction;
-  multi_.size = multi_.count;
-  if (direction == 1) {
-    for (size_t i = 0; i < multi_.size;) {
-      if (callback_func(multi_.heap[i])) {
-        ++i;
-      } else {
-        --multi_.size;
-        std::swap(multi_.heap[i], multi_.heap[multi_.size]);
-      }
-    }
-    std::make_heap(multi_.heap, multi_.heap + multi_.size, ForwardComp());
-  } else {
-    for (size_t i = 0; i < multi_.size;) {
-      if (callback_func(multi_.heap[i])) {
-        ++i;
-      } else {
-        --multi_.size;
-        std::swap(multi_.heap[i], multi_.heap[multi_.size]);
-      }
+  // Leaves take the nodes [count, 2 * count), the winner of node "n" is kept
+  // in tree[count + n] while the inner nodes are played bottom up
+  size_t* tree = multi_.tree;
+  size_t* winner = tree + count;
+  auto node_winner = [&](size_t node) {
+    return node < count ? winner[node] : node - count;
+  };
+  for (size_t node = count - 1; node > 0; --node) {
+    size_t l = node_winner(node * 2);
+    size_t r = node_winner(node * 2 + 1);
+    if (Before<direction>(r, l)) {
+      std::swap(l, r);
     }
-    std::make_heap(multi_.heap, multi_.heap + multi_.size, BackwardComp());
+    tree[node] = r;
+    winner[node] = l;
   }
+  multi_.winner = count > 1 ? winner[1] : 0;
 }
 
 template <bool heap_mode>
@@ -594,15 +610,13 @@ PatriciaRepIterator<heap_mode>::PatriciaRepIterator(details::tries_t& tries,
   assert(tries.size() > 0);
   if (heap_mode) {
     valvec<HeapItem> hitem(tries.size(), terark::valvec_reserve());
-    valvec<HeapItem*> hptrs(tries.size(), terark::valvec_reserve());
     for (size_t i = 0; i < tries_size; ++i) {
-      hptrs.push_back(new (hitem.grow_no_init(1)) HeapItem(tries[i]));
+      new (hitem.grow_no_init(1)) HeapItem(tries[i]);
     }
-    assert(hitem.size() == hptrs.size());
     multi_.count = hitem.size();
     multi_.array = hitem.risk_release_ownership();
-    multi_.heap = hptrs.risk_release_ownership();
-    multi_.size = 0;
+    multi_.tree = (size_t*)malloc(sizeof(size_t) * 2 * multi_.count);
+    multi_.winner = 0;
   } else {
     new (&single_) HeapItem(tries.front());
   }
@@ -610,7 +624,7 @@ PatriciaRepIterator<heap_mode>::PatriciaRepIterator(details::tries_t& tries,
 template <bool heap_mode>
 PatriciaRepIterator<heap_mode>::~PatriciaRepIterator() {
   if (heap_mode) {
-    free(multi_.heap);
+    free(multi_.tree);
     for (size_t i = 0; i < multi_.count; ++i) {
       multi_.array[i].~HeapItem();
     }
@@ -639,20 +653,15 @@ void PatriciaRepIterator<heap_mode>::Next() {
         item->Seek(find_key, tag);
         return item->index != size_t(-1);
       });
-      if (multi_.size == 0) {
-        direction_ = 0;
+      if (direction_ == 0) {
         return;
       }
     }
-    multi_.heap[0]->Next();
-    if (multi_.heap[0]->index == size_t(-1)) {
-      std::pop_heap(multi_.heap, multi_.heap + multi_.size, ForwardComp());
-      if (--multi_.size == 0) {
-        direction_ = 0;
-        return;
-      }
-    } else {
-      terark::adjust_heap_top(multi_.heap, multi_.size, ForwardComp());
+    multi_.array[multi_.winner].Next();
+    Adjust<1>(multi_.winner);
+    if (multi_.array[multi_.winner].index == size_t(-1)) {
+      direction_ = 0;
+      return;
     }
   } else {
     single_.Next();
@@ -674,20 +683,15 @@ void PatriciaRepIterator<heap_mode>::Prev() {
         item->SeekForPrev(find_key, tag);
         return item->index != size_t(-1);
       });
-      if (multi_.size == 0) {
-        direction_ = 0;
+      if (direction_ == 0) {
         return;
       }
     }
-    multi_.heap[0]->Prev();
-    if (multi_.heap[0]->index == size_t(-1)) {
-      std::pop_heap(multi_.heap, multi_.heap + multi_.size, BackwardComp());
-      if (--multi_.size == 0) {
-        direction_ = 0;
-        return;
-      }
-    } else {
-      terark::adjust_heap_top(multi_.heap, multi_.size, BackwardComp());
+    multi_.array[multi_.winner].Prev();
+    Adjust<-1>(multi_.winner);
+    if (multi_.array[multi_.winner].index == size_t(-1)) {
+      direction_ = 0;
+      return;
     }
   } else {
     single_.Prev();
@@ -718,8 +722,7 @@ void PatriciaRepIterator<heap_mode>::Seek(const Slice& user_key,
       item->Seek(find_key, tag);
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
-      direction_ = 0;
+    if (direction_ == 0) {
       return;
     }
   } else {
@@ -752,8 +755,7 @@ void PatriciaRepIterator<heap_mode>::SeekForPrev(const Slice& user_key,
       item->SeekForPrev(find_key, tag);
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
-      direction_ = 0;
+    if (direction_ == 0) {
       return;
     }
   } else {
@@ -774,8 +776,7 @@ void PatriciaRepIterator<heap_mode>::SeekToFirst() {
       item->SeekToFirst();
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
-      direction_ = 0;
+    if (direction_ == 0) {
       return;
     }
   } else {
@@ -796,8 +797,7 @@ void PatriciaRepIterator<heap_mode>::SeekToLast() {
       item->SeekToLast();
       return item->index != size_t(-1);
     });
-    if (multi_.size == 0) {
-      direction_ = 0;
+    if (direction_ == 0) {
       return;
     }
   } else {
@@ -127,8 +127,8 @@ class PatriciaTrieRep : public MemTableRep {
   virtual void MarkReadOnly() override;
 };
 
-// Heap iterator for traversing multi tries simultaneously.
-// Create a heap to merge iterators from all tries.
+// Merging iterator for traversing multi tries simultaneously.
+// Create a loser tree to merge iterators from all tries.
 template <bool heap_mode>
 class PatriciaRepIterator : public MemTableRep::Iterator, boost::noncopyable {
   typedef terark::Patricia::ReaderToken token_t;
@@ -164,8 +164,10 @@ class PatriciaRepIterator : public MemTableRep::Iterator, boost::noncopyable {
     struct {
       HeapItem* array;
       size_t count;
-      HeapItem** heap;
-      size_t size;
+      // loser tree over array, tree[1, count) hold the losers of the inner
+      // nodes, tree[count, 2 * count) is scratch for the winners on rebuild
+      size_t* tree;
+      size_t winner;
     } multi_;
     HeapItem single_;
   };
@@ -175,11 +177,13 @@ class PatriciaRepIterator : public MemTableRep::Iterator, boost::noncopyable {
 
   // Return pointer of current heap item.
   const HeapItem* Current() const {
-    return heap_mode ? *multi_.heap : &single_;
+    return heap_mode ? &multi_.array[multi_.winner] : &single_;
   }
 
   // Return pointer of current heap item.
-  HeapItem* Current() { return heap_mode ? *multi_.heap : &single_; }
+  HeapItem* Current() {
+    return heap_mode ? &multi_.array[multi_.winner] : &single_;
+  }
 
   // Return current key.
   terark::fstring CurrentKey() { return Current()->handle->word(); }
@@ -187,25 +191,32 @@ class PatriciaRepIterator : public MemTableRep::Iterator, boost::noncopyable {
   // Return current tag.
   uint64_t CurrentTag() { return Current()->tag; }
 
-  // Lexicographical order 3 way compartor
-  struct ForwardComp {
-    bool operator()(HeapItem* l, HeapItem* r) const {
-      int c = terark::fstring_func::compare3()(l->handle->word(),
-                                               r->handle->word());
-      return c == 0 ? l->tag < r->tag : c > 0;
+  // Return true if item "l" goes out before item "r" in "direction",
+  // exhausted items go out last
+  template <int direction>
+  bool Before(size_t l, size_t r) const {
+    const HeapItem& li = multi_.array[l];
+    const HeapItem& ri = multi_.array[r];
+    if (ri.index == size_t(-1)) {
+      return li.index != size_t(-1);
     }
-  };
-
-  // Reverse lexicographical order 3 way compartor
-  struct BackwardComp {
-    bool operator()(HeapItem* l, HeapItem* r) const {
-      int c = terark::fstring_func::compare3()(l->handle->word(),
-                                               r->handle->word());
-      return c == 0 ? l->tag > r->tag : c < 0;
+    if (li.index == size_t(-1)) {
+      return false;
     }
-  };
+    int c = terark::fstring_func::compare3()(li.handle->word(),
+                                             ri.handle->word());
+    if (direction == 1) {
+      return c == 0 ? li.tag > ri.tag : c < 0;
+    } else {
+      return c == 0 ? li.tag < ri.tag : c > 0;
+    }
+  }
+
+  // Replay the matches from leaf "i" up to the root after it moved
+  template <int direction>
+  void Adjust(size_t i);
 
-  // Rebuild heap for orderness
+  // Rebuild loser tree for orderness
   template <int direction, class func_t>
   void Rebuild(func_t&& callback_func);
 
@@ -13,6 +13,8 @@
 #include "db/dbformat.h"
 #include "gtest/gtest.h"
 #include "rocksdb/terark_namespace.h"
+#include "table/scoped_arena_iterator.h"
+#include "util/random.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -209,6 +211,72 @@ TEST_F(TerarkZipMemtableTest, MultiThreadingTest) {
          dur, total_size);
   delete mem_;
 }
+
+// Entries spread over several tries are merged in internal key order
+TEST_F(TerarkZipMemtableTest, MultiTrieIteratorTest) {
+  Options options;
+  std::shared_ptr<MemTableRepFactory> fallback(new SkipListFactory());
+  // A small first trie makes the inserts spill over several tries
+  options.memtable_factory = std::make_shared<PatriciaTrieRepFactory>(
+      fallback, terark_memtable_details::ConcurrentType::Native,
+      terark_memtable_details::PatriciaKeyType::UserKey, 64 << 10);
+
+  InternalKeyComparator cmp(BytewiseComparator());
+  ImmutableCFOptions ioptions(options);
+  WriteBufferManager wb(options.db_write_buffer_size);
+  std::unique_ptr<MemTable> mem(new MemTable(cmp, ioptions,
+                                             MutableCFOptions(options), true,
+                                             &wb, kMaxSequenceNumber, 0));
+
+  Random rnd(301);
+  std::vector<std::string> expected;
+  SequenceNumber seq = 0;
+  for (int i = 0; i < 20000; ++i) {
+    std::string key("key " + std::to_string(rnd.Uniform(5000)));
+    ASSERT_TRUE(mem->Add(++seq, kTypeValue, key, std::string(64, 'v')));
+    InternalKey ikey(key, seq, kTypeValue);
+    expected.emplace_back(ikey.Encode().ToString());
+  }
+  std::sort(expected.begin(), expected.end(),
+            [&](const std::string& l, const std::string& r) {
+              return cmp.Compare(l, r) < 0;
+            });
+
+  Arena arena;
+  ScopedArenaIterator iter(mem->NewIterator(ReadOptions(), &arena));
+  size_t i = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++i) {
+    ASSERT_LT(i, expected.size());
+    ASSERT_EQ(expected[i], iter->key().ToString());
+  }
+  ASSERT_EQ(expected.size(), i);
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    ASSERT_GT(i, 0);
+    ASSERT_EQ(expected[--i], iter->key().ToString());
+  }
+  ASSERT_EQ(0, i);
+
+  // Change direction after seeks
+  for (int j = 0; j < 1000; ++j) {
+    size_t pos = rnd.Uniform(static_cast<int>(expected.size() - 2)) + 1;
+    iter->Seek(expected[pos]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected[pos], iter->key().ToString());
+    iter->Next();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected[pos + 1], iter->key().ToString());
+    iter->Prev();
+    iter->Prev();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected[pos - 1], iter->key().ToString());
+    iter->SeekForPrev(expected[pos]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected[pos], iter->key().ToString());
+    iter->Next();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected[pos + 1], iter->key().ToString());
+  }
+}
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
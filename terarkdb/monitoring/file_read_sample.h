@@ -12,6 +12,8 @@ namespace TERARKDB_NAMESPACE {
 static const uint32_t kFileReadSampleRate = 1024;
 extern bool should_sample_file_read();
 extern void sample_file_read_inc(FileMetaData*);
+extern void sample_map_range_read_inc(const FileMetaData&, const Slice&,
+                                      const Slice&, uint64_t);
 
 inline bool should_sample_file_read() {
   return (Random::GetTLSInstance()->Next() % kFileReadSampleRate == 307);
@@ -21,4 +23,15 @@ inline void sample_file_read_inc(FileMetaData* meta) {
   meta->stats.num_reads_sampled.fetch_add(kFileReadSampleRate,
                                           std::memory_order_relaxed);
 }
+
+// "num_probes" is the number of files the sampled read looked into for the
+// map sst range [smallest_key, largest_key]
+inline void sample_map_range_read_inc(const FileMetaData& meta,
+                                      const Slice& smallest_key,
+                                      const Slice& largest_key,
+                                      uint64_t num_probes) {
+  meta.stats.GetMapReads()->Add(smallest_key, largest_key,
+                                kFileReadSampleRate,
+                                num_probes * kFileReadSampleRate);
+}
 }  // namespace TERARKDB_NAMESPACE
@@ -56,6 +56,9 @@ void PerfContext::Reset() {
   internal_delete_skipped_count = 0;
   internal_recent_skipped_count = 0;
   internal_merge_count = 0;
+  blob_scan_read_count = 0;
+  blob_scan_seek_count = 0;
+  blob_scan_read_time = 0;
   write_wal_time = 0;
 
   get_snapshot_time = 0;
@@ -163,6 +166,9 @@ std::string PerfContext::ToString(bool exclude_zero_counters) const {
   PERF_CONTEXT_OUTPUT(internal_delete_skipped_count);
   PERF_CONTEXT_OUTPUT(internal_recent_skipped_count);
   PERF_CONTEXT_OUTPUT(internal_merge_count);
+  PERF_CONTEXT_OUTPUT(blob_scan_read_count);
+  PERF_CONTEXT_OUTPUT(blob_scan_seek_count);
+  PERF_CONTEXT_OUTPUT(blob_scan_read_time);
   PERF_CONTEXT_OUTPUT(write_wal_time);
   PERF_CONTEXT_OUTPUT(get_snapshot_time);
   PERF_CONTEXT_OUTPUT(get_from_memtable_time);
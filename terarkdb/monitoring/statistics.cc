@@ -139,6 +139,8 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {GC_TOUCH_FILES, "rocksdb.num.gc.touch_files"},
     {GC_SKIP_GET_BY_SEQ, "rocksdb.num.gc.skip_by_seqno"},
     {GC_SKIP_GET_BY_FILE, "rocksdb.num.gc.skip_by_file_meta"},
+    {GC_GET_KEYS_SEEK, "rocksdb.num.gc.get_keys.seek"},
+    {GC_GET_KEYS_REUSE, "rocksdb.num.gc.get_keys.reuse"},
     {READ_BLOB_VALID, "rocksdb.num.read.blob_valid"},
     {READ_BLOB_INVALID, "rocksdb.num.read.blob_invalid"},
 };
@@ -180,6 +182,8 @@ const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
     {PICK_GARBAGE_COLLECTION_TIME, "rocksdb.pick.gc.micros"},
     {INSTALL_SUPER_VERSION_TIME, "rocksdb.install.super.version.micros"},
     {BUILD_VERSION_TIME, "rocksdb.build.version.micros"},
+    {GC_PROBE_TIME, "rocksdb.gc.probe.micros"},
+    {GC_REWRITE_TIME, "rocksdb.gc.rewrite.micros"},
 };
 
 std::shared_ptr<Statistics> CreateDBStatistics() {
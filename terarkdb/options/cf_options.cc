@@ -206,6 +206,10 @@ void MutableCFOptions::Dump(Logger* log) const {
                  blob_file_defragment_size);
   ROCKS_LOG_INFO(log, "              max_dependence_blob_overlap: %zu",
                  max_dependence_blob_overlap);
+  ROCKS_LOG_INFO(log, "                        blob_offset_index: %d",
+                 blob_offset_index);
+  ROCKS_LOG_INFO(log, "                map_sst_flatten_threshold: %" PRIu64,
+                 map_sst_flatten_threshold);
   ROCKS_LOG_INFO(log, "                     maintainer_job_ratio: %f",
                  maintainer_job_ratio);
   ROCKS_LOG_INFO(log, "      soft_pending_compaction_bytes_limit: %" PRIu64,
@@ -298,6 +302,8 @@ MutableCFOptions::MutableCFOptions(const ColumnFamilyOptions& options, Env* env)
       target_blob_file_size(options.target_blob_file_size),
       blob_file_defragment_size(options.blob_file_defragment_size),
       max_dependence_blob_overlap(options.max_dependence_blob_overlap),
+      blob_offset_index(options.blob_offset_index),
+      map_sst_flatten_threshold(options.map_sst_flatten_threshold),
       maintainer_job_ratio(options.maintainer_job_ratio),
       soft_pending_compaction_bytes_limit(
           options.soft_pending_compaction_bytes_limit),
@@ -162,6 +162,8 @@ struct MutableCFOptions {
         target_blob_file_size(0),
         blob_file_defragment_size(0),
         max_dependence_blob_overlap(0),
+        blob_offset_index(false),
+        map_sst_flatten_threshold(0),
         maintainer_job_ratio(0),
         soft_pending_compaction_bytes_limit(0),
         hard_pending_compaction_bytes_limit(0),
@@ -223,6 +225,8 @@ struct MutableCFOptions {
   uint64_t target_blob_file_size;
   uint64_t blob_file_defragment_size;
   size_t max_dependence_blob_overlap;
+  bool blob_offset_index;
+  uint64_t map_sst_flatten_threshold;
   double maintainer_job_ratio;
   uint64_t soft_pending_compaction_bytes_limit;
   uint64_t hard_pending_compaction_bytes_limit;
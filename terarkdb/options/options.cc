@@ -277,6 +277,11 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    blob_file_defragment_size);
   ROCKS_LOG_HEADER(log, "            Options.max_dependence_blob_overlap: %zu",
                    max_dependence_blob_overlap);
+  ROCKS_LOG_HEADER(log, "                      Options.blob_offset_index: %d",
+                   blob_offset_index);
+  ROCKS_LOG_HEADER(log,
+                   "              Options.map_sst_flatten_threshold: %" PRIu64,
+                   map_sst_flatten_threshold);
   ROCKS_LOG_HEADER(log, "                   Options.maintainer_job_ratio: %f",
                    maintainer_job_ratio);
   ROCKS_LOG_HEADER(log, "                           Options.ttl_gc_ratio: %f",
@@ -584,6 +589,8 @@ ReadOptions::ReadOptions()
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
+      blob_lookahead(0),
+      blob_readahead_budget(0),
       iter_start_seqnum(0) {}
 
 ReadOptions::ReadOptions(bool cksum, bool cache)
@@ -602,6 +609,8 @@ ReadOptions::ReadOptions(bool cksum, bool cache)
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
+      blob_lookahead(0),
+      blob_readahead_budget(0),
       iter_start_seqnum(0) {}
 
 }  // namespace TERARKDB_NAMESPACE
@@ -176,6 +176,9 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.blob_file_defragment_size;
   cf_opts.max_dependence_blob_overlap =
       mutable_cf_options.max_dependence_blob_overlap;
+  cf_opts.blob_offset_index = mutable_cf_options.blob_offset_index;
+  cf_opts.map_sst_flatten_threshold =
+      mutable_cf_options.map_sst_flatten_threshold;
   cf_opts.maintainer_job_ratio = mutable_cf_options.maintainer_job_ratio;
   cf_opts.optimize_filters_for_hits =
       mutable_cf_options.optimize_filters_for_hits;
@@ -1947,6 +1950,14 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::max_dependence_blob_overlap),
           OptionType::kSizeT, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, max_dependence_blob_overlap)}},
+        {"blob_offset_index",
+         {offset_of(&ColumnFamilyOptions::blob_offset_index),
+          OptionType::kBoolean, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, blob_offset_index)}},
+        {"map_sst_flatten_threshold",
+         {offset_of(&ColumnFamilyOptions::map_sst_flatten_threshold),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, map_sst_flatten_threshold)}},
         {"maintainer_job_ratio",
          {offset_of(&ColumnFamilyOptions::maintainer_job_ratio),
           OptionType::kDouble, OptionVerificationType::kNormal, true,
@@ -478,6 +478,8 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "target_blob_file_size=0;"
       "blob_file_defragment_size=0;"
       "max_dependence_blob_overlap=1024;"
+      "blob_offset_index=true;"
+      "map_sst_flatten_threshold=0;"
       "maintainer_job_ratio=0.1;"
       "optimize_filters_for_hits=false;"
       "optimize_range_deletion=false;"
@@ -271,6 +271,11 @@ struct BlockBasedTableBuilder::Rep {
   size_t compressed_cache_key_prefix_size;
 
   BlockHandle pending_handle;  // Handle to add to index block
+  // Every entry gets a data block of its own, see
+  // TableBuilderOptions::one_entry_per_block. The block holding the last
+  // entry is flushed at once and its index entry is left pending.
+  const bool one_entry_per_block;
+  bool pending_index_entry = false;
 
   std::string compressed_output;
   std::unique_ptr<FlushBlockPolicy> flush_block_policy;
@@ -308,6 +313,7 @@ struct BlockBasedTableBuilder::Rep {
         use_delta_encoding_for_index_values(table_opt.format_version >= 4 &&
                                             !table_opt.block_align),
         compressed_cache_key_prefix_size(0),
+        one_entry_per_block(builder_opt.one_entry_per_block),
         flush_block_policy(
             table_options.flush_block_policy_factory->NewFlushBlockPolicy(
                 table_options, data_block)),
@@ -404,8 +410,12 @@ Status BlockBasedTableBuilder::Add(const Slice& key,
     return Status::Corruption("BlockBasedTableBuilder::Add: overlapping key");
   }
 
-  auto should_flush = r->flush_block_policy->Update(key, value);
-  if (should_flush) {
+  if (r->one_entry_per_block) {
+    if (r->pending_index_entry && ok()) {
+      r->index_builder->AddIndexEntry(&r->last_key, &key, r->pending_handle);
+    }
+    r->pending_index_entry = false;
+  } else if (r->flush_block_policy->Update(key, value)) {
     assert(!r->data_block.empty());
     Flush();
 
@@ -443,6 +453,10 @@ Status BlockBasedTableBuilder::Add(const Slice& key,
   NotifyCollectTableCollectorsOnAdd(key, value, r->offset,
                                     r->table_properties_collectors,
                                     r->ioptions.info_log);
+  if (r->one_entry_per_block) {
+    Flush();
+    r->pending_index_entry = ok();
+  }
   return r->status;
 }  // namespace TERARKDB_NAMESPACE
 
@@ -880,7 +894,7 @@ Status BlockBasedTableBuilder::Finish(
     const std::vector<uint64_t>* inheritance_tree) {
   Rep* r = rep_;
   assert(r->status.ok());
-  bool empty_data_block = r->data_block.empty();
+  bool empty_data_block = r->data_block.empty() && !r->pending_index_entry;
   Flush();
   assert(!r->closed);
   r->closed = true;
@@ -988,6 +1002,15 @@ TableProperties BlockBasedTableBuilder::GetTableProperties() const {
   return ret;
 }
 
+bool BlockBasedTableBuilder::GetLastEntryHandle(ValueHandle* handle) const {
+  if (!rep_->pending_index_entry) {
+    return false;
+  }
+  handle->offset = rep_->pending_handle.offset();
+  handle->size = rep_->pending_handle.size();
+  return true;
+}
+
 const std::string BlockBasedTable::kFilterBlockPrefix = "filter.";
 const std::string BlockBasedTable::kFullFilterBlockPrefix = "fullfilter.";
 const std::string BlockBasedTable::kPartitionedFilterBlockPrefix =
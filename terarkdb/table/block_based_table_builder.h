@@ -85,6 +85,8 @@ class BlockBasedTableBuilder : public TableBuilder {
   // Get table properties
   TableProperties GetTableProperties() const override;
 
+  bool GetLastEntryHandle(ValueHandle* handle) const override;
+
  private:
   // Return non-ok iff some error has been detected.
   Status status() const;
@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -611,8 +612,17 @@ const std::string kPropTrue = "1";
 const std::string kPropFalse = "0";
 
 static TableFactory* BlockedCreator(const std::string& options, Status* s) {
+  // Compaction workers get GetOptionString() output: escaped values, one
+  // option per line, parsed the same way as an OPTIONS file
+  std::string opts_str = options;
+  std::replace(opts_str.begin(), opts_str.end(), '\n', ';');
+  std::unordered_map<std::string, std::string> opts_map;
+  *s = StringToMap(opts_str, &opts_map);
   BlockBasedTableOptions base, bbto;
-  *s = GetBlockBasedTableOptionsFromString(base, options, &bbto);
+  if (s->ok()) {
+    *s = GetBlockBasedTableOptionsFromMap(base, opts_map, &bbto,
+                                          true /* input_strings_escaped */);
+  }
   if (s->ok()) {
     return NewBlockBasedTableFactory(bbto);
   }
@@ -2401,6 +2401,39 @@ bool BlockBasedTable::FullFilterKeyMayMatch(
   return may_match;
 }
 
+namespace {
+
+// Values read by Get pin the data block the DataBlockIter in the context
+// refers to.
+class DataBlockLazyBufferState : public LazyBufferState {
+ public:
+  virtual void destroy(LazyBuffer* /*buffer*/) const override {}
+
+  virtual Status pin_buffer(LazyBuffer* buffer) const override {
+    if (buffer->size() <= sizeof(LazyBufferContext)) {
+      buffer->reset(buffer->slice(), true, buffer->file_number());
+      return Status::OK();
+    }
+    auto context = get_context(buffer);
+    DataBlockIter* iter = reinterpret_cast<DataBlockIter*>(context->data[0]);
+    assert(iter != nullptr);
+    Cleanable release_cached_entry = iter->RefCache();
+    if (release_cached_entry.Empty()) {
+      return Status::NotSupported();
+    }
+    buffer->reset(buffer->slice(), std::move(release_cached_entry),
+                  buffer->file_number());
+    return Status::OK();
+  }
+
+  Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
+    return Status::OK();
+  }
+};
+DataBlockLazyBufferState data_block_lazy_buffer_state;
+
+}  // namespace
+
 Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
                             GetContext* get_context,
                             const SliceTransform* prefix_extractor,
@@ -2484,34 +2517,6 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
           break;
         }
 
-        class LazyBufferStateImpl : public LazyBufferState {
-         public:
-          virtual void destroy(LazyBuffer* /*buffer*/) const override {}
-
-          virtual Status pin_buffer(LazyBuffer* buffer) const override {
-            if (buffer->size() <= sizeof(LazyBufferContext)) {
-              buffer->reset(buffer->slice(), true, buffer->file_number());
-              return Status::OK();
-            }
-            auto context = get_context(buffer);
-            DataBlockIter* iter =
-                reinterpret_cast<DataBlockIter*>(context->data[0]);
-            assert(iter != nullptr);
-            Cleanable release_cached_entry = iter->RefCache();
-            if (release_cached_entry.Empty()) {
-              return Status::NotSupported();
-            }
-            buffer->reset(buffer->slice(), std::move(release_cached_entry),
-                          buffer->file_number());
-            return Status::OK();
-          }
-
-          Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
-            return Status::OK();
-          }
-        };
-        static LazyBufferStateImpl static_state;
-
         // Call the *saver function on each entry/block until it returns false
         for (; biter.Valid(); biter.Next()) {
           ParsedInternalKey parsed_key;
@@ -2521,7 +2526,7 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
 
           if (!get_context->SaveValue(
                   parsed_key,
-                  LazyBuffer(&static_state,
+                  LazyBuffer(&data_block_lazy_buffer_state,
                              {reinterpret_cast<uint64_t>(&biter)},
                              biter.value(), rep_->file_number),
                   &matched)) {
@@ -2555,6 +2560,43 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
   return s;
 }
 
+Status BlockBasedTable::GetByHandle(const ReadOptions& read_options,
+                                    const Slice& key, const ValueHandle& handle,
+                                    GetContext* get_context) {
+  assert(key.size() >= 8);  // key must be internal key
+  DataBlockIter biter;
+  NewDataBlockIterator<DataBlockIter>(
+      rep_, read_options, BlockHandle(handle.offset, handle.size), &biter,
+      false, true /* key_includes_seq */, get_context);
+  if (read_options.read_tier == kBlockCacheTier &&
+      biter.status().IsIncomplete()) {
+    get_context->MarkKeyMayExist();
+    return Status::OK();
+  }
+  if (!biter.status().ok()) {
+    return biter.status();
+  }
+  biter.SeekToFirst();
+  if (!biter.Valid()) {
+    return biter.status().ok() ? Status::NotFound() : biter.status();
+  }
+  ParsedInternalKey parsed_key;
+  if (!ParseInternalKey(biter.key(), &parsed_key)) {
+    return Status::Corruption(Slice());
+  }
+  if (rep_->internal_comparator.user_comparator()->Compare(
+          parsed_key.user_key, ExtractUserKey(key)) != 0) {
+    return Status::NotFound();
+  }
+  bool matched = false;
+  get_context->SaveValue(parsed_key,
+                         LazyBuffer(&data_block_lazy_buffer_state,
+                                    {reinterpret_cast<uint64_t>(&biter)},
+                                    biter.value(), rep_->file_number),
+                         &matched);
+  return biter.status();
+}
+
 Status BlockBasedTable::Prefetch(const Slice* const begin,
                                  const Slice* const end) {
   auto& comparator = rep_->internal_comparator;
@@ -124,6 +124,10 @@ class BlockBasedTable : public TableReader {
              GetContext* get_context, const SliceTransform* prefix_extractor,
              bool skip_filters = false) override;
 
+  Status GetByHandle(const ReadOptions& readOptions, const Slice& key,
+                     const ValueHandle& handle,
+                     GetContext* get_context) override;
+
   // Pre-fetch the disk blocks that correspond to the key range specified by
   // (kbegin, kend). The call will return error status in the event of
   // IO or iteration error.
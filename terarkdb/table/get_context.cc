@@ -57,7 +57,9 @@ GetContext::GetContext(const Comparator* ucmp,
       min_seq_type_(0),
       callback_(callback),
       is_index_(false),
-      is_finished_(false) {
+      is_finished_(false),
+      defer_separated_value_(false),
+      read_options_(nullptr) {
   if (seq_) {
     *seq_ = kMaxSequenceNumber;
   }
@@ -201,8 +203,14 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
           }
           return Finish();
         }
-        value = separate_helper_->TransToCombined(user_key_,
-                                                  parsed_key.sequence, value);
+        value = TransToCombined(parsed_key.sequence, value);
+        if (defer_separated_value_ && kNotFound == state_) {
+          state_ = kFound;
+          if (LIKELY(lazy_val_ != nullptr)) {
+            lazy_val_->reset(std::move(value));
+          }
+          return Finish();
+        }
         FALLTHROUGH_INTENDED;
       case kTypeValue:
         assert(state_ == kNotFound || state_ == kMerge);
@@ -264,8 +272,7 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
           }
           return Finish();
         }
-        value = separate_helper_->TransToCombined(user_key_,
-                                                  parsed_key.sequence, value);
+        value = TransToCombined(parsed_key.sequence, value);
         FALLTHROUGH_INTENDED;
       case kTypeMerge:
         assert(state_ == kNotFound || state_ == kMerge);
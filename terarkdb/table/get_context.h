@@ -86,6 +86,16 @@ class GetContext {
 
   bool is_finished() const { return is_finished_; }
 
+  // Leave a separated value that is found unfetched in "value", for the
+  // caller to read later. Merge operands are still read right away.
+  void DeferSeparatedValue() { defer_separated_value_ = true; }
+
+  // Fetch separated values with the cache and checksum settings of
+  // "read_options", which must outlive the context.
+  void SetReadOptions(const ReadOptions* read_options) {
+    read_options_ = read_options;
+  }
+
   void SetMinSequenceAndType(uint64_t min_seq_type) {
     min_seq_type_ = min_seq_type;
   }
@@ -101,6 +111,14 @@ class GetContext {
   void ReportCounters();
 
  private:
+  LazyBuffer TransToCombined(SequenceNumber sequence,
+                             const LazyBuffer& value) const {
+    return read_options_ == nullptr
+               ? separate_helper_->TransToCombined(user_key_, sequence, value)
+               : separate_helper_->TransToCombinedForRead(
+                     user_key_, sequence, value, *read_options_);
+  }
+
   const Comparator* ucmp_;
   const MergeOperator* merge_operator_;
   // the merge operations encountered;
@@ -125,6 +143,8 @@ class GetContext {
   bool sample_;
   bool is_index_;
   bool is_finished_;
+  bool defer_separated_value_;
+  const ReadOptions* read_options_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -124,10 +124,14 @@ LazyBuffer CombinedInternalIterator::value() const {
 }
 
 LazyBuffer CombinedInternalIterator::value(const Slice& user_key,
-                                           std::string* meta) const {
+                                           std::string* meta,
+                                           ValueHandle* handle) const {
   if (meta != nullptr) {
     meta->clear();
   }
+  if (handle != nullptr) {
+    *handle = ValueHandle();
+  }
   if (separate_helper_ == nullptr) {
     return iter_->value();
   }
@@ -145,6 +149,13 @@ LazyBuffer CombinedInternalIterator::value(const Slice& user_key,
     auto meta_slice = SeparateHelper::DecodeValueMeta(value_index.slice());
     meta->assign(meta_slice.data(), meta_slice.size());
   }
+  // The handle is stale once GC moved the value to another file
+  if (handle != nullptr && value_index.valid() &&
+      SeparateHelper::DecodeFileNumber(value_index.slice()) ==
+          v.file_number() &&
+      !SeparateHelper::DecodeValueHandle(value_index.slice(), handle)) {
+    *handle = ValueHandle();
+  }
   return v;
 }
 
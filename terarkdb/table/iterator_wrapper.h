@@ -130,7 +130,10 @@ class CombinedInternalIterator : public InternalIterator {
   bool Valid() const override { return iter_->Valid(); }
   Slice key() const override { return iter_->key(); }
   LazyBuffer value() const override;
-  LazyBuffer value(const Slice& user_key, std::string* meta) const;
+  // Also returns the meta of a separated value, and its handle if the value
+  // is still where the handle points to.
+  LazyBuffer value(const Slice& user_key, std::string* meta,
+                   ValueHandle* handle = nullptr) const;
   Status status() const override { return iter_->status(); }
   void Next() override { iter_->Next(); }
   void Prev() override { iter_->Prev(); }
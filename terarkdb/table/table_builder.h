@@ -86,7 +86,8 @@ struct TableBuilderOptions {
       const std::string* _compression_dict, bool _skip_filters,
       const std::string& _column_family_name, int _level,
       double _compaction_load, uint64_t _creation_time = 0,
-      int64_t _oldest_key_time = 0, SstPurpose _sst_purpose = kEssenceSst)
+      int64_t _oldest_key_time = 0, SstPurpose _sst_purpose = kEssenceSst,
+      bool _one_entry_per_block = false)
       : ioptions(_ioptions),
         moptions(_moptions),
         internal_comparator(_internal_comparator),
@@ -100,7 +101,8 @@ struct TableBuilderOptions {
         compaction_load(_compaction_load),
         creation_time(_creation_time),
         oldest_key_time(_oldest_key_time),
-        sst_purpose(_sst_purpose) {}
+        sst_purpose(_sst_purpose),
+        one_entry_per_block(_one_entry_per_block) {}
   const ImmutableCFOptions& ioptions;
   const MutableCFOptions& moptions;
   const InternalKeyComparator& internal_comparator;
@@ -118,6 +120,9 @@ struct TableBuilderOptions {
   const uint64_t creation_time;
   const int64_t oldest_key_time;
   const SstPurpose sst_purpose;
+  // Cut a data block after every entry, so that an entry can be read back
+  // by its block handle alone. Used for blob ssts with blob_offset_index.
+  const bool one_entry_per_block;
   Slice smallest_user_key;
   Slice largest_user_key;
 
@@ -189,6 +194,13 @@ class TableBuilder {
 
   // Returns table properties
   virtual TableProperties GetTableProperties() const = 0;
+
+  // Position of the entry last added, if the builder can address single
+  // entries (see TableBuilderOptions::one_entry_per_block). The handle
+  // becomes valid to read once the table is finished.
+  virtual bool GetLastEntryHandle(ValueHandle* /*handle*/) const {
+    return false;
+  }
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -26,6 +26,7 @@ class Statistics;
 struct ReadOptions;
 struct TableProperties;
 class GetContext;
+struct ValueHandle;
 
 // A Table is a sorted map from strings to strings.  Tables are
 // immutable and persistent.  A Table may be safely accessed from
@@ -92,6 +93,18 @@ class TableReader {
                      const SliceTransform* prefix_extractor,
                      bool skip_filters = false) = 0;
 
+  // Like Get(), but reads the entry straight from the position a table
+  // builder reported through TableBuilder::GetLastEntryHandle(), without
+  // consulting the index. Returns NotFound if the entry at handle doesn't
+  // have the user key of key, and NotSupported if the table can't address
+  // single entries.
+  virtual Status GetByHandle(const ReadOptions& /*readOptions*/,
+                             const Slice& /*key*/,
+                             const ValueHandle& /*handle*/,
+                             GetContext* /*get_context*/) {
+    return Status::NotSupported();
+  }
+
   // Logic same as for(it->Seek(begin); it->Valid() && callback(*it); ++it) {}
   // Specialization for performance
   virtual void RangeScan(const Slice* begin,
@@ -10,6 +10,7 @@
 #include "table/two_level_iterator.h"
 
 #include "db/version_edit.h"
+#include "monitoring/file_read_sample.h"
 #include "rocksdb/options.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/block.h"
@@ -206,6 +207,7 @@ class MapSstIterator final : public InternalIterator {
   InternalIterator* first_level_iter_;
   LazyBuffer first_level_value_;
   bool is_backword_;
+  bool sample_reads_;
   Status status_;
   IteratorCache iterator_cache_;
   Slice smallest_key_;
@@ -361,6 +363,15 @@ class MapSstIterator final : public InternalIterator {
     }
   }
 
+  // A seek looks into every link of the range it lands in
+  void MaybeSampleSeek() {
+    if (sample_reads_ && status_.ok() && first_level_iter_->Valid() &&
+        should_sample_file_read()) {
+      sample_map_range_read_inc(*file_meta_, smallest_key_, largest_key_,
+                                link_.size());
+    }
+  }
+
   bool IsInRange(const Slice& k) {
     auto& icomp = min_heap_.comparator().internal_comparator();
     return icomp.Compare(smallest_key_, k) < include_smallest_ &&
@@ -371,10 +382,12 @@ class MapSstIterator final : public InternalIterator {
   MapSstIterator(const FileMetaData* file_meta, InternalIterator* iter,
                  const DependenceMap& dependence_map,
                  const InternalKeyComparator& icomp, void* create_arg,
-                 const IteratorCache::CreateIterCallback& create)
+                 const IteratorCache::CreateIterCallback& create,
+                 bool sample_reads)
       : file_meta_(file_meta),
         first_level_iter_(iter),
         is_backword_(false),
+        sample_reads_(sample_reads && file_meta != nullptr),
         iterator_cache_(dependence_map, create_arg, create),
         include_smallest_(false),
         include_largest_(false),
@@ -434,6 +447,7 @@ class MapSstIterator final : public InternalIterator {
       include = include_smallest_;
     }
     InitSecondLevelMinHeap(seek_target, include);
+    MaybeSampleSeek();
     assert(min_heap_.empty() || IsInRange(min_heap_.top().key));
   }
   virtual void SeekForPrev(const Slice& target) override {
@@ -465,6 +479,7 @@ class MapSstIterator final : public InternalIterator {
       include = include_largest_;
     }
     InitSecondLevelMaxHeap(seek_target, include);
+    MaybeSampleSeek();
     assert(max_heap_.empty() || IsInRange(max_heap_.top().key));
   }
   virtual void Next() override {
@@ -556,16 +571,16 @@ InternalIterator* NewMapSstIterator(
     const FileMetaData* file_meta, InternalIterator* mediate_sst_iter,
     const DependenceMap& dependence_map, const InternalKeyComparator& icomp,
     void* callback_arg, const IteratorCache::CreateIterCallback& create_iter,
-    Arena* arena) {
+    Arena* arena, bool sample_reads) {
   assert(file_meta == nullptr || file_meta->prop.is_map_sst());
   if (arena == nullptr) {
     return new MapSstIterator(file_meta, mediate_sst_iter, dependence_map,
-                              icomp, callback_arg, create_iter);
+                              icomp, callback_arg, create_iter, sample_reads);
   } else {
     void* buffer = arena->AllocateAligned(sizeof(MapSstIterator));
     return new (buffer)
         MapSstIterator(file_meta, mediate_sst_iter, dependence_map, icomp,
-                       callback_arg, create_iter);
+                       callback_arg, create_iter, sample_reads);
   }
 }
 
@@ -44,10 +44,11 @@ extern InternalIteratorBase<BlockHandle>* NewTwoLevelIterator(
 
 // Retuan a two level iterator. for unroll map sst
 // keep all params lifecycle please
+// sample_reads: sample the seeks into file_meta's map read stats
 extern InternalIterator* NewMapSstIterator(
     const FileMetaData* file_meta, InternalIterator* mediate_sst_iter,
     const DependenceMap& dependence_map, const InternalKeyComparator& icomp,
     void* callback_arg, const IteratorCache::CreateIterCallback& create_iter,
-    Arena* arena = nullptr);
+    Arena* arena = nullptr, bool sample_reads = false);
 
 }  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,1075 @@
+// Copyright (c) Facebook, Inc. and its affiliates. All Rights Reserved.
+// Copyright (c) 2019-present, Western Digital Corporation
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#if !defined(ROCKSDB_LITE) && !defined(OS_WIN)
+
+#include "io_zenfs.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libzbd/zbd.h>
+#include <linux/blkzoned.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+ZoneExtent::ZoneExtent(uint64_t start, uint64_t length, Zone* zone)
+    : start_(start), length_(length), zone_(zone) {}
+
+Status ZoneExtent::DecodeFrom(Slice* input) {
+  if (input->size() != (sizeof(start_) + sizeof(length_)))
+    return Status::Corruption("ZoneExtent", "Error: length missmatch");
+
+  GetFixed64(input, &start_);
+  GetFixed64(input, &length_);
+  return Status::OK();
+}
+
+void ZoneExtent::EncodeTo(std::string* output) {
+  PutFixed64(output, start_);
+  PutFixed64(output, length_);
+}
+
+void ZoneExtent::EncodeJson(std::ostream& json_stream) {
+  json_stream << "{";
+  json_stream << "\"start\":" << start_ << ",";
+  json_stream << "\"length\":" << length_;
+  json_stream << "}";
+}
+
+enum ZoneFileTag : uint32_t {
+  kFileID = 1,
+  kFileName = 2,
+  kFileSize = 3,
+  kWriteLifeTimeHint = 4,
+  kExtent = 5,
+  kModificationTime = 6,
+  kActiveExtentStart = 7,
+  kIsSparse = 8,
+};
+
+void ZoneFile::EncodeTo(std::string* output, uint32_t extent_start) {
+  PutFixed32(output, kFileID);
+  PutFixed64(output, file_id_);
+
+  PutFixed32(output, kFileName);
+  PutLengthPrefixedSlice(output, Slice(filename_));
+
+  PutFixed32(output, kFileSize);
+  PutFixed64(output, fileSize);
+
+  PutFixed32(output, kWriteLifeTimeHint);
+  PutFixed32(output, (uint32_t)lifetime_);
+
+  for (uint32_t i = extent_start; i < extents_.size(); i++) {
+    std::string extent_str;
+
+    PutFixed32(output, kExtent);
+    extents_[i]->EncodeTo(&extent_str);
+    PutLengthPrefixedSlice(output, Slice(extent_str));
+  }
+
+  PutFixed32(output, kModificationTime);
+  PutFixed64(output, (uint64_t)m_time_);
+
+  /* We store the current extent start - if there is a crash
+   * we know that this file wrote the data starting from
+   * active extent start up to the zone write pointer.
+   * We don't need to store the active zone as we can look it up
+   * from extent_start_ */
+  PutFixed32(output, kActiveExtentStart);
+  PutFixed64(output, extent_start_);
+
+  if (is_sparse_) {
+    PutFixed32(output, kIsSparse);
+  }
+}
+
+void ZoneFile::EncodeJson(std::ostream& json_stream) {
+  json_stream << "{";
+  json_stream << "\"id\":" << file_id_ << ",";
+  json_stream << "\"filename\":\"" << filename_ << "\",";
+  json_stream << "\"size\":" << fileSize << ",";
+  json_stream << "\"hint\":" << lifetime_ << ",";
+  json_stream << "\"extents\":[";
+
+  bool first_element = true;
+  for (ZoneExtent* extent : extents_) {
+    if (first_element) {
+      first_element = false;
+    } else {
+      json_stream << ",";
+    }
+    extent->EncodeJson(json_stream);
+  }
+  json_stream << "]}";
+}
+
+Status ZoneFile::DecodeFrom(Slice* input) {
+  uint32_t tag = 0;
+
+  GetFixed32(input, &tag);
+  if (tag != kFileID || !GetFixed64(input, &file_id_))
+    return Status::Corruption("ZoneFile", "File ID missing");
+
+  while (true) {
+    Slice slice;
+    ZoneExtent* extent;
+    Status s;
+
+    if (!GetFixed32(input, &tag)) break;
+
+    switch (tag) {
+      case kFileName:
+        if (!GetLengthPrefixedSlice(input, &slice))
+          return Status::Corruption("ZoneFile", "Filename missing");
+        filename_ = slice.ToString();
+        if (filename_.length() == 0)
+          return Status::Corruption("ZoneFile", "Zero length filename");
+        break;
+      case kFileSize:
+        if (!GetFixed64(input, &fileSize))
+          return Status::Corruption("ZoneFile", "Missing file size");
+        break;
+      case kWriteLifeTimeHint:
+        uint32_t lt;
+        if (!GetFixed32(input, &lt))
+          return Status::Corruption("ZoneFile", "Missing life time hint");
+        lifetime_ = (Env::WriteLifeTimeHint)lt;
+        break;
+      case kExtent:
+        extent = new ZoneExtent(0, 0, nullptr);
+        GetLengthPrefixedSlice(input, &slice);
+        s = extent->DecodeFrom(&slice);
+        if (!s.ok()) {
+          delete extent;
+          return s;
+        }
+        extent->zone_ = zbd_->GetIOZone(extent->start_);
+        if (!extent->zone_)
+          return Status::Corruption("ZoneFile", "Invalid zone extent");
+        extent->zone_->used_capacity_ += extent->length_;
+        extents_.push_back(extent);
+        break;
+      case kModificationTime:
+        uint64_t ct;
+        if (!GetFixed64(input, &ct))
+          return Status::Corruption("ZoneFile", "Missing creation time");
+        m_time_ = (time_t)ct;
+        break;
+      case kActiveExtentStart:
+        uint64_t es;
+        if (!GetFixed64(input, &es))
+          return Status::Corruption("ZoneFile", "Active extent start");
+        extent_start_ = es;
+        break;
+      case kIsSparse:
+        is_sparse_ = true;
+        break;
+      default:
+        return Status::Corruption("ZoneFile", "Unexpected tag");
+    }
+  }
+
+  MetadataSynced();
+  return Status::OK();
+}
+
+Status ZoneFile::MergeUpdate(std::shared_ptr<ZoneFile> update, bool replace) {
+  if (file_id_ != update->GetID())
+    return Status::Corruption("ZoneFile update", "ID missmatch");
+
+  Rename(update->GetFilename());
+  SetFileSize(update->GetFileSize());
+  SetWriteLifeTimeHint(update->GetWriteLifeTimeHint());
+  SetFileModificationTime(update->GetFileModificationTime());
+
+  if (replace) {
+    ClearExtents();
+  }
+
+  std::vector<ZoneExtent*> update_extents = update->GetExtents();
+  for (long unsigned int i = 0; i < update_extents.size(); i++) {
+    ZoneExtent* extent = update_extents[i];
+    Zone* zone = extent->zone_;
+    zone->used_capacity_ += extent->length_;
+    extents_.push_back(new ZoneExtent(extent->start_, extent->length_, zone));
+  }
+  extent_start_ = update->GetExtentStart();
+  is_sparse_ = update->IsSparse();
+  MetadataSynced();
+
+  return Status::OK();
+}
+
+ZoneFile::ZoneFile(ZonedBlockDevice* zbd, std::string filename,
+                   uint64_t file_id)
+    : zbd_(zbd),
+      active_zone_(NULL),
+      extent_start_(NO_EXTENT),
+      extent_filepos_(0),
+      lifetime_(Env::WLTH_NOT_SET),
+      io_type_(IOType::kUnknown),
+      fileSize(0),
+      filename_(filename),
+      file_id_(file_id),
+      nr_synced_extents_(0),
+      m_time_(0) {}
+
+std::string ZoneFile::GetFilename() { return filename_; }
+void ZoneFile::Rename(std::string name) { filename_ = name; }
+time_t ZoneFile::GetFileModificationTime() { return m_time_; }
+
+uint64_t ZoneFile::GetFileSize() { return fileSize; }
+void ZoneFile::SetFileSize(uint64_t sz) { fileSize = sz; }
+void ZoneFile::SetFileModificationTime(time_t mt) { m_time_ = mt; }
+void ZoneFile::SetIOType(IOType io_type) { io_type_ = io_type; }
+
+ZoneFile::~ZoneFile() {
+  ClearExtents();
+  IOStatus s = CloseWR();
+  if (!s.ok()) {
+    zbd_->SetZoneDeferredStatus(s);
+  }
+}
+
+void ZoneFile::ClearExtents() {
+  for (auto e = std::begin(extents_); e != std::end(extents_); ++e) {
+    Zone* zone = (*e)->zone_;
+
+    assert(zone && zone->used_capacity_ >= (*e)->length_);
+    zone->used_capacity_ -= (*e)->length_;
+    delete *e;
+  }
+  extents_.clear();
+}
+
+IOStatus ZoneFile::CloseWR() {
+  IOStatus s;
+  if (open_for_wr_) {
+    /* Mark up the file as being closed */
+    extent_start_ = NO_EXTENT;
+    s = PersistMetadata();
+    if (!s.ok()) return s;
+    open_for_wr_ = false;
+    s = CloseActiveZone();
+  }
+  return s;
+}
+
+IOStatus ZoneFile::CloseActiveZone() {
+  IOStatus s = IOStatus::OK();
+  if (active_zone_) {
+    bool full = active_zone_->IsFull();
+    s = active_zone_->Close();
+    ReleaseActiveZone();
+    if (!s.ok()) {
+      return s;
+    }
+    zbd_->PutOpenIOZoneToken();
+    if (full) {
+      zbd_->PutActiveIOZoneToken();
+    }
+  }
+  return s;
+}
+
+void ZoneFile::OpenWR(MetadataWriter* metadata_writer) {
+  open_for_wr_ = true;
+  metadata_writer_ = metadata_writer;
+}
+
+bool ZoneFile::IsOpenForWR() { return open_for_wr_; }
+
+IOStatus ZoneFile::PersistMetadata() {
+  assert(metadata_writer_ != NULL);
+  return metadata_writer_->Persist(this);
+}
+
+ZoneExtent* ZoneFile::GetExtent(uint64_t file_offset, uint64_t* dev_offset) {
+  for (unsigned int i = 0; i < extents_.size(); i++) {
+    if (file_offset < extents_[i]->length_) {
+      *dev_offset = extents_[i]->start_ + file_offset;
+      return extents_[i];
+    } else {
+      file_offset -= extents_[i]->length_;
+    }
+  }
+  return NULL;
+}
+
+IOStatus ZoneFile::PositionedRead(uint64_t offset, size_t n, Slice* result,
+                                  char* scratch, bool direct) {
+  ZenFSMetricsLatencyGuard guard(zbd_->GetMetrics(), ZENFS_READ_LATENCY,
+                                 Env::Default());
+  zbd_->GetMetrics()->ReportQPS(ZENFS_READ_QPS, 1);
+
+  ReadLock lck(this);
+
+  int f = zbd_->GetReadFD();
+  int f_direct = zbd_->GetReadDirectFD();
+  char* ptr;
+  uint64_t r_off;
+  size_t r_sz;
+  ssize_t r = 0;
+  size_t read = 0;
+  ZoneExtent* extent;
+  uint64_t extent_end;
+  IOStatus s;
+
+  if (offset >= fileSize) {
+    *result = Slice(scratch, 0);
+    return IOStatus::OK();
+  }
+
+  r_off = 0;
+  extent = GetExtent(offset, &r_off);
+  if (!extent) {
+    /* read start beyond end of (synced) file data*/
+    *result = Slice(scratch, 0);
+    return s;
+  }
+  extent_end = extent->start_ + extent->length_;
+
+  /* Limit read size to end of file */
+  if ((offset + n) > fileSize)
+    r_sz = fileSize - offset;
+  else
+    r_sz = n;
+
+  ptr = scratch;
+
+  while (read != r_sz) {
+    size_t pread_sz = r_sz - read;
+
+    if ((pread_sz + r_off) > extent_end) pread_sz = extent_end - r_off;
+
+    /* We may get some unaligned direct reads due to non-aligned extent lengths,
+     * so increase read request size to be aligned to next blocksize boundary.
+     */
+    bool aligned = (pread_sz % zbd_->GetBlockSize() == 0);
+
+    size_t bytes_to_align = 0;
+    if (direct && !aligned) {
+      bytes_to_align = zbd_->GetBlockSize() - (pread_sz % zbd_->GetBlockSize());
+      pread_sz += bytes_to_align;
+      aligned = true;
+    }
+
+    if (direct && aligned) {
+      r = pread(f_direct, ptr, pread_sz, r_off);
+    } else {
+      r = pread(f, ptr, pread_sz, r_off);
+    }
+
+    if (r <= 0) {
+      if (r == -1 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    /* Verify and update the the bytes read count (if read size was incremented,
+     * for alignment purposes).
+     */
+    if ((size_t)r <= pread_sz - bytes_to_align)
+      pread_sz = (size_t)r;
+    else
+      pread_sz -= bytes_to_align;
+
+    ptr += pread_sz;
+    read += pread_sz;
+    r_off += pread_sz;
+
+    if (read != r_sz && r_off == extent_end) {
+      extent = GetExtent(offset + read, &r_off);
+      if (!extent) {
+        /* read beyond end of (synced) file data */
+        break;
+      }
+      r_off = extent->start_;
+      extent_end = extent->start_ + extent->length_;
+    }
+  }
+
+  if (r < 0) {
+    s = IOStatus::IOError("pread error\n");
+    read = 0;
+  }
+
+  *result = Slice((char*)scratch, read);
+  return s;
+}
+
+void ZoneFile::PushExtent() {
+  uint64_t length;
+
+  assert(fileSize >= extent_filepos_);
+
+  if (!active_zone_) return;
+
+  length = fileSize - extent_filepos_;
+  if (length == 0) return;
+
+  assert(length <= (active_zone_->wp_ - extent_start_));
+  extents_.push_back(new ZoneExtent(extent_start_, length, active_zone_));
+
+  active_zone_->used_capacity_ += length;
+  extent_start_ = active_zone_->wp_;
+  extent_filepos_ = fileSize;
+}
+
+IOStatus ZoneFile::AllocateNewZone() {
+  Zone* zone;
+  IOStatus s = zbd_->AllocateIOZone(lifetime_, io_type_, &zone);
+
+  if (!s.ok()) return s;
+  if (!zone) {
+    return IOStatus::NoSpace("Zone allocation failure\n");
+  }
+  SetActiveZone(zone);
+  extent_start_ = active_zone_->wp_;
+  extent_filepos_ = fileSize;
+
+  /* Persist metadata so we can recover the active extent using
+     the zone write pointer in case there is a crash before syncing */
+  return PersistMetadata();
+}
+
+/* Byte-aligned writes without a sparse header */
+IOStatus ZoneFile::BufferedAppend(char* buffer, uint32_t data_size) {
+  uint32_t left = data_size;
+  uint32_t wr_size;
+  uint32_t block_sz = GetBlockSize();
+  IOStatus s;
+
+  if (active_zone_ == NULL) {
+    s = AllocateNewZone();
+    if (!s.ok()) return s;
+  }
+
+  while (left) {
+    wr_size = left;
+    if (wr_size > active_zone_->capacity_) wr_size = active_zone_->capacity_;
+
+    /* Pad to the next block boundary if needed */
+    uint32_t align = wr_size % block_sz;
+    uint32_t pad_sz = 0;
+
+    if (align) pad_sz = block_sz - align;
+
+    /* the buffer size s aligned on block size, so this is ok*/
+    if (pad_sz) memset(buffer + wr_size, 0x0, pad_sz);
+
+    uint64_t extent_length = wr_size;
+
+    s = active_zone_->Append(buffer, wr_size + pad_sz);
+    if (!s.ok()) return s;
+
+    extents_.push_back(
+        new ZoneExtent(extent_start_, extent_length, active_zone_));
+
+    extent_start_ = active_zone_->wp_;
+    active_zone_->used_capacity_ += extent_length;
+    fileSize += extent_length;
+    left -= extent_length;
+
+    if (active_zone_->capacity_ == 0) {
+      s = CloseActiveZone();
+      if (!s.ok()) {
+        return s;
+      }
+      if (left) {
+        memcpy((void*)(buffer), (void*)(buffer + wr_size), left);
+      }
+      s = AllocateNewZone();
+      if (!s.ok()) return s;
+    }
+  }
+
+  return IOStatus::OK();
+}
+
+/* Byte-aligned, sparse writes with inline metadata
+   the caller reserves 8 bytes of data for a size header */
+IOStatus ZoneFile::SparseAppend(char* sparse_buffer, uint32_t data_size) {
+  uint32_t left = data_size;
+  uint32_t wr_size;
+  uint32_t block_sz = GetBlockSize();
+  IOStatus s;
+
+  if (active_zone_ == NULL) {
+    s = AllocateNewZone();
+    if (!s.ok()) return s;
+  }
+
+  while (left) {
+    wr_size = left + ZoneFile::SPARSE_HEADER_SIZE;
+    if (wr_size > active_zone_->capacity_) wr_size = active_zone_->capacity_;
+
+    /* Pad to the next block boundary if needed */
+    uint32_t align = wr_size % block_sz;
+    uint32_t pad_sz = 0;
+
+    if (align) pad_sz = block_sz - align;
+
+    /* the sparse buffer has block_sz extra bytes tail allocated for padding, so
+     * this is safe */
+    if (pad_sz) memset(sparse_buffer + wr_size, 0x0, pad_sz);
+
+    uint64_t extent_length = wr_size - ZoneFile::SPARSE_HEADER_SIZE;
+    EncodeFixed64(sparse_buffer, extent_length);
+
+    s = active_zone_->Append(sparse_buffer, wr_size + pad_sz);
+    if (!s.ok()) return s;
+
+    extents_.push_back(
+        new ZoneExtent(extent_start_ + ZoneFile::SPARSE_HEADER_SIZE,
+                       extent_length, active_zone_));
+
+    extent_start_ = active_zone_->wp_;
+    active_zone_->used_capacity_ += extent_length;
+    fileSize += extent_length;
+    left -= extent_length;
+
+    if (active_zone_->capacity_ == 0) {
+      s = CloseActiveZone();
+      if (!s.ok()) {
+        return s;
+      }
+      if (left) {
+        memcpy((void*)(sparse_buffer + ZoneFile::SPARSE_HEADER_SIZE),
+               (void*)(sparse_buffer + wr_size), left);
+      }
+      s = AllocateNewZone();
+      if (!s.ok()) return s;
+    }
+  }
+
+  return IOStatus::OK();
+}
+
+/* Assumes that data and size are block aligned */
+IOStatus ZoneFile::Append(void* data, int data_size) {
+  uint32_t left = data_size;
+  uint32_t wr_size, offset = 0;
+  IOStatus s = IOStatus::OK();
+
+  if (!active_zone_) {
+    s = AllocateNewZone();
+    if (!s.ok()) return s;
+  }
+
+  while (left) {
+    if (active_zone_->capacity_ == 0) {
+      PushExtent();
+
+      s = CloseActiveZone();
+      if (!s.ok()) {
+        return s;
+      }
+
+      s = AllocateNewZone();
+      if (!s.ok()) return s;
+    }
+
+    wr_size = left;
+    if (wr_size > active_zone_->capacity_) wr_size = active_zone_->capacity_;
+
+    s = active_zone_->Append((char*)data + offset, wr_size);
+    if (!s.ok()) return s;
+
+    fileSize += wr_size;
+    left -= wr_size;
+    offset += wr_size;
+  }
+
+  return IOStatus::OK();
+}
+
+IOStatus ZoneFile::RecoverSparseExtents(uint64_t start, uint64_t end,
+                                        Zone* zone) {
+  /* Sparse writes, we need to recover each individual segment */
+  IOStatus s;
+  uint32_t block_sz = GetBlockSize();
+  int f = zbd_->GetReadFD();
+  uint64_t next_extent_start = start;
+  char* buffer;
+  int recovered_segments = 0;
+  int ret;
+
+  ret = posix_memalign((void**)&buffer, sysconf(_SC_PAGESIZE), block_sz);
+  if (ret) {
+    return IOStatus::IOError("Out of memory while recovering");
+  }
+
+  while (next_extent_start < end) {
+    uint64_t extent_length;
+
+    ret = pread(f, (void*)buffer, block_sz, next_extent_start);
+    if (ret != (int)block_sz) {
+      s = IOStatus::IOError("Unexpected read error while recovering");
+      break;
+    }
+
+    extent_length = DecodeFixed64(buffer);
+    if (extent_length == 0) {
+      s = IOStatus::IOError("Unexexpeted extent length while recovering");
+      break;
+    }
+    recovered_segments++;
+
+    zone->used_capacity_ += extent_length;
+    extents_.push_back(new ZoneExtent(next_extent_start + SPARSE_HEADER_SIZE,
+                                      extent_length, zone));
+
+    uint64_t extent_blocks = 1 + extent_length / block_sz;
+    next_extent_start += extent_blocks * block_sz;
+  }
+
+  free(buffer);
+  return s;
+}
+
+IOStatus ZoneFile::Recover() {
+  /* If there is no active extent, the file was either closed gracefully
+     or there were no writes prior to a crash. All good.*/
+  if (!HasActiveExtent()) return IOStatus::OK();
+
+  /* Figure out which zone we were writing to */
+  Zone* zone = zbd_->GetIOZone(extent_start_);
+
+  if (zone == nullptr) {
+    return IOStatus::IOError(
+        "Could not find zone for extent start while recovering");
+  }
+
+  if (zone->wp_ < extent_start_) {
+    return IOStatus::IOError("Zone wp is smaller than active extent start");
+  }
+
+  /* How much data do we need to recover? */
+  uint64_t to_recover = zone->wp_ - extent_start_;
+
+  /* Do we actually have any data to recover? */
+  if (to_recover == 0) {
+    /* Mark up the file as having no missing extents */
+    extent_start_ = NO_EXTENT;
+    return IOStatus::OK();
+  }
+
+  /* Is the data sparse or was it writted direct? */
+  if (is_sparse_) {
+    IOStatus s = RecoverSparseExtents(extent_start_, zone->wp_, zone);
+    if (!s.ok()) return s;
+  } else {
+    /* For non-sparse files, the data is contigous and we can recover directly
+       any missing data using the WP */
+    zone->used_capacity_ += to_recover;
+    extents_.push_back(new ZoneExtent(extent_start_, to_recover, zone));
+  }
+
+  /* Mark up the file as having no missing extents */
+  extent_start_ = NO_EXTENT;
+
+  /* Recalculate file size */
+  fileSize = 0;
+  for (uint32_t i = 0; i < extents_.size(); i++) {
+    fileSize += extents_[i]->length_;
+  }
+
+  return IOStatus::OK();
+}
+
+void ZoneFile::ReplaceExtentList(std::vector<ZoneExtent*> new_list) {
+  assert(!IsOpenForWR() && new_list.size() > 0);
+  assert(new_list.size() == extents_.size());
+
+  WriteLock lck(this);
+  extents_ = new_list;
+}
+
+IOStatus ZoneFile::SetWriteLifeTimeHint(Env::WriteLifeTimeHint lifetime) {
+  lifetime_ = lifetime;
+  return IOStatus::OK();
+}
+
+void ZoneFile::ReleaseActiveZone() {
+  assert(active_zone_ != nullptr);
+  bool ok = active_zone_->Release();
+  assert(ok);
+  (void)ok;
+  active_zone_ = nullptr;
+}
+
+void ZoneFile::SetActiveZone(Zone* zone) {
+  assert(active_zone_ == nullptr);
+  assert(zone->IsBusy());
+  active_zone_ = zone;
+}
+
+ZonedWritableFile::ZonedWritableFile(ZonedBlockDevice* zbd, bool _buffered,
+                                     std::shared_ptr<ZoneFile> zoneFile,
+                                     MetadataWriter* metadata_writer) {
+  wp = zoneFile->GetFileSize();
+
+  buffered = _buffered;
+  block_sz = zbd->GetBlockSize();
+  zoneFile_ = zoneFile;
+  buffer_pos = 0;
+  sparse_buffer = nullptr;
+  buffer = nullptr;
+
+  if (buffered) {
+    if (zoneFile->IsSparse()) {
+      size_t sparse_buffer_sz;
+
+      sparse_buffer_sz =
+          1024 * 1024 + block_sz; /* one extra block size for padding */
+      int ret = posix_memalign((void**)&sparse_buffer, sysconf(_SC_PAGESIZE),
+                               sparse_buffer_sz);
+
+      if (ret) sparse_buffer = nullptr;
+
+      assert(sparse_buffer != nullptr);
+
+      buffer_sz = sparse_buffer_sz - ZoneFile::SPARSE_HEADER_SIZE - block_sz;
+      buffer = sparse_buffer + ZoneFile::SPARSE_HEADER_SIZE;
+    } else {
+      buffer_sz = 1024 * 1024;
+      int ret =
+          posix_memalign((void**)&buffer, sysconf(_SC_PAGESIZE), buffer_sz);
+
+      if (ret) buffer = nullptr;
+      assert(buffer != nullptr);
+    }
+  }
+
+  zoneFile_->OpenWR(metadata_writer);
+}
+
+ZonedWritableFile::~ZonedWritableFile() {
+  IOStatus s = CloseInternal();
+  if (buffered) {
+    if (sparse_buffer != nullptr) {
+      free(sparse_buffer);
+    } else {
+      free(buffer);
+    }
+  }
+
+  if (!s.ok()) {
+    zoneFile_->GetZbd()->SetZoneDeferredStatus(s);
+  }
+}
+
+MetadataWriter::~MetadataWriter() {}
+
+IOStatus ZonedWritableFile::Truncate(uint64_t size,
+                                     const IOOptions& /*options*/,
+                                     IODebugContext* /*dbg*/) {
+  zoneFile_->SetFileSize(size);
+  return IOStatus::OK();
+}
+
+IOStatus ZonedWritableFile::DataSync() {
+  if (buffered) {
+    IOStatus s;
+    buffer_mtx_.lock();
+    /* Flushing the buffer will result in a new extent added to the list*/
+    s = FlushBuffer();
+    buffer_mtx_.unlock();
+    if (!s.ok()) {
+      return s;
+    }
+
+    /* We need to persist the new extent, if the file is not sparse,
+     * as we can't use the active zone WP, which is block-aligned, to recover
+     * the file size */
+    if (!zoneFile_->IsSparse()) return zoneFile_->PersistMetadata();
+  } else {
+    /* For direct writes, there is no buffer to flush, we just need to push
+       an extent for the latest written data */
+    zoneFile_->PushExtent();
+  }
+
+  return IOStatus::OK();
+}
+
+IOStatus ZonedWritableFile::Fsync(const IOOptions& /*options*/,
+                                  IODebugContext* /*dbg*/) {
+  IOStatus s;
+  ZenFSMetricsLatencyGuard guard(zoneFile_->GetZBDMetrics(),
+                                 zoneFile_->GetIOType() == IOType::kWAL
+                                     ? ZENFS_WAL_SYNC_LATENCY
+                                     : ZENFS_NON_WAL_SYNC_LATENCY,
+                                 Env::Default());
+  zoneFile_->GetZBDMetrics()->ReportQPS(ZENFS_SYNC_QPS, 1);
+
+  s = DataSync();
+  if (!s.ok()) return s;
+
+  /* As we've already synced the metadata in DataSync, no need to do it again */
+  if (buffered && !zoneFile_->IsSparse()) return IOStatus::OK();
+
+  return zoneFile_->PersistMetadata();
+}
+
+IOStatus ZonedWritableFile::Sync(const IOOptions& /*options*/,
+                                 IODebugContext* /*dbg*/) {
+  return DataSync();
+}
+
+IOStatus ZonedWritableFile::Flush(const IOOptions& /*options*/,
+                                  IODebugContext* /*dbg*/) {
+  return IOStatus::OK();
+}
+
+IOStatus ZonedWritableFile::RangeSync(uint64_t offset, uint64_t nbytes,
+                                      const IOOptions& /*options*/,
+                                      IODebugContext* /*dbg*/) {
+  if (wp < offset + nbytes) return DataSync();
+
+  return IOStatus::OK();
+}
+
+IOStatus ZonedWritableFile::Close(const IOOptions& /*options*/,
+                                  IODebugContext* /*dbg*/) {
+  return CloseInternal();
+}
+
+IOStatus ZonedWritableFile::CloseInternal() {
+  if (!zoneFile_->IsOpenForWR()) {
+    return IOStatus::OK();
+  }
+
+  IOStatus s = DataSync();
+  if (!s.ok()) return s;
+
+  return zoneFile_->CloseWR();
+}
+
+IOStatus ZonedWritableFile::FlushBuffer() {
+  IOStatus s;
+
+  if (buffer_pos == 0) return IOStatus::OK();
+
+  if (zoneFile_->IsSparse()) {
+    s = zoneFile_->SparseAppend(sparse_buffer, buffer_pos);
+  } else {
+    s = zoneFile_->BufferedAppend(buffer, buffer_pos);
+  }
+
+  if (!s.ok()) {
+    return s;
+  }
+
+  wp += buffer_pos;
+  buffer_pos = 0;
+
+  return IOStatus::OK();
+}
+
+IOStatus ZonedWritableFile::BufferedWrite(const Slice& slice) {
+  uint32_t data_left = slice.size();
+  char* data = (char*)slice.data();
+  IOStatus s;
+
+  while (data_left) {
+    uint32_t buffer_left = buffer_sz - buffer_pos;
+    uint32_t to_buffer;
+
+    if (!buffer_left) {
+      s = FlushBuffer();
+      if (!s.ok()) return s;
+      buffer_left = buffer_sz;
+    }
+
+    to_buffer = data_left;
+    if (to_buffer > buffer_left) {
+      to_buffer = buffer_left;
+    }
+
+    memcpy(buffer + buffer_pos, data, to_buffer);
+    buffer_pos += to_buffer;
+    data_left -= to_buffer;
+    data += to_buffer;
+  }
+
+  return IOStatus::OK();
+}
+
+IOStatus ZonedWritableFile::Append(const Slice& data,
+                                   const IOOptions& /*options*/,
+                                   IODebugContext* /*dbg*/) {
+  IOStatus s;
+  ZenFSMetricsLatencyGuard guard(zoneFile_->GetZBDMetrics(),
+                                 zoneFile_->GetIOType() == IOType::kWAL
+                                     ? ZENFS_WAL_WRITE_LATENCY
+                                     : ZENFS_NON_WAL_WRITE_LATENCY,
+                                 Env::Default());
+  zoneFile_->GetZBDMetrics()->ReportQPS(ZENFS_WRITE_QPS, 1);
+  zoneFile_->GetZBDMetrics()->ReportThroughput(ZENFS_WRITE_THROUGHPUT,
+                                               data.size());
+
+  if (buffered) {
+    buffer_mtx_.lock();
+    s = BufferedWrite(data);
+    buffer_mtx_.unlock();
+  } else {
+    s = zoneFile_->Append((void*)data.data(), data.size());
+    if (s.ok()) wp += data.size();
+  }
+
+  return s;
+}
+
+IOStatus ZonedWritableFile::PositionedAppend(const Slice& data, uint64_t offset,
+                                             const IOOptions& /*options*/,
+                                             IODebugContext* /*dbg*/) {
+  IOStatus s;
+  ZenFSMetricsLatencyGuard guard(zoneFile_->GetZBDMetrics(),
+                                 zoneFile_->GetIOType() == IOType::kWAL
+                                     ? ZENFS_WAL_WRITE_LATENCY
+                                     : ZENFS_NON_WAL_WRITE_LATENCY,
+                                 Env::Default());
+  zoneFile_->GetZBDMetrics()->ReportQPS(ZENFS_WRITE_QPS, 1);
+  zoneFile_->GetZBDMetrics()->ReportThroughput(ZENFS_WRITE_THROUGHPUT,
+                                               data.size());
+
+  if (offset != wp) {
+    assert(false);
+    return IOStatus::IOError("positioned append not at write pointer");
+  }
+
+  if (buffered) {
+    buffer_mtx_.lock();
+    s = BufferedWrite(data);
+    buffer_mtx_.unlock();
+  } else {
+    s = zoneFile_->Append((void*)data.data(), data.size());
+    if (s.ok()) wp += data.size();
+  }
+
+  return s;
+}
+
+void ZonedWritableFile::SetWriteLifeTimeHint(Env::WriteLifeTimeHint hint) {
+  zoneFile_->SetWriteLifeTimeHint(hint);
+}
+
+IOStatus ZonedSequentialFile::Read(size_t n, const IOOptions& /*options*/,
+                                   Slice* result, char* scratch,
+                                   IODebugContext* /*dbg*/) {
+  IOStatus s;
+
+  s = zoneFile_->PositionedRead(rp, n, result, scratch, direct_);
+  if (s.ok()) rp += result->size();
+
+  return s;
+}
+
+IOStatus ZonedSequentialFile::Skip(uint64_t n) {
+  if (rp + n >= zoneFile_->GetFileSize())
+    return IOStatus::InvalidArgument("Skip beyond end of file");
+  rp += n;
+  return IOStatus::OK();
+}
+
+IOStatus ZonedSequentialFile::PositionedRead(uint64_t offset, size_t n,
+                                             const IOOptions& /*options*/,
+                                             Slice* result, char* scratch,
+                                             IODebugContext* /*dbg*/) {
+  return zoneFile_->PositionedRead(offset, n, result, scratch, direct_);
+}
+
+IOStatus ZonedRandomAccessFile::Read(uint64_t offset, size_t n,
+                                     const IOOptions& /*options*/,
+                                     Slice* result, char* scratch,
+                                     IODebugContext* /*dbg*/) const {
+  return zoneFile_->PositionedRead(offset, n, result, scratch, direct_);
+}
+
+size_t ZoneFile::GetUniqueId(char* id, size_t max_size) {
+  /* Based on the posix fs implementation */
+  if (max_size < kMaxVarint64Length * 3) {
+    return 0;
+  }
+
+  struct stat buf;
+  int fd = zbd_->GetReadFD();
+  int result = fstat(fd, &buf);
+  if (result == -1) {
+    return 0;
+  }
+
+  char* rid = id;
+  rid = EncodeVarint64(rid, buf.st_dev);
+  rid = EncodeVarint64(rid, buf.st_ino);
+  rid = EncodeVarint64(rid, file_id_);
+  assert(rid >= id);
+  return static_cast<size_t>(rid - id);
+
+  return 0;
+}
+
+IOStatus ZoneFile::MigrateData(uint64_t offset, uint32_t length,
+                               Zone* target_zone) {
+  uint32_t step = 128 << 10;
+  uint32_t read_sz = step;
+  int block_sz = zbd_->GetBlockSize();
+
+  assert(offset % block_sz == 0);
+  if (offset % block_sz != 0) {
+    return IOStatus::IOError("MigrateData offset is not aligned!\n");
+  }
+
+  char* buf;
+  int ret = posix_memalign((void**)&buf, block_sz, step);
+  if (ret) {
+    return IOStatus::IOError("failed allocating alignment write buffer\n");
+  }
+
+  int pad_sz = 0;
+  while (length > 0) {
+    read_sz = length > read_sz ? read_sz : length;
+    pad_sz = read_sz % block_sz == 0 ? 0 : (block_sz - (read_sz % block_sz));
+
+    int r = zbd_->DirectRead(buf, offset, read_sz + pad_sz);
+    if (r < 0) {
+      free(buf);
+      return IOStatus::IOError(strerror(errno));
+    }
+    target_zone->Append(buf, r);
+    length -= read_sz;
+    offset += r;
+  }
+
+  free(buf);
+
+  return IOStatus::OK();
+}
+
+size_t ZonedRandomAccessFile::GetUniqueId(char* id, size_t max_size) const {
+  return zoneFile_->GetUniqueId(id, max_size);
+}
+
+}  // namespace ROCKSDB_NAMESPACE
+
+#endif  // !defined(ROCKSDB_LITE) && !defined(OS_WIN)
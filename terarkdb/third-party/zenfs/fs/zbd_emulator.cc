@@ -0,0 +1,277 @@
+// Copyright (c) 2019-present, Western Digital Corporation
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#if !defined(ROCKSDB_LITE) && !defined(OS_WIN)
+
+#include "zbd_emulator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace ROCKSDB_NAMESPACE {
+
+const std::string ZonedFileEmulator::kPrefix = "emu:";
+
+static const uint64_t kEmulatorMagic = 0x756d655346736e5aULL;  // "ZnsFSemu"
+
+bool ZonedFileEmulator::IsEmulated(const std::string &bdevname) {
+  return bdevname.compare(0, kPrefix.size(), kPrefix) == 0;
+}
+
+std::string ZonedFileEmulator::SideFilename(const std::string &path) {
+  return path + ".zones";
+}
+
+IOStatus ZonedFileEmulator::Create(const std::string &path, uint64_t zone_size,
+                                   uint32_t nr_zones, uint32_t block_size,
+                                   uint32_t max_nr_active_zones,
+                                   uint32_t max_nr_open_zones) {
+  if (block_size == 0 || zone_size == 0 || zone_size % block_size != 0)
+    return IOStatus::InvalidArgument(
+        "Zone size must be a multiple of the block size");
+  if (nr_zones == 0) return IOStatus::InvalidArgument("No zones");
+
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return IOStatus::IOError("Failed to create " + path);
+  /* Sparse, the emulated zones only take space once written */
+  int ret = ftruncate(fd, (off_t)(zone_size * nr_zones));
+  close(fd);
+  if (ret) return IOStatus::IOError("Failed to size " + path);
+
+  size_t size = offsetof(Header, wp) + sizeof(uint64_t) * nr_zones;
+  std::string side = SideFilename(path);
+  std::string buf(size, '\0');
+  Header *h = (Header *)&buf[0];
+  h->magic = kEmulatorMagic;
+  h->zone_size = zone_size;
+  h->nr_zones = nr_zones;
+  h->block_size = block_size;
+  h->max_nr_active_zones = max_nr_active_zones;
+  h->max_nr_open_zones = max_nr_open_zones;
+  for (uint32_t i = 0; i < nr_zones; i++) h->wp[i] = i * zone_size;
+
+  fd = open(side.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return IOStatus::IOError("Failed to create " + side);
+  ssize_t written = write(fd, buf.data(), size);
+  ret = fsync(fd);
+  close(fd);
+  if (written != (ssize_t)size || ret)
+    return IOStatus::IOError("Failed to write " + side);
+
+  return IOStatus::OK();
+}
+
+ZonedFileEmulator::~ZonedFileEmulator() {
+  if (header_ != nullptr) munmap(header_, header_size_);
+}
+
+IOStatus ZonedFileEmulator::Load() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ != nullptr) return IOStatus::OK();
+
+  std::string side = SideFilename(path_);
+  int fd = open(side.c_str(), O_RDWR);
+  if (fd < 0) return IOStatus::NotFound("No emulated zoned device at " + path_);
+
+  struct stat st;
+  if (fstat(fd, &st) || (size_t)st.st_size < offsetof(Header, wp)) {
+    close(fd);
+    return IOStatus::Corruption("Bad emulated zoned device " + side);
+  }
+  void *p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                 0);
+  close(fd);
+  if (p == MAP_FAILED) return IOStatus::IOError("Failed to map " + side);
+
+  Header *h = (Header *)p;
+  if (h->magic != kEmulatorMagic || h->zone_size == 0 || h->block_size == 0 ||
+      offsetof(Header, wp) + sizeof(uint64_t) * h->nr_zones >
+          (size_t)st.st_size) {
+    munmap(p, st.st_size);
+    return IOStatus::Corruption("Bad emulated zoned device " + side);
+  }
+
+  header_ = h;
+  header_size_ = st.st_size;
+  open_.assign(h->nr_zones, false);
+  return IOStatus::OK();
+}
+
+IOStatus ZonedFileEmulator::Sync() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ == nullptr) return IOStatus::OK();
+  if (msync(header_, header_size_, MS_SYNC))
+    return IOStatus::IOError("Failed to sync " + SideFilename(path_));
+  return IOStatus::OK();
+}
+
+int ZonedFileEmulator::Open(int flags, struct zbd_info *info) {
+  if (!Load().ok()) {
+    errno = ENODEV;
+    return -1;
+  }
+
+  /* Regular files may sit on file systems without O_DIRECT support, and
+   * O_EXCL only has a meaning for block devices: emulate it with a lock */
+  int fd = open(path_.c_str(), flags & ~(O_DIRECT | O_EXCL));
+  if (fd < 0) return fd;
+  if (flags & O_EXCL) {
+    if (flock(fd, LOCK_EX | LOCK_NB)) {
+      close(fd);
+      errno = EBUSY;
+      return -1;
+    }
+    lock_fd_ = fd;
+  }
+
+  uint64_t capacity = header_->zone_size * header_->nr_zones;
+  memset(info, 0, sizeof(*info));
+  snprintf(info->vendor_id, sizeof(info->vendor_id), "%s", "ZenFS emulator");
+  info->nr_sectors = capacity >> 9;
+  info->nr_lblocks = capacity / header_->block_size;
+  info->nr_pblocks = info->nr_lblocks;
+  info->zone_size = header_->zone_size;
+  info->zone_sectors = header_->zone_size >> 9;
+  info->lblock_size = header_->block_size;
+  info->pblock_size = header_->block_size;
+  info->nr_zones = header_->nr_zones;
+  info->max_nr_open_zones = header_->max_nr_open_zones;
+  info->max_nr_active_zones = header_->max_nr_active_zones;
+  info->model = ZBD_DM_HOST_MANAGED;
+
+  return fd;
+}
+
+void ZonedFileEmulator::Close(int fd) {
+  if (fd < 0) return;
+  if (fd == lock_fd_) {
+    flock(fd, LOCK_UN);
+    lock_fd_ = -1;
+  }
+  close(fd);
+}
+
+void ZonedFileEmulator::FillZone(uint32_t idx, struct zbd_zone *z) {
+  memset(z, 0, sizeof(*z));
+  z->start = idx * header_->zone_size;
+  z->len = header_->zone_size;
+  z->capacity = header_->zone_size;
+  z->wp = header_->wp[idx];
+  z->type = ZBD_ZONE_TYPE_SWR;
+  if (z->wp == z->start)
+    z->cond = ZBD_ZONE_COND_EMPTY;
+  else if (z->wp == z->start + z->len)
+    z->cond = ZBD_ZONE_COND_FULL;
+  else if (open_[idx])
+    z->cond = ZBD_ZONE_COND_IMP_OPEN;
+  else
+    z->cond = ZBD_ZONE_COND_CLOSED;
+}
+
+int ZonedFileEmulator::ListZones(uint64_t ofst, uint64_t len,
+                                 struct zbd_zone **zones,
+                                 unsigned int *nr_zones) {
+  uint64_t zone_size = header_->zone_size;
+  uint64_t first = ofst / zone_size;
+  uint64_t end = std::min<uint64_t>((ofst + len + zone_size - 1) / zone_size,
+                                    header_->nr_zones);
+  unsigned int nr = first < end ? end - first : 0;
+
+  *zones = (struct zbd_zone *)calloc(nr == 0 ? 1 : nr, sizeof(struct zbd_zone));
+  if (*zones == nullptr) return -ENOMEM;
+  *nr_zones = nr;
+  return ReportZones(ofst, len, *zones, nr_zones);
+}
+
+int ZonedFileEmulator::ReportZones(uint64_t ofst, uint64_t len,
+                                   struct zbd_zone *zones,
+                                   unsigned int *nr_zones) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t zone_size = header_->zone_size;
+  unsigned int nr = 0;
+  for (uint64_t i = ofst / zone_size; i < header_->nr_zones &&
+                                      i * zone_size < ofst + len &&
+                                      nr < *nr_zones;
+       i++) {
+    FillZone((uint32_t)i, &zones[nr++]);
+  }
+  *nr_zones = nr;
+  return 0;
+}
+
+int ZonedFileEmulator::ResetZones(uint64_t ofst, uint64_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t zone_size = header_->zone_size;
+  for (uint64_t i = ofst / zone_size;
+       i < header_->nr_zones && i * zone_size < ofst + len; i++) {
+    if (header_->wp[i] != i * zone_size) {
+      /* Give the zone's space back, like a device would on reset */
+      int fd = open(path_.c_str(), O_WRONLY);
+      if (fd >= 0) {
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  (off_t)(i * zone_size), (off_t)zone_size);
+        close(fd);
+      }
+      header_->zone_resets++;
+    }
+    header_->wp[i] = i * zone_size;
+    open_[i] = false;
+  }
+  return 0;
+}
+
+int ZonedFileEmulator::FinishZones(uint64_t ofst, uint64_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t zone_size = header_->zone_size;
+  for (uint64_t i = ofst / zone_size;
+       i < header_->nr_zones && i * zone_size < ofst + len; i++) {
+    header_->wp[i] = (i + 1) * zone_size;
+    open_[i] = false;
+  }
+  return 0;
+}
+
+int ZonedFileEmulator::CloseZones(uint64_t ofst, uint64_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t zone_size = header_->zone_size;
+  for (uint64_t i = ofst / zone_size;
+       i < header_->nr_zones && i * zone_size < ofst + len; i++) {
+    open_[i] = false;
+  }
+  return 0;
+}
+
+void ZonedFileEmulator::Written(uint64_t ofst, uint64_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t i = ofst / header_->zone_size;
+  if (i >= header_->nr_zones) return;
+  header_->wp[i] = ofst + size;
+  header_->bytes_written += size;
+  open_[i] = true;
+}
+
+uint64_t ZonedFileEmulator::GetBytesWritten() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return header_ == nullptr ? 0 : header_->bytes_written;
+}
+
+uint64_t ZonedFileEmulator::GetZoneResets() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return header_ == nullptr ? 0 : header_->zone_resets;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
+
+#endif  // !defined(ROCKSDB_LITE) && !defined(OS_WIN)
@@ -0,0 +1,90 @@
+// Copyright (c) 2019-present, Western Digital Corporation
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#if !defined(ROCKSDB_LITE) && defined(OS_LINUX)
+
+#include <libzbd/zbd.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rocksdb/io_status.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+/* Emulates a host managed zoned block device on top of a regular file, so
+ * ZenFS can be exercised without ZNS hardware. Zone data lives in the file,
+ * the geometry, the zone write pointers and the device write counters live
+ * in a "<path>.zones" side file that is mapped shared, so they survive a
+ * process that exits without closing the device.
+ *
+ * A device name of the form "emu:<path>" selects the emulator.
+ */
+class ZonedFileEmulator {
+ public:
+  static const std::string kPrefix;
+
+  static bool IsEmulated(const std::string &bdevname);
+  static std::string SideFilename(const std::string &path);
+
+  static IOStatus Create(const std::string &path, uint64_t zone_size,
+                         uint32_t nr_zones, uint32_t block_size,
+                         uint32_t max_nr_active_zones,
+                         uint32_t max_nr_open_zones);
+
+  explicit ZonedFileEmulator(const std::string &path) : path_(path) {}
+  ~ZonedFileEmulator();
+
+  /* The calls below mirror their libzbd counterparts and report errors the
+   * same way: -1 (or the negative errno) with errno set. */
+  int Open(int flags, struct zbd_info *info);
+  void Close(int fd);
+  int ListZones(uint64_t ofst, uint64_t len, struct zbd_zone **zones,
+                unsigned int *nr_zones);
+  int ReportZones(uint64_t ofst, uint64_t len, struct zbd_zone *zones,
+                  unsigned int *nr_zones);
+  int ResetZones(uint64_t ofst, uint64_t len);
+  int FinishZones(uint64_t ofst, uint64_t len);
+  int CloseZones(uint64_t ofst, uint64_t len);
+
+  /* Advance the write pointer of the zone at ofst after a successful write */
+  void Written(uint64_t ofst, uint64_t size);
+
+  IOStatus Load();
+  IOStatus Sync();
+
+  uint64_t GetBytesWritten();
+  uint64_t GetZoneResets();
+
+ private:
+  struct Header {
+    uint64_t magic;
+    uint64_t zone_size;
+    uint32_t nr_zones;
+    uint32_t block_size;
+    uint32_t max_nr_active_zones;
+    uint32_t max_nr_open_zones;
+    uint64_t bytes_written;
+    uint64_t zone_resets;
+    uint64_t wp[1];  // nr_zones write pointers
+  };
+
+  void FillZone(uint32_t idx, struct zbd_zone *z);
+
+  std::string path_;
+  std::mutex mutex_;
+  Header *header_ = nullptr;
+  size_t header_size_ = 0;
+  int lock_fd_ = -1;
+  std::vector<bool> open_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
+
+#endif  // !defined(ROCKSDB_LITE) && defined(OS_LINUX)
@@ -0,0 +1,1001 @@
+// Copyright (c) Facebook, Inc. and its affiliates. All Rights Reserved.
+// Copyright (c) 2019-present, Western Digital Corporation
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#if !defined(ROCKSDB_LITE) && !defined(OS_WIN)
+
+#include "zbd_zenfs.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libzbd/zbd.h>
+#include <linux/blkzoned.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "rocksdb/io_status.h"
+#include "snapshot.h"
+
+#define KB (1024)
+#define MB (1024 * KB)
+
+/* Number of reserved zones for metadata
+ * Two non-offline meta zones are needed to be able
+ * to roll the metadata log safely. One extra
+ * is allocated to cover for one zone going offline.
+ */
+#define ZENFS_META_ZONES (3)
+
+/* Minimum of number of zones that makes sense */
+#define ZENFS_MIN_ZONES (32)
+
+namespace ROCKSDB_NAMESPACE {
+
+Zone::Zone(ZonedBlockDevice *zbd, struct zbd_zone *z)
+    : zbd_(zbd),
+      busy_(false),
+      start_(zbd_zone_start(z)),
+      max_capacity_(zbd_zone_capacity(z)),
+      wp_(zbd_zone_wp(z)) {
+  lifetime_ = Env::WLTH_NOT_SET;
+  used_capacity_ = 0;
+  capacity_ = 0;
+  if (!(zbd_zone_full(z) || zbd_zone_offline(z) || zbd_zone_rdonly(z)))
+    capacity_ = zbd_zone_capacity(z) - (zbd_zone_wp(z) - zbd_zone_start(z));
+}
+
+bool Zone::IsUsed() { return (used_capacity_ > 0); }
+uint64_t Zone::GetCapacityLeft() { return capacity_; }
+bool Zone::IsFull() { return (capacity_ == 0); }
+bool Zone::IsEmpty() { return (wp_ == start_); }
+uint64_t Zone::GetZoneNr() { return start_ / zbd_->GetZoneSize(); }
+
+void Zone::EncodeJson(std::ostream &json_stream) {
+  json_stream << "{";
+  json_stream << "\"start\":" << start_ << ",";
+  json_stream << "\"capacity\":" << capacity_ << ",";
+  json_stream << "\"max_capacity\":" << max_capacity_ << ",";
+  json_stream << "\"wp\":" << wp_ << ",";
+  json_stream << "\"lifetime\":" << lifetime_ << ",";
+  json_stream << "\"used_capacity\":" << used_capacity_;
+  json_stream << "}";
+}
+
+IOStatus Zone::Reset() {
+  struct zbd_zone z;
+  int ret;
+
+  assert(!IsUsed());
+  assert(IsBusy());
+
+  ret = zbd_->ResetZone(start_);
+  if (ret) return IOStatus::IOError("Zone reset failed\n");
+
+  ret = zbd_->ReportZone(start_, &z);
+
+  if (ret) return IOStatus::IOError("Zone report failed\n");
+
+  if (zbd_zone_offline(&z))
+    capacity_ = 0;
+  else
+    max_capacity_ = capacity_ = zbd_zone_capacity(&z);
+
+  wp_ = start_;
+  lifetime_ = Env::WLTH_NOT_SET;
+
+  return IOStatus::OK();
+}
+
+IOStatus Zone::Finish() {
+  size_t zone_sz = zbd_->GetZoneSize();
+  int ret;
+
+  assert(IsBusy());
+
+  ret = zbd_->FinishZone(start_);
+  if (ret) return IOStatus::IOError("Zone finish failed\n");
+
+  capacity_ = 0;
+  wp_ = start_ + zone_sz;
+
+  return IOStatus::OK();
+}
+
+IOStatus Zone::Close() {
+  int ret;
+
+  assert(IsBusy());
+
+  if (!(IsEmpty() || IsFull())) {
+    ret = zbd_->CloseZone(start_);
+    if (ret) return IOStatus::IOError("Zone close failed\n");
+  }
+
+  return IOStatus::OK();
+}
+
+IOStatus Zone::Append(char *data, uint32_t size) {
+  zbd_->GetMetrics()->ReportThroughput(ZENFS_ZONE_WRITE_THROUGHPUT, size);
+  char *ptr = data;
+  uint32_t left = size;
+  int fd = zbd_->GetWriteFD();
+  int ret;
+
+  if (capacity_ < size)
+    return IOStatus::NoSpace("Not enough capacity for append");
+
+  assert((size % zbd_->GetBlockSize()) == 0);
+
+  while (left) {
+    ret = pwrite(fd, ptr, size, wp_);
+    if (ret < 0) {
+      return IOStatus::IOError(strerror(errno));
+    }
+
+    zbd_->ZoneWritten(wp_, ret);
+    ptr += ret;
+    wp_ += ret;
+    capacity_ -= ret;
+    left -= ret;
+  }
+
+  return IOStatus::OK();
+}
+
+inline IOStatus Zone::CheckRelease() {
+  if (!Release()) {
+    assert(false);
+    return IOStatus::Corruption("Failed to unset busy flag of zone " +
+                                std::to_string(GetZoneNr()));
+  }
+
+  return IOStatus::OK();
+}
+
+Zone *ZonedBlockDevice::GetIOZone(uint64_t offset) {
+  for (const auto z : io_zones)
+    if (z->start_ <= offset && offset < (z->start_ + zone_sz_)) return z;
+  return nullptr;
+}
+
+ZonedBlockDevice::ZonedBlockDevice(std::string bdevname,
+                                   std::shared_ptr<Logger> logger,
+                                   std::shared_ptr<ZenFSMetrics> metrics)
+    : filename_("/dev/" + bdevname),
+      read_f_(-1),
+      read_direct_f_(-1),
+      write_f_(-1),
+      logger_(logger),
+      metrics_(metrics) {
+  if (ZonedFileEmulator::IsEmulated(bdevname)) {
+    filename_ = bdevname.substr(ZonedFileEmulator::kPrefix.size());
+    emu_.reset(new ZonedFileEmulator(filename_));
+  }
+  Info(logger_, "New Zoned Block Device: %s%s", filename_.c_str(),
+       emu_ ? " (emulated)" : "");
+}
+
+int ZonedBlockDevice::OpenDevice(int flags, struct zbd_info *info) {
+  if (emu_) return emu_->Open(flags, info);
+  return zbd_open(filename_.c_str(), flags, info);
+}
+
+void ZonedBlockDevice::CloseDevice(int fd) {
+  if (emu_)
+    emu_->Close(fd);
+  else
+    zbd_close(fd);
+}
+
+int ZonedBlockDevice::ReportZone(uint64_t start, struct zbd_zone *z) {
+  unsigned int report = 1;
+  int ret;
+
+  if (emu_)
+    ret = emu_->ReportZones(start, zone_sz_, z, &report);
+  else
+    ret = zbd_report_zones(read_f_, start, zone_sz_, ZBD_RO_ALL, z, &report);
+
+  if (!ret && report != 1) return -EIO;
+  return ret;
+}
+
+int ZonedBlockDevice::ResetZone(uint64_t start) {
+  if (emu_) return emu_->ResetZones(start, zone_sz_);
+  return zbd_reset_zones(write_f_, start, zone_sz_);
+}
+
+int ZonedBlockDevice::FinishZone(uint64_t start) {
+  if (emu_) return emu_->FinishZones(start, zone_sz_);
+  return zbd_finish_zones(write_f_, start, zone_sz_);
+}
+
+int ZonedBlockDevice::CloseZone(uint64_t start) {
+  if (emu_) return emu_->CloseZones(start, zone_sz_);
+  return zbd_close_zones(write_f_, start, zone_sz_);
+}
+
+void ZonedBlockDevice::ZoneWritten(uint64_t ofst, uint64_t size) {
+  if (emu_) emu_->Written(ofst, size);
+}
+
+std::string ZonedBlockDevice::ErrorToString(int err) {
+  char *err_str = strerror(err);
+  if (err_str != nullptr) return std::string(err_str);
+  return "";
+}
+
+IOStatus ZonedBlockDevice::CheckScheduler() {
+  std::ostringstream path;
+  std::string s = filename_;
+  std::fstream f;
+
+  s.erase(0, 5);  // Remove "/dev/" from /dev/nvmeXnY
+  path << "/sys/block/" << s << "/queue/scheduler";
+  f.open(path.str(), std::fstream::in);
+  if (!f.is_open()) {
+    return IOStatus::InvalidArgument("Failed to open " + path.str());
+  }
+
+  std::string buf;
+  getline(f, buf);
+  if (buf.find("[mq-deadline]") == std::string::npos) {
+    f.close();
+    return IOStatus::InvalidArgument(
+        "Current ZBD scheduler is not mq-deadline, set it to mq-deadline.");
+  }
+
+  f.close();
+  return IOStatus::OK();
+}
+
+IOStatus ZonedBlockDevice::Open(bool readonly, bool exclusive) {
+  struct zbd_zone *zone_rep;
+  unsigned int reported_zones;
+  uint64_t addr_space_sz;
+  zbd_info info;
+  Status s;
+  uint64_t i = 0;
+  uint64_t m = 0;
+  // Reserve one zone for metadata and another one for extent migration
+  int reserved_zones = 2;
+  int ret;
+
+  if (!readonly && !exclusive)
+    return IOStatus::InvalidArgument("Write opens must be exclusive");
+
+  /* The non-direct file descriptor acts as an exclusive-use semaphore */
+  if (exclusive) {
+    read_f_ = OpenDevice(O_RDONLY | O_EXCL, &info);
+  } else {
+    read_f_ = OpenDevice(O_RDONLY, &info);
+  }
+
+  if (read_f_ < 0) {
+    return IOStatus::InvalidArgument(
+        "Failed to open zoned block device for read: " + ErrorToString(errno));
+  }
+
+  read_direct_f_ = OpenDevice(O_RDONLY | O_DIRECT, &info);
+  if (read_direct_f_ < 0) {
+    return IOStatus::InvalidArgument(
+        "Failed to open zoned block device for direct read: " +
+        ErrorToString(errno));
+  }
+
+  if (readonly) {
+    write_f_ = -1;
+  } else {
+    write_f_ = OpenDevice(O_WRONLY | O_DIRECT, &info);
+    if (write_f_ < 0) {
+      return IOStatus::InvalidArgument(
+          "Failed to open zoned block device for write: " +
+          ErrorToString(errno));
+    }
+  }
+
+  if (info.model != ZBD_DM_HOST_MANAGED) {
+    return IOStatus::NotSupported("Not a host managed block device");
+  }
+
+  if (info.nr_zones < ZENFS_MIN_ZONES) {
+    return IOStatus::NotSupported(
+        "To few zones on zoned block device (32 required)");
+  }
+
+  if (!emu_) {
+    IOStatus ios = CheckScheduler();
+    if (ios != IOStatus::OK()) return ios;
+  }
+
+  block_sz_ = info.pblock_size;
+  zone_sz_ = info.zone_size;
+  nr_zones_ = info.nr_zones;
+
+  if (info.max_nr_active_zones == 0)
+    max_nr_active_io_zones_ = info.nr_zones;
+  else
+    max_nr_active_io_zones_ = info.max_nr_active_zones - reserved_zones;
+
+  if (info.max_nr_open_zones == 0)
+    max_nr_open_io_zones_ = info.nr_zones;
+  else
+    max_nr_open_io_zones_ = info.max_nr_open_zones - reserved_zones;
+
+  Info(logger_, "Zone block device nr zones: %u max active: %u max open: %u \n",
+       info.nr_zones, info.max_nr_active_zones, info.max_nr_open_zones);
+
+  addr_space_sz = (uint64_t)nr_zones_ * zone_sz_;
+
+  if (emu_)
+    ret = emu_->ListZones(0, addr_space_sz, &zone_rep, &reported_zones);
+  else
+    ret = zbd_list_zones(read_f_, 0, addr_space_sz, ZBD_RO_ALL, &zone_rep,
+                         &reported_zones);
+
+  if (ret || reported_zones != nr_zones_) {
+    Error(logger_, "Failed to list zones, err: %d", ret);
+    return IOStatus::IOError("Failed to list zones");
+  }
+
+  while (m < ZENFS_META_ZONES && i < reported_zones) {
+    struct zbd_zone *z = &zone_rep[i++];
+    /* Only use sequential write required zones */
+    if (zbd_zone_type(z) == ZBD_ZONE_TYPE_SWR) {
+      if (!zbd_zone_offline(z)) {
+        meta_zones.push_back(new Zone(this, z));
+      }
+      m++;
+    }
+  }
+
+  active_io_zones_ = 0;
+  open_io_zones_ = 0;
+
+  for (; i < reported_zones; i++) {
+    struct zbd_zone *z = &zone_rep[i];
+    /* Only use sequential write required zones */
+    if (zbd_zone_type(z) == ZBD_ZONE_TYPE_SWR) {
+      if (!zbd_zone_offline(z)) {
+        Zone *newZone = new Zone(this, z);
+        if (!newZone->Acquire()) {
+          assert(false);
+          return IOStatus::Corruption("Failed to set busy flag of zone " +
+                                      std::to_string(newZone->GetZoneNr()));
+        }
+        io_zones.push_back(newZone);
+        if (zbd_zone_imp_open(z) || zbd_zone_exp_open(z) ||
+            zbd_zone_closed(z)) {
+          active_io_zones_++;
+          if (zbd_zone_imp_open(z) || zbd_zone_exp_open(z)) {
+            if (!readonly) {
+              newZone->Close();
+            }
+          }
+        }
+        IOStatus status = newZone->CheckRelease();
+        if (!status.ok()) return status;
+      }
+    }
+  }
+
+  free(zone_rep);
+  start_time_ = time(NULL);
+
+  return IOStatus::OK();
+}
+
+uint64_t ZonedBlockDevice::GetFreeSpace() {
+  uint64_t free = 0;
+  for (const auto z : io_zones) {
+    free += z->capacity_;
+  }
+  return free;
+}
+
+uint64_t ZonedBlockDevice::GetUsedSpace() {
+  uint64_t used = 0;
+  for (const auto z : io_zones) {
+    used += z->used_capacity_;
+  }
+  return used;
+}
+
+uint64_t ZonedBlockDevice::GetReclaimableSpace() {
+  uint64_t reclaimable = 0;
+  for (const auto z : io_zones) {
+    if (z->IsFull()) reclaimable += (z->max_capacity_ - z->used_capacity_);
+  }
+  return reclaimable;
+}
+
+void ZonedBlockDevice::LogZoneStats() {
+  uint64_t used_capacity = 0;
+  uint64_t reclaimable_capacity = 0;
+  uint64_t reclaimables_max_capacity = 0;
+  uint64_t active = 0;
+
+  for (const auto z : io_zones) {
+    used_capacity += z->used_capacity_;
+
+    if (z->used_capacity_) {
+      reclaimable_capacity += z->max_capacity_ - z->used_capacity_;
+      reclaimables_max_capacity += z->max_capacity_;
+    }
+
+    if (!(z->IsFull() || z->IsEmpty())) active++;
+  }
+
+  if (reclaimables_max_capacity == 0) reclaimables_max_capacity = 1;
+
+  Info(logger_,
+       "[Zonestats:time(s),used_cap(MB),reclaimable_cap(MB), "
+       "avg_reclaimable(%%), active(#), active_zones(#), open_zones(#)] %ld "
+       "%lu %lu %lu %lu %ld %ld\n",
+       time(NULL) - start_time_, used_capacity / MB, reclaimable_capacity / MB,
+       100 * reclaimable_capacity / reclaimables_max_capacity, active,
+       active_io_zones_.load(), open_io_zones_.load());
+}
+
+void ZonedBlockDevice::LogZoneUsage() {
+  for (const auto z : io_zones) {
+    int64_t used = z->used_capacity_;
+
+    if (used > 0) {
+      Debug(logger_, "Zone 0x%lX used capacity: %ld bytes (%ld MB)\n",
+            z->start_, used, used / MB);
+    }
+  }
+}
+
+void ZonedBlockDevice::LogGarbageInfo() {
+  // Log zone garbage stats vector.
+  //
+  // The values in the vector represents how many zones with target garbage
+  // percent. Garbage percent of each index: [0%, <10%, < 20%, ... <100%, 100%]
+  // For example `[100, 1, 2, 3....]` means 100 zones are empty, 1 zone has less
+  // than 10% garbage, 2 zones have  10% ~ 20% garbage ect.
+  //
+  // We don't need to lock io_zones since we only read data and we don't need
+  // the result to be precise.
+  int zone_gc_stat[12] = {0};
+  for (auto z : io_zones) {
+    if (z->IsEmpty()) {
+      zone_gc_stat[0]++;
+      continue;
+    }
+
+    if (!z->Acquire()) {
+      continue;
+    }
+
+    double garbage_rate =
+        double(z->wp_ - z->start_ - z->used_capacity_) / z->max_capacity_;
+    assert(garbage_rate > 0);
+    int idx = int((garbage_rate + 0.1) * 10);
+    zone_gc_stat[idx]++;
+
+    z->Release();
+  }
+
+  std::stringstream ss;
+  ss << "Zone Garbage Stats: [";
+  for (int i = 0; i < 12; i++) {
+    ss << zone_gc_stat[i] << " ";
+  }
+  ss << "]";
+  Info(logger_, "%s", ss.str().data());
+}
+
+ZonedBlockDevice::~ZonedBlockDevice() {
+  for (const auto z : meta_zones) {
+    delete z;
+  }
+
+  for (const auto z : io_zones) {
+    delete z;
+  }
+
+  if (emu_) {
+    IOStatus s = emu_->Sync();
+    if (!s.ok())
+      Error(logger_, "Failed to sync emulated zones: %s",
+            s.ToString().c_str());
+    Info(logger_, "Emulated device bytes written: %lu zone resets: %lu",
+         emu_->GetBytesWritten(), emu_->GetZoneResets());
+  }
+
+  CloseDevice(read_f_);
+  CloseDevice(read_direct_f_);
+  CloseDevice(write_f_);
+}
+
+#define LIFETIME_DIFF_NOT_GOOD (100)
+#define LIFETIME_DIFF_COULD_BE_WORSE (50)
+
+unsigned int GetLifeTimeDiff(Env::WriteLifeTimeHint zone_lifetime,
+                             Env::WriteLifeTimeHint file_lifetime) {
+  assert(file_lifetime <= Env::WLTH_EXTREME);
+
+  if ((file_lifetime == Env::WLTH_NOT_SET) ||
+      (file_lifetime == Env::WLTH_NONE)) {
+    if (file_lifetime == zone_lifetime) {
+      return 0;
+    } else {
+      return LIFETIME_DIFF_NOT_GOOD;
+    }
+  }
+
+  /* Files of one lifetime class are expected to die together, keep them in
+   * the same zone so it can be reset without migrating live data. A zone of
+   * a longer class is the next best home. */
+  if (zone_lifetime == file_lifetime) return 0;
+  if (zone_lifetime > file_lifetime) return zone_lifetime - file_lifetime;
+
+  return LIFETIME_DIFF_NOT_GOOD;
+}
+
+IOStatus ZonedBlockDevice::AllocateMetaZone(Zone **out_meta_zone) {
+  assert(out_meta_zone);
+  *out_meta_zone = nullptr;
+  ZenFSMetricsLatencyGuard guard(metrics_, ZENFS_META_ALLOC_LATENCY,
+                                 Env::Default());
+  metrics_->ReportQPS(ZENFS_META_ALLOC_QPS, 1);
+
+  for (const auto z : meta_zones) {
+    /* If the zone is not used, reset and use it */
+    if (z->Acquire()) {
+      if (!z->IsUsed()) {
+        if (!z->IsEmpty() && !z->Reset().ok()) {
+          Warn(logger_, "Failed resetting zone!");
+          IOStatus status = z->CheckRelease();
+          if (!status.ok()) return status;
+          continue;
+        }
+        *out_meta_zone = z;
+        return IOStatus::OK();
+      }
+    }
+  }
+  assert(true);
+  Error(logger_, "Out of metadata zones, we should go to read only now.");
+  return IOStatus::NoSpace("Out of metadata zones");
+}
+
+IOStatus ZonedBlockDevice::ResetUnusedIOZones() {
+  for (const auto z : io_zones) {
+    if (z->Acquire()) {
+      if (!z->IsEmpty() && !z->IsUsed()) {
+        bool full = z->IsFull();
+        IOStatus reset_status = z->Reset();
+        IOStatus release_status = z->CheckRelease();
+        if (!reset_status.ok()) return reset_status;
+        if (!release_status.ok()) return release_status;
+        if (!full) PutActiveIOZoneToken();
+      } else {
+        IOStatus release_status = z->CheckRelease();
+        if (!release_status.ok()) return release_status;
+      }
+    }
+  }
+  return IOStatus::OK();
+}
+
+void ZonedBlockDevice::WaitForOpenIOZoneToken(bool prioritized) {
+  long allocator_open_limit;
+
+  /* Avoid non-priortized allocators from starving prioritized ones */
+  if (prioritized) {
+    allocator_open_limit = max_nr_open_io_zones_;
+  } else {
+    allocator_open_limit = max_nr_open_io_zones_ - 1;
+  }
+
+  /* Wait for an open IO Zone token - after this function returns
+   * the caller is allowed to write to a closed zone. The callee
+   * is responsible for calling a PutOpenIOZoneToken to return the resource
+   */
+  std::unique_lock<std::mutex> lk(zone_resources_mtx_);
+  zone_resources_.wait(lk, [this, allocator_open_limit] {
+    if (open_io_zones_.load() < allocator_open_limit) {
+      open_io_zones_++;
+      return true;
+    } else {
+      return false;
+    }
+  });
+}
+
+bool ZonedBlockDevice::GetActiveIOZoneTokenIfAvailable() {
+  /* Grap an active IO Zone token if available - after this function returns
+   * the caller is allowed to write to a closed zone. The callee
+   * is responsible for calling a PutActiveIOZoneToken to return the resource
+   */
+  std::unique_lock<std::mutex> lk(zone_resources_mtx_);
+  if (active_io_zones_.load() < max_nr_active_io_zones_) {
+    active_io_zones_++;
+    return true;
+  }
+  return false;
+}
+
+void ZonedBlockDevice::PutOpenIOZoneToken() {
+  {
+    std::unique_lock<std::mutex> lk(zone_resources_mtx_);
+    open_io_zones_--;
+  }
+  zone_resources_.notify_one();
+}
+
+void ZonedBlockDevice::PutActiveIOZoneToken() {
+  {
+    std::unique_lock<std::mutex> lk(zone_resources_mtx_);
+    active_io_zones_--;
+  }
+  zone_resources_.notify_one();
+}
+
+IOStatus ZonedBlockDevice::ApplyFinishThreshold() {
+  IOStatus s;
+
+  if (finish_threshold_ == 0) return IOStatus::OK();
+
+  for (const auto z : io_zones) {
+    if (z->Acquire()) {
+      bool within_finish_threshold =
+          z->capacity_ < (z->max_capacity_ * finish_threshold_ / 100);
+      if (!(z->IsEmpty() || z->IsFull()) && within_finish_threshold) {
+        /* If there is less than finish_threshold_% remaining capacity in a
+         * non-open-zone, finish the zone */
+        s = z->Finish();
+        if (!s.ok()) {
+          z->Release();
+          Debug(logger_, "Failed finishing zone");
+          return s;
+        }
+        s = z->CheckRelease();
+        if (!s.ok()) return s;
+        PutActiveIOZoneToken();
+      } else {
+        s = z->CheckRelease();
+        if (!s.ok()) return s;
+      }
+    }
+  }
+
+  return IOStatus::OK();
+}
+
+IOStatus ZonedBlockDevice::FinishCheapestIOZone() {
+  IOStatus s;
+  Zone *finish_victim = nullptr;
+
+  for (const auto z : io_zones) {
+    if (z->Acquire()) {
+      if (z->IsEmpty() || z->IsFull()) {
+        s = z->CheckRelease();
+        if (!s.ok()) return s;
+        continue;
+      }
+      if (finish_victim == nullptr) {
+        finish_victim = z;
+        continue;
+      }
+      if (finish_victim->capacity_ > z->capacity_) {
+        s = finish_victim->CheckRelease();
+        if (!s.ok()) return s;
+        finish_victim = z;
+      } else {
+        s = z->CheckRelease();
+        if (!s.ok()) return s;
+      }
+    }
+  }
+
+  // If all non-busy zones are empty or full, we should return success.
+  if (finish_victim == nullptr) {
+    Info(logger_, "All non-busy zones are empty or full, skip.");
+    return IOStatus::OK();
+  }
+
+  s = finish_victim->Finish();
+  IOStatus release_status = finish_victim->CheckRelease();
+
+  if (s.ok()) {
+    PutActiveIOZoneToken();
+  }
+
+  if (!release_status.ok()) {
+    return release_status;
+  }
+
+  return s;
+}
+
+IOStatus ZonedBlockDevice::GetBestOpenZoneMatch(
+    Env::WriteLifeTimeHint file_lifetime, unsigned int *best_diff_out,
+    Zone **zone_out, uint32_t min_capacity) {
+  unsigned int best_diff = LIFETIME_DIFF_NOT_GOOD;
+  Zone *allocated_zone = nullptr;
+  IOStatus s;
+
+  for (const auto z : io_zones) {
+    if (z->Acquire()) {
+      if ((z->used_capacity_ > 0) && !z->IsFull() &&
+          z->capacity_ >= min_capacity) {
+        unsigned int diff = GetLifeTimeDiff(z->lifetime_, file_lifetime);
+        if (diff <= best_diff) {
+          if (allocated_zone != nullptr) {
+            s = allocated_zone->CheckRelease();
+            if (!s.ok()) {
+              IOStatus s_ = z->CheckRelease();
+              if (!s_.ok()) return s_;
+              return s;
+            }
+          }
+          allocated_zone = z;
+          best_diff = diff;
+        } else {
+          s = z->CheckRelease();
+          if (!s.ok()) return s;
+        }
+      } else {
+        s = z->CheckRelease();
+        if (!s.ok()) return s;
+      }
+    }
+  }
+
+  *best_diff_out = best_diff;
+  *zone_out = allocated_zone;
+
+  return IOStatus::OK();
+}
+
+IOStatus ZonedBlockDevice::AllocateEmptyZone(Zone **zone_out) {
+  IOStatus s;
+  Zone *allocated_zone = nullptr;
+  for (const auto z : io_zones) {
+    if (z->Acquire()) {
+      if (z->IsEmpty()) {
+        allocated_zone = z;
+        break;
+      } else {
+        s = z->CheckRelease();
+        if (!s.ok()) return s;
+      }
+    }
+  }
+  *zone_out = allocated_zone;
+  return IOStatus::OK();
+}
+
+int ZonedBlockDevice::DirectRead(char *buf, uint64_t offset, int n) {
+  int ret = 0;
+  int r = -1;
+  int f = GetReadDirectFD();
+
+  while (ret < n) {
+    r = pread(f, buf, n, offset);
+    if (r <= 0) {
+      if (r == -1 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    ret += r;
+  }
+
+  if (r < 0) return r;
+  return ret;
+}
+
+IOStatus ZonedBlockDevice::ReleaseMigrateZone(Zone *zone) {
+  IOStatus s = IOStatus::OK();
+  {
+    std::unique_lock<std::mutex> lock(migrate_zone_mtx_);
+    migrating_ = false;
+    if (zone != nullptr) {
+      s = zone->CheckRelease();
+      Info(logger_, "ReleaseMigrateZone: %lu", zone->start_);
+    }
+  }
+  migrate_resource_.notify_one();
+  return s;
+}
+
+IOStatus ZonedBlockDevice::TakeMigrateZone(Zone **out_zone,
+                                           Env::WriteLifeTimeHint file_lifetime,
+                                           uint32_t min_capacity) {
+  std::unique_lock<std::mutex> lock(migrate_zone_mtx_);
+  migrate_resource_.wait(lock, [this] { return !migrating_; });
+
+  migrating_ = true;
+
+  unsigned int best_diff = LIFETIME_DIFF_NOT_GOOD;
+  auto s =
+      GetBestOpenZoneMatch(file_lifetime, &best_diff, out_zone, min_capacity);
+  if (s.ok() && (*out_zone) != nullptr) {
+    Info(logger_, "TakeMigrateZone: %lu", (*out_zone)->start_);
+  } else {
+    migrating_ = false;
+  }
+
+  return s;
+}
+
+IOStatus ZonedBlockDevice::AllocateIOZone(Env::WriteLifeTimeHint file_lifetime,
+                                          IOType io_type, Zone **out_zone) {
+  Zone *allocated_zone = nullptr;
+  unsigned int best_diff = LIFETIME_DIFF_NOT_GOOD;
+  int new_zone = 0;
+  IOStatus s;
+  ZenFSMetricsLatencyGuard guard(metrics_,
+                                 io_type == IOType::kWAL
+                                     ? ZENFS_WAL_IO_ALLOC_LATENCY
+                                     : ZENFS_NON_WAL_IO_ALLOC_LATENCY,
+                                 Env::Default());
+  metrics_->ReportQPS(ZENFS_IO_ALLOC_QPS, 1);
+
+  // Check if a deferred IO error was set
+  s = GetZoneDeferredStatus();
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (io_type != IOType::kWAL) {
+    s = ApplyFinishThreshold();
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  WaitForOpenIOZoneToken(io_type == IOType::kWAL);
+
+  /* Try to fill an already open zone(with the best life time diff) */
+  s = GetBestOpenZoneMatch(file_lifetime, &best_diff, &allocated_zone);
+  if (!s.ok()) {
+    PutOpenIOZoneToken();
+    return s;
+  }
+
+  // Holding allocated_zone if != nullptr
+
+  if (best_diff >= LIFETIME_DIFF_COULD_BE_WORSE) {
+    bool got_token = GetActiveIOZoneTokenIfAvailable();
+
+    /* If we did not get a token, try to use the best match, even if the life
+     * time diff not good but a better choice than to finish an existing zone
+     * and open a new one
+     */
+    if (allocated_zone != nullptr) {
+      if (!got_token && best_diff == LIFETIME_DIFF_COULD_BE_WORSE) {
+        Debug(logger_,
+              "Allocator: avoided a finish by relaxing lifetime diff "
+              "requirement\n");
+      } else {
+        s = allocated_zone->CheckRelease();
+        if (!s.ok()) {
+          PutOpenIOZoneToken();
+          if (got_token) PutActiveIOZoneToken();
+          return s;
+        }
+        allocated_zone = nullptr;
+      }
+    }
+
+    /* If we haven't found an open zone to fill, open a new zone */
+    if (allocated_zone == nullptr) {
+      /* We have to make sure we can open an empty zone */
+      while (!got_token && !GetActiveIOZoneTokenIfAvailable()) {
+        s = FinishCheapestIOZone();
+        if (!s.ok()) {
+          PutOpenIOZoneToken();
+          return s;
+        }
+      }
+
+      s = AllocateEmptyZone(&allocated_zone);
+      if (!s.ok()) {
+        PutActiveIOZoneToken();
+        PutOpenIOZoneToken();
+        return s;
+      }
+
+      if (allocated_zone != nullptr) {
+        assert(allocated_zone->IsBusy());
+        allocated_zone->lifetime_ = file_lifetime;
+        new_zone = true;
+      } else {
+        PutActiveIOZoneToken();
+      }
+    }
+  }
+
+  if (allocated_zone) {
+    assert(allocated_zone->IsBusy());
+    Debug(logger_,
+          "Allocating zone(new=%d) start: 0x%lx wp: 0x%lx lt: %d file lt: %d\n",
+          new_zone, allocated_zone->start_, allocated_zone->wp_,
+          allocated_zone->lifetime_, file_lifetime);
+  } else {
+    PutOpenIOZoneToken();
+  }
+
+  if (io_type != IOType::kWAL) {
+    LogZoneStats();
+  }
+
+  *out_zone = allocated_zone;
+
+  metrics_->ReportGeneral(ZENFS_OPEN_ZONES_COUNT, open_io_zones_);
+  metrics_->ReportGeneral(ZENFS_ACTIVE_ZONES_COUNT, active_io_zones_);
+
+  return IOStatus::OK();
+}
+
+std::string ZonedBlockDevice::GetFilename() { return filename_; }
+
+uint32_t ZonedBlockDevice::GetBlockSize() { return block_sz_; }
+
+void ZonedBlockDevice::EncodeJsonZone(std::ostream &json_stream,
+                                      const std::vector<Zone *> zones) {
+  bool first_element = true;
+  json_stream << "[";
+  for (Zone *zone : zones) {
+    if (first_element) {
+      first_element = false;
+    } else {
+      json_stream << ",";
+    }
+    zone->EncodeJson(json_stream);
+  }
+
+  json_stream << "]";
+}
+
+void ZonedBlockDevice::EncodeJson(std::ostream &json_stream) {
+  json_stream << "{";
+  json_stream << "\"meta\":";
+  EncodeJsonZone(json_stream, meta_zones);
+  json_stream << ",\"io\":";
+  EncodeJsonZone(json_stream, io_zones);
+  json_stream << "}";
+}
+
+IOStatus ZonedBlockDevice::GetZoneDeferredStatus() {
+  std::lock_guard<std::mutex> lock(zone_deferred_status_mutex_);
+  return zone_deferred_status_;
+}
+
+void ZonedBlockDevice::SetZoneDeferredStatus(IOStatus status) {
+  std::lock_guard<std::mutex> lk(zone_deferred_status_mutex_);
+  if (!zone_deferred_status_.ok()) {
+    zone_deferred_status_ = status;
+  }
+}
+
+void ZonedBlockDevice::GetZoneSnapshot(std::vector<ZoneSnapshot> &snapshot) {
+  for (auto *zone : io_zones) {
+    snapshot.emplace_back(*zone);
+  }
+}
+
+}  // namespace ROCKSDB_NAMESPACE
+
+#endif  // !defined(ROCKSDB_LITE) && !defined(OS_WIN)
@@ -0,0 +1,199 @@
+// Copyright (c) Facebook, Inc. and its affiliates. All Rights Reserved.
+// Copyright (c) 2019-present, Western Digital Corporation
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <cstdint>
+#if !defined(ROCKSDB_LITE) && defined(OS_LINUX)
+
+#include <errno.h>
+#include <libzbd/zbd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "metrics.h"
+#include "zbd_emulator.h"
+#include "rocksdb/env.h"
+#include "rocksdb/file_system.h"
+#include "rocksdb/io_status.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+class ZonedBlockDevice;
+class ZoneSnapshot;
+class ZenFSSnapshotOptions;
+
+class Zone {
+  ZonedBlockDevice *zbd_;
+  std::atomic_bool busy_;
+
+ public:
+  explicit Zone(ZonedBlockDevice *zbd, struct zbd_zone *z);
+
+  uint64_t start_;
+  uint64_t capacity_; /* remaining capacity */
+  uint64_t max_capacity_;
+  uint64_t wp_;
+  Env::WriteLifeTimeHint lifetime_;
+  std::atomic<uint64_t> used_capacity_;
+
+  IOStatus Reset();
+  IOStatus Finish();
+  IOStatus Close();
+
+  IOStatus Append(char *data, uint32_t size);
+  bool IsUsed();
+  bool IsFull();
+  bool IsEmpty();
+  uint64_t GetZoneNr();
+  uint64_t GetCapacityLeft();
+  bool IsBusy() { return this->busy_.load(std::memory_order_relaxed); }
+  bool Acquire() {
+    bool expected = false;
+    return this->busy_.compare_exchange_strong(expected, true,
+                                               std::memory_order_acq_rel);
+  }
+  bool Release() {
+    bool expected = true;
+    return this->busy_.compare_exchange_strong(expected, false,
+                                               std::memory_order_acq_rel);
+  }
+
+  void EncodeJson(std::ostream &json_stream);
+
+  inline IOStatus CheckRelease();
+};
+
+class ZonedBlockDevice {
+ private:
+  std::string filename_;
+  uint32_t block_sz_;
+  uint64_t zone_sz_;
+  uint32_t nr_zones_;
+  std::vector<Zone *> io_zones;
+  std::vector<Zone *> meta_zones;
+  int read_f_;
+  int read_direct_f_;
+  int write_f_;
+  time_t start_time_;
+  std::shared_ptr<Logger> logger_;
+  uint32_t finish_threshold_ = 0;
+
+  std::atomic<long> active_io_zones_;
+  std::atomic<long> open_io_zones_;
+  /* Protects zone_resuorces_  condition variable, used
+     for notifying changes in open_io_zones_ */
+  std::mutex zone_resources_mtx_;
+  std::condition_variable zone_resources_;
+  std::mutex zone_deferred_status_mutex_;
+  IOStatus zone_deferred_status_;
+
+  std::condition_variable migrate_resource_;
+  std::mutex migrate_zone_mtx_;
+  std::atomic<bool> migrating_{false};
+
+  unsigned int max_nr_active_io_zones_;
+  unsigned int max_nr_open_io_zones_;
+
+  std::shared_ptr<ZenFSMetrics> metrics_;
+  std::unique_ptr<ZonedFileEmulator> emu_;
+
+  void EncodeJsonZone(std::ostream &json_stream,
+                      const std::vector<Zone *> zones);
+
+ public:
+  explicit ZonedBlockDevice(std::string bdevname,
+                            std::shared_ptr<Logger> logger,
+                            std::shared_ptr<ZenFSMetrics> metrics =
+                                std::make_shared<NoZenFSMetrics>());
+  virtual ~ZonedBlockDevice();
+
+  IOStatus Open(bool readonly, bool exclusive);
+  IOStatus CheckScheduler();
+
+  Zone *GetIOZone(uint64_t offset);
+
+  IOStatus AllocateIOZone(Env::WriteLifeTimeHint file_lifetime, IOType io_type,
+                          Zone **out_zone);
+  IOStatus AllocateMetaZone(Zone **out_meta_zone);
+
+  uint64_t GetFreeSpace();
+  uint64_t GetUsedSpace();
+  uint64_t GetReclaimableSpace();
+
+  std::string GetFilename();
+  uint32_t GetBlockSize();
+
+  IOStatus ResetUnusedIOZones();
+  void LogZoneStats();
+  void LogZoneUsage();
+  void LogGarbageInfo();
+
+  int GetReadFD() { return read_f_; }
+  int GetReadDirectFD() { return read_direct_f_; }
+  int GetWriteFD() { return write_f_; }
+
+  /* Zone management, routed to libzbd or to the file backed emulator */
+  int ReportZone(uint64_t start, struct zbd_zone *z);
+  int ResetZone(uint64_t start);
+  int FinishZone(uint64_t start);
+  int CloseZone(uint64_t start);
+  void ZoneWritten(uint64_t ofst, uint64_t size);
+
+  bool IsEmulated() { return emu_ != nullptr; }
+
+  uint64_t GetZoneSize() { return zone_sz_; }
+  uint32_t GetNrZones() { return nr_zones_; }
+  std::vector<Zone *> GetMetaZones() { return meta_zones; }
+
+  void SetFinishTreshold(uint32_t threshold) { finish_threshold_ = threshold; }
+
+  void PutOpenIOZoneToken();
+  void PutActiveIOZoneToken();
+
+  void EncodeJson(std::ostream &json_stream);
+
+  void SetZoneDeferredStatus(IOStatus status);
+
+  std::shared_ptr<ZenFSMetrics> GetMetrics() { return metrics_; }
+
+  void GetZoneSnapshot(std::vector<ZoneSnapshot> &snapshot);
+
+  int DirectRead(char *buf, uint64_t offset, int n);
+
+  IOStatus ReleaseMigrateZone(Zone *zone);
+
+  IOStatus TakeMigrateZone(Zone **out_zone, Env::WriteLifeTimeHint lifetime,
+                           uint32_t min_capacity);
+
+ private:
+  std::string ErrorToString(int err);
+  int OpenDevice(int flags, struct zbd_info *info);
+  void CloseDevice(int fd);
+  IOStatus GetZoneDeferredStatus();
+  bool GetActiveIOZoneTokenIfAvailable();
+  void WaitForOpenIOZoneToken(bool prioritized);
+  IOStatus ApplyFinishThreshold();
+  IOStatus FinishCheapestIOZone();
+  IOStatus GetBestOpenZoneMatch(Env::WriteLifeTimeHint file_lifetime,
+                                unsigned int *best_diff_out, Zone **zone_out,
+                                uint32_t min_capacity = 0);
+  IOStatus AllocateEmptyZone(Zone **zone_out);
+};
+
+}  // namespace ROCKSDB_NAMESPACE
+
+#endif  // !defined(ROCKSDB_LITE) && defined(OS_LINUX)
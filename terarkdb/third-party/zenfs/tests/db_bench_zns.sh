@@ -0,0 +1,62 @@
+#!/bin/bash
+set -e
+
+# Runs db_bench on ZenFS over a file backed zoned device emulator and reports
+# the device level write amplification: the bytes ZenFS appended to zones
+# over the bytes the benchmark wrote to the db.
+#
+# Example:
+#   ./db_bench_zns.sh /tmp/zns.img
+#   BENCHMARKS=fillrandom,overwrite VALUE_SIZE=8192 ./db_bench_zns.sh /tmp/zns.img
+
+IMG=$1
+if [ -z "$IMG" ]; then
+  echo "Usage: $0 <emulated device image>" 1>&2
+  exit 1
+fi
+
+SCRIPT_DIR=$(cd $(dirname "${BASH_SOURCE[0]}") && pwd)
+TOOLS_DIR=${TOOLS_DIR:-"$SCRIPT_DIR/../../../"}
+ZENFS_DIR=${ZENFS_DIR:-"$SCRIPT_DIR/../util/"}
+
+ZONE_SIZE_MB=${ZONE_SIZE_MB:-64}
+NR_ZONES=${NR_ZONES:-128}
+MAX_ACTIVE_ZONES=${MAX_ACTIVE_ZONES:-14}
+MAX_OPEN_ZONES=${MAX_OPEN_ZONES:-14}
+
+BENCHMARKS=${BENCHMARKS:-"fillrandom,overwrite"}
+NUM=${NUM:-1000000}
+VALUE_SIZE=${VALUE_SIZE:-4096}
+BLOB_SIZE=${BLOB_SIZE:-512}
+
+ZBD="emu:$IMG"
+AUXPATH=${AUXPATH:-"$IMG-aux"}
+OUT=${OUT:-"$IMG-db_bench.out"}
+
+emu_stat() {
+  $ZENFS_DIR/zenfs emu-stat --zbd=$ZBD | grep "^$1:" | awk '{print $2}'
+}
+
+rm -rf $AUXPATH
+$ZENFS_DIR/zenfs mkemu --zbd=$ZBD --emu_zone_size_mb=$ZONE_SIZE_MB \
+  --emu_nr_zones=$NR_ZONES --emu_max_active_zones=$MAX_ACTIVE_ZONES \
+  --emu_max_open_zones=$MAX_OPEN_ZONES --force
+$ZENFS_DIR/zenfs mkfs --zbd=$ZBD --aux_path=$AUXPATH --force
+
+DEV_BYTES_BEFORE=$(emu_stat bytes_written)
+RESETS_BEFORE=$(emu_stat zone_resets)
+
+DB_BENCH_PARAMS="--benchmarks=$BENCHMARKS --num=$NUM --value_size=$VALUE_SIZE --blob_size=$BLOB_SIZE --compression_type=none --statistics --zbd_path=$ZBD $DB_BENCH_EXTRA_PARAMS"
+echo "# Running db_bench with parameters: $DB_BENCH_PARAMS" | tee $OUT
+$TOOLS_DIR/db_bench $DB_BENCH_PARAMS >> $OUT
+
+DEV_BYTES=$(( $(emu_stat bytes_written) - $DEV_BYTES_BEFORE ))
+RESETS=$(( $(emu_stat zone_resets) - $RESETS_BEFORE ))
+USER_BYTES=$(grep "rocksdb.bytes.written COUNT" $OUT | awk '{s += $4} END {print s + 0}')
+
+echo "device bytes written: $DEV_BYTES" | tee -a $OUT
+echo "user bytes written: $USER_BYTES" | tee -a $OUT
+echo "zone resets: $RESETS" | tee -a $OUT
+if [ "$USER_BYTES" -gt 0 ]; then
+  echo "device write amplification: $(awk "BEGIN {printf \"%.2f\", $DEV_BYTES / $USER_BYTES}")" | tee -a $OUT
+fi
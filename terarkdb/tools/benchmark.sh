@@ -3,8 +3,8 @@
 
 if [ $# -ne 1 ]; then
   echo -n "./benchmark.sh [bulkload/fillseq/overwrite/filluniquerandom/"
-  echo    "readrandom/readwhilewriting/readwhilemerging/updaterandom/"
-  echo    "mergerandom/randomtransaction/compact]"
+  echo    "readrandom/multireadrandom/readwhilewriting/readwhilemerging/"
+  echo    "updaterandom/mergerandom/randomtransaction/compact]"
   exit 0
 fi
 
@@ -371,6 +371,49 @@ function run_readrandom {
   summarize_result $output_dir/${out_name} readrandom.t${num_threads} readrandom
 }
 
+function run_multireadrandom {
+  # MultiGet reads inline values from the SST it finds the key in, and
+  # separated ones from blob SSTs after all keys are looked up. Load and read
+  # the DB twice: once with every value kept inline, once with every value
+  # separated.
+  batch_size=${MULTIGET_BATCH_SIZE:-32}
+  for layout in inline separated; do
+    if [ $layout = inline ]; then
+      blob_size=$((value_size + 1))
+    else
+      blob_size=$((value_size / 2))
+    fi
+
+    echo "Loading $num_keys keys sequentially, $layout values"
+    log_file_name=$output_dir/benchmark_multireadrandom.$layout.load.log
+    cmd="./db_bench --benchmarks=fillseq \
+         --use_existing_db=0 \
+         --sync=0 \
+         $params_w \
+         --blob_size=$blob_size \
+         --threads=1 \
+         --seed=$( date +%s ) \
+         2>&1 | tee -a $log_file_name"
+    echo $cmd | tee $log_file_name
+    eval $cmd
+
+    echo "Reading $num_keys random keys in batches of $batch_size, $layout values"
+    out_name="benchmark_multireadrandom.$layout.t${num_threads}.log"
+    cmd="./db_bench --benchmarks=multireadrandom \
+         --use_existing_db=1 \
+         $params_w \
+         --blob_size=$blob_size \
+         --batch_size=$batch_size \
+         --threads=$num_threads \
+         --seed=$( date +%s ) \
+         2>&1 | tee -a $output_dir/${out_name}"
+    echo $cmd | tee $output_dir/${out_name}
+    eval $cmd
+    summarize_result $output_dir/${out_name} \
+        multireadrandom.$layout.t${num_threads} multireadrandom
+  done
+}
+
 function run_readwhile {
   operation=$1
   echo "Reading $num_keys random keys while $operation"
@@ -474,6 +517,8 @@ for job in ${jobs[@]}; do
     run_filluniquerandom
   elif [ $job = readrandom ]; then
     run_readrandom
+  elif [ $job = multireadrandom ]; then
+    run_multireadrandom
   elif [ $job = fwdrange ]; then
     run_range $job false
   elif [ $job = revrange ]; then
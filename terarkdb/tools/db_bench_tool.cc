@@ -999,8 +999,35 @@ DEFINE_uint64(blob_file_defragment_size, 0, "Blob file defragment threshold");
 
 DEFINE_uint64(max_dependence_blob_overlap, 1024, "Max dependence blob overlap");
 
+DEFINE_bool(blob_offset_index, false,
+            "Keep the offset of separated values in their value index");
+
+DEFINE_uint64(map_sst_flatten_threshold, 0,
+              "Rewrite a map sst range once sampled reads through it probed "
+              "this many extra files, 0 to rewrite ranges regardless of reads");
+
+DEFINE_uint64(blob_lookahead, 0,
+              "Entries a scan steps over in a blob sst before seeking, "
+              "0 looks up each separated value on its own");
+
+DEFINE_uint64(blob_readahead_budget, 0,
+              "Readahead bytes shared by the blob cursors of a scan");
+
 DEFINE_uint64(maintainer_job_ratio, 0.1, "Maintainer job ratio");
 
+#ifdef WITH_TERARK_ZIP
+DEFINE_uint64(local_compaction_workers, 0,
+              "Run compactions in this many worker processes, 0 runs them "
+              "in the db process. Implies --enable_lazy_compaction=false "
+              "with level compaction");
+
+DEFINE_uint64(local_compaction_worker_memory_limit, 0,
+              "Bytes a compaction worker process may map, 0 for no limit");
+
+DEFINE_string(local_compaction_worker_command, "",
+              "Program run as compaction worker, empty forks db_bench");
+#endif  // WITH_TERARK_ZIP
+
 DEFINE_uint64(wal_ttl_seconds, 0, "Set the TTL for the WAL Files in seconds.");
 DEFINE_uint64(wal_size_limit_MB, 0,
               "Set the size limit for the WAL Files"
@@ -3603,7 +3630,24 @@ class Benchmark {
     options.target_blob_file_size = FLAGS_target_blob_file_size;
     options.blob_file_defragment_size = FLAGS_blob_file_defragment_size;
     options.max_dependence_blob_overlap = FLAGS_max_dependence_blob_overlap;
+    options.blob_offset_index = FLAGS_blob_offset_index;
+    options.map_sst_flatten_threshold = FLAGS_map_sst_flatten_threshold;
     options.maintainer_job_ratio = FLAGS_maintainer_job_ratio;
+#ifdef WITH_TERARK_ZIP
+    if (FLAGS_local_compaction_workers > 0) {
+      LocalCompactionDispatcherOptions dispatcher_options;
+      dispatcher_options.num_workers = FLAGS_local_compaction_workers;
+      dispatcher_options.worker_memory_limit =
+          FLAGS_local_compaction_worker_memory_limit;
+      dispatcher_options.worker_command = FLAGS_local_compaction_worker_command;
+      dispatcher_options.env = FLAGS_env;
+      options.compaction_dispatcher =
+          NewLocalProcessCompactionDispatcher(dispatcher_options);
+      if (options.compaction_style == kCompactionStyleLevel) {
+        options.enable_lazy_compaction = false;
+      }
+    }
+#endif  // WITH_TERARK_ZIP
     options.optimize_filters_for_hits = FLAGS_optimize_filters_for_hits;
     options.optimize_range_deletion = FLAGS_optimize_range_deletion;
 
@@ -5005,6 +5049,8 @@ class Benchmark {
   void ReadSequential(ThreadState* thread, DB* db) {
     ReadOptions options(FLAGS_verify_checksum, true);
     options.tailing = FLAGS_use_tailing_iterator;
+    options.blob_lookahead = FLAGS_blob_lookahead;
+    options.blob_readahead_budget = FLAGS_blob_readahead_budget;
 
     Iterator* iter = db->NewIterator(options);
     int64_t i = 0;
@@ -5269,6 +5315,8 @@ class Benchmark {
     int64_t bytes = 0;
     ReadOptions options(FLAGS_verify_checksum, true);
     options.tailing = FLAGS_use_tailing_iterator;
+    options.blob_lookahead = FLAGS_blob_lookahead;
+    options.blob_readahead_budget = FLAGS_blob_readahead_budget;
 
     Iterator* single_iter = nullptr;
     std::vector<Iterator*> multi_iters;